@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Microbenchmarks of the search space types, validation and the
+ * built-in optimisers.
+ */
+
+#include <bench/harness.hpp>
+
+#include <benchmarks/synthetic.hpp>
+#include <optimisers/gridsearch.hpp>
+#include <optimisers/random.hpp>
+#include <optimisers/qmc.hpp>
+
+// search space instances -----------------------------------------------------
+
+OPTK_BENCHMARK ("inst::node/build_10", [] {
+    std::vector<std::string> names;
+    for (int i = 0; i < 10; i++)
+        names.push_back (std::to_string (i));
+    return [names] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            inst::node *root = new inst::node ("root");
+            for (const std::string &k: names)
+                root->add_item (new inst::dbl_val (k, 1.));
+            optkbench::keep (root);
+            inst::free_node (root);
+        }
+    };
+});
+
+OPTK_BENCHMARK ("inst::node/getdbl_10", [] {
+    std::shared_ptr<inst::node> root (new inst::node ("root"), inst::free_node);
+    std::vector<std::string> names;
+    for (int i = 0; i < 10; i++) {
+        names.push_back (std::to_string (i));
+        root->add_item (new inst::dbl_val (names.back (), i));
+    }
+    return [root, names] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            double s = 0;
+            for (const std::string &k: names)
+                s += root->getdbl (k);
+            optkbench::keep (s);
+        }
+    };
+});
+
+// sampling -------------------------------------------------------------------
+
+/** Times the sample method of a parameter, which is owned by the body. */
+template <class T, typename... Args>
+static optkbench::body
+sample_body (Args... args)
+{
+    std::shared_ptr<T> p = std::make_shared<T> ("p", args...);
+    std::shared_ptr<optk::rng> r = std::make_shared<optk::rng> (1);
+    return [p, r] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            optkbench::keep (p->sample (*r));
+    };
+}
+
+OPTK_BENCHMARK ("sspace::randint/sample",
+        [] { return sample_body<sspace::randint> (0, 100); });
+OPTK_BENCHMARK ("sspace::uniform/sample",
+        [] { return sample_body<sspace::uniform> (-5., 5.); });
+OPTK_BENCHMARK ("sspace::quniform/sample",
+        [] { return sample_body<sspace::quniform> (-5., 5., .1); });
+OPTK_BENCHMARK ("sspace::loguniform/sample",
+        [] { return sample_body<sspace::loguniform> (1e-3, 1e3); });
+OPTK_BENCHMARK ("sspace::normal/sample",
+        [] { return sample_body<sspace::normal> (0., 1.); });
+OPTK_BENCHMARK ("sspace::lognormal/sample",
+        [] { return sample_body<sspace::lognormal> (0., 1.); });
+
+OPTK_BENCHMARK ("sspace::categorical/sample", [] {
+    std::shared_ptr<std::vector<std::string>> opts =
+        std::make_shared<std::vector<std::string>> (
+                std::vector<std::string> {"a", "b", "c", "d"});
+    std::shared_ptr<sspace::categorical<std::string>> p =
+        std::make_shared<sspace::categorical<std::string>> ("p", opts.get ());
+    std::shared_ptr<optk::rng> r = std::make_shared<optk::rng> (1);
+    return optkbench::body ([opts, p, r] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            optkbench::keep (p->sample (*r));
+    });
+});
+
+// validation -----------------------------------------------------------------
+
+OPTK_BENCHMARK ("sspace::validate_param_values/ackley1_10", [] {
+    std::shared_ptr<syn::ackley1> b = std::make_shared<syn::ackley1> (10);
+    std::shared_ptr<random_search> rs = std::make_shared<random_search> ();
+    rs->update_search_space (b->get_search_space ());
+    inst::set x = rs->generate_parameters (0);
+    return optkbench::body ([b, rs, x] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            sspace::validate_param_values (x->get_values (),
+                    b->get_search_space ());
+    });
+});
+
+OPTK_BENCHMARK ("sspace::compiled::validate/ackley1_10", [] {
+    std::shared_ptr<syn::ackley1> b = std::make_shared<syn::ackley1> (10);
+    std::shared_ptr<random_search> rs = std::make_shared<random_search> ();
+    rs->update_search_space (b->get_search_space ());
+    inst::set x = rs->generate_parameters (0);
+    std::shared_ptr<sspace::compiled> cs =
+        std::make_shared<sspace::compiled> (b->get_search_space ());
+    return optkbench::body ([b, rs, x, cs] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            cs->validate (x->get_values ());
+    });
+});
+
+// optimisers -----------------------------------------------------------------
+
+/**
+ * Times one generate/receive step of an optimiser on a benchmark, including
+ * the evaluation; exhausted optimisers are restarted.
+ */
+static optkbench::body
+step_body (std::shared_ptr<optk::optimiser> opt, std::shared_ptr<syn::synthetic> b)
+{
+    opt->seed (1);
+    opt->update_search_space (b->get_search_space ());
+    b->set_validation (false);
+    std::shared_ptr<int> id = std::make_shared<int> (0);
+    return [opt, b, id] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            inst::set x = opt->generate_parameters (*id);
+            if (x == NULL) {
+                opt->update_search_space (b->get_search_space ());
+                x = opt->generate_parameters (*id);
+            }
+            opt->receive_trial_results ((*id)++, x, b->evaluate (x));
+        }
+    };
+}
+
+OPTK_BENCHMARK ("gridsearch/step_ackley1_4", [] {
+    return step_body (std::make_shared<gridsearch> (),
+            std::make_shared<syn::ackley1> (4));
+});
+
+OPTK_BENCHMARK ("random_search/step_ackley1_10", [] {
+    return step_body (std::make_shared<random_search> (),
+            std::make_shared<syn::ackley1> (10));
+});
+
+OPTK_BENCHMARK ("qmc_search/step_sobol_ackley1_10", [] {
+    return step_body (std::make_shared<qmc_search> (),
+            std::make_shared<syn::ackley1> (10));
+});
+
+OPTK_BENCHMARK ("random_search/generate_parameters_10", [] {
+    std::shared_ptr<syn::ackley1> b = std::make_shared<syn::ackley1> (10);
+    std::shared_ptr<random_search> rs = std::make_shared<random_search> ();
+    rs->seed (1);
+    rs->update_search_space (b->get_search_space ());
+    return optkbench::body ([b, rs] (uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            inst::set x = rs->generate_parameters (0);
+            optkbench::keep (x);
+            rs->receive_trial_results (0, x, 0);
+        }
+    });
+});
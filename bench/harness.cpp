@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief The runner of the microbenchmark suite, which reports its results
+ * as JSON.
+ *
+ * Usage: optk_bench [--filter=SUBSTRING] [--min-time=SECONDS] [--out=FILE]
+ *
+ * Each benchmark is run for increasing numbers of iterations until one run
+ * lasts at least the minimum time, then repeated; the median (real_time) and
+ * fastest (fastest_time) times per iteration over the repetitions are
+ * reported, in a layout close to that of Google Benchmark's JSON output.
+ */
+
+#include <bench/harness.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+std::vector<optkbench::entry> &
+optkbench::registry ()
+{
+    static std::vector<entry> r;
+    return r;
+}
+
+/** @returns The time taken by n iterations of a body, in nanoseconds. */
+static double
+time_body (optkbench::body &b, uint64_t n)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now ();
+    b (n);
+    return std::chrono::duration<double, std::nano> (
+            std::chrono::steady_clock::now () - start).count ();
+}
+
+/** The result of one benchmark. */
+typedef struct {
+    std::string name;
+    uint64_t iterations;
+    double min_ns, median_ns;
+} result;
+
+static result
+run_one (const optkbench::entry &e, double min_time)
+{
+    const uint repetitions = 5;
+    optkbench::body b = e.setup ();
+
+    // calibrate the number of iterations per repetition
+    uint64_t n = 1;
+    double t;
+    while ((t = time_body (b, n)) < min_time * 1e9 / repetitions &&
+            n < (1ull << 40)) {
+        double scale = t > 0 ? min_time * 1e9 / repetitions / t : 10;
+        n = std::max (n + 1, (uint64_t) (n * std::min (scale * 1.2, 10.)));
+    }
+
+    std::vector<double> per_iter;
+    for (uint r = 0; r < repetitions; r++)
+        per_iter.push_back (time_body (b, n) / n);
+    std::sort (per_iter.begin (), per_iter.end ());
+
+    return { e.name, n, per_iter.front (), per_iter[repetitions / 2] };
+}
+
+/** Appends a string to a JSON document, quoted. */
+static void
+json_string (std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for (char c: s) {
+        if (c == '"' || c == '\\')
+            os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+
+static void
+write_json (std::ostream &os, const std::vector<result> &rs, double min_time)
+{
+    char date[32];
+    std::time_t now = std::time (NULL);
+    std::strftime (date, sizeof (date), "%FT%T%z", std::localtime (&now));
+
+    os << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n"
+       << "    \"num_cpus\": " << std::thread::hardware_concurrency () << ",\n"
+       << "    \"min_time\": " << min_time << "\n  },\n"
+       << "  \"benchmarks\": [";
+    for (size_t i = 0; i < rs.size (); i++) {
+        os << (i ? ",\n" : "\n") << "    {\"name\": ";
+        json_string (os, rs[i].name);
+        os << ", \"iterations\": " << rs[i].iterations
+           << ", \"real_time\": " << rs[i].median_ns
+           << ", \"fastest_time\": " << rs[i].min_ns
+           << ", \"time_unit\": \"ns\"}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+int
+main (int argc, char **argv)
+{
+    std::string filter, out;
+    double min_time = .5;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp (argv[i], "--filter=", 9)) {
+            filter = argv[i] + 9;
+        } else if (!strncmp (argv[i], "--min-time=", 11)) {
+            min_time = atof (argv[i] + 11);
+        } else if (!strncmp (argv[i], "--out=", 6)) {
+            out = argv[i] + 6;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter=SUBSTRING] "
+                "[--min-time=SECONDS] [--out=FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<result> rs;
+    for (const optkbench::entry &e: optkbench::registry ()) {
+        if (e.name.find (filter) == std::string::npos)
+            continue;
+        result r = run_one (e, min_time);
+        fprintf (stderr, "%-48s %12.1f ns %12llu iterations\n",
+                r.name.c_str (), r.median_ns,
+                (unsigned long long) r.iterations);
+        rs.push_back (r);
+    }
+
+    if (out.empty ()) {
+        write_json (std::cout, rs, min_time);
+    } else {
+        std::ofstream f (out);
+        if (!f) {
+            std::cerr << "Error: could not open '" << out << "'" << std::endl;
+            return 1;
+        }
+        write_json (f, rs, min_time);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Microbenchmarks of the evaluation of every synthetic benchmark.
+ */
+
+#include <bench/harness.hpp>
+
+#include <benchmarks/synthetic.hpp>
+#include <optimisers/random.hpp>
+
+/**
+ * Registers one benchmark per synthetic function (and number of dimensions),
+ * which evaluates a fixed random point without validation, as for trusted
+ * optimisers.
+ */
+static struct synthetic_benchmarks {
+    synthetic_benchmarks ()
+    {
+        syn::registry reg;
+        for (const syn::entry &e: *reg.entries ()) {
+            std::function<syn::synthetic *()> make = e.make;
+            optkbench::registry ().push_back ({
+                "syn::" + e.name + "/evaluate_" + std::to_string (e.dims) + "d",
+                [make] () -> optkbench::body {
+                    std::shared_ptr<syn::synthetic> b (make ());
+                    b->set_validation (false);
+                    std::shared_ptr<random_search> rs =
+                        std::make_shared<random_search> ();
+                    rs->seed (1);
+                    rs->update_search_space (b->get_search_space ());
+                    inst::set x = rs->generate_parameters (0);
+                    return [b, rs, x] (uint64_t n) {
+                        for (uint64_t i = 0; i < n; i++)
+                            optkbench::keep (b->evaluate (x));
+                    };
+                }
+            });
+        }
+    }
+} __synthetic_benchmarks;
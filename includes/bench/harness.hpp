@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A small microbenchmark harness for the framework's hot paths.
+ */
+
+#ifndef __HARNESS_H_
+#define __HARNESS_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace optkbench {
+
+/**
+ * The body of a microbenchmark, which performs the measured operation n
+ * times. Any setup should happen before it is returned, or outside the loop.
+ */
+typedef std::function<void(uint64_t n)> body;
+
+/** A registered microbenchmark. */
+typedef struct {
+    std::string name;
+    /** Performs any setup, and returns the body to be timed.               */
+    std::function<body()> setup;
+} entry;
+
+/** @returns All the registered microbenchmarks, in registration order. */
+std::vector<entry> &registry ();
+
+/** Registers a benchmark at static initialisation time. */
+class registrar {
+    public:
+        registrar (const std::string &name, std::function<body()> setup)
+        { registry ().push_back ({name, setup}); }
+};
+
+/**
+ * Prevents the compiler from optimising away the computation of a value.
+ * @param v The value to keep.
+ */
+template <typename T>
+inline void
+keep (T const &v)
+{
+    asm volatile ("" : : "r,m" (v) : "memory");
+}
+
+} // namespace optkbench
+
+#define __OPTKBENCH_CAT2(a, b) a ## b
+#define __OPTKBENCH_CAT(a, b) __OPTKBENCH_CAT2(a, b)
+
+/**
+ * Registers a microbenchmark; the setup (which may contain commas) is a
+ * callable returning an optkbench::body.
+ */
+#define OPTK_BENCHMARK(name, ...) \
+    static optkbench::registrar __OPTKBENCH_CAT(__optkbench_, __LINE__) \
+    (name, __VA_ARGS__)
+
+#endif // __HARNESS_H_
@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Vectorised kernels for the scalable synthetic benchmarks, with
+ * runtime selection of the instruction set.
+ */
+
+#ifndef __SIMD_H_
+#define __SIMD_H_
+
+#include <string>
+#include <sys/types.h>
+
+namespace syn {
+namespace simd {
+
+/**
+ * The instruction sets for which kernels are compiled. The scalar level
+ * disables the kernels altogether, so that the benchmarks use their plain
+ * C++ implementations.
+ */
+enum class level {
+    scalar,
+    avx2,
+    avx512
+};
+
+/**
+ * The synthetic functions which have vectorised kernels. These are the
+ * scalable functions which are reductions over their coordinates.
+ */
+enum class function {
+    ackley1,
+    alpine1,
+    alpine2,
+    brown,
+    chung_reynolds,
+    cosine_mixture,
+    deb1,
+    dixon_price,
+    exponential,
+    griewank
+};
+
+/**
+ * @returns a printable name for an instruction set level.
+ */
+std::string level_name (level l);
+
+/**
+ * @returns true if this binary has kernels for l and the CPU it is running on
+ * supports it.
+ */
+bool supported (level l);
+
+/**
+ * @returns the widest supported level; this is the level used by default.
+ */
+level best ();
+
+/**
+ * @returns the level currently used by evaluate and evaluate_batch.
+ */
+level active ();
+
+/**
+ * Selects the level used for all subsequent evaluations; this is mostly
+ * useful to compare the kernels against each other.
+ * @param l The level to use.
+ * @throws std::invalid_argument if l is not supported.
+ */
+void set_active (level l);
+
+/**
+ * Evaluates f at a single point, vectorising over its coordinates.
+ * @param f The function to evaluate.
+ * @param x The d coordinates of the point.
+ * @param d The number of dimensions.
+ * @param res The result is written here.
+ * @returns false if the active level is scalar, in which case res is left
+ * untouched and the caller should use its own implementation.
+ */
+bool evaluate (function f, const double *x, u_int d, double *res);
+
+/**
+ * Evaluates f at a batch of points, vectorising over the points. These are
+ * laid out as a structure of arrays: coordinate j of point i is x[j * n + i].
+ * @param f The function to evaluate.
+ * @param x The d by n matrix of points.
+ * @param d The number of dimensions.
+ * @param n The number of points.
+ * @param out The n results.
+ * @returns false if the active level is scalar, in which case out is left
+ * untouched.
+ */
+bool evaluate_batch (function f, const double *x, u_int d, u_int n, double *out);
+
+} // namespace simd
+} // namespace syn
+
+#endif // __SIMD_H_
@@ -23,20 +23,30 @@
 #ifndef __SYNTHETIC_H_
 #define __SYNTHETIC_H_
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <sys/types.h>
 #include <bits/stdint-intn.h>
 
 #include <optk/core.hpp>
 #include <optk/types.hpp>
 #include <optk/benchmark.hpp>
+#include <optk/threadpool.hpp>
 
 namespace syn {
 
+struct variant_spec;
+
 /**
  * This enumerates the properties of the functions in this benchmark.
  */
@@ -54,6 +64,45 @@ enum class properties: char {
     unimodal
 };
 
+/**
+ * A set of dimensions, for with_dims.
+ */
+template <u_int... Ns> struct dim_set {};
+
+/**
+ * The dimensions at which the kernels of the scalable functions are also
+ * compiled with their dimension as a constant, so that their loops over the
+ * coordinates have a known trip count and can be unrolled; these are the
+ * small dimensions at which the registry and most experiments run them.
+ */
+typedef dim_set<2, 3, 4, 5, 10, 15> fixed_dims;
+
+/**
+ * Calls a kernel with the dimension d: as a std::integral_constant if d is
+ * one of Ns, so that the kernel is instantiated for that constant, and as a
+ * plain u_int otherwise.
+ * @param f The kernel, a generic lambda which takes the dimension as its
+ * (auto) parameter and uses it, rather than m_dims, as its loop bounds.
+ * @returns The result of f.
+ */
+template <typename F, u_int... Ns>
+inline double
+with_dims (dim_set<Ns...>, u_int d, F &&f)
+{
+    double res = 0.;
+    bool fixed = ((d == Ns &&
+                (res = f (std::integral_constant<u_int, Ns> ()), true)) || ...);
+    return fixed ? res : f (d);
+}
+
+/** As above, for the fixed_dims. */
+template <typename F>
+inline double
+with_dims (u_int d, F &&f)
+{
+    return with_dims (fixed_dims (), d, std::forward<F> (f));
+}
+
 /**
  * Owing to the similarity of the structure, and subsequent exposition, of the
  * 175 functions in Jamil et al. 2013, we use this as base class for the
@@ -131,6 +180,47 @@ class synthetic: public optk::benchmark {
          * with; or the fixed dimension that the derived function can take. */
         u_int get_dims () { return m_dims; }
 
+        /**
+         * Evaluates the benchmark on a parameter set; this validates the
+         * set against the search space, and then calls evaluate_dense on the
+         * contiguous array of its values (see inst::node::dense).
+         * @param x The parameter values to evaluate the benchmark at.
+         * @throws std::invalid_argument when the parameter set instance is
+         * invalid.
+         */
+        double evaluate (inst::set x) override;
+
+        /**
+         * Evaluates the benchmark function itself.
+         * @param x The m_dims coordinates of the point to evaluate, in the
+         * order of the search space.
+         */
+        virtual double evaluate_dense (const double *x) = 0;
+
+        /**
+         * Evaluates a batch of points laid out as a structure of arrays (see
+         * optk::benchmark::evaluate_batch); this validates every coordinate
+         * against the search space and then calls evaluate_dense_batch.
+         * @param x The m_dims by n matrix of points.
+         * @param n The number of points.
+         * @param out The n results.
+         * @throws std::invalid_argument when any of the points is invalid.
+         */
+        void evaluate_batch (const double *x, u_int n, double *out) override;
+
+        /**
+         * Evaluates the benchmark function on a batch of points. The default
+         * implementation copies each point into a contiguous array and calls
+         * evaluate_dense; functions which are simple reductions over their
+         * coordinates override this with loops over the points that the
+         * compiler can vectorise.
+         * @param x The m_dims by n matrix of points; coordinate j of point i
+         * is x[j * n + i].
+         * @param n The number of points.
+         * @param out The n results.
+         */
+        virtual void evaluate_dense_batch (const double *x, u_int n, double *out);
+
         /**
          * This function validates that a set of parameter instances provided
          * to be evaluated is compatible with the search space.
@@ -157,6 +247,105 @@ class synthetic: public optk::benchmark {
         std::vector<properties> m_properties;
         inst::set opt_params;
         sspace::sspace_t m_sspace;
+
+    private:
+        /** Compiles m_sspace on first use, once derived constructors have
+         * finished with it. */
+        void compile_space ();
+
+        /** The compilation of m_sspace, against which values are validated. */
+        sspace::compiled m_compiled;
+        std::once_flag m_compile_once;
+};
+
+/**
+ * @param p A benchmark property.
+ * @returns The name of the property as used on the command line; for
+ * instance "non_separable" for properties::non_separable.
+ */
+std::string property_name (properties p);
+
+/**
+ * Parses the name of a property, as returned by property_name.
+ * @param n The name of the property.
+ * @param p Set to the matching property on success.
+ * @returns Whether n named a property.
+ */
+bool parse_property (const std::string &n, properties *p);
+
+/**
+ * An entry in the registry of synthetic benchmarks; this describes the
+ * benchmark without needing to instantiate it.
+ */
+typedef struct {
+    /** The name of the benchmark, as returned by benchmark::get_name        */
+    std::string name;
+    /** The number of dimensions the benchmark is constructed with           */
+    u_int dims;
+    /** The properties of the benchmark function                             */
+    std::vector<properties> props;
+    /** Constructs a new instance of the benchmark on the heap               */
+    std::function<synthetic *()> make;
+} entry;
+
+/**
+ * The registry holds a factory for every synthetic benchmark known to OPTK,
+ * along with its name, dimensions and properties, so that benchmarks can be
+ * enumerated, filtered and scheduled before any of them is constructed.
+ */
+class registry {
+    public:
+        /**
+         * The constructor registers all the synthetic benchmarks, in the
+         * order in which their results appear in the output.
+         */
+        registry ();
+
+        /**
+         * Registers a benchmark. The benchmark is instantiated once (and
+         * immediately freed) to find its name, dimensions and properties.
+         * @param args The arguments to the benchmark's constructor; usually
+         * nothing, or the number of dimensions for scalable functions.
+         */
+        template <class T, typename... Args>
+        void
+        add (Args... args)
+        {
+            std::function<synthetic *()> make =
+                [args...] () -> synthetic * { return new T (args...); };
+            synthetic *tmp = make ();
+            m_entries.push_back ({
+                    tmp->get_name (),
+                    tmp->get_dims (),
+                    tmp->get_properties (),
+                    make
+                    });
+            delete tmp;
+        }
+
+        /** @returns All the registered benchmarks. */
+        std::vector<entry> *entries () { return &m_entries; }
+
+        /**
+         * Selects a subset of the registered benchmarks from a comma-separated
+         * list of benchmark names and property names, such as
+         * "scalable,multimodal" or "ackley1,branin1". Spaces in benchmark
+         * names may be written as underscores.
+         *
+         * A benchmark is selected if it is named in the list, or if the list
+         * contains properties and the benchmark has all of them. An empty
+         * list selects every benchmark. The registration order is preserved.
+         *
+         * @param spec The list of names and properties.
+         * @returns The selected entries.
+         * @exception std::invalid_argument if an element of the list is
+         * neither a property nor the name of a benchmark, or if nothing is
+         * selected.
+         */
+        std::vector<entry> select (const std::string &spec);
+
+    private:
+        std::vector<entry> m_entries;
 };
 
 /**
@@ -165,17 +354,54 @@ class synthetic: public optk::benchmark {
  */
 class synthetic_benchmark: public optk::benchmark_set {
     public:
-        synthetic_benchmark ();
+        /**
+         * The constructor.
+         * @param spec Selects the benchmarks to run; see registry::select.
+         * @exception std::invalid_argument on an invalid selection.
+         */
+        synthetic_benchmark (const std::string &spec = "");
+
+        ~synthetic_benchmark ();
+
+        /**
+         * Runs variants of the selected benchmarks rather than the
+         * benchmarks themselves (see syn::variant).
+         * @param v The variant's settings.
+         */
+        void set_variant (const variant_spec &v);
 
-        ~synthetic_benchmark () {}
+        uint size () override { return m_selected.size (); }
+
+        std::string benchmark_name (uint j) override;
+
+        std::vector<std::string> benchmark_properties (uint j) override;
 
         /**
-         * provided with an optimisation algorithm, this will run
-         * through all the synthetic benchmarks (perhaps in parallel) and evaluate the
-         * performance of the optimisation algorithm on this (e.g. calculating traces,
-         * AUC etc.)
+         * Runs a new instance of the j-th selected benchmark, in the core
+         * loop chosen by ctx: batched, asynchronous or sequential. The
+         * asynchronous loop always has trials pending, so it is never saved
+         * into prog; optk refuses to checkpoint asynchronous sweeps. The
+         * noise of a variant is drawn from the id of each trial combined
+         * with seed, the seed of the run. Summaries are measured against the
+         * benchmark's known optimum.
          */
-        void run (optk::optimisers *opts, optk::ctx_t *ctx) override;
+        void run_one (
+                uint j,
+                optk::optimiser *opt,
+                optk::trace &tr,
+                optk::ctx_t *ctx,
+                optk::thread_pool *pool,
+                optk::progress *prog,
+                uint64_t seed) override;
+
+        /** @returns The benchmarks selected to be run. */
+        std::vector<entry> *selected () { return &m_selected; }
+
+    private:
+        registry m_registry;
+        std::vector<entry> m_selected;
+        /** The variant to run, or NULL for the benchmarks themselves.      */
+        std::unique_ptr<variant_spec> m_variant;
 };
 
 /**
@@ -195,7 +421,8 @@ class ackley1: public synthetic {
         /** The constructor for the ackley1 function.
          * @param d The number of dimensions for this problem. */
         ackley1 (int d);
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -212,7 +439,7 @@ class ackley1: public synthetic {
 class ackley2: public synthetic {
     public:
         ackley2 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -228,7 +455,7 @@ class ackley2: public synthetic {
 class ackley3: public synthetic {
     public:
         ackley3 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -245,7 +472,7 @@ class ackley3: public synthetic {
 class adjiman: public synthetic {
     public:
         adjiman ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -260,7 +487,8 @@ class adjiman: public synthetic {
 class alpine1: public synthetic {
     public:
         alpine1 (int dims);
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -275,7 +503,8 @@ class alpine1: public synthetic {
 class alpine2: public synthetic {
     public:
         alpine2 (int dims);
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -298,7 +527,7 @@ class alpine2: public synthetic {
 class brad: public synthetic {
     public:
         brad ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -313,7 +542,7 @@ class brad: public synthetic {
 class bartels_conn: public synthetic {
     public:
         bartels_conn ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -330,7 +559,7 @@ class bartels_conn: public synthetic {
 class beale: public synthetic {
     public:
         beale ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -346,7 +575,7 @@ class beale: public synthetic {
 class biggs_exp2: public synthetic {
     public:
         biggs_exp2 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -363,7 +592,7 @@ class biggs_exp2: public synthetic {
 class biggs_exp3: public synthetic {
     public:
         biggs_exp3 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -380,7 +609,7 @@ class biggs_exp3: public synthetic {
 class biggs_exp4: public synthetic {
     public:
         biggs_exp4 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -396,7 +625,7 @@ class biggs_exp4: public synthetic {
 class biggs_exp5: public synthetic {
     public:
         biggs_exp5 ();
-        double evaluate(inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -412,7 +641,7 @@ class biggs_exp5: public synthetic {
 class biggs_exp6: public synthetic {
     public:
         biggs_exp6 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -430,7 +659,7 @@ class biggs_exp6: public synthetic {
 class bird: public synthetic {
     public:
         bird ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -445,7 +674,7 @@ class bird: public synthetic {
 class bohachevsky1: public synthetic {
     public:
         bohachevsky1 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -460,7 +689,7 @@ class bohachevsky1: public synthetic {
 class bohachevsky2: public synthetic {
     public:
         bohachevsky2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -474,7 +703,7 @@ class bohachevsky2: public synthetic {
 class bohachevsky3: public synthetic {
     public:
         bohachevsky3 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -488,7 +717,7 @@ class bohachevsky3: public synthetic {
 class booth: public synthetic {
     public:
         booth ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -508,7 +737,7 @@ class booth: public synthetic {
 class box_betts: public synthetic {
     public:
         box_betts ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -525,7 +754,7 @@ class box_betts: public synthetic {
 class branin1: public synthetic {
     public:
         branin1 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -542,7 +771,7 @@ class branin1: public synthetic {
 class branin2: public synthetic {
     public:
         branin2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -556,7 +785,7 @@ class branin2: public synthetic {
 class brent: public synthetic {
     public:
         brent ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -571,7 +800,8 @@ class brent: public synthetic {
 class brown: public synthetic {
     public:
         brown (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -586,7 +816,7 @@ class brown: public synthetic {
 class bukin2: public synthetic {
     public:
         bukin2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -601,7 +831,7 @@ class bukin2: public synthetic {
 class bukin4: public synthetic {
     public:
         bukin4 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -617,7 +847,7 @@ class bukin4: public synthetic {
 class bukin6: public synthetic {
     public:
         bukin6 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -631,7 +861,7 @@ class bukin6: public synthetic {
 class camel3: public synthetic {
     public:
         camel3 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -648,7 +878,7 @@ class camel3: public synthetic {
 class camel6: public synthetic {
     public:
         camel6 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 // We omit the chen* functions on the basis that they are difficult to
@@ -670,7 +900,7 @@ class camel6: public synthetic {
 class chichinadze: public synthetic {
     public:
         chichinadze ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -684,7 +914,8 @@ class chichinadze: public synthetic {
 class chung_reynolds: public synthetic {
     public:
         chung_reynolds (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -729,7 +960,7 @@ class chung_reynolds: public synthetic {
 class cola: public synthetic {
     public:
         cola ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -748,7 +979,7 @@ class cola: public synthetic {
 class colville: public synthetic {
     public:
         colville ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -779,7 +1010,7 @@ class colville: public synthetic {
 class corana: public synthetic {
     public:
         corana ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -794,7 +1025,7 @@ class corana: public synthetic {
 class cosine_mixture2: public synthetic {
     public:
         cosine_mixture2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -809,7 +1040,8 @@ class cosine_mixture2: public synthetic {
 class cosine_mixture: public synthetic {
     public:
         cosine_mixture (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -826,7 +1058,7 @@ class cosine_mixture: public synthetic {
 class cross_in_tray: public synthetic {
     public:
         cross_in_tray ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -843,7 +1075,7 @@ class cross_in_tray: public synthetic {
 class csendes: public synthetic {
     public:
         csendes (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -857,7 +1089,7 @@ class csendes: public synthetic {
 class cube: public synthetic {
     public:
         cube ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 
@@ -877,7 +1109,7 @@ class cube: public synthetic {
 class damavandi: public synthetic {
     public:
         damavandi ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -892,7 +1124,8 @@ class damavandi: public synthetic {
 class deb1: public synthetic {
     public:
         deb1 (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -908,7 +1141,7 @@ class deb1: public synthetic {
 class deb2: public synthetic {
     public:
         deb2 (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -926,7 +1159,7 @@ class deb2: public synthetic {
 class deckkers_aarts: public synthetic {
     public:
         deckkers_aarts ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -948,7 +1181,7 @@ class deckkers_aarts: public synthetic {
 class devillers_glasser1: public synthetic {
     public:
         devillers_glasser1 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -972,7 +1205,7 @@ class devillers_glasser2: public synthetic {
          * FIXME improve floating point calculation accuracy for function
          * evaluations
          */
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -987,7 +1220,8 @@ class devillers_glasser2: public synthetic {
 class dixon_price: public synthetic {
     public:
         dixon_price (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -1004,7 +1238,7 @@ class dixon_price: public synthetic {
 class dolan: public synthetic {
     public:
         dolan ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1031,7 +1265,7 @@ class dolan: public synthetic {
 class deceptive: public synthetic {
     public:
         deceptive (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1047,7 +1281,7 @@ class deceptive: public synthetic {
 class deflected_corrugated_spring: public synthetic {
     public:
         deflected_corrugated_spring (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1062,7 +1296,7 @@ class deflected_corrugated_spring: public synthetic {
 class drop_wave: public synthetic {
     public:
         drop_wave ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1077,7 +1311,7 @@ class drop_wave: public synthetic {
 class easom: public synthetic {
     public:
         easom ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1091,7 +1325,7 @@ class easom: public synthetic {
 class egg_crate: public synthetic {
     public:
         egg_crate ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1108,7 +1342,7 @@ class egg_crate: public synthetic {
 class egg_holder: public synthetic {
     public:
         egg_holder ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1124,7 +1358,7 @@ class egg_holder: public synthetic {
 class el_attar_vidyasagar_dutta: public synthetic {
     public:
         el_attar_vidyasagar_dutta ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1139,7 +1373,8 @@ class el_attar_vidyasagar_dutta: public synthetic {
 class exponential: public synthetic {
     public:
         exponential (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -1156,7 +1391,7 @@ class exponential: public synthetic {
 class exp2: public synthetic {
     public:
         exp2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1177,7 +1412,7 @@ class exp2: public synthetic {
 class franke: public synthetic {
     public:
         franke ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1192,7 +1427,7 @@ class franke: public synthetic {
 class freudenstein_roth: public synthetic {
     public:
         freudenstein_roth ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1210,7 +1445,7 @@ class freudenstein_roth: public synthetic {
 class gear: public synthetic {
     public:
         gear ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1228,7 +1463,7 @@ class gear: public synthetic {
 class giunta: public synthetic {
     public:
         giunta ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1251,7 +1486,7 @@ class giunta: public synthetic {
 class goldstein_price: public synthetic {
     public:
         goldstein_price ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1266,7 +1501,8 @@ class goldstein_price: public synthetic {
 class griewank: public synthetic {
     public:
         griewank (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
+        void evaluate_dense_batch (const double *x, u_int n, double *out) override;
 };
 
 /**
@@ -1288,7 +1524,7 @@ class griewank: public synthetic {
 class gulf: public synthetic {
     public:
         gulf ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1304,7 +1540,7 @@ class gulf: public synthetic {
 class hansen: public synthetic {
     public:
         hansen ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1336,7 +1572,7 @@ class hansen: public synthetic {
 class hartman3: public synthetic {
     public:
         hartman3 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1374,7 +1610,7 @@ class hartman3: public synthetic {
 class hartman6: public synthetic {
     public:
         hartman6 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1396,7 +1632,7 @@ class hartman6: public synthetic {
 class helical_valley: public synthetic {
     public:
         helical_valley ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1411,7 +1647,7 @@ class helical_valley: public synthetic {
 class himmelblau: public synthetic {
     public:
         himmelblau ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1428,7 +1664,7 @@ class himmelblau: public synthetic {
 class holder_table: public synthetic {
     public:
         holder_table ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1446,7 +1682,7 @@ class holder_table: public synthetic {
 class hosaki: public synthetic {
     public:
         hosaki ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1461,7 +1697,7 @@ class hosaki: public synthetic {
 class jennrich_sampson: public synthetic {
     public:
         jennrich_sampson ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1492,7 +1728,7 @@ class jennrich_sampson: public synthetic {
 class judge: public synthetic {
     public:
         judge ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1516,7 +1752,7 @@ class judge: public synthetic {
 class langermann2: public synthetic {
     public:
         langermann2 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1547,7 +1783,7 @@ class langermann2: public synthetic {
 class langermann5: public synthetic {
     public:
         langermann5 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1571,7 +1807,7 @@ class langermann5: public synthetic {
 class lennard_jones: public synthetic {
     public:
         lennard_jones ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1587,7 +1823,7 @@ class lennard_jones: public synthetic {
 class keane: public synthetic {
     public:
         keane ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1601,7 +1837,7 @@ class keane: public synthetic {
 class leon: public synthetic {
     public:
         leon ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1622,7 +1858,7 @@ class leon: public synthetic {
 class levy3: public synthetic {
     public:
         levy3 (int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1639,7 +1875,7 @@ class levy3: public synthetic {
 class levy5: public synthetic {
     public:
         levy5 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1655,7 +1891,7 @@ class levy5: public synthetic {
 class levy13: public synthetic {
     public:
         levy13 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1669,7 +1905,7 @@ class levy13: public synthetic {
 class matyas: public synthetic {
     public:
         matyas ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -1685,7 +1921,7 @@ class matyas: public synthetic {
 class mccormick: public synthetic {
     public:
         mccormick ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /** This is a more compact way of passing the regression problem dimensions. */
@@ -1736,7 +1972,7 @@ class regression: public synthetic {
 
         virtual void kernel (double *xs, double *ret) = 0;
 
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 
     protected:
         /**
@@ -2669,7 +2905,7 @@ class court28: public regression {
 class michalewicz02: public synthetic {
     public:
         michalewicz02 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2687,7 +2923,7 @@ class michalewicz02: public synthetic {
 class michalewicz06: public synthetic {
     public:
         michalewicz06 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2706,7 +2942,7 @@ class michalewicz06: public synthetic {
 class michalewicz12: public synthetic {
     public:
         michalewicz12 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2721,7 +2957,7 @@ class michalewicz12: public synthetic {
 class miele_cantrell: public synthetic {
     public:
         miele_cantrell();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2739,7 +2975,7 @@ class miele_cantrell: public synthetic {
 class mishra01: public synthetic {
     public:
         mishra01(int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2757,7 +2993,7 @@ class mishra01: public synthetic {
 class mishra02: public synthetic {
     public:
         mishra02(int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2773,7 +3009,7 @@ class mishra02: public synthetic {
 class mishra03: public synthetic {
     public:
         mishra03();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2789,7 +3025,7 @@ class mishra03: public synthetic {
 class mishra04: public synthetic {
     public:
         mishra04();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2808,7 +3044,7 @@ class mishra04: public synthetic {
 class mishra05: public synthetic {
     public:
         mishra05();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2828,7 +3064,7 @@ class mishra05: public synthetic {
 class mishra06: public synthetic {
     public:
         mishra06();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 // We exclude the mishra 07 (factorial function) for reasons of computational
@@ -2854,7 +3090,7 @@ class mishra06: public synthetic {
 class mishra08: public synthetic {
     public:
         mishra08();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2876,7 +3112,7 @@ class mishra08: public synthetic {
 class mishra09: public synthetic {
     public:
         mishra09();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2892,7 +3128,7 @@ class mishra09: public synthetic {
 class mishra10: public synthetic {
     public:
         mishra10();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2910,7 +3146,7 @@ class mishra10: public synthetic {
 class mishra11: public synthetic {
     public:
         mishra11(int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2926,7 +3162,7 @@ class mishra11: public synthetic {
 class manifoldmin: public synthetic {
     public:
         manifoldmin(int dims);
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 /**
@@ -2941,7 +3177,7 @@ class manifoldmin: public synthetic {
 class mog01: public synthetic {
     public:
         mog01 ();
-        double evaluate (inst::set x) override;
+        double evaluate_dense (const double *x) override;
 };
 
 // pick up from f85. in jamil et al
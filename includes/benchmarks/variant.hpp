@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Noisy, costly and multi-fidelity variants of the synthetic
+ * benchmarks.
+ */
+
+#ifndef __VARIANT_H_
+#define __VARIANT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <benchmarks/synthetic.hpp>
+#include <optk/types.hpp>
+
+namespace syn {
+
+/** How the latency of an evaluation is simulated. */
+enum class latency: char {
+    /** The cost is only reported, so that sweeps run at full speed.       */
+    none,
+    /** The evaluating thread sleeps for the cost, in seconds.             */
+    sleep,
+    /** The evaluating thread spins for the cost, keeping its core busy.   */
+    spin
+};
+
+/**
+ * The description of a variant, as parsed by parse_variant. A default spec
+ * describes no variant at all.
+ */
+struct variant_spec {
+    /** The standard deviation of the Gaussian noise added to each value    */
+    double noise = 0.;
+    /** The cost, in seconds, of an evaluation at full fidelity             */
+    double cost = 0.;
+    /** The relative spread of the costs of different points, in [0, 1)     */
+    double jitter = 0.;
+    /** The lowest fidelity which may be asked for, or 0 for a fixed one    */
+    double fidelity = 0.;
+    /** The amplitude of the error of an evaluation at fidelity 0           */
+    double bias = 1.;
+    /** How the cost is simulated                                           */
+    latency wait = latency::none;
+};
+
+/**
+ * Parses a variant from a comma-separated list of settings, such as
+ * "noise=0.1,cost=0.002,jitter=0.5,fidelity=0.1,wait=sleep", where the
+ * keys are those of variant_spec. An empty string is the default spec.
+ * @param s The settings.
+ * @returns The variant.
+ * @exception std::invalid_argument on an unknown key or invalid value.
+ */
+variant_spec parse_variant (const std::string &s);
+
+/** @returns Whether a spec changes the benchmarks at all. */
+bool is_variant (const variant_spec &v);
+
+/**
+ * A synthetic benchmark made noisy, costly or multi-fidelity, to stand in
+ * for the expensive and stochastic objectives which optimisers are used on.
+ *
+ * With noise, each evaluation adds a draw from \f$\mathcal{N}(0,
+ * \sigma^2)\f$. The draws are reproducible: that of an evaluation depends
+ * only on the run's seed, the point and an index. In the core loops, the
+ * index is the id of the trial (see optk::benchmark::trial), so that runs
+ * with the same seed agree regardless of batching, threading or resumption;
+ * elsewhere, it is the number of earlier evaluations by the variant.
+ *
+ * With a cost, evaluating point x is reported (see optk::benchmark::cost) to
+ * cost \f$c\,s\,(1 + j(2u_x - 1))\f$, where c is the cost at full fidelity,
+ * s the fidelity, j the jitter and \f$u_x \in [0, 1)\f$ is hashed from the
+ * coordinates of x other than its fidelity, so that the same point always
+ * costs the same, in proportion to its fidelity. The cost may also be waited
+ * for, as latency.
+ *
+ * With a fidelity, the search space gains a parameter "fidelity" in
+ * \f$[s_0, 1]\f$, and an evaluation at fidelity s returns
+ * \f$f(x) + (1 - s)\,b\,D^{-1}\sum_{i=1}^D \cos(x_i)\f$: a smooth error which
+ * vanishes at full fidelity, where the benchmark is unchanged.
+ */
+class variant: public optk::benchmark {
+    public:
+        /**
+         * The constructor.
+         * @param base The benchmark to vary, which the variant then owns.
+         * @param spec The variant's settings.
+         * @param seed The seed of the run, from which the noise is drawn.
+         */
+        variant (synthetic *base, const variant_spec &spec, uint64_t seed);
+
+        ~variant ();
+
+        sspace::sspace_t *get_search_space () override { return &m_sspace; }
+
+        /** @throws std::invalid_argument when x is invalid. */
+        double evaluate (inst::set x) override;
+
+        /** The coordinates of the points are those of the base benchmark,
+         * followed by the fidelity, if any. */
+        void evaluate_batch (const double *x, u_int n, double *out) override;
+
+        double cost (inst::set x) override;
+
+        /** @returns The value of the base benchmark at x. */
+        double exact (inst::set x, double v) override;
+
+        /** @returns The benchmark which is varied. */
+        synthetic *base () { return m_base; }
+
+    private:
+        /** @returns The noise and bias to add to a value at point x and
+         * fidelity s; k is the hash of the point, and n the index of the
+         * evaluation, if it is noisy. */
+        double offset (uint64_t k, uint64_t n, const double *x, u_int stride,
+                double s);
+
+        /** @returns The index of the next evaluation, reserving those of
+         * the n evaluations of a batch; see the class. */
+        uint64_t index (u_int n = 1);
+
+        /** @returns The cost of point x at fidelity s. */
+        double cost_of (const double *x, u_int stride, double s);
+
+        /** Waits for a cost, as the spec says. */
+        void wait (double secs);
+
+        synthetic *m_base;
+        const variant_spec m_spec;
+        const uint64_t m_seed;
+        u_int m_dims;
+
+        /** The base benchmark's space, and the fidelity, if any.           */
+        sspace::sspace_t m_sspace;
+        sspace::uniform *m_fidelity;
+        sspace::compiled m_compiled;
+
+        /** The number of evaluations made outside the core loops.          */
+        std::atomic<uint64_t> m_evals;
+};
+
+} // namespace syn
+
+#endif // __VARIANT_H_
@@ -23,47 +23,465 @@
 #define __GP_H_
 
 #include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 #include <optk/optimiser.hpp>
 #include <optk/types.hpp>
+#include <optimisers/qmc.hpp>
+
+namespace __gp {
+
+/** The acquisition functions which the GP optimiser may maximise. */
+enum class acquisition: char {
+    /** Expected improvement over the best observed value. */
+    ei,
+    /** The (negated) lower confidence bound, mu - beta * sigma. */
+    ucb
+};
+
+/** The surrogate models available to the GP optimiser. */
+enum class mode: char {
+    /** An exact GP over all observations. */
+    exact,
+    /** A sparse GP with a fixed set of inducing inputs. */
+    sparse,
+    /** An exact GP over the neighbourhood of the incumbent, searched within
+     * a trust region which grows on success and shrinks on failure. */
+    local
+};
+
+/**
+ * A lower-triangular Cholesky factor, stored in packed row-major order (row i
+ * holds i+1 entries starting at offset i(i+1)/2) so that it can grow by one
+ * row per observation without moving the existing entries.
+ */
+class cholesky {
+    public:
+
+        cholesky (): m_n (0) {}
+
+        /** @returns The number of rows in the factor. */
+        u_int size () { return m_n; }
+
+        /** @returns A pointer to the first element of row i. */
+        double *row (u_int i) { return m_rows.data () + (size_t) i * (i + 1) / 2; }
+
+        /**
+         * Extends the factor of K to that of [[K, k], [k^T, kxx]] in O(n^2).
+         * This solves L l = k and sets the new diagonal element to
+         * sqrt(kxx - l^T l), clamped away from zero for (near) duplicates.
+         *
+         * @param k The covariances with the existing points (n values).
+         * @param kxx The prior variance of the new point.
+         */
+        void append (const double *k, double kxx);
+
+        /** Solves L x = b in place, for b of length size(). */
+        void forward (double *b);
+
+        /** Solves L^T x = b in place, for b of length size(). */
+        void backward (double *b);
+
+        /**
+         * Solves L X = B in place for width right-hand sides at once, where
+         * B is stored row-major (B[i * width + j]) so that each row of L is
+         * streamed from memory once per block rather than once per
+         * right-hand side.
+         */
+        void forward_multi (double *b);
+
+        /** The number of right-hand sides solved by forward_multi. */
+        static constexpr u_int width = 32;
+
+        /** Empties the factor. */
+        void clear () { m_rows.clear (); m_n = 0; }
+
+        /** Appends the factor to a snapshot (see optk::optimiser::save). */
+        void save (std::string *out);
+
+        /** Restores a factor written by save, from in at *off. */
+        void restore (const std::string &in, size_t *off);
+
+    private:
+        std::vector<double> m_rows;
+        u_int m_n;
+};
+
+/**
+ * The interface shared by the GP optimiser's surrogate models, which all
+ * work on the unit hypercube and keep track of the incumbent.
+ */
+class surrogate {
+    public:
+
+        /** @param d The input dimension. */
+        surrogate (u_int d): m_d (d), m_best (INFINITY), m_argbest (d, .5) {}
+
+        virtual ~surrogate () {}
+
+        /** @returns The number of observations. */
+        virtual u_int size () = 0;
+
+        /**
+         * Adds an observation.
+         * @param x The input, as d values in [0, 1].
+         * @param y The observed output.
+         */
+        virtual void add (const double *x, double y) = 0;
+
+        /**
+         * Computes the posterior mean and variance at m inputs.
+         *
+         * @param xs The m inputs, stored row-major (xs[j * d + k]).
+         * @param m The number of inputs.
+         * @param mu Receives the m posterior means.
+         * @param var Receives the m posterior variances.
+         */
+        virtual void predict (
+                const double *xs,
+                u_int m,
+                double *mu,
+                double *var
+                ) = 0;
+
+        /**
+         * @returns The number of points predictions are conditioned on,
+         * which determines their cost.
+         */
+        virtual u_int rank () { return size (); }
+
+        /** @returns The input dimension. */
+        u_int dims () { return m_d; }
+
+        /** @returns The smallest observed output. */
+        double best () { return m_best; }
+
+        /** @returns The input at which best() was observed. */
+        const double *argbest () { return m_argbest.data (); }
+
+        /**
+         * Appends the observations, and whatever has been factorised from
+         * them, to a snapshot; caches which predict rebuilds are left out.
+         */
+        virtual void save (std::string *out);
+
+        /** Restores a model of the same kind written by save. */
+        virtual void restore (const std::string &in, size_t *off);
+
+    protected:
+
+        /** Updates the incumbent; to be called by add. */
+        void record (const double *x, double y);
+
+        const u_int m_d;
+        double m_best;
+        std::vector<double> m_argbest;
+};
+
+/**
+ * An exact Gaussian process with a Matern 5/2 kernel on the unit hypercube.
+ *
+ * Observations are added one at a time, each extending the Cholesky factor
+ * of the kernel matrix by a single row; the outputs are standardised at
+ * prediction time, which only requires two O(n^2) triangular solves.
+ */
+class model: public surrogate {
+    public:
+
+        /**
+         * @param d The input dimension.
+         * @param lengthscale The kernel lengthscale (in unit-cube coordinates).
+         * @param noise The observation noise variance, relative to the
+         * standardised output variance.
+         */
+        model (u_int d, double lengthscale, double noise);
+
+        u_int size () override { return m_chol.size (); }
+
+        /** Adds an observation in O(n^2). */
+        void add (const double *x, double y) override;
+
+        /**
+         * The candidates are processed in fixed-size blocks; for each block
+         * the cross covariances are built and solved against L together.
+         */
+        void predict (
+                const double *xs,
+                u_int m,
+                double *mu,
+                double *var
+                ) override;
+
+        /** Removes all observations. */
+        void clear ();
+
+        void save (std::string *out) override;
+
+        void restore (const std::string &in, size_t *off) override;
+
+        /** The number of candidates handled together by predict. */
+        static constexpr u_int block = cholesky::width;
+
+    private:
+
+        /** Recomputes the standardised weights K^{-1} (y - mean) / scale. */
+        void update_weights ();
+
+        const double m_ls, m_noise;
+
+        /** Observed inputs, row-major, and outputs. */
+        std::vector<double> m_x, m_y;
+
+        cholesky m_chol;
+
+        std::vector<double> m_alpha;
+        bool m_alpha_valid;
+        double m_mean, m_scale;
+};
+
+/**
+ * A sparse (FITC) Gaussian process, whose inducing inputs are the first m
+ * observations; until there are that many the model is exact.
+ *
+ * With Kmm = L L^T, each later observation contributes v = L^{-1} k_i to
+ * B = I + sum_i v v^T / lambda_i, where lambda_i = 1 + noise - |v|^2 is the
+ * FITC diagonal correction. Adding an observation then costs O(m^2) and
+ * nothing but B and two vectors is stored, so the cost of an iteration does
+ * not depend on the number of observations.
+ */
+class sparse_model: public surrogate {
+    public:
+
+        /**
+         * @param d The input dimension.
+         * @param m The number of inducing inputs.
+         * @param lengthscale The kernel lengthscale.
+         * @param noise The relative observation noise variance.
+         */
+        sparse_model (u_int d, u_int m, double lengthscale, double noise);
+
+        u_int size () override { return m_n; }
+
+        u_int rank () override { return std::min (m_n, m_m); }
+
+        /** Adds an observation in O(m^2). */
+        void add (const double *x, double y) override;
+
+        /** Costs O(m^2) per input, plus O(m^3) after any addition. */
+        void predict (
+                const double *xs,
+                u_int m,
+                double *mu,
+                double *var
+                ) override;
+
+        /** @returns Whether the inducing inputs have been fixed. */
+        bool sparse () { return !m_z.empty (); }
+
+        void save (std::string *out) override;
+
+        void restore (const std::string &in, size_t *off) override;
+
+    private:
+
+        /** Fixes the inducing inputs, moving the exact model's data over. */
+        void freeze ();
+
+        /** Adds an observation once the inducing inputs are fixed. */
+        void accumulate (const double *x, double y);
+
+        const u_int m_m;
+        const double m_ls, m_noise;
+        u_int m_n;
+
+        /** Observations until the inducing inputs are fixed. */
+        model m_exact;
+        std::vector<double> m_x0, m_y0;
+
+        /** The inducing inputs and the factor of their kernel matrix. */
+        std::vector<double> m_z;
+        cholesky m_lmm;
+
+        /** B (dense, row-major), sum v y / lambda and sum v / lambda. */
+        std::vector<double> m_b, m_cy, m_c1;
+
+        /** The factor of B and the standardised weights B^{-1} c. */
+        cholesky m_lb;
+        std::vector<double> m_w;
+        bool m_valid;
+
+        /** Running sums of the outputs, for standardisation. */
+        double m_sy, m_syy, m_mean, m_scale;
+};
+
+/**
+ * A local Gaussian process: an exact model fitted to the observations
+ * nearest to the incumbent, refitted whenever the data changes.
+ *
+ * All observations are stored (O(n d) memory), and selecting the
+ * neighbourhood is O(n d), so the cost of an iteration grows linearly with
+ * the number of observations.
+ */
+class local_model: public surrogate {
+    public:
+
+        /**
+         * @param d The input dimension.
+         * @param k The number of neighbours to fit to.
+         * @param lengthscale The kernel lengthscale.
+         * @param noise The relative observation noise variance.
+         */
+        local_model (u_int d, u_int k, double lengthscale, double noise);
+
+        u_int size () override { return m_y.size (); }
+
+        u_int rank () override { return std::min (size (), m_k); }
+
+        void add (const double *x, double y) override;
+
+        void predict (
+                const double *xs,
+                u_int m,
+                double *mu,
+                double *var
+                ) override;
+
+        /** Only the observations are saved; the local fit is redone. */
+        void save (std::string *out) override;
+
+        void restore (const std::string &in, size_t *off) override;
+
+    private:
+
+        const u_int m_k;
+        std::vector<double> m_x, m_y;
+
+        model m_local;
+        bool m_valid;
+};
+
+} // end namespace __gp
 
 /**
  * gp_opt is a generic Gaussian process-based optimiser which is only
  * implemented to provide a baseline against other methods.
+ *
+ * After a small (scrambled Sobol) initial design, each new parameter set maximises the
+ * acquisition function over the unit hypercube onto which the search space
+ * is mapped, starting a local search from the most promising of a set of
+ * random and perturbed-incumbent candidates.
+ *
+ * The exact surrogate costs O(n^2) per iteration and memory; for long runs
+ * the sparse and local modes keep both constant or linear in the number of
+ * observations.
  */
 class gp_opt: public optk::optimiser {
 
     public:
 
-        gp_opt();
+        /**
+         * @param acq The acquisition function to maximise.
+         * @param m The surrogate model to use.
+         */
+        gp_opt (
+                __gp::acquisition acq = __gp::acquisition::ei,
+                __gp::mode m = __gp::mode::exact
+                );
+
+        ~gp_opt ();
+
+        /** @returns A new GP optimiser with the same acquisition and mode. */
+        optk::optimiser *clone () override { return new gp_opt (m_acq, m_mode); }
+
+        /** Every value the GP optimiser generates lies within bounds. */
+        bool trusted () override { return true; }
 
         /**
          * The GP optimiser is only compatible with continuous valued inputs
          * (for the moment); conceretely an error will be raised if the input
          * is not pt::uniform, pt::loguniform, pt::normal, pt::lognormal.
-         * Currently all parameter types are treated as pt::uniform, although
-         * in the future information about parameters' distributions may be
-         * taken into account.
+         * Uniform parameters are mapped linearly onto [0, 1], loguniform
+         * parameters in log space, and (log)normal parameters onto the
+         * interval mu +/- 3 sigma.
          * @param space The new search space.
          */
         void update_search_space (sspace::sspace_t *space) override;
 
         inst::set generate_parameters (int param_id) override;
 
+        /**
+         * Generates a batch with the constant liar heuristic: once a point is
+         * chosen, the model is told that it scored the incumbent's value, so
+         * that the next maximum of the acquisition function lies elsewhere.
+         * The model is restored once the batch is complete, leaving only the
+         * real results to be added by receive_batch.
+         */
+        uint generate_batch (
+            int first_id,
+            uint k,
+            std::vector<inst::set> *out
+        ) override;
+
         void receive_trial_results (
                 int param_id,
                 inst::set params,
                 double value
                 ) override;
 
+        /**
+         * Saves the surrogate with its factorisations, the trust region and
+         * the position in the initial design, so that a resumed run need
+         * not refit the model.
+         */
+        bool save (std::string *out) override;
+
+        void restore (const std::string &in) override;
+
     private:
 
+        /** Maps a value of the i-th parameter onto [0, 1]. */
+        double to_unit (u_int i, double v);
+
+        /** Maps a point in [0, 1] back onto the i-th parameter. */
+        double from_unit (u_int i, double u);
+
+        /** Maximises the acquisition function, writing the result into x. */
+        void maximise_acquisition (double *x);
+
+        /** Evaluates the acquisition function at m unit-cube points. */
+        void acquire (const double *xs, u_int m, double *out);
+
+        /** Adapts the trust region after an observation (local mode). */
+        void update_trust_region (bool improved);
+
+        /** The number of space-filling parameter sets before the GP is used. */
+        u_int initial_design ();
+
         /** Counts the number of iterations performed */
         uint n_iters;
 
         /** A copy of the problem search space */
         sspace::sspace_t *m_space;
 
+        const __gp::acquisition m_acq;
+        const __gp::mode m_mode;
+
+        /** The surrogate model, created with the search space. */
+        __gp::surrogate *m_model;
+
+        /** The quasi-random sequence from which the initial design is drawn. */
+        __qmc::generator *m_design;
+
+        /** The side length of the trust region (local mode only), and the
+         * current runs of successes and failures used to adapt it. */
+        double m_tr;
+        u_int m_succ, m_fail;
+
+        /** Scratch space used by the acquisition optimiser. */
+        std::vector<double> m_mu, m_var;
+
 };
 
 #endif // _GP_H__
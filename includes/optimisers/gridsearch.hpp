@@ -25,6 +25,7 @@
 #include <unordered_map>
 #include <vector>
 #include <tuple>
+#include <cstdint>
 
 #include <optk/optimiser.hpp>
 #include <optk/types.hpp>
@@ -38,17 +39,43 @@ enum class pspace_t: char {
     str_val
 };
 
+/**
+ * A dimension (or subspace) of the grid, which takes get_count () values any
+ * of which can be instantiated from its index.
+ */
 class param {
     public:
         param (const std::string &k, pspace_t t);
+        virtual ~param () {}
         pspace_t get_type () { return m_type; }
         std::string get_key () { return m_key; }
 
+        /** @returns The number of values taken; saturates at UINT64_MAX. */
+        virtual uint64_t get_count () = 0;
+
+        /**
+         * Instantiates the i-th value, allocating it on the heap.
+         * @param i The index of the value, smaller than get_count ().
+         */
+        virtual inst::param *instance (uint64_t i) = 0;
+
     private:
         const std::string m_key;
         const pspace_t m_type;
 };
 
+/** The order in which a (shard of a) grid is visited. */
+enum class order: char {
+    /** Shard k of N is the k-th of N consecutive blocks of indices. */
+    contiguous,
+    /** Shard k of N visits the indices k, k + N, k + 2N, ... */
+    strided,
+    /** As strided, with the indices scattered by a multiplicative
+     * (golden-ratio) permutation, so that any prefix of the traversal is
+     * spread over the whole grid. */
+    golden
+};
+
 // classes inheriting __gs::param are declared / defined in the gridsearch.cpp
 
 } // end namespace gs
@@ -73,9 +100,15 @@ class gridsearch: public optk::optimiser {
          */
         void clear () override;
 
+        optk::optimiser *clone () override;
+
+        /** Grid points are always drawn from the search space. */
+        bool trusted () override { return true; }
+
         /**
-         * Expands the lists of parameters into a format from which it is easier
-         * to generate all possible configurations sequentially.
+         * Describes the grid as a mixed-radix counter over the cardinalities
+         * of the parameters, from which any grid point can be decoded on
+         * demand; memory use is independent of the size of the grid.
          *
          * @param space The search space to unpack. The gridsearch optimiser
          * only accepts parameters of type param::choice, param::categorical,
@@ -106,6 +139,46 @@ class gridsearch: public optk::optimiser {
          */
         void update_search_space_s (sspace::sspace_t *space, double q);
 
+        /** @returns The number of points in the grid (saturating). */
+        uint64_t size ();
+
+        /**
+         * Only visit shard k of n of the grid. Processes given the same
+         * search space, order and n, and distinct k, visit disjoint sets of
+         * points which together cover the grid, without any coordination.
+         * Throws std::invalid_argument unless k < n.
+         */
+        void set_shard (uint64_t k, uint64_t n);
+
+        /** Sets the order in which (the shard of) the grid is visited. */
+        void set_order (__gs::order o);
+
+        /**
+         * Sets the quantisation used when converting a continuous (synthetic)
+         * search space in update_search_space; 0.05 by default. Throws
+         * std::invalid_argument unless q is positive.
+         */
+        void set_quantisation (double q);
+
+        /** @returns The number of points this shard visits. */
+        uint64_t shard_size ();
+
+        /**
+         * Restricts the enumeration to the begin-th up to (but excluding) the
+         * end-th points which this shard would visit; with a single,
+         * contiguous shard these are the grid indices. Reset by
+         * update_search_space.
+         */
+        void set_range (uint64_t begin, uint64_t end);
+
+        /**
+         * Decodes a grid point in O(d), without affecting the enumeration.
+         * @param i The index of the point; throws std::out_of_range if it is
+         * not smaller than size ().
+         * @returns The parameter values, owned by the caller.
+         */
+        inst::set point (uint64_t i);
+
         /**
          * Returns the next unique parameter configuration.
          * @param param_id The identifier which will be matched with the
@@ -136,8 +209,25 @@ class gridsearch: public optk::optimiser {
          * representation of the search space. */
         __gs::param *m_root;
 
-        /** Indicates whether this is the first call to generate_parameters */
-        bool fst_gen;
+        /** Computes the traversal of the current shard. */
+        void configure_traversal ();
+
+        /** @returns The grid index of the j-th point of the traversal. */
+        uint64_t index (uint64_t j);
+
+        /** The shard of the grid to visit, and the traversal order. */
+        uint64_t m_shard, m_nshards;
+        __gs::order m_order;
+
+        /** The quantisation of continuous parameters. */
+        double m_q;
+
+        /** The j-th point visited has the index (first + j stride) mult,
+         * modulo the grid size; mult is 1 except in the golden order. */
+        uint64_t m_first, m_stride, m_mult;
+
+        /** The position of the next point in the traversal, and its end. */
+        uint64_t m_next, m_end;
 
         /**
          * A list of pointers to converted synthetic benchmark search spaces
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Header file for the quasi-random search built-in optimisers.
+ */
+
+#ifndef __QMC_H_
+#define __QMC_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <optk/optimiser.hpp>
+#include <optk/types.hpp>
+
+namespace __qmc {
+
+/** The point sets which a generator can produce. */
+enum class sequence: char {
+    /** A Sobol sequence, with a random linear scramble and digital shift. */
+    sobol,
+    /** A Halton sequence, with random digit permutations. */
+    halton,
+    /** Consecutive Latin hypercube designs, one per block. */
+    lhs
+};
+
+/**
+ * Generates the points of a randomised low-discrepancy sequence in
+ * [0, 1)^d, a block at a time.
+ *
+ * The Sobol direction numbers for the first 16 dimensions are those of Joe
+ * and Kuo; the primitive polynomials for further dimensions are found on
+ * construction and given fixed pseudo-random initial direction numbers.
+ */
+class generator {
+    public:
+
+        /**
+         * @param s The sequence to generate.
+         * @param d The number of dimensions.
+         * @param r The generator from which to draw the randomisation.
+         */
+        generator (sequence s, u_int d, optk::rng &r);
+
+        /** @returns The number of dimensions. */
+        u_int dims () { return m_d; }
+
+        /**
+         * Writes the next n points into out, row-major (out[i * d + j]). For
+         * the lhs sequence, each block is a Latin hypercube of n points.
+         */
+        void next_block (u_int n, double *out);
+
+        /**
+         * Appends the position of the generator in its sequence to a
+         * snapshot; the randomisation is not saved, as a generator
+         * constructed from the same rng state draws the same one.
+         */
+        void save (std::string *out);
+
+        /** Restores the position written by save, from in at *off. */
+        void restore (const std::string &in, size_t *off);
+
+    private:
+
+        void sobol_init (optk::rng &r);
+        void halton_init (optk::rng &r);
+
+        const sequence m_seq;
+        const u_int m_d;
+
+        /** The index of the next point in the sequence. */
+        uint64_t m_index;
+
+        /** Sobol: 32 scrambled direction numbers per dimension, the current
+         * (Gray code) point and the digital shift. */
+        std::vector<uint32_t> m_v, m_x, m_shift;
+
+        /** Halton: the base of each dimension, and per-base digit
+         * permutations (stored consecutively from m_poff[j]). */
+        std::vector<u_int> m_bases, m_poff;
+        std::vector<uint16_t> m_perm;
+
+        /** Latin hypercubes are drawn afresh for each block. */
+        optk::rng m_rng;
+        std::vector<u_int> m_strata;
+};
+
+} // end namespace __qmc
+
+/**
+ * qmc_search samples the search space along a quasi-random sequence,
+ * mapping each coordinate through the inverse CDF of its parameter; this
+ * covers the space more evenly than random search for the same number of
+ * evaluations.
+ */
+class qmc_search: public optk::optimiser {
+
+    public:
+
+        /**
+         * @param s The sequence to sample along.
+         * @param block The number of points generated at once; for Latin
+         * hypercube sampling this is the size of each design.
+         */
+        qmc_search (
+                __qmc::sequence s = __qmc::sequence::sobol,
+                u_int block = 64
+                );
+
+        ~qmc_search ();
+
+        optk::optimiser *clone () override
+        { return new qmc_search (m_seq, m_block); }
+
+        /** All values are quantiles of the search space's own parameters. */
+        bool trusted () override { return true; }
+
+        /**
+         * Every concrete parameter, including those nested in choices, is
+         * given a coordinate of the sequence.
+         * @param space The new search space.
+         */
+        void update_search_space (sspace::sspace_t *space) override;
+
+        inst::set generate_parameters (int param_id) override;
+
+        void receive_trial_results (
+                int param_id,
+                inst::set params,
+                double value
+            ) override;
+
+        /** Saves the position in the sequence, and the current block. */
+        bool save (std::string *out) override;
+
+        void restore (const std::string &in) override;
+
+    private:
+        const __qmc::sequence m_seq;
+        const u_int m_block;
+
+        /** The compiled search space, onto which the points are mapped. */
+        sspace::compiled m_space;
+        __qmc::generator *m_gen;
+
+        /** The current block of points, and the next one to use. */
+        std::vector<double> m_points;
+        u_int m_next;
+};
+
+#endif // __QMC_H_
@@ -31,11 +31,16 @@ class random_search: public optk::optimiser {
 
         random_search();
 
+        optk::optimiser *clone () override { return new random_search (); }
+
+        /** Samples are always drawn from the search space. */
+        bool trusted () override { return true; }
+
         void update_search_space (sspace::sspace_t *space) override;
 
         /**
          * The random search optimiser will simply generate the relevant parameters
-         * by calling the \c sample method of parameters in the search space.
+         * by sampling each parameter of the compiled search space.
          * @param param_id A largely disregarded parameter; save for internal
          * memory management.
          * @returns A randomly generated set of valid parameters, with no
@@ -49,18 +54,14 @@ class random_search: public optk::optimiser {
                 double value
             ) override;
 
-    private:
+        /** The only state of a random search is its generator. */
+        bool save (std::string *out) override;
 
-        /**
-         * This function recursively traverses the search space, sampling a value at
-         * random from each of the parameters.
-         * @param parent A pointer to the parent instance node to which to store the
-         * results.
-         */
-        void sample_ss (inst::node *parent);
+        void restore (const std::string &in) override;
 
-        /** A copy of the problem search space */
-        sspace::sspace_t *m_space;
+    private:
+        /** The compiled problem search space, from which samples are drawn. */
+        sspace::compiled m_space;
 };
 
 #endif // __RANDOM_H_
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief An optimiser which runs in another process, and is driven over a
+ * Unix socket.
+ *
+ * The protocol is a compact binary ask/tell exchange. Every message is
+ * framed by a 4-byte payload length and a 1-byte message type; numbers are
+ * sent in the host's byte order, since both ends share a host.
+ *
+ *  - space  (client to server): u32 d, then for each of the d parameters,
+ *    u8 sspace type (see pt), u16 name length, the name, and three f64:
+ *    the bounds (or mean and standard deviation) and the quantisation, which
+ *    is zero for continuous parameters. This (re)starts an optimisation run.
+ *  - ask    (client to server): u32 first id, u32 k. Asks for k trials.
+ *  - points (server to client): u32 first id, u32 k, then k * d f64 values,
+ *    point by point. Fewer than the k asked for means there are no more.
+ *  - tell   (client to server): u32 n, then n pairs of u32 id, f64 value.
+ *  - bye    (client to server): empty; ends the session.
+ *
+ * Every ask is answered by exactly one points message, in order, and no
+ * other messages are answered, so that asks can be pipelined: the client
+ * keeps asking ahead of the trials it has handed out, so that the next
+ * trials are already on their way while the current ones are evaluated.
+ * Tells are buffered, and written together with the next ask.
+ */
+
+#ifndef __REMOTE_H_
+#define __REMOTE_H_
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <optk/net.hpp>
+#include <optk/optimiser.hpp>
+#include <optk/types.hpp>
+
+namespace __remote {
+
+/** The types of the messages of the protocol. */
+enum class msg: uint8_t {
+    space = 1,
+    ask = 2,
+    points = 3,
+    tell = 4,
+    bye = 5
+};
+
+/**
+ * Serves an optimiser to a single client, for as many optimisation runs as
+ * the client starts, until it says bye or disconnects. This is the server
+ * end of remote_optimiser, and a reference for implementing the protocol in
+ * other languages.
+ * @param fd The connected socket; it is closed on return.
+ * @param opt The optimiser to serve.
+ * @exception std::runtime_error on a protocol error.
+ */
+void serve (int fd, optk::optimiser *opt);
+
+} // namespace __remote
+
+/**
+ * An optimiser which forwards generate_parameters and receive_trial_results
+ * to an optimiser in another process (see __remote::serve), which listens on
+ * a Unix socket. Every clone makes its own connection, when it is first
+ * given a search space, so the server should accept many.
+ *
+ * Only flat search spaces of real-valued and randint parameters can be sent.
+ */
+class remote_optimiser: public optk::optimiser {
+    public:
+        /**
+         * @param path The path of the server's socket.
+         * @param lookahead The number of trials to keep asked for beyond
+         * those generated so far; with zero, every trial is asked for only
+         * once the results of all the previous ones have been told.
+         */
+        remote_optimiser (const std::string &path, uint lookahead = 1);
+        ~remote_optimiser ();
+
+        optk::optimiser *clone () override
+        { return new remote_optimiser (m_path, m_lookahead); }
+
+        /**
+         * Connects if need be, and starts a new optimisation run on the
+         * server.
+         * @exception std::invalid_argument if the space cannot be sent.
+         * @exception std::runtime_error if the server cannot be reached.
+         */
+        void update_search_space (sspace::sspace_t *space) override;
+
+        inst::set generate_parameters (int param_id) override;
+
+        uint generate_batch (
+            int first_id,
+            uint k,
+            std::vector<inst::set> *out
+        ) override;
+
+        void receive_trial_results (
+                int param_id,
+                inst::set params,
+                double value
+            ) override;
+
+        void clear () override;
+
+    private:
+        /**
+         * Receives trials until at least n are queued, or the server has no
+         * more, and then asks ahead.
+         */
+        void fill (uint n);
+
+        /** Moves the buffered tells into the channel's write buffer. */
+        void put_tells ();
+
+        /** Sends an ask for k trials, along with any buffered tells. */
+        void ask (uint k);
+
+        /** Reads the reply to the oldest outstanding ask. */
+        void receive_points ();
+
+        /** @returns The oldest queued trial, as a parameter set. */
+        inst::set pop (int param_id);
+
+        std::string m_path;
+        uint m_lookahead;
+        optk::net::channel *m_chan;
+        sspace::sspace_t *m_space;
+
+        /** The remote ids and values of the queued trials. */
+        std::deque<uint32_t> m_ids;
+        std::deque<double> m_values;
+        /** The sizes of the outstanding asks. */
+        std::deque<uint32_t> m_asks;
+        /** The total size of the outstanding asks. */
+        uint m_asked;
+        /** The next remote id to ask for. */
+        uint32_t m_next;
+        /** Set once the server has run out of trials. */
+        bool m_exhausted;
+
+        /** The remote ids of the trials handed out, by parameter id. */
+        std::unordered_map<int, uint32_t> m_remote;
+        /** The number of tells buffered in m_tells. */
+        uint32_t m_ntells;
+        std::string m_tells;
+};
+
+#endif // __REMOTE_H_
@@ -22,6 +22,7 @@
 #ifndef __BENCHMARK_H_
 #define __BENCHMARK_H_
 
+#include <cstdint>
 #include <string>
 
 #include <optk/types.hpp>
@@ -30,6 +31,9 @@
 namespace optk {
 
 class benchmark_set;
+class progress;
+class thread_pool;
+class trace;
 typedef std::vector<benchmark_set *> bench_list;
 
 /**
@@ -43,6 +47,11 @@ class benchmark {
          */
         benchmark (const std::string &name);
 
+        /**
+         * Virtual destructor allows derived classes to be deleted correctly.
+         */
+        virtual ~benchmark () {}
+
         /**
          * @returns The name of the benchmark
          */
@@ -68,8 +77,88 @@ class benchmark {
          */
         virtual double evaluate (inst::set x) = 0;
 
+        /**
+         * Evaluates the benchmark on a batch of points at once. The points
+         * are laid out as a structure of arrays: with \f$d\f$ the number of
+         * parameters in the search space, coordinate \f$j\f$ of point
+         * \f$i\f$ is at x[j * n + i], so that each parameter's values are
+         * contiguous.
+         *
+         * This is only meaningful for flat search spaces of double-valued
+         * parameters. The default implementation builds an inst::node for
+         * each point, keyed by the names of the search space parameters, and
+         * calls evaluate; derived classes should override it with something
+         * faster.
+         *
+         * @param x The \f$d \times n\f$ matrix of points.
+         * @param n The number of points in the batch.
+         * @param out The n results are written here.
+         */
+        virtual void evaluate_batch (const double *x, u_int n, double *out);
+
+        /**
+         * Enables or disables the validation of the parameters passed to
+         * evaluate against the search space; benchmarks which validate their
+         * inputs skip it while it is disabled. This is used to avoid the cost
+         * of validation for trusted optimisers (see optimiser::trusted).
+         * @param v Whether to validate parameters; the default is true.
+         */
+        virtual void set_validation (bool v) { m_validate = v; }
+
+        /**
+         * Reports the cost of an evaluation, such as the simulated time
+         * which it took, so that optimisers can be compared on the budget
+         * which they spent as well as on the number of evaluations. The core
+         * loops record it into traces which carry costs (see optk::trace),
+         * once the point has been evaluated.
+         * @param x The evaluated point.
+         * @returns 0, unless overridden.
+         */
+        virtual double cost (inst::set x) { return 0.; }
+
+        /**
+         * Reports the value of an evaluation without the noise or the error
+         * at low fidelity which the benchmark added to it, against which
+         * summaries measure the regret of a run (see optk::trace), so that a
+         * lucky draw or a cheap evaluation cannot reach the target.
+         * @param x The evaluated point.
+         * @param v The value which evaluate returned for x.
+         * @returns v, unless overridden.
+         */
+        virtual double exact (inst::set x, double v) { return v; }
+
+        /** @returns whether parameters are to be validated. */
+        bool validation () { return m_validate; }
+
+        /**
+         * The id of the trial which the calling thread is evaluating, which
+         * the core loops set for the duration of each evaluation (see
+         * scoped_trial), or -1 outside them. Benchmarks which draw noise
+         * derive it from the trial, so that a run's draws do not depend on
+         * the order in which its trials happen to be evaluated.
+         */
+        static int64_t &
+        trial ()
+        {
+            static thread_local int64_t t = -1;
+            return t;
+        }
+
     protected:
         std::string m_name; /** The benchmark's name */
+        bool m_validate;    /** Whether to validate parameters */
+};
+
+/** Makes a trial current on this thread for the lifetime of the scope. */
+class scoped_trial {
+    public:
+        scoped_trial (uint id): m_prev (benchmark::trial ())
+        { benchmark::trial () = id; }
+
+        ~scoped_trial () { benchmark::trial () = m_prev; }
+
+    private:
+        int64_t m_prev;
 };
 
 /**
@@ -96,10 +185,52 @@ class benchmark_set {
 
         /**
          * This is used to run all the optimisers in the set on the benchmarks.
+         *
+         * Every replicate of each (optimiser, benchmark) pair is run as an
+         * independent job (see run_one) on a pool of ctx->threads threads,
+         * with a clone of the optimiser seeded from ctx->seed and the index
+         * of the job. The rows of the output file are always written in the
+         * same order, regardless of the number of threads.
+         *
+         * If ctx->ckpt is set, the jobs which it holds as finished are not
+         * run again, and the others are resumed from their latest snapshot.
+         *
          * @param The optimiser(s) to run on each benchmark.
          * @todo should this simply be a vector of optk::optimiser?
          */
-        virtual void run (optk::optimisers *opts, optk::ctx_t *ctx) = 0;
+        virtual void run (optk::optimisers *opts, optk::ctx_t *ctx);
+
+        /** @returns The number of benchmarks in the set. */
+        virtual uint size () = 0;
+
+        /** @returns The name of the j-th benchmark of the set. */
+        virtual std::string benchmark_name (uint j) = 0;
+
+        /** @returns The names of the properties of the j-th benchmark. */
+        virtual std::vector<std::string> benchmark_properties (uint j) = 0;
+
+        /**
+         * Runs one optimiser on a new instance of one benchmark of the set;
+         * this is the unit of work of run, and of distributed sweeps. It is
+         * called concurrently.
+         * @param j The index of the benchmark.
+         * @param opt The optimiser, which is seeded and owned by the caller.
+         * @param tr The trace into which to record the run.
+         * @param ctx The program context, for the core loop's settings.
+         * @param pool The pool on which to evaluate batches.
+         * @param prog If not NULL, the progress from which to resume the
+         * run, and into which to save it.
+         * @param seed The optimiser's seed, from which the benchmark's own
+         * randomness (such as noise) is drawn.
+         */
+        virtual void run_one (
+                uint j,
+                optk::optimiser *opt,
+                optk::trace &tr,
+                optk::ctx_t *ctx,
+                optk::thread_pool *pool,
+                optk::progress *prog,
+                uint64_t seed) = 0;
 
         std::string get_name () { return m_name; }
 
@@ -0,0 +1,194 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A cache of objective function values, shared between runs.
+ */
+
+#ifndef __CACHE_H_
+#define __CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <optk/benchmark.hpp>
+#include <optk/types.hpp>
+
+namespace optk {
+
+/**
+ * A cache of the values of deterministic objective functions, keyed by a
+ * canonical hash of the benchmark's name and the parameter set (see key), so
+ * that points which are evaluated again, by the same or another run, need
+ * not be.
+ *
+ * Values are held in memory, and optionally in a file which is mapped into
+ * memory and shared by every process which opens it, so that later sweeps
+ * start warm. The file is a fixed-size, open-addressed hash table which is
+ * updated in place with atomic operations; a process which is killed loses
+ * at most the entry it was writing. Once the table is three quarters full no
+ * new entries are added to it, although they are still kept in memory.
+ *
+ * The file holds a 64 byte header: "OPTKEVC1", u64 number of slots, u64
+ * number of entries, then the slots, each of u64 key, f64 value and u64 check
+ * word, in the host's byte order. A slot is only read once its check word
+ * matches its key and value.
+ *
+ * All the methods may be called concurrently.
+ */
+class eval_cache {
+    public:
+        /** The number of slots of a new file, unless otherwise given. */
+        static const uint64_t default_slots = 1 << 20;
+
+        /** Creates a cache which is only held in memory. */
+        eval_cache ();
+
+        /**
+         * Creates a cache which is also held in a file, which is created if
+         * it does not exist.
+         * @param path The path to the file.
+         * @param slots The number of slots of the table, if the file is
+         * created; an existing file keeps its own size.
+         * @exception std::runtime_error if the file cannot be opened or
+         * mapped, or is not a cache file.
+         */
+        eval_cache (const std::string &path, uint64_t slots = default_slots);
+
+        ~eval_cache ();
+
+        eval_cache (const eval_cache &) = delete;
+        eval_cache &operator= (const eval_cache &) = delete;
+
+        /**
+         * The canonical hash of a parameter set: it does not depend on the
+         * order of the values, treats 0 and -0 alike, and is the same for
+         * every process and build on the same architecture.
+         * @param bench The name of the benchmark.
+         * @param x The parameter set.
+         */
+        static uint64_t key (const std::string &bench, inst::set x);
+
+        /**
+         * As above, for a point of a flat space of doubles, which hashes as
+         * the parameter set with those values would.
+         * @param bench The name of the benchmark.
+         * @param ss The search space, from which the names are taken.
+         * @param x The coordinates of the point.
+         * @param stride The distance between successive coordinates in x.
+         */
+        static uint64_t key (const std::string &bench, sspace::sspace_t *ss,
+                const double *x, u_int stride = 1);
+
+        /**
+         * Looks a value up.
+         * @param k The key of the value.
+         * @param v The value is written here, if it is found.
+         * @returns Whether the value was found.
+         */
+        bool find (uint64_t k, double *v);
+
+        /**
+         * Adds a value to the cache.
+         * @param k The key of the value.
+         * @param v The value.
+         */
+        void insert (uint64_t k, double v);
+
+        /** @returns The number of lookups which found a value. */
+        uint64_t hits () const { return m_hits; }
+
+        /** @returns The number of lookups which did not. */
+        uint64_t misses () const { return m_misses; }
+
+        /** @returns The number of values held in the file, or 0. */
+        uint64_t persisted () const;
+
+    private:
+        /** A slot of the file's table. */
+        typedef struct {
+            uint64_t key;
+            uint64_t bits;
+            uint64_t check;
+        } slot_t;
+
+        bool find_file (uint64_t k, double *v);
+        void insert_file (uint64_t k, double v);
+
+        /** The memory tier, split into shards to reduce contention. */
+        static const int nshards = 16;
+        struct shard {
+            std::mutex lock;
+            std::unordered_map<uint64_t, double> values;
+        } m_shards[nshards];
+
+        /** The file tier, if any. */
+        int m_fd;
+        void *m_map;
+        size_t m_len;
+        uint64_t *m_count;
+        slot_t *m_slots;
+        uint64_t m_nslots;
+
+        std::atomic<uint64_t> m_hits, m_misses;
+};
+
+/**
+ * A benchmark which looks the values of another up in an eval_cache before
+ * evaluating them. Only deterministic benchmarks should be cached.
+ */
+class cached_benchmark: public benchmark {
+    public:
+        /**
+         * The constructor.
+         * @param b The benchmark to cache, which must outlive this one.
+         * @param cache The cache to use.
+         */
+        cached_benchmark (benchmark *b, eval_cache *cache);
+
+        sspace::sspace_t *get_search_space () override
+        { return m_bench->get_search_space (); }
+
+        double evaluate (inst::set x) override;
+
+        /** Only the points which are not found are passed on, as a batch. */
+        void evaluate_batch (const double *x, u_int n, double *out) override;
+
+        void set_validation (bool v) override;
+
+        /** The cost is that of the wrapped benchmark, whether or not the
+         * value was found. */
+        double cost (inst::set x) override { return m_bench->cost (x); }
+
+        /** The exact value is also that of the wrapped benchmark. */
+        double
+        exact (inst::set x, double v) override
+        {
+            return m_bench->exact (x, v);
+        }
+
+    private:
+        benchmark *m_bench;
+        eval_cache *m_cache;
+};
+
+} // namespace optk
+
+#endif // __CACHE_H_
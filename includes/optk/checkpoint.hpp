@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Checkpoints, from which a stopped sweep can be resumed.
+ */
+
+#ifndef __CHECKPOINT_H_
+#define __CHECKPOINT_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace optk {
+
+class optimiser;
+class trace;
+
+/**
+ * Saves the progress of one run of the core loop, and resumes it. The core
+ * loops call resume once the optimiser has been given its search space, and
+ * step after every iteration (or batch), while no trials are pending.
+ */
+class progress {
+    public:
+        virtual ~progress () {}
+
+        /**
+         * Restores the optimiser and the trace from the latest saved state
+         * of the run, if there is one.
+         * @param opt The optimiser, seeded for the run.
+         * @param tr The trace of the run, which is empty.
+         * @returns The number of iterations already run.
+         */
+        virtual uint resume (optk::optimiser *opt, optk::trace &tr) = 0;
+
+        /**
+         * Offers to save the state of the run, which has recorded
+         * tr.count () iterations so far.
+         */
+        virtual void step (optk::optimiser *opt, optk::trace &tr) = 0;
+};
+
+/**
+ * A checkpoint file, into which a sweep saves the traces of its finished
+ * runs, and periodic snapshots of its unfinished ones, so that a sweep which
+ * is stopped can be resumed. Runs are identified by the name of their
+ * benchmark set and their job index (see benchmark_set::run), so a sweep may
+ * only be resumed with the same configuration and seed.
+ *
+ * The file is a sequence of messages framed as by optk::net, in the host's
+ * byte order, which is only ever appended to; a process which is killed
+ * loses at most the message it was writing, and that is discarded when the
+ * file is reopened. The messages are:
+ *
+ *  - header:   "OPTKCKP1", u64 seed, then the configuration of the sweep.
+ *  - finished: u32 length and name of the set, u32 job, then the f64 entries
+ *    of the trace.
+ *  - snapshot: u32 length and name of the set, u32 job, u32 iterations, f64
+ *    lowest value, the entries of the trace as written by net::put_vec, then
+ *    the state saved by the optimiser.
+ *
+ * Snapshots are only taken between iterations of optimisers which implement
+ * optimiser::save. When the file is reopened, it is compacted down to the
+ * finished runs and the latest snapshot of each unfinished one.
+ */
+class checkpoint {
+    public:
+        /**
+         * Opens a checkpoint file, reading back what an earlier process
+         * saved in it, or creates it.
+         * @param path The path of the file.
+         * @param config A description of the sweep, of everything which
+         * affects its results other than the seed.
+         * @param seed The sweep's seed, which is replaced by the saved one
+         * when the file already exists (see seed).
+         * @param period The minimum number of seconds between two snapshots
+         * of a run.
+         * @exception std::runtime_error if the file cannot be read or
+         * written, or was written by a different sweep.
+         */
+        checkpoint (
+                const std::string &path,
+                const std::string &config,
+                uint64_t seed,
+                double period = 60
+                );
+
+        ~checkpoint ();
+
+        /** @returns The seed of the sweep being checkpointed. */
+        uint64_t seed () { return m_seed; }
+
+        /** @returns The number of finished runs read back from the file. */
+        uint restored () { return m_restored; }
+
+        /**
+         * Looks up a finished run.
+         * @param set The name of the benchmark set.
+         * @param job The index of the run in the set.
+         * @param entries Is set to the entries of the run's trace.
+         * @returns Whether the run has finished.
+         */
+        bool finished (
+                const std::string &set,
+                uint job,
+                std::vector<double> *entries
+                );
+
+        /**
+         * Records that a run has finished. This may be called concurrently.
+         * @param set The name of the benchmark set.
+         * @param job The index of the run in the set.
+         * @param entries The entries of its trace.
+         * @param n The number of entries.
+         */
+        void finish (
+                const std::string &set,
+                uint job,
+                const double *entries,
+                uint n
+                );
+
+        /**
+         * @returns A new progress, for the core loop running a job, which
+         * takes snapshots at most every period seconds and resumes from the
+         * latest one saved; the caller deletes it.
+         */
+        optk::progress *start (const std::string &set, uint job);
+
+    private:
+        friend class run_progress;
+
+        typedef std::pair<std::string, uint> key_t;
+
+        /** Reads the file back, and rewrites it compacted. */
+        void load (const std::string &config);
+
+        /** Appends a message to the file, warning if that fails. */
+        void append (uint8_t type, const key_t &k, const std::string &body);
+
+        /** @returns The payload of a message about a run. */
+        static std::string encode (const key_t &k, const std::string &body);
+
+        const std::string m_path;
+        const double m_period;
+        uint64_t m_seed;
+        uint m_restored;
+        int m_fd;
+        bool m_failed;
+
+        std::mutex m_mtx;
+        std::map<key_t, std::vector<double>> m_finished;
+        std::map<key_t, std::string> m_snapshots;
+};
+
+} // namespace optk
+
+#endif // __CHECKPOINT_H_
@@ -26,25 +26,117 @@
 
 #include <optk/types.hpp>
 #include <optk/benchmark.hpp>
+#include <optk/checkpoint.hpp>
 #include <optk/optimiser.hpp>
+#include <optk/threadpool.hpp>
+#include <optk/trace.hpp>
 
 namespace optk {
 
 /**
  * This performs the core optimisation loop. Given a benchmark and an
  * optimiser, this function will first commuicate the benchmark's search space,
- * and then iterate for up to max_iter iterations, generating new
- * configurations, evaluating, and storing the results.
+ * and then iterate for up to tr.iters() iterations, generating new
+ * configurations, evaluating, and recording the results.
  * @param bench A pointer to the benchmark to be run
  * @param opt A pointer to the optimiser to run on the benchmark
- * @param max_iter The maximum number of iterations; default 20
+ * @param tr The trace into which to record the results; it is cleared first
+ * @param prog If not NULL, the run is resumed from, and periodically saved
+ * into, this progress.
  */
 void
 core_loop (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        optk::progress *prog = NULL
+        );
+
+/**
+ * As above, recording every result into a caller-provided array.
+ * @param bench A pointer to the benchmark to be run
+ * @param opt A pointer to the optimiser to run on the benchmark
+ * @param trace The max_iter results are written here
+ * @param max_iter The maximum number of iterations
+ */
+void
+core_loop (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        double *trace,
+        uint max_iter
+        );
+
+/**
+ * A variant of core_loop which asks the optimiser for batches of trials, and
+ * evaluates the trials of each batch in parallel on a thread pool before
+ * reporting them back together. The benchmark's evaluate method must be safe
+ * to call concurrently.
+ * @param bench A pointer to the benchmark to be run
+ * @param opt A pointer to the optimiser to run on the benchmark
+ * @param tr The results are recorded here, in parameter id order
+ * @param batch The number of trials to ask for at once
+ * @param pool The pool on which to evaluate the trials; if NULL, they are
+ * evaluated sequentially on the calling thread. This may be the pool running
+ * the caller.
+ * @param prog If not NULL, the run is resumed from, and saved into, this
+ * progress between batches.
+ */
+void
+core_loop_batch (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        uint batch,
+        optk::thread_pool *pool,
+        optk::progress *prog = NULL
+        );
+
+/** As above, recording every result into the max_iter entries of trace. */
+void
+core_loop_batch (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        double *trace,
+        uint max_iter,
+        uint batch,
+        optk::thread_pool *pool
+        );
+
+/**
+ * An asynchronous variant of core_loop, which keeps up to inflight
+ * evaluations running at all times. As soon as any evaluation completes, its
+ * result is passed to the optimiser and a new trial is requested, without
+ * waiting for the other evaluations. Only the calling thread ever calls the
+ * optimiser, which sees results out of parameter id order. The benchmark's
+ * evaluate method must be safe to call concurrently.
+ * @param bench A pointer to the benchmark to be run
+ * @param opt A pointer to the optimiser to run on the benchmark
+ * @param tr The results are recorded here, in the order in which the
+ * evaluations completed
+ * @param inflight The maximum number of concurrent evaluations
+ * @param pool The pool on which to evaluate the trials. The calling thread
+ * also evaluates trials when it has nothing else to do, so this may be the
+ * pool running the caller.
+ */
+void
+core_loop_async (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        uint inflight,
+        optk::thread_pool *pool
+        );
+
+/** As above, recording every result into the max_iter entries of trace. */
+void
+core_loop_async (
         optk::benchmark *bench,
         optk::optimiser *opt,
         double *trace,
-        uint max_iter=20
+        uint max_iter,
+        uint inflight,
+        optk::thread_pool *pool
         );
 }
 
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Distributes a sweep between processes on many nodes: a coordinator
+ * hands out units of work to workers, over TCP, and writes their results.
+ *
+ * A unit of work is one replicate of one (optimiser, benchmark) pair of one
+ * benchmark set; units are numbered as the jobs of benchmark_set::run, and
+ * seeded in the same way, so that a distributed sweep writes the same output
+ * as a local one. The workers are the same optk binary, configured with the
+ * coordinator's arguments.
+ *
+ * The messages are framed as by optk::net, and sent in the host byte order,
+ * so the nodes must share a byte order:
+ *
+ *  - hello  (worker to coordinator): u32 threads.
+ *  - config (coordinator to worker): u32 argc, then each argument as a u32
+ *    length and its bytes.
+ *  - units  (coordinator to worker): u32 n, then n u32 unit ids.
+ *  - result (worker to coordinator): u32 unit id, u32 n, then the n f64
+ *    entries of the trace.
+ *  - done   (coordinator to worker): empty; there is no more work.
+ *  - error  (worker to coordinator): the message of the exception with which
+ *    a unit failed; as it would fail on any worker, the sweep is abandoned.
+ *
+ * Workers pull: each is kept two units per thread ahead, so that it never
+ * waits for the coordinator. Once there are no units left to hand out, idle
+ * workers steal the units still running on others, and whichever result
+ * comes first is kept, so that a slow node does not hold up the end of the
+ * sweep. The units of a worker which disconnects are handed out again.
+ */
+
+#ifndef __DIST_H_
+#define __DIST_H_
+
+#include <string>
+#include <vector>
+
+#include <optk/benchmark.hpp>
+#include <optk/net.hpp>
+#include <optk/optimiser.hpp>
+#include <optk/types.hpp>
+
+namespace optk {
+namespace dist {
+
+/** The types of the messages between coordinators and workers. */
+enum class msg: uint8_t {
+    hello = 1,
+    config = 2,
+    units = 3,
+    result = 4,
+    done = 5,
+    error = 6
+};
+
+/**
+ * Runs a sweep of the benchmark sets by handing its units out to the workers
+ * which connect, until every unit's result has been written to ctx->results.
+ * If ctx->ckpt is set, the units it holds as finished are not handed out, and
+ * the others are saved into it as they finish; workers take no snapshots, so
+ * the units which were running when a sweep was stopped are run again.
+ * @param lfd The listening socket, on which workers connect.
+ * @param bms The benchmark sets to run.
+ * @param opts The optimisers to run on them.
+ * @param ctx The program context.
+ * @param config The arguments with which to configure the workers, which
+ * must select the same benchmarks and optimisers.
+ * @exception std::runtime_error if a unit fails on a worker.
+ */
+void coordinate (
+        int lfd,
+        optk::bench_list *bms,
+        optk::optimisers *opts,
+        optk::ctx_t *ctx,
+        const std::vector<std::string> &config);
+
+/**
+ * Joins a coordinator.
+ * @param chan The connection to the coordinator.
+ * @param threads The number of threads which the worker runs.
+ * @returns The arguments with which the coordinator configures the worker.
+ * @exception std::runtime_error if the coordinator does not answer.
+ */
+std::vector<std::string> join (optk::net::channel *chan, uint threads);
+
+/**
+ * Runs the units handed out by a coordinator, on ctx->threads threads, and
+ * sends back their results until the coordinator says it is done.
+ * @param chan The connection to the coordinator.
+ * @param bms The benchmark sets, as configured by the coordinator.
+ * @param opts The optimisers, as configured by the coordinator.
+ * @param ctx The program context, as configured by the coordinator.
+ * @exception std::runtime_error if the coordinator goes away, or with the
+ * error of a unit which failed, once it has been reported.
+ */
+void work (
+        optk::net::channel *chan,
+        optk::bench_list *bms,
+        optk::optimisers *opts,
+        optk::ctx_t *ctx);
+
+} // namespace dist
+} // namespace optk
+
+#endif // __DIST_H_
@@ -49,7 +49,7 @@ class optimiser {
          * The destructor will free any generated parameter instances not freed
          * by explicit calls to receive_trial_results.
          */
-        ~optimiser ();
+        virtual ~optimiser ();
 
         /**
          * Clears / resets this optimiser. This should be the same as calling
@@ -64,6 +64,16 @@ class optimiser {
 
         // required methods ---------------------------------------------------
 
+        /**
+         * Creates a new, independent instance of this optimisation algorithm
+         * with the same configuration, but none of the trial state. This is
+         * used to give every concurrently running benchmark its own
+         * optimiser.
+         * @returns A pointer to a heap-allocated optimiser; the caller is
+         * responsible for deleting it.
+         */
+        virtual optimiser *clone () = 0;
+
         /**
          * This updates the search space defined by the optimiser.
          * @param space The new search space to use
@@ -100,6 +110,74 @@ class optimiser {
 
         // optional, convenience methods --------------------------------------
 
+        /**
+         * Reseeds the optimiser's random number generator, so that its trials
+         * can be reproduced. Unless this is called, the generator is seeded
+         * from the calling thread's generator at construction.
+         * @param s The seed.
+         */
+        void seed (uint64_t s) { m_rng.seed (s); }
+
+        /**
+         * An optimiser is trusted if every parameter set it generates is known
+         * to be valid under the search space it was given, which is the case
+         * for optimisers that only ever sample from that space. The core
+         * loops skip the benchmarks' validation for trusted optimisers.
+         * @returns false, unless overridden.
+         */
+        virtual bool trusted () { return false; }
+
+        /**
+         * Generates a batch of up to k trials which are all pending at the
+         * same time, so that they can be evaluated in parallel. The trials
+         * are given consecutive parameter ids starting at first_id. The
+         * default implementation calls generate_parameters k times, stopping
+         * early if it returns NULL.
+         * @param first_id The parameter id of the first trial in the batch.
+         * @param k The maximum number of trials to generate.
+         * @param out The generated trials are appended to this vector.
+         * @returns The number of trials generated; this is less than k only
+         * when the optimiser has run out of parameters.
+         */
+        virtual uint generate_batch (
+            int first_id,
+            uint k,
+            std::vector<inst::set> *out
+        );
+
+        /**
+         * Reports the results of a batch of trials generated by
+         * generate_batch. The default implementation calls
+         * receive_trial_results for each trial, in order.
+         * @param first_id The parameter id of the first trial in the batch.
+         * @param params The trials, in parameter id order.
+         * @param values The values of the objective function, one per trial.
+         */
+        virtual void receive_batch (
+            int first_id,
+            std::vector<inst::set> *params,
+            const double *values
+        );
+
+        /**
+         * Saves the state of the optimiser, so that a run which is stopped
+         * can later be resumed from this point (see optk::checkpoint). This
+         * is only called between iterations, when no trials are pending.
+         * @param out The state is appended to this string.
+         * @returns false if the optimiser cannot save its state, which is the
+         * default; its stopped runs are then started again.
+         */
+        virtual bool save (std::string *out) { return false; }
+
+        /**
+         * Restores the state written by save. This is called on a new
+         * optimiser, seeded as the saved one was, once it has been given the
+         * same search space.
+         * @param in The saved state.
+         * @exception std::runtime_error if the state is malformed.
+         */
+        virtual void restore (const std::string &in) {}
+
         /**
          * Uses the visitor pattern to register an optimiser with the optimisers
          * class.
@@ -129,6 +207,9 @@ class optimiser {
          */
         std::unordered_map<int, inst::set> trials;
 
+        /** The generator from which stochastic optimisers should draw.     */
+        optk::rng m_rng;
+
     private:
         /** The optimisation algorithm's name                                */
         std::string m_name;
@@ -23,23 +23,33 @@
 #define __OPTK_H_
 
 #include <argp.h>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <unistd.h>
 
 #include <optk/types.hpp>
 #include <optk/benchmark.hpp>
+#include <optk/cache.hpp>
+#include <optk/checkpoint.hpp>
+#include <optk/dist.hpp>
 #include <optk/optimiser.hpp>
+#include <optk/results.hpp>
 
 // optimisers
 #include <optimisers/gp.hpp>
+#include <optimisers/qmc.hpp>
 #include <optimisers/random.hpp>
+#include <optimisers/remote.hpp>
 #include <optimisers/gridsearch.hpp>
 
 // benchmarks
 #include <benchmarks/synthetic.hpp>
+#include <benchmarks/variant.hpp>
 
 #ifdef __OPTK_TESTING
 #include <tests/tests.hpp>
@@ -57,12 +67,48 @@ typedef struct {
     int threads;
     /** The number of iterations to run per benchmark                        */
     int max_iters;
+    /** The number of iterations summarised by each entry of a trace        */
+    int stride;
+    /** Record the best value so far, rather than the latest one            */
+    bool best;
+    /** The number of seeded replicates to run of each pair                 */
+    int repeats;
+    /** The number of trials to request from the optimiser at once          */
+    int batch;
+    /** Keep THREADS evaluations running, rather than waiting for batches   */
+    bool async;
+    /** The random seed, or NULL to choose one at random                    */
+    const char *seed;
+    /** The shard of the grid to visit, as K/N, or NULL for the whole grid  */
+    const char *shard;
+    /** The order in which gridsearch visits the grid                       */
+    const char *order;
+    /** The quantisation of continuous parameters for gridsearch            */
+    double grid_q;
+    /** The layout of the results file: csv or columnar                     */
+    const char *format;
+    /** Hand the sweep out to workers connecting on this HOST:PORT, or NULL */
+    const char *coordinate;
+    /** Work for the coordinator at this HOST:PORT, or NULL                 */
+    const char *worker;
+    /** The file from which to resume the sweep, and into which to save it  */
+    const char *checkpoint;
+    /** The minimum number of seconds between snapshots of a run            */
+    double period;
+    /** The file holding the cache of evaluations, or NULL for no cache     */
+    const char *cache;
+    /** The noise and cost model of the synthetic benchmarks, or NULL       */
+    const char *variant;
+    /** Summarise runs against this tolerance of the optimum, if not < 0    */
+    double target;
     /** The directory into which the output file(s) should go                */
     const char *output;
     /** The benchmarks to run                                                */
     const char *benchmark;
     /** The optimisation algorithm to evaluate                               */
     const char *algorithm;
+    /** List the available benchmarks instead of running them               */
+    bool list;
 } arguments;
 
 }
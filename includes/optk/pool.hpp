@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A small-object memory pool, used for the parameter trees passed
+ * between optimisers and benchmarks.
+ */
+
+#ifndef __POOL_H_
+#define __POOL_H_
+
+#include <cstddef>
+#include <new>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define __OPTK_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define __OPTK_ASAN
+#endif
+#endif
+
+namespace optk {
+
+/**
+ * The pool keeps a free list of blocks for each size class, in multiples of
+ * 16 bytes, up to max_size bytes; larger requests go straight to operator
+ * new. The free lists are thread local, so that neither allocating nor
+ * freeing takes a lock: an allocation pops a block off a list, or failing
+ * that bumps a pointer into the thread's current chunk.
+ *
+ * Every chunk records the thread cache which owns it, and a freed block goes
+ * back to the owner of its chunk: onto the owner's list if it is freed by
+ * the same thread, and otherwise onto the owner's lock-free remote list,
+ * which the owner takes over once its own list runs dry. Blocks allocated on
+ * one thread and freed on another, such as those of trials evaluated on a
+ * thread pool, are therefore reused rather than piling up on the freeing
+ * thread. The cache of a thread which exits is adopted, with its chunks and
+ * lists, by the next thread to start using the pool. Caches are never freed,
+ * so a block may be freed into an exited thread's cache at any time; and a
+ * thread which uses the pool once its cache has gone, from a thread-local or
+ * static destructor, shares a global cache under a lock instead.
+ *
+ * Chunks are never returned to the system; in the steady state of an
+ * optimisation loop each trial reuses the blocks freed by the one before.
+ */
+namespace pool {
+
+/** The largest allocation served from the pool, in bytes.                   */
+static constexpr std::size_t max_size = 256;
+
+/**
+ * Whether the parameter trees are allocated from the pool. In the test
+ * build, and under AddressSanitizer, they go straight to operator new, so
+ * that the sanitiser sees the use of a freed trial; the pool itself may
+ * still be called directly.
+ */
+#if defined(__OPTK_TESTING) || defined(__OPTK_ASAN)
+static constexpr bool enabled = false;
+#else
+static constexpr bool enabled = true;
+#endif
+
+/**
+ * Allocates a block of memory suitably aligned for any fundamental type.
+ * @param n The number of bytes required.
+ * @returns A pointer to the new block.
+ */
+void *allocate (std::size_t n);
+
+/**
+ * Returns a block to the pool.
+ * @param p A pointer returned by allocate, or NULL.
+ * @param n The size with which the block was allocated.
+ */
+void deallocate (void *p, std::size_t n) noexcept;
+
+/** @returns The number of chunks allocated so far, by all threads. */
+std::size_t chunks ();
+
+} // namespace pool
+
+/**
+ * A stateless standard allocator drawing from optk::pool; this allows
+ * containers of small nodes, such as std::unordered_map, to use the pool.
+ */
+template <class T>
+class pool_allocator {
+    public:
+        typedef T value_type;
+
+        pool_allocator () noexcept {}
+
+        template <class U>
+        pool_allocator (const pool_allocator<U> &) noexcept {}
+
+        T *
+        allocate (std::size_t n)
+        {
+            if (!pool::enabled)
+                return static_cast<T *>(::operator new (n * sizeof (T)));
+            return static_cast<T *>(pool::allocate (n * sizeof (T)));
+        }
+
+        void
+        deallocate (T *p, std::size_t n) noexcept
+        {
+            if (!pool::enabled)
+                ::operator delete (p);
+            else
+                pool::deallocate (p, n * sizeof (T));
+        }
+};
+
+template <class T, class U> bool
+operator== (const pool_allocator<T> &, const pool_allocator<U> &)
+{
+    return true;
+}
+
+template <class T, class U> bool
+operator!= (const pool_allocator<T> &, const pool_allocator<U> &)
+{
+    return false;
+}
+
+} // namespace optk
+
+#endif // __POOL_H_
@@ -0,0 +1,298 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A buffered, thread-safe sink for benchmark results.
+ */
+
+#ifndef __RESULTS_H_
+#define __RESULTS_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <optk/stats.hpp>
+
+namespace optk {
+
+/** The layouts in which results may be written. */
+enum class result_format: char {
+    /** One row per run, and one column per iteration.                     */
+    csv,
+    /** The fixed-layout binary format described below.                   */
+    columnar
+};
+
+/**
+ * The columnar format is designed to be memory-mapped and read without
+ * copies or parsing (e.g. with numpy.memmap). All integers are in native
+ * (little-endian) byte order, and all offsets are from the start of the
+ * file. The file begins with a 64-byte header:
+ *
+ *     offset  type      field
+ *     0       char[8]   magic, "OPTKCOL1"
+ *     8       uint32    iters, the number of trace entries in each run
+ *     12      uint32    stride, the number of iterations per entry, or 0
+ *                       when the entries are the named columns of summaries
+ *     16      uint64    runs, the number of runs
+ *     24      uint64    offset of the value column
+ *     32      uint64    offset of the run table
+ *     40      uint64    offset of the metadata
+ *     48      uint64    size of the metadata, in bytes
+ *     56      uint64    reserved (0)
+ *
+ * The value column is a double[runs][iters] array, so that the iteration of a
+ * value is implied by its position (see optk::trace). The run table holds the
+ * per-run columns uint64 seed[runs], uint32 benchmark[runs], uint32
+ * optimiser[runs] and uint32 statistic[runs], the latter three indexing into
+ * the "benchmarks", "optimisers" and "statistics" lists of the metadata,
+ * which is a JSON object also listing the properties of each benchmark, and
+ * the names of the columns if the entries are summaries. The
+ * statistic of a single run is "value"; aggregated replicates have one run
+ * per statistic (such as "mean" or "median"), with seed 0. Sweeps which
+ * record costs follow each run with its cost, as statistic "cost" (or
+ * "cost_mean", "cost_median" and so on).
+ *
+ * Values are written as runs complete; the run count in the header covers
+ * those which have reached the disk, while the run table and metadata are
+ * written when the writer is destroyed.
+ */
+static const size_t columnar_header_size = 64;
+
+/**
+ * Writes the rows of a results file. Rows may be submitted concurrently
+ * and in any order; they are written out in the order of their indices, as
+ * soon as all the rows before them are available.
+ *
+ * Output is buffered in memory, and flushed to disk whenever the buffer
+ * fills and at least every flush interval by a background thread, so that a
+ * crashed run still leaves the rows completed up to the last interval.
+ */
+class result_writer {
+    public:
+        /**
+         * The constructor; truncates (or creates) the output file.
+         * @param path The path of the output file.
+         * @param format The layout of the output file.
+         * @param flush_ms The longest time, in milliseconds, for which a
+         * completed row may remain unwritten; zero disables the background
+         * flush.
+         * @param capacity The size of the output buffer, in bytes.
+         * @throws std::runtime_error if the file cannot be opened.
+         */
+        result_writer (
+                const std::string &path,
+                result_format format = result_format::csv,
+                uint flush_ms = 1000,
+                size_t capacity = 1 << 16
+                );
+
+        /** Flushes any outstanding rows, and closes the file. */
+        ~result_writer ();
+
+        /**
+         * Writes the header row, whose columns are labelled by the last
+         * iteration which each trace entry summarises.
+         * @param iters The number of iterations in each run.
+         * @param stride The number of iterations per trace entry.
+         * @param statistics Whether rows carry the statistic which they
+         * summarise, in a column after the optimiser.
+         */
+        void header (uint iters, uint stride = 1, bool statistics = false);
+
+        /**
+         * Writes the header row of runs which are summarised by named
+         * columns, rather than traced (see trace::summary_columns).
+         * @param columns The names of the columns.
+         * @param statistics As above.
+         */
+        void header (const std::vector<std::string> &columns,
+                bool statistics = false);
+
+        /**
+         * Reserves a block of consecutive row indices.
+         * @param n The number of rows in the block.
+         * @returns The index of the first row in the block.
+         */
+        uint reserve (uint n);
+
+        /**
+         * Submits a row; this may be called from any thread.
+         * @param row The index of the row, within a reserved block.
+         * @param bench The name of the benchmark.
+         * @param opt The name of the optimiser.
+         * @param trace The values of the objective function at each iteration.
+         * @param n The number of entries in the trace.
+         * @param seed The seed of the optimiser for this run.
+         * @param props The properties of the benchmark.
+         * @param stat The statistic which the row summarises, if any.
+         * @throws std::invalid_argument if, in the columnar format, n differs
+         * from the number of trace entries given by the header.
+         */
+        void submit (
+                uint row,
+                const std::string &bench,
+                const std::string &opt,
+                const double *trace,
+                uint n,
+                uint64_t seed = 0,
+                const std::vector<std::string> &props = {},
+                const std::string &stat = "value"
+                );
+
+        /** Writes all the buffered output through to the file. */
+        void flush ();
+
+        /**
+         * Appends a double to a string, formatted as std::ostream would with
+         * its default settings (as %g), but without the iostream overhead.
+         * @param out The string to append to.
+         * @param v The value to format.
+         */
+        static void format (std::string &out, double v);
+
+    private:
+        /** A formatted row, and the facts recorded in the run table. */
+        struct entry {
+            std::string data, bench, opt, stat;
+            std::vector<std::string> props;
+            uint64_t seed;
+        };
+
+        /** Writes the header row, with the given column labels. */
+        void write_header (const std::vector<std::string> &labels,
+                uint stride, bool statistics);
+
+        /** Appends a row to the output; the lock must be held. */
+        void emit (entry &e);
+
+        /** Writes out the buffer; the lock must be held. */
+        void drain ();
+
+        /** Writes the run table and metadata of a columnar file. */
+        void finish_columnar ();
+
+        /** The loop run by the background flushing thread. */
+        void flusher ();
+
+        std::FILE *m_file;
+        const result_format m_format;
+        size_t m_capacity;
+        std::chrono::milliseconds m_interval;
+
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::thread m_thread;
+        bool m_stop;
+
+        /** Output which is ready to be written, in order.                  */
+        std::string m_buf;
+        /** Rows which arrived before some row preceding them.              */
+        std::map<uint, entry> m_pending;
+        /** The index of the next row to write, and of the next to reserve. */
+        uint m_next, m_reserved;
+
+        /** The columnar run table, and the names which it indexes.         */
+        uint m_entries;
+        uint64_t m_written;
+        std::vector<uint64_t> m_seeds;
+        std::vector<uint32_t> m_bench_ids, m_opt_ids, m_stat_ids;
+        std::vector<std::string> m_benches, m_opts, m_stats, m_columns;
+        std::vector<std::vector<std::string>> m_props;
+        std::unordered_map<std::string, uint32_t> m_bench_idx, m_opt_idx,
+            m_stat_idx;
+        bool m_statistics;
+};
+
+/**
+ * Collects the traces of a sweep, which runs every (optimiser, benchmark)
+ * pair some number of times, and writes them out in pair order whatever the
+ * order in which they complete. A single run of each pair is written out as
+ * it is; replicated runs are aggregated as they complete, so that only their
+ * statistics are kept, and the statistics are written once all the
+ * replicates of a pair are in. This is thread-safe.
+ */
+class sweep_rows {
+    public:
+        /**
+         * Reserves the rows of the sweep in the writer.
+         * @param out The results sink.
+         * @param pairs The number of (optimiser, benchmark) pairs.
+         * @param reps The number of replicates of each pair.
+         * @param costs Whether the traces carry costs (see trace::span); the
+         * costs are then written as rows of their own.
+         */
+        sweep_rows (result_writer *out, uint pairs, uint reps,
+                bool costs = false);
+
+        /** @returns Whether the replicates are summarised by statistics. */
+        bool aggregate () { return m_reps > 1; }
+
+        /**
+         * Adds the trace of a run. Replicates are aggregated in the order of
+         * their indices, whatever the order in which they are added, so that
+         * the quantile estimates do not depend on the scheduling.
+         * @param pair The index of the run's pair.
+         * @param rep The index of the replicate.
+         * @param seed The seed of the run.
+         * @param trace The run's trace.
+         * @param n The number of doubles in the trace, which is its span.
+         * @param bench The name of the benchmark.
+         * @param opt The name of the optimiser.
+         * @param props The properties of the benchmark.
+         */
+        void add (
+                uint pair,
+                uint rep,
+                uint64_t seed,
+                const double *trace,
+                uint n,
+                const std::string &bench,
+                const std::string &opt,
+                const std::vector<std::string> &props);
+
+    private:
+        /**
+         * The statistics of the replicates of a pair which have been
+         * aggregated, and the traces of those waiting for their predecessors.
+         */
+        typedef struct {
+            std::mutex mtx;
+            std::unique_ptr<trace_stats> stats;
+            uint done = 0;
+            std::map<uint, std::vector<double>> early;
+        } pair_state;
+
+        result_writer *m_out;
+        uint m_reps, m_first;
+        bool m_costs;
+        std::vector<pair_state> m_pairs;
+};
+
+} // namespace optk
+
+#endif // __RESULTS_H_
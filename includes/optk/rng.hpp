@@ -0,0 +1,237 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A small, fast and seedable pseudo-random number generator.
+ */
+
+#ifndef __RNG_H_
+#define __RNG_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace optk {
+
+/**
+ * xoshiro256** (Blackman and Vigna), a 256-bit state generator which passes
+ * the usual statistical test suites, and is much smaller and faster than
+ * std::mt19937. It satisfies the UniformRandomBitGenerator requirements, so
+ * it may also be used with the standard library distributions.
+ *
+ * A generator is not thread safe; each thread should either own one or use
+ * thread_rng.
+ */
+class rng {
+    public:
+        typedef uint64_t result_type;
+
+        /** The complete state of a generator, so that it can be saved. */
+        typedef struct {
+            uint64_t s[4];
+            bool has_spare;
+            double spare;
+        } state_t;
+
+        /**
+         * The constructor.
+         * @param s The seed; any value, including 0, is acceptable.
+         */
+        explicit rng (uint64_t s = 0) { seed (s); }
+
+        /**
+         * Resets the state of the generator from a seed, which is expanded
+         * with splitmix64 as recommended by the authors.
+         * @param s The seed.
+         */
+        void
+        seed (uint64_t s)
+        {
+            for (int i = 0; i < 4; i++)
+                m_s[i] = splitmix (s);
+            m_has_spare = false;
+            m_spare = 0.;
+        }
+
+        /** @returns The state of the generator. */
+        state_t
+        state () const
+        {
+            state_t st;
+            std::copy (m_s, m_s + 4, st.s);
+            st.has_spare = m_has_spare;
+            st.spare = m_spare;
+            return st;
+        }
+
+        /**
+         * Restores a state returned by state, so that the generator continues
+         * from where that one was.
+         * @param st The state.
+         */
+        void
+        restore (const state_t &st)
+        {
+            std::copy (st.s, st.s + 4, m_s);
+            m_has_spare = st.has_spare;
+            m_spare = st.spare;
+        }
+
+        /**
+         * Derives the seed of an independent stream from a base seed, for
+         * instance to give every (benchmark, optimiser) pair its own
+         * reproducible generator.
+         * @param s The base seed.
+         * @param stream The index of the stream.
+         */
+        static uint64_t
+        derive (uint64_t s, uint64_t stream)
+        {
+            uint64_t x = s ^ (stream * 0xd1342543de82ef95ull);
+            splitmix (x);
+            return splitmix (x);
+        }
+
+        static constexpr result_type min () { return 0; }
+        static constexpr result_type max ()
+        { return std::numeric_limits<result_type>::max (); }
+
+        /** @returns the next 64 random bits. */
+        result_type
+        operator() ()
+        {
+            const uint64_t res = rotl (m_s[1] * 5, 7) * 9;
+            const uint64_t t = m_s[1] << 17;
+
+            m_s[2] ^= m_s[0];
+            m_s[3] ^= m_s[1];
+            m_s[1] ^= m_s[2];
+            m_s[0] ^= m_s[3];
+            m_s[2] ^= t;
+            m_s[3] = rotl (m_s[3], 45);
+
+            return res;
+        }
+
+        /** @returns a double drawn uniformly from [0, 1), with 53 bits. */
+        double
+        uniform ()
+        {
+            return (double) ((*this) () >> 11) * 0x1.0p-53;
+        }
+
+        /** @returns a double drawn uniformly from [lower, upper). */
+        double
+        uniform (double lower, double upper)
+        {
+            return lower + (upper - lower) * uniform ();
+        }
+
+        /**
+         * Draws an integer uniformly, without bias, using Lemire's
+         * multiply-and-reject method.
+         * @returns an integer in the closed range [lower, upper].
+         */
+        int64_t
+        uniform_int (int64_t lower, int64_t upper)
+        {
+            uint64_t range = (uint64_t) (upper - lower) + 1;
+            if (range == 0)
+                return (int64_t) (*this) ();
+
+            unsigned __int128 m = (unsigned __int128) (*this) () * range;
+            uint64_t l = (uint64_t) m;
+            if (l < range) {
+                uint64_t t = -range % range;
+                while (l < t) {
+                    m = (unsigned __int128) (*this) () * range;
+                    l = (uint64_t) m;
+                }
+            }
+            return lower + (int64_t) (m >> 64);
+        }
+
+        /**
+         * Draws from a normal distribution with the Marsaglia polar method;
+         * every other call is served from the spare value.
+         * @returns a sample from \f$\mathcal{N}(\mu, \sigma^2)\f$.
+         */
+        double
+        normal (double mu = 0., double sigma = 1.)
+        {
+            if (m_has_spare) {
+                m_has_spare = false;
+                return mu + sigma * m_spare;
+            }
+
+            double u, v, s;
+            do {
+                u = 2. * uniform () - 1.;
+                v = 2. * uniform () - 1.;
+                s = u * u + v * v;
+            } while (s >= 1. || s == 0.);
+            s = std::sqrt (-2. * std::log (s) / s);
+
+            m_spare = v * s;
+            m_has_spare = true;
+            return mu + sigma * u * s;
+        }
+
+    private:
+        static uint64_t
+        rotl (uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        static uint64_t
+        splitmix (uint64_t &x)
+        {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t m_s[4];
+        bool m_has_spare;
+        double m_spare;
+};
+
+/**
+ * @returns the calling thread's generator. Each thread's generator is seeded
+ * from the global seed (see set_seed) and the order in which the threads
+ * first called this function.
+ */
+rng &thread_rng ();
+
+/**
+ * Sets the global seed, and reseeds every thread's generator from it as the
+ * thread next calls thread_rng. Until this is called, the global seed is
+ * drawn from std::random_device.
+ * @param s The new global seed.
+ */
+void set_seed (uint64_t s);
+
+/** @returns the global seed. */
+uint64_t get_seed ();
+
+} // namespace optk
+
+#endif // __RNG_H_
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Streaming statistics, for aggregating replicated runs.
+ */
+
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace optk {
+
+/**
+ * Welford's online algorithm for the mean and variance of a stream, which is
+ * numerically stable and needs constant memory.
+ */
+class welford {
+    public:
+        welford (): m_n (0), m_mean (0), m_m2 (0) { }
+
+        /** Adds an observation. */
+        void
+        add (double x)
+        {
+            m_n++;
+            double d = x - m_mean;
+            m_mean += d / m_n;
+            m_m2 += d * (x - m_mean);
+        }
+
+        /** @returns The number of observations. */
+        uint64_t count () { return m_n; }
+
+        /** @returns The mean of the observations. */
+        double mean () { return m_mean; }
+
+        /** @returns The sample (n - 1) variance, or 0 for fewer than two. */
+        double variance () { return m_n > 1 ? m_m2 / (m_n - 1) : 0.; }
+
+        /** @returns The sample standard deviation. */
+        double stddev () { return std::sqrt (variance ()); }
+
+    private:
+        uint64_t m_n;
+        double m_mean, m_m2;
+};
+
+/**
+ * The P-squared algorithm of Jain and Chlamtac (1985), which estimates a
+ * quantile of a stream from five markers, without storing the observations.
+ * The estimate is exact for up to five observations.
+ */
+class p2_quantile {
+    public:
+        /** @param p The quantile to estimate, in (0, 1). */
+        p2_quantile (double p = .5);
+
+        /** Adds an observation. */
+        void add (double x);
+
+        /** @returns The current estimate, or NaN if nothing was added. */
+        double value ();
+
+    private:
+        double m_p;
+        uint64_t m_count;
+        /** Marker heights, and actual and desired marker positions. */
+        double m_q[5], m_n[5], m_np[5];
+};
+
+/**
+ * Aggregates replicated traces entry by entry: the mean, standard deviation,
+ * extremes and quartiles of each trace entry over the replicates, in memory
+ * independent of the number of replicates.
+ */
+class trace_stats {
+    public:
+        /** The statistics, in the order of the rows returned by row. */
+        enum statistic: char {
+            mean, stddev, min, q25, median, q75, max
+        };
+
+        /** The number of statistics. */
+        static const uint count = 7;
+
+        /** @returns The name of a statistic, as used in the output. */
+        static const char *name (uint s);
+
+        /** @param entries The number of entries in each trace. */
+        trace_stats (uint entries);
+
+        /** Adds one replicate's trace, of the given number of entries. */
+        void add (const double *trace);
+
+        /** @returns The number of traces added. */
+        uint64_t replicates () { return m_n; }
+
+        /**
+         * Computes one statistic of every entry.
+         * @param s The statistic.
+         * @param out The entries of the statistic are written here.
+         */
+        void row (uint s, double *out);
+
+    private:
+        uint m_entries;
+        uint64_t m_n;
+        std::vector<welford> m_moments;
+        std::vector<double> m_min, m_max;
+        std::vector<p2_quantile> m_q25, m_median, m_q75;
+};
+
+} // namespace optk
+
+#endif // __STATS_H_
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A simple fixed-size thread pool used to run work concurrently.
+ */
+
+#ifndef __THREADPOOL_H_
+#define __THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace optk {
+
+/**
+ * A fixed-size pool of worker threads which execute submitted tasks in FIFO
+ * order. The pool is used to run independent (benchmark, optimiser) pairs
+ * concurrently.
+ */
+class thread_pool {
+    public:
+        /**
+         * The constructor; starts the worker threads.
+         * @param n The number of worker threads; values less than one are
+         * treated as one.
+         */
+        thread_pool (uint n);
+
+        /**
+         * The destructor waits for all outstanding tasks to complete before
+         * joining the worker threads.
+         */
+        ~thread_pool ();
+
+        /**
+         * Queue a task for execution on one of the worker threads.
+         * @param task The task to run.
+         */
+        void submit (std::function<void()> task);
+
+        /**
+         * Blocks until every task submitted so far has completed. If any task
+         * threw an exception, the first such exception is rethrown here.
+         */
+        void wait ();
+
+        /**
+         * Calls f (i) for every i in [0, n), spreading the calls across the
+         * worker threads, and returns once all of them have completed. The
+         * calling thread takes part in the work, so this may be called from
+         * within a task running on this same pool without deadlocking, even
+         * when every worker is busy.
+         * @param n The number of iterations.
+         * @param f The loop body.
+         * @throws Rethrows the first exception thrown by f, once all the
+         * other iterations have finished.
+         */
+        void parallel_for (uint n, std::function<void(uint)> f);
+
+        /** @returns The number of worker threads in the pool. */
+        uint size () { return m_workers.size(); }
+
+    private:
+        /** The loop run by each of the worker threads. */
+        void worker ();
+
+        std::vector<std::thread> m_workers;
+        std::queue<std::function<void()>> m_tasks;
+
+        std::mutex m_mtx;
+        /** Signalled when a task is queued, or the pool is stopping.        */
+        std::condition_variable m_task_cv;
+        /** Signalled when the number of outstanding tasks reaches zero.     */
+        std::condition_variable m_done_cv;
+
+        /** The number of tasks which are queued or running.                 */
+        uint m_pending;
+        bool m_stop;
+        /** The first exception thrown by a task, if any.                    */
+        std::exception_ptr m_err;
+};
+
+} // namespace optk
+
+#endif // __THREADPOOL_H_
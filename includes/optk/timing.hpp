@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Optional per-phase timing of the core optimisation loops.
+ *
+ * The instrumentation is compiled out unless __OPTK_TIMING is defined (build
+ * with `make TIMING=1`); the OPTK_TIME macros then expand to nothing, so
+ * that the loops pay nothing for it.
+ */
+
+#ifndef __TIMING_H_
+#define __TIMING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+namespace optk {
+
+/** The phases of an iteration which are timed separately. */
+enum class phase: char {
+    /** opt->generate_parameters (or generate_batch)                       */
+    generate,
+    /** bench->evaluate, including any validation                          */
+    evaluate,
+    /** The validation of parameters within evaluate                       */
+    validate,
+    /** opt->receive_trial_results (or receive_batch)                      */
+    receive
+};
+
+/** The number of phases. */
+static const uint n_phases = 4;
+
+/** @returns The name of a phase, as used in the output. */
+const char *phase_name (phase p);
+
+/**
+ * Accumulates the durations of the phases of one (benchmark, optimiser)
+ * pair: the number of calls, their total and maximum durations, and a
+ * histogram with one bucket per power of two nanoseconds. Durations may be
+ * added from several threads at once.
+ */
+class timings {
+    public:
+        /** Bucket k counts durations of [2^k, 2^(k+1)) ns; the last bucket
+         * also counts any longer ones. */
+        static const uint buckets = 40;
+
+        timings () { clear (); }
+
+        /** Adds a duration to a phase. */
+        void
+        add (phase p, uint64_t ns)
+        {
+            counter &c = m_phases[(uint) p];
+            c.calls.fetch_add (1, std::memory_order_relaxed);
+            c.total.fetch_add (ns, std::memory_order_relaxed);
+            uint64_t prev = c.max.load (std::memory_order_relaxed);
+            while (ns > prev && !c.max.compare_exchange_weak (prev, ns,
+                        std::memory_order_relaxed))
+                ;
+            uint b = ns ? 63 - __builtin_clzll (ns) : 0;
+            c.hist[b < buckets ? b : buckets - 1].fetch_add (1,
+                    std::memory_order_relaxed);
+        }
+
+        /** Resets every counter to zero. */
+        void
+        clear ()
+        {
+            for (counter &c: m_phases) {
+                c.calls = 0;
+                c.total = 0;
+                c.max = 0;
+                for (std::atomic<uint64_t> &h: c.hist)
+                    h = 0;
+            }
+        }
+
+        uint64_t calls (phase p) { return m_phases[(uint) p].calls; }
+        uint64_t total (phase p) { return m_phases[(uint) p].total; }
+        uint64_t max (phase p) { return m_phases[(uint) p].max; }
+        uint64_t hist (phase p, uint b) { return m_phases[(uint) p].hist[b]; }
+
+        /**
+         * Formats the header of the timing csv file.
+         * @returns The header line, terminated by a newline.
+         */
+        static std::string csv_header ();
+
+        /**
+         * Formats one csv line per phase which was called at least once.
+         * @param bench The name of the benchmark.
+         * @param opt The name of the optimiser.
+         */
+        std::string csv_rows (const std::string &bench, const std::string &opt);
+
+        /**
+         * The timings to which validation within evaluate is attributed on
+         * the calling thread, or NULL; see OPTK_TIME_SINK.
+         */
+        static timings *&
+        current ()
+        {
+            static thread_local timings *t = NULL;
+            return t;
+        }
+
+    private:
+        struct counter {
+            std::atomic<uint64_t> calls, total, max;
+            std::atomic<uint64_t> hist[buckets];
+        };
+        counter m_phases[n_phases];
+};
+
+/** Adds the lifetime of the timer to a phase of some timings, if any. */
+class scoped_timer {
+    public:
+        scoped_timer (timings *t, phase p):
+            m_t (t), m_p (p), m_start (std::chrono::steady_clock::now ())
+        { }
+
+        ~scoped_timer ()
+        {
+            if (m_t)
+                m_t->add (m_p, std::chrono::duration_cast<
+                        std::chrono::nanoseconds> (
+                            std::chrono::steady_clock::now () - m_start
+                        ).count ());
+        }
+
+    private:
+        timings *m_t;
+        phase m_p;
+        std::chrono::steady_clock::time_point m_start;
+};
+
+/** Makes some timings current on this thread for the lifetime of the scope. */
+class scoped_sink {
+    public:
+        scoped_sink (timings *t): m_prev (timings::current ())
+        { timings::current () = t; }
+
+        ~scoped_sink () { timings::current () = m_prev; }
+
+    private:
+        timings *m_prev;
+};
+
+} // namespace optk
+
+#define __OPTK_CAT2(a, b) a ## b
+#define __OPTK_CAT(a, b) __OPTK_CAT2(a, b)
+
+#ifdef __OPTK_TIMING
+/** Times the rest of the enclosing scope as phase p of the timings t. */
+#define OPTK_TIME(t, p) \
+    optk::scoped_timer __OPTK_CAT(__optk_timer_, __LINE__) (t, p)
+/** Attributes phases timed with optk::timings::current () to t. */
+#define OPTK_TIME_SINK(t) \
+    optk::scoped_sink __OPTK_CAT(__optk_sink_, __LINE__) (t)
+#else
+#define OPTK_TIME(t, p)
+#define OPTK_TIME_SINK(t)
+#endif
+
+#endif // __TIMING_H_
@@ -0,0 +1,322 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief A buffer for the objective values of a run, optionally reduced.
+ */
+
+#ifndef __TRACE_H_
+#define __TRACE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <optk/timing.hpp>
+
+namespace optk {
+
+/**
+ * Records the objective value of every iteration of a run. The trace is
+ * heap allocated, so that budgets of millions of iterations are safe, and may
+ * be reduced to one entry per stride iterations, so that long runs need not
+ * keep O(n) values per (benchmark, optimiser) pair.
+ *
+ * Entry j summarises iterations [j * stride, (j + 1) * stride): either the
+ * value of the latest of them, or the best (lowest) value found up to it.
+ * Entries for iterations which were never run are left at zero.
+ *
+ * A trace may also record the cost of each evaluation, as reported by the
+ * benchmark (see benchmark::cost). Cost entry j holds the total cost of the
+ * iterations up to the latest of those which entry j summarises; the cost
+ * entries follow the values in data, so that saving span () doubles from
+ * data saves both.
+ *
+ * A trace may instead summarise its run in a fixed number of entries, named
+ * by summary_columns, which are updated online from the exact values of the
+ * evaluations, without noise or error at low fidelity (see record), so that
+ * only a point which truly comes close to the optimum reaches the target:
+ * the best value so far, its regret and log10 regret from the benchmark's
+ * known optimum (see target), the number of evaluations and seconds so far,
+ * whether the best value has come within eps of the optimum (1 or 0), and
+ * the evaluations and seconds which that took. If costs are recorded, the
+ * total cost and the cost to reach the target follow. Until the target is
+ * reached, the costs to reach it are those so far, so that replicates can be
+ * aggregated as censored values, as for the expected running time. This
+ * holds O(1) values per run whatever the budget.
+ *
+ * When built with __OPTK_TIMING, a trace also carries the phase timings of
+ * its run.
+ */
+class trace {
+    public:
+        /**
+         * The constructor.
+         * @param iters The maximum number of iterations to be recorded.
+         * @param stride The number of iterations summarised by each entry;
+         * values less than one are treated as one.
+         * @param best Whether to record the best value so far rather than
+         * the latest value.
+         * @param costs Whether to record the costs of the evaluations.
+         * @param summary Whether to summarise the run rather than record its
+         * values; the stride and best are then ignored.
+         */
+        trace (uint iters, uint stride = 1, bool best = false,
+                bool costs = false, bool summary = false):
+            m_iters (iters), m_stride (std::max (stride, 1u)), m_best (best),
+            m_entries (summary ? summary_columns (costs).size () :
+                    (iters + m_stride - 1) / m_stride),
+            m_costs (costs), m_summary (summary),
+            m_data (m_entries * (costs && !summary ? 2 : 1), 0.),
+            m_opt (std::numeric_limits<double>::quiet_NaN ()), m_eps (0.)
+        { clear (); }
+
+        /**
+         * @returns The names of the entries of a summary.
+         * @param costs Whether the summary includes costs.
+         */
+        static std::vector<std::string>
+        summary_columns (bool costs)
+        {
+            std::vector<std::string> cols = {
+                "best", "regret", "log10_regret", "evals", "seconds",
+                "reached", "evals_to_target", "seconds_to_target"
+            };
+            if (costs) {
+                cols.push_back ("cost");
+                cols.push_back ("cost_to_target");
+            }
+            return cols;
+        }
+
+        /**
+         * Sets the optimum against which a summary measures its run; until
+         * this is called, the regret is NaN and the target is never reached.
+         * @param opt The known global minimum.
+         * @param eps How close to opt the best value must come to reach the
+         * target.
+         */
+        void
+        target (double opt, double eps)
+        {
+            m_opt = opt;
+            m_eps = eps;
+        }
+
+        /**
+         * Records the value of the next iteration.
+         * @param v The value of the objective function.
+         * @param cost The cost of the evaluation, if costs are recorded.
+         */
+        void record (double v, double cost = 0.) { record (v, cost, v); }
+
+        /**
+         * As above, for a value which carries noise or an error at low
+         * fidelity (see benchmark::exact).
+         * @param exact The value without them, which a summary measures.
+         */
+        void
+        record (double v, double cost, double exact)
+        {
+            m_cost += cost;
+            if (m_summary) {
+                summarise (exact);
+                return;
+            }
+            if (v < m_min)
+                m_min = v;
+            uint j = m_count++ / m_stride;
+            m_data[j] = m_best ? m_min : v;
+            if (m_costs)
+                m_data[m_entries + j] = m_cost;
+        }
+
+        /** Discards all the recorded values. */
+        void
+        clear ()
+        {
+            std::fill (m_data.begin (), m_data.end (), 0.);
+            m_count = 0;
+            m_min = std::numeric_limits<double>::infinity ();
+            m_cost = 0.;
+            m_reached = false;
+            m_start = std::chrono::steady_clock::now ();
+            if (m_summary) {
+                const double inf = std::numeric_limits<double>::infinity ();
+                std::fill (m_data.begin (), m_data.begin () + evals, inf);
+            }
+#ifdef __OPTK_TIMING
+            m_timings.clear ();
+#endif
+        }
+
+        /** @returns The entries of the trace; those of a summary are
+         * brought up to date. */
+        double *
+        data ()
+        {
+            if (m_summary) {
+                m_data[seconds] = elapsed ();
+                if (!m_reached)
+                    m_data[seconds_to_target] = m_data[seconds];
+            }
+            return m_data.data ();
+        }
+
+        /** @returns The number of entries in the trace. */
+        uint size () { return m_entries; }
+
+        /** @returns Whether the trace records costs. */
+        bool costed () { return m_costs; }
+
+        /** @returns Whether the trace summarises its run. */
+        bool summary () { return m_summary; }
+
+        /** @returns The cost entries, or NULL if costs are not recorded
+         * apart from the values, as in summaries. */
+        double *
+        costs ()
+        {
+            return m_costs && !m_summary ? m_data.data () + m_entries : NULL;
+        }
+
+        /** @returns The number of doubles at data: the entries, followed by
+         * the cost entries if costs are recorded. */
+        uint span () { return m_data.size (); }
+
+        /** @returns The maximum number of iterations. */
+        uint iters () { return m_iters; }
+
+        /** @returns The number of iterations recorded so far. */
+        uint count () { return m_count; }
+
+        /** @returns The number of iterations summarised by each entry. */
+        uint stride () { return m_stride; }
+
+        /** @returns Whether entries hold the best value so far. */
+        bool best () { return m_best; }
+
+        /** @returns The lowest value recorded so far; in a summary, the
+         * lowest exact value. */
+        double min () { return m_min; }
+
+        /**
+         * Resumes a trace from a snapshot, once the saved span has been
+         * written through data.
+         * @param count The number of iterations recorded in the snapshot.
+         * @param min The lowest value among them.
+         */
+        void
+        resume (uint count, double min)
+        {
+            m_count = count;
+            m_min = min;
+            if (m_summary) {
+                m_reached = m_data[reached] != 0.;
+                m_start = std::chrono::steady_clock::now () -
+                    std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration> (
+                                std::chrono::duration<double> (
+                                    m_data[seconds]));
+                if (m_costs)
+                    m_cost = m_data[total_cost];
+            } else if (m_costs && count > 0) {
+                m_cost = m_data[m_entries + (count - 1) / m_stride];
+            }
+        }
+
+#ifdef __OPTK_TIMING
+        /** @returns The phase timings of the run. */
+        optk::timings *timings () { return &m_timings; }
+#endif
+
+        /**
+         * @returns The last iteration summarised by entry j, by which it is
+         * labelled in the output.
+         */
+        static uint
+        iteration (uint j, uint iters, uint stride)
+        {
+            return std::min ((uint64_t) (j + 1) * stride, (uint64_t) iters) - 1;
+        }
+
+    private:
+        /** The positions of the entries of a summary. */
+        enum : uint {
+            best_value, regret, log10_regret, evals, seconds, reached,
+            evals_to_target, seconds_to_target, total_cost, cost_to_target
+        };
+
+        /** @returns The seconds since the run started. */
+        double
+        elapsed ()
+        {
+            return std::chrono::duration<double> (
+                    std::chrono::steady_clock::now () - m_start).count ();
+        }
+
+        /** Updates a summary with the exact value of the next iteration. */
+        void
+        summarise (double v)
+        {
+            double *s = m_data.data ();
+            s[evals] = ++m_count;
+            if (m_costs)
+                s[total_cost] = m_cost;
+            if (v < m_min) {
+                m_min = v;
+                s[best_value] = v;
+                s[regret] = v - m_opt;
+                // a regret of zero, or below it by rounding
+                s[log10_regret] = std::log10 (std::max (s[regret], 1e-300));
+            }
+            if (m_reached)
+                return;
+            s[evals_to_target] = m_count;
+            if (m_costs)
+                s[cost_to_target] = m_cost;
+            if (s[regret] <= m_eps) {
+                m_reached = true;
+                s[reached] = 1.;
+                s[seconds_to_target] = elapsed ();
+            }
+        }
+
+        uint m_iters, m_stride;
+        bool m_best;
+        uint m_entries;
+        bool m_costs, m_summary;
+        std::vector<double> m_data;
+        uint m_count;
+        double m_min, m_cost;
+        /** The optimum and tolerance of a summary's target.                */
+        double m_opt, m_eps;
+        bool m_reached;
+        std::chrono::steady_clock::time_point m_start;
+#ifdef __OPTK_TIMING
+        optk::timings m_timings;
+#endif
+};
+
+} // namespace optk
+
+#endif // __TRACE_H_
@@ -28,10 +28,10 @@
 #ifndef __TYPES_H_
 #define __TYPES_H_
 
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
 #include <memory>
-#include <random>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -40,14 +40,33 @@
 
 #include <sys/types.h>
 
+#include <optk/pool.hpp>
+#include <optk/rng.hpp>
+
 // Program context ------------------------------------------------------------
 
 namespace optk {
 
+class result_writer;
+class checkpoint;
+class eval_cache;
+
 typedef struct {
     std::string outfile;    /// The name of the output file
+    result_writer *results; /// The sink to which results are written
     uint max_iters;         /// Max number of iterations to run per benchmark
+    uint stride;            /// The number of iterations per trace entry
+    bool best;              /// Record the best value so far in the trace
+    bool costs;             /// Record the costs of the evaluations too
+    bool summary;           /// Summarise each run rather than trace it
+    double eps;             /// The tolerance of the summaries' target
+    uint repeats;           /// The number of seeded replicates of each pair
     int threads;            /// The number of threads to use
+    uint batch;             /// The number of trials to evaluate at once
+    bool async;             /// Evaluate trials asynchronously
+    uint64_t seed;          /// The seed from which all generators derive
+    checkpoint *ckpt;       /// Where to save progress, or NULL
+    eval_cache *cache;      /// The cache of evaluations to use, or NULL
     bool error;             /// Flags whether an error has occurred
 } ctx_t;
 
@@ -82,8 +101,14 @@ class node;
  * values. */
 typedef node *set;
 
-/** This is used to succinctly describe a map of key, parameter pairs. */
-typedef std::unordered_map <std::string, param *> value_map;
+/** This is used to succinctly describe a map of key, parameter pairs. The
+ * map's nodes are allocated from optk::pool. */
+typedef std::unordered_map <
+    std::string, param *,
+    std::hash<std::string>,
+    std::equal_to<std::string>,
+    optk::pool_allocator<std::pair<const std::string, param *>>
+    > value_map;
 
 /** This is the format used to pass sets of parameter values between
  * optimisation algorithms and the benchmarks / problems being optimised. */
@@ -94,9 +119,37 @@ class param {
         inst_t get_type () { return type; }
         std::string get_key() { return key; }
 
+        /** Parameter values are allocated from optk::pool; they must be
+         * deleted through a pointer to their concrete type (see free_node). */
+        static void *
+        operator new (std::size_t n)
+        {
+            if (!optk::pool::enabled)
+                return ::operator new (n);
+            return optk::pool::allocate (n);
+        }
+
+        static void
+        operator delete (void *p, std::size_t n)
+        {
+            if (!optk::pool::enabled)
+                ::operator delete (p);
+            else
+                optk::pool::deallocate (p, n);
+        }
+
+    protected:
+        /** Tells the node holding this value that it has changed, so that
+         * the node's dense() copy is rebuilt. */
+        void changed ();
+
     private:
+        friend class node;
+
         const std::string key;
         const inst_t type;
+        /** The node to which this value was last added, if any.            */
+        node *owner;
 };
 
 // Could have used a template class for the following three classes, however
@@ -110,8 +163,10 @@ class int_val: public param {
         int_val (const std::string &k, int v);
 
         int get_val () { return val; }
-        void update_val (int v) { val = v; };
-        int *get_addr () { return &val; }
+        void update_val (int v) { val = v; changed (); };
+        /** As the value may be written through the pointer, this counts as
+         * a change (see node::dense). */
+        int *get_addr () { changed (); return &val; }
 
     private:
         int val;
@@ -123,8 +178,10 @@ class dbl_val: public param {
         dbl_val (const std::string &k, double v);
 
         double get_val () { return val; }
-        void update_val (double v) { val = v; };
-        double *get_addr () { return &val; }
+        void update_val (double v) { val = v; changed (); };
+        /** As the value may be written through the pointer, this counts as
+         * a change (see node::dense). */
+        double *get_addr () { changed (); return &val; }
 
     private:
         double val;
@@ -136,8 +193,10 @@ class str_val: public param {
         str_val (const std::string &k, const std::string &v);
 
         std::string get_val () { return val; }
-        void update_val (std::string v) { val = v; };
-        std::string *get_addr () { return &val; }
+        void update_val (std::string v) { val = v; changed (); };
+        /** As the value may be written through the pointer, this counts as
+         * a change (see node::dense). */
+        std::string *get_addr () { changed (); return &val; }
 
     private:
         std::string val;
@@ -170,7 +229,9 @@ class node : public param {
         void remove_item (const std::string &k);
 
         /**
-         * Return all the values
+         * Return all the values. Items should be added or removed through
+         * add_item and remove_item rather than through the map, which does
+         * not keep dense() up to date.
          * @returns The unordered map of key, parameter pairs
          */
         value_map *get_values ()
@@ -183,10 +244,33 @@ class node : public param {
         std::string getstr(const std::string &key);
         std::string getstr(int i);
 
+        /**
+         * Returns a flat, all-continuous parameter set as a contiguous array,
+         * where element i holds the double value with key std::to_string(i).
+         * This is the case for the synthetic benchmarks.
+         *
+         * The array is built on the first call and then cached until the node
+         * is next modified, through add_item, add_items or remove_item, or
+         * one of its values is changed by update_val or get_addr. Once
+         * built, getdbl(int) also reads from this array.
+         *
+         * @param n The number of values to read.
+         * @returns A pointer to n doubles, owned by this node.
+         * @exception std::out_of_range if any of the keys are missing.
+         */
+        const double *dense (u_int n);
+
     private:
         /** An unordered map of concrete values and nodes at this 'level' of
          * the search space, identified by their key */
         value_map values;
+
+        friend class param;
+
+        /** The cached, contiguous copy of the values; see dense().          */
+        std::vector<double, optk::pool_allocator<double>> m_dense;
+        /** Whether m_dense reflects the current values.                     */
+        bool m_dense_valid;
 };
 
 /**
@@ -341,7 +425,6 @@ class categorical: public param_t
             if (options->size() == 0)
                 throw std::invalid_argument("Empty value list is invalid");
             m_options = *options;
-            init_rand ();
         }
 
         /**
@@ -355,7 +438,6 @@ class categorical: public param_t
             if (options->size() == 0)
                 throw std::invalid_argument("Empty value list is invalid");
             m_options = *options;
-            init_rand ();
         }
 
         /**
@@ -369,7 +451,6 @@ class categorical: public param_t
             if (options->size() == 0)
                 throw std::invalid_argument("Empty value list is invalid");
             m_options = *options;
-            init_rand ();
         }
 
         /** values */
@@ -402,34 +483,39 @@ class categorical: public param_t
         }
 
         /**
-         * Sample a random value uniformly at random from the list of values.
+         * Sample a random value uniformly at random from the list of values,
+         * using the calling thread's generator.
          */
         T
         sample ()
         {
-            return get(dist(generator));
+            return sample (optk::thread_rng ());
         }
 
-    private:
+        /**
+         * Sample a random value uniformly at random from the list of values.
+         * @param r The generator to draw from.
+         */
+        T
+        sample (optk::rng &r)
+        {
+            return get(r.uniform_int (0, m_options.size() - 1));
+        }
 
         /**
-         * Called from constructors; initialises the random number generator.
+         * The inverse of the (discrete uniform) cumulative distribution
+         * function; maps u in [0, 1) onto one of the values.
+         * @param u The cumulative probability.
          */
-        void
-        init_rand ()
+        T
+        quantile (double u)
         {
-            generator = std::mt19937 (rd ());
-            uint u = m_options.size() - 1;
-            if (u < 0) u = 0;
-            dist = std::uniform_int_distribution<int> (0, u);
+            size_t i = (size_t) (u * m_options.size());
+            return m_options[std::min (i, m_options.size() - 1)];
         }
 
+    private:
         std::vector<T> m_options;
-
-        // used to implement random sampling
-        std::random_device rd;
-        std::mt19937 generator;
-        std::uniform_int_distribution<int> dist;
 };
 
 /**
@@ -501,17 +587,25 @@ class randint: public param_t
          */
         int sample ();
 
+        /**
+         * As above, drawing from the given generator.
+         * @param r The generator to draw from.
+         */
+        int sample (optk::rng &r);
+
+        /**
+         * The inverse of the cumulative distribution function, with the same
+         * support as sample.
+         * @param u The cumulative probability, in [0, 1).
+         */
+        int quantile (double u);
+
         /**
          * Bounds of the selection range.
          * Encapsulation should be irrelevant here so we save the effort of
          * making getters/setters and just make these members public...
          */
         int m_lower, m_upper;
-
-    private:
-        std::random_device rd;
-        std::mt19937 generator;
-        std::uniform_int_distribution<int> dist;
 };
 
 /**
@@ -547,17 +641,29 @@ class uniform: public param_t
          * This is a virtual method to allow for runtime polymorphism when using
          * derived classes in the choice parameter type.
          *
+         * @param r The generator to draw from.
          * @returns a new random sample
          */
-        virtual double sample();
+        virtual double sample (optk::rng &r);
+
+        /**
+         * As above, using the calling thread's generator.
+         * @returns a new random sample
+         */
+        double sample () { return sample (optk::thread_rng ()); }
+
+        /**
+         * The inverse of the cumulative distribution function, which maps a
+         * uniform variate onto this parameter's distribution; this lets
+         * quasi-random samplers use any parameter type.
+         *
+         * @param u The cumulative probability, in [0, 1).
+         * @returns The value with cumulative probability u.
+         */
+        virtual double quantile (double u);
 
         /** Lower and upper bounds on the uniform distribution. */
         double m_lower, m_upper;
-
-    protected:
-        std::random_device rd;
-        std::mt19937 generator;
-        std::uniform_real_distribution<double> dist;
 };
 
 /**
@@ -593,7 +699,9 @@ class quniform: public uniform {
          * @returns a double-precision floating point value sampled from a
          * quantised uniform distribution.
          */
-        double sample();
+        double sample (optk::rng &r) override;
+        using uniform::sample;
+        double quantile (double u) override;
 
         double m_q;
 };
@@ -632,7 +740,9 @@ class loguniform: public uniform {
          * @returns a double-precision floating point value sampled from a
          * loguniform distribution.
          */
-        double sample ();
+        double sample (optk::rng &r) override;
+        using uniform::sample;
+        double quantile (double u) override;
 };
 
 /**
@@ -668,7 +778,9 @@ class qloguniform: public loguniform {
          * @returns a double-precision floating point value sampled from a
          * quantised loguniform distribution.
          */
-        double sample ();
+        double sample (optk::rng &r) override;
+        using loguniform::sample;
+        double quantile (double u) override;
 
         double m_q;
 };
@@ -700,17 +812,29 @@ class normal: public param_t {
          * \f[ p(x|\mu\,\sigma) \= \frac{1}{\sigma \sqrt{2 \pi}}
          * e\^{- \frac{{x - \mu}\^ {2}}{2 \sigma \^ {2}} } \f]
          *
+         * @param r The generator to draw from.
+         * @returns A single sapmled value.
+         */
+        virtual double sample (optk::rng &r);
+
+        /**
+         * As above, using the calling thread's generator.
          * @returns A single sapmled value.
          */
-        virtual double sample ();
+        double sample () { return sample (optk::thread_rng ()); }
+
+        /**
+         * The inverse of the cumulative distribution function, which maps a
+         * uniform variate onto this parameter's distribution.
+         *
+         * @param u The cumulative probability, in (0, 1); values of 0 and 1
+         * are nudged inwards, to keep the result finite.
+         * @returns The value with cumulative probability u.
+         */
+        virtual double quantile (double u);
 
         /** The parameters of the underlying normal distribution. */
         double m_mu, m_sigma;
-
-    protected:
-        std::random_device rd;
-        std::mt19937 generator;
-        std::normal_distribution<double> dist;
 };
 
 /**
@@ -736,7 +860,9 @@ class qnormal: public normal {
          * v = \text{round}\big(\text{normal}(\mu, \sigma) / q\big) \cdot q.
          * \f]
          */
-        double sample ();
+        double sample (optk::rng &r) override;
+        using normal::sample;
+        double quantile (double u) override;
 
         double m_q;
 };
@@ -767,7 +893,9 @@ class lognormal: public normal {
          * p(x \vert \mu, \sigma ) = \exp \bigg(\mathcal{N}(x; \mu, \sigma)\bigg).
          * \f]
          */
-        double sample ();
+        double sample (optk::rng &r) override;
+        using normal::sample;
+        double quantile (double u) override;
 };
 
 /**
@@ -795,7 +923,9 @@ class qlognormal: public lognormal {
          * v = \text{round}\bigg(\text{lognormal}(\mu, \sigma) / q\bigg)\cdot q.
          * \f]
          */
-        double sample ();
+        double sample (optk::rng &r) override;
+        using lognormal::sample;
+        double quantile (double u) override;
 
         double m_q;
 };
@@ -812,6 +942,17 @@ class qlognormal: public lognormal {
  */
 void validate_param_values (inst::value_map *vals, sspace::sspace_t *sspace);
 
+/**
+ * Validates an array of double-precision values against the description of a
+ * single parameter; this is used to validate batches of points.
+ * @param vals The values to validate.
+ * @param n The number of values.
+ * @param param The description of the parameter.
+ * @exception std::invalid_argument if any of the values are invalid under
+ * param, or if param does not take double values.
+ */
+void validate_dbl_values (const double *vals, u_int n, sspace::param_t *param);
+
 /**
  * A convenience method to delete a search space description which was
  * allocated on the heap. This function is often used in class destructors.
@@ -819,6 +960,139 @@ void validate_param_values (inst::value_map *vals, sspace::sspace_t *sspace);
  */
 void free_ss (sspace_t *ss);
 
+// Compiled search spaces -----------------------------------------------------
+
+/**
+ * A compiled search space is a flat, read-only copy of a search space
+ * description, laid out as a structure of arrays so that optimisers and
+ * validation can walk it without chasing pointers or dispatching on the type
+ * of each parameter object.
+ *
+ * Every parameter is an entry, numbered in depth-first order, so that the
+ * options of a choice are the entries which immediately follow it, up to but
+ * excluding end (i). The numeric description of an entry is held in a, b and
+ * q: the bounds of the uniform parameters and of randint, or the mean and
+ * standard deviation of the normal parameters, and the quantisation (0 when
+ * unquantised). The options of the categorical parameters are held in one
+ * pool per type, from offset (i), for count (i) options.
+ *
+ * A compiled space does not refer to the space from which it was compiled,
+ * and may outlive it.
+ */
+class compiled {
+    public:
+        compiled () {}
+
+        /**
+         * Compiles a search space description.
+         * @param space The description to compile.
+         */
+        explicit compiled (sspace_t *space) { compile (space); }
+
+        /**
+         * Replaces this compiled space with the compilation of another.
+         * @param space The description to compile.
+         */
+        void compile (sspace_t *space);
+
+        /** @returns The number of entries, including choices. */
+        uint32_t size () const { return m_type.size (); }
+
+        /** @returns The number of coordinates needed to sample the space; one
+         * for every entry which is not a choice. */
+        u_int dims () const { return m_dims; }
+
+        /** @returns The type of entry i. */
+        pt type (uint32_t i) const { return m_type[i]; }
+
+        /** @returns The name of entry i. */
+        const std::string &name (uint32_t i) const { return m_name[i]; }
+
+        /** @returns The lower bound, or mean, of entry i. */
+        double a (uint32_t i) const { return m_a[i]; }
+
+        /** @returns The upper bound, or standard deviation, of entry i. */
+        double b (uint32_t i) const { return m_b[i]; }
+
+        /** @returns The quantisation of entry i, or 0 if unquantised. */
+        double q (uint32_t i) const { return m_q[i]; }
+
+        /** @returns One past the last entry nested within entry i. */
+        uint32_t end (uint32_t i) const { return m_end[i]; }
+
+        /** @returns The position of a categorical entry's first option in
+         * the pool of its type. */
+        uint32_t offset (uint32_t i) const { return m_off[i]; }
+
+        /** @returns The number of options of a categorical entry, or of
+         * direct options of a choice. */
+        uint32_t count (uint32_t i) const { return m_count[i]; }
+
+        /**
+         * Samples a value for every entry in the space, drawing from r in the
+         * same order, and with the same distributions, as the sample methods
+         * of the parameters from which the space was compiled.
+         * @param parent The node to which to add the sampled values; the
+         * options of a choice are added to a node of their own.
+         * @param r The generator to draw from.
+         */
+        void sample (inst::node *parent, optk::rng &r) const;
+
+        /**
+         * Maps a point of the unit hypercube onto the space, through the
+         * quantile method of each entry's parameter.
+         * @param parent The node to which to add the values.
+         * @param u The dims () coordinates of the point, in entry order.
+         */
+        void map (inst::node *parent, const double *u) const;
+
+        /**
+         * Validates a set of concrete values against this space, as
+         * validate_param_values does against the uncompiled description.
+         * @param vals The set of concrete values.
+         * @exception std::invalid_argument when a value is invalid, or names
+         * no parameter of the space.
+         */
+        void validate (inst::value_map *vals) const;
+
+        /**
+         * Validates an array of double-precision values against a single
+         * entry, as validate_dbl_values does.
+         * @param i The entry.
+         * @param vals The values to validate.
+         * @param n The number of values.
+         * @exception std::invalid_argument if any of the values are invalid.
+         */
+        void validate (uint32_t i, const double *vals, u_int n) const;
+
+    private:
+        void compile_range (sspace_t *space);
+        /** Draws the pool index of one of a categorical entry's options. */
+        uint32_t pick (uint32_t i, optk::rng &r) const;
+        void sample_range (inst::node *parent, uint32_t first, uint32_t last,
+                optk::rng &r) const;
+        void map_range (inst::node *parent, uint32_t first, uint32_t last,
+                const double **u) const;
+        void validate_range (inst::value_map *vals, uint32_t first,
+                uint32_t last) const;
+        void validate_value (inst::param *p, uint32_t i) const;
+        void validate_dbl (double v, uint32_t i) const;
+
+        std::vector<pt> m_type;
+        std::vector<std::string> m_name;
+        std::vector<double> m_a, m_b, m_q;
+        std::vector<uint32_t> m_end, m_off, m_count;
+
+        /** The pools of categorical options. */
+        std::vector<int> m_ints;
+        std::vector<double> m_dbls;
+        std::vector<std::string> m_strs;
+
+        /** Maps the names of the top level entries to their indices. */
+        std::unordered_map<std::string, uint32_t> m_index;
+        u_int m_dims = 0;
+};
+
 } // namespace sspace
 
 #endif // __TYPES_H_
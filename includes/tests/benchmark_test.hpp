@@ -22,6 +22,7 @@
 #ifndef __BENCHMARK_TEST_H_
 #define __BENCHMARK_TEST_H_
 
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
 #include <limits>
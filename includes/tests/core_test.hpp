@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Defines tests for the core framework (thread pool, core loop,
+ * results writer, statistics).
+ */
+
+#ifndef __CORE_TEST_H_
+#define __CORE_TEST_H_
+
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <optk/core.hpp>
+#include <optk/results.hpp>
+#include <optk/rng.hpp>
+#include <optk/stats.hpp>
+#include <optk/threadpool.hpp>
+#include <tests/testutils.hpp>
+
+/**
+ * Runs all the tests for the core framework.
+ * Exits upon error.
+ */
+void run_core_tests();
+
+/**
+ * Runs the tests for distributed sweeps.
+ * Exits upon error.
+ */
+void run_dist_tests ();
+
+/**
+ * Runs the tests for checkpoints.
+ * Exits upon error.
+ */
+void run_checkpoint_tests ();
+
+/**
+ * Runs the tests for the cache of evaluations.
+ * Exits upon error.
+ */
+void run_cache_tests ();
+
+#endif // __CORE_TEST_H_
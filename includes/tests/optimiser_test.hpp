@@ -33,6 +33,9 @@ extern void run_static_gridsearch_tests ();
 
 void run_gridsearch_tests ();
 void run_random_search_tests ();
+void run_qmc_tests ();
+void run_remote_tests ();
+void run_gp_tests ();
 
 #endif // __OPTIMISER_TEST_H_
 
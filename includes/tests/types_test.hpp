@@ -23,9 +23,16 @@
 #define __TYPES_TEST_H_
 
 #include <assert.h>
+#include <condition_variable>
 #include <iostream>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <thread>
 
+#include <optk/pool.hpp>
+#include <optk/rng.hpp>
 #include <optk/types.hpp>
 #include <tests/testutils.hpp>
 
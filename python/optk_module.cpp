@@ -0,0 +1,637 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Python bindings for the synthetic benchmarks and the optimisers.
+ *
+ * These are written against the CPython API directly, and exchange arrays
+ * through the buffer protocol, so that NumPy arrays (and anything else
+ * exposing a buffer of doubles) are passed to and from the benchmarks
+ * without copying. The GIL is released while the benchmarks and the core
+ * loop run.
+ *
+ * Batches of points are laid out as benchmark::evaluate_batch expects, with
+ * each parameter's values contiguous: in NumPy terms, an (n, d) array in
+ * Fortran order, e.g. np.asfortranarray(x).
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmarks/synthetic.hpp>
+#include <optimisers/gp.hpp>
+#include <optimisers/gridsearch.hpp>
+#include <optimisers/qmc.hpp>
+#include <optimisers/random.hpp>
+#include <optk/core.hpp>
+#include <optk/trace.hpp>
+
+// buffers ---------------------------------------------------------------------
+
+/**
+ * Checks that a buffer holds native doubles.
+ * @returns false, with a Python exception set, if it does not.
+ */
+static bool
+is_double_buffer (Py_buffer *view, const char *what)
+{
+    const char *f = view->format ? view->format : "B";
+    if (view->itemsize != sizeof (double) ||
+            (std::strcmp (f, "d") && std::strcmp (f, "=d") &&
+             std::strcmp (f, "@d"))) {
+        PyErr_Format (PyExc_TypeError, "%s must be an array of float64", what);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Gets a read-only view of a batch of n points of d dimensions, as an (n, d)
+ * array whose columns are contiguous. A 1-dimensional array of length d is
+ * taken to be a single point.
+ * @returns false, with a Python exception set, if the layout is wrong; the
+ * view is released in this case.
+ */
+static bool
+get_batch (PyObject *obj, Py_buffer *view, u_int d, u_int *n)
+{
+    if (PyObject_GetBuffer (obj, view, PyBUF_STRIDES | PyBUF_FORMAT))
+        return false;
+    if (!is_double_buffer (view, "x"))
+        goto fail;
+
+    if (view->ndim == 1 && view->shape[0] == (Py_ssize_t) d &&
+            PyBuffer_IsContiguous (view, 'A')) {
+        *n = 1;
+        return true;
+    }
+    if (view->ndim != 2 || view->shape[1] != (Py_ssize_t) d) {
+        PyErr_Format (PyExc_ValueError,
+                "x must have shape (n, %u) for this benchmark", d);
+        goto fail;
+    }
+    if (!PyBuffer_IsContiguous (view, 'F')) {
+        PyErr_SetString (PyExc_ValueError,
+                "x must be in Fortran order (see np.asfortranarray), so that "
+                "it can be evaluated without copying");
+        goto fail;
+    }
+    *n = view->shape[0];
+    return true;
+
+fail:
+    PyBuffer_Release (view);
+    return false;
+}
+
+/**
+ * Creates a new writable buffer of n doubles, as a memoryview over a
+ * bytearray; np.asarray wraps it without copying.
+ */
+static PyObject *
+new_doubles (Py_ssize_t n, PyObject **bytes)
+{
+    *bytes = PyByteArray_FromStringAndSize (NULL, n * sizeof (double));
+    if (!*bytes)
+        return NULL;
+    PyObject *raw = PyMemoryView_FromObject (*bytes);
+    if (!raw)
+        return NULL;
+    PyObject *mv = PyObject_CallMethod (raw, "cast", "s", "d");
+    Py_DECREF (raw);
+    return mv;
+}
+
+// Benchmark -------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    syn::synthetic *bench;
+    /** set while the benchmark runs without the GIL */
+    bool busy;
+} benchmark_obj;
+
+/** Claims a benchmark for use without the GIL. */
+static bool
+claim (benchmark_obj *self)
+{
+    if (self->busy) {
+        PyErr_SetString (PyExc_RuntimeError,
+                "the benchmark is in use by another thread");
+        return false;
+    }
+    self->busy = true;
+    return true;
+}
+
+static int
+benchmark_init (benchmark_obj *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"name", "dims", NULL};
+    const char *name;
+    unsigned int dims = 0;
+    if (!PyArg_ParseTupleAndKeywords (args, kwds, "s|I", (char **) kwlist,
+                &name, &dims))
+        return -1;
+
+    syn::registry reg;
+    std::vector<syn::entry> sel;
+    try {
+        sel = reg.select (name);
+    } catch (const std::invalid_argument &e) {
+        PyErr_SetString (PyExc_ValueError, e.what ());
+        return -1;
+    }
+    for (syn::entry &e: sel) {
+        if (dims && e.dims != dims)
+            continue;
+        delete self->bench;
+        self->bench = e.make ();
+        return 0;
+    }
+    PyErr_Format (PyExc_ValueError, "no %u-dimensional benchmark '%s'", dims,
+            name);
+    return -1;
+}
+
+static void
+benchmark_dealloc (benchmark_obj *self)
+{
+    delete self->bench;
+    Py_TYPE (self)->tp_free ((PyObject *) self);
+}
+
+/** Checks that a Benchmark was initialised. */
+static bool
+ready (benchmark_obj *self)
+{
+    if (!self->bench) {
+        PyErr_SetString (PyExc_RuntimeError, "uninitialised benchmark");
+        return false;
+    }
+    return true;
+}
+
+PyDoc_STRVAR (evaluate_batch_doc,
+"evaluate_batch(x, out=None)\n--\n\n"
+"Evaluates the benchmark on a batch of points, given as an (n, d) float64\n"
+"array in Fortran order, or a single point of length d. The n results are\n"
+"written into out, a writable float64 buffer of length n, if given, and\n"
+"into a new buffer otherwise; the buffer is returned. Nothing is copied.");
+
+static PyObject *
+benchmark_evaluate_batch (benchmark_obj *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"x", "out", NULL};
+    PyObject *xo, *oo = Py_None;
+    if (!ready (self) || !PyArg_ParseTupleAndKeywords (args, kwds, "O|O",
+                (char **) kwlist, &xo, &oo))
+        return NULL;
+
+    Py_buffer x, out;
+    u_int n;
+    if (!get_batch (xo, &x, self->bench->get_dims (), &n))
+        return NULL;
+
+    PyObject *ret, *bytes = NULL;
+    if (oo == Py_None) {
+        ret = new_doubles (n, &bytes);
+        Py_XDECREF (bytes);
+        if (!ret) {
+            PyBuffer_Release (&x);
+            return NULL;
+        }
+    } else {
+        Py_INCREF (oo);
+        ret = oo;
+    }
+    if (PyObject_GetBuffer (ret, &out,
+                PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | PyBUF_WRITABLE)) {
+        Py_DECREF (ret);
+        PyBuffer_Release (&x);
+        return NULL;
+    }
+    if (!is_double_buffer (&out, "out") ||
+            out.len != (Py_ssize_t) (n * sizeof (double)) || !claim (self)) {
+        if (!PyErr_Occurred ())
+            PyErr_Format (PyExc_ValueError,
+                    "out must have room for exactly %u values", n);
+        PyBuffer_Release (&out);
+        PyBuffer_Release (&x);
+        Py_DECREF (ret);
+        return NULL;
+    }
+
+    std::string err;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        self->bench->evaluate_batch ((const double *) x.buf, n,
+                (double *) out.buf);
+    } catch (const std::exception &e) {
+        err = e.what ();
+    }
+    Py_END_ALLOW_THREADS
+    self->busy = false;
+
+    PyBuffer_Release (&out);
+    PyBuffer_Release (&x);
+    if (!err.empty ()) {
+        Py_DECREF (ret);
+        PyErr_SetString (PyExc_ValueError, err.c_str ());
+        return NULL;
+    }
+    return ret;
+}
+
+PyDoc_STRVAR (space_doc,
+"space()\n--\n\n"
+"Describes the search space: a list with a dict for each parameter, holding\n"
+"its name and type, and the bounds of uniform parameters.");
+
+static PyObject *
+benchmark_space (benchmark_obj *self, PyObject *Py_UNUSED (ignored))
+{
+    if (!ready (self))
+        return NULL;
+    sspace::sspace_t *space = self->bench->get_search_space ();
+    PyObject *list = PyList_New (space->size ());
+    if (!list)
+        return NULL;
+    for (size_t i = 0; i < space->size (); i++) {
+        sspace::param_t *p = space->at (i);
+        PyObject *d;
+        if (p->get_type () == pt::uniform) {
+            sspace::uniform *u = static_cast<sspace::uniform *>(p);
+            d = Py_BuildValue ("{s:s,s:s,s:d,s:d}", "name",
+                    p->get_name ().c_str (), "type", "uniform", "lower",
+                    u->m_lower, "upper", u->m_upper);
+        } else {
+            d = Py_BuildValue ("{s:s,s:i}", "name", p->get_name ().c_str (),
+                    "type", (int) p->get_type ());
+        }
+        if (!d) {
+            Py_DECREF (list);
+            return NULL;
+        }
+        PyList_SET_ITEM (list, i, d);
+    }
+    return list;
+}
+
+static PyObject *
+benchmark_get_name (benchmark_obj *self, void *closure)
+{
+    return ready (self) ?
+        PyUnicode_FromString (self->bench->get_name ().c_str ()) : NULL;
+}
+
+static PyObject *
+benchmark_get_dims (benchmark_obj *self, void *closure)
+{
+    return ready (self) ? PyLong_FromUnsignedLong (self->bench->get_dims ()) :
+        NULL;
+}
+
+static PyObject *
+benchmark_get_optimum (benchmark_obj *self, void *closure)
+{
+    return ready (self) ? PyFloat_FromDouble (self->bench->get_opt ()) : NULL;
+}
+
+static PyObject *
+benchmark_get_validation (benchmark_obj *self, void *closure)
+{
+    return ready (self) ? PyBool_FromLong (self->bench->validation ()) : NULL;
+}
+
+static int
+benchmark_set_validation (benchmark_obj *self, PyObject *v, void *closure)
+{
+    if (!ready (self))
+        return -1;
+    int b = v ? PyObject_IsTrue (v) : -1;
+    if (b < 0) {
+        if (!PyErr_Occurred ())
+            PyErr_SetString (PyExc_TypeError, "cannot delete validation");
+        return -1;
+    }
+    self->bench->set_validation (b);
+    return 0;
+}
+
+static PyMethodDef benchmark_methods[] = {
+    {"evaluate_batch", (PyCFunction) benchmark_evaluate_batch,
+        METH_VARARGS | METH_KEYWORDS, evaluate_batch_doc},
+    {"space", (PyCFunction) benchmark_space, METH_NOARGS, space_doc},
+    {NULL}
+};
+
+static PyGetSetDef benchmark_getset[] = {
+    {"name", (getter) benchmark_get_name, NULL, "the benchmark's name", NULL},
+    {"dims", (getter) benchmark_get_dims, NULL, "the number of parameters",
+        NULL},
+    {"optimum", (getter) benchmark_get_optimum, NULL,
+        "the global minimum of the objective", NULL},
+    {"validation", (getter) benchmark_get_validation,
+        (setter) benchmark_set_validation,
+        "whether points are checked against the search space", NULL},
+    {NULL}
+};
+
+static PyTypeObject benchmark_type = {
+    PyVarObject_HEAD_INIT (NULL, 0)
+};
+
+// Optimiser -------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    optk::optimiser *opt;
+} optimiser_obj;
+
+/** The names of the optimisers, as accepted on the command line. */
+static const char *optimiser_names[] = {
+    "gridsearch", "random_search", "sobol_search", "halton_search",
+    "lhs_search", "gp_optimiser", "sparse_gp_optimiser", "local_gp_optimiser",
+    NULL
+};
+
+/** @returns A new optimiser, with its default configuration, or NULL. */
+static optk::optimiser *
+make_optimiser (const std::string &name)
+{
+    if (name == "gridsearch")
+        return new gridsearch ();
+    if (name == "random_search")
+        return new random_search ();
+    if (name == "sobol_search")
+        return new qmc_search (__qmc::sequence::sobol);
+    if (name == "halton_search")
+        return new qmc_search (__qmc::sequence::halton);
+    if (name == "lhs_search")
+        return new qmc_search (__qmc::sequence::lhs);
+    if (name == "gp_optimiser")
+        return new gp_opt ();
+    if (name == "sparse_gp_optimiser")
+        return new gp_opt (__gp::acquisition::ei, __gp::mode::sparse);
+    if (name == "local_gp_optimiser")
+        return new gp_opt (__gp::acquisition::ei, __gp::mode::local);
+    return NULL;
+}
+
+static int
+optimiser_init (optimiser_obj *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"name", "seed", NULL};
+    const char *name;
+    unsigned long long seed = 0;
+    int has_seed = 0;
+    PyObject *so = Py_None;
+    if (!PyArg_ParseTupleAndKeywords (args, kwds, "s|O", (char **) kwlist,
+                &name, &so))
+        return -1;
+    if (so != Py_None) {
+        seed = PyLong_AsUnsignedLongLong (so);
+        if (PyErr_Occurred ())
+            return -1;
+        has_seed = 1;
+    }
+
+    optk::optimiser *opt = make_optimiser (name);
+    if (!opt) {
+        PyErr_Format (PyExc_ValueError, "unknown optimiser '%s'", name);
+        return -1;
+    }
+    if (has_seed)
+        opt->seed (seed);
+    delete self->opt;
+    self->opt = opt;
+    return 0;
+}
+
+static void
+optimiser_dealloc (optimiser_obj *self)
+{
+    delete self->opt;
+    Py_TYPE (self)->tp_free ((PyObject *) self);
+}
+
+static PyObject *
+optimiser_get_name (optimiser_obj *self, void *closure)
+{
+    if (!self->opt) {
+        PyErr_SetString (PyExc_RuntimeError, "uninitialised optimiser");
+        return NULL;
+    }
+    return PyUnicode_FromString (self->opt->get_name ().c_str ());
+}
+
+static PyGetSetDef optimiser_getset[] = {
+    {"name", (getter) optimiser_get_name, NULL, "the optimiser's name", NULL},
+    {NULL}
+};
+
+static PyTypeObject optimiser_type = {
+    PyVarObject_HEAD_INIT (NULL, 0)
+};
+
+// module ----------------------------------------------------------------------
+
+PyDoc_STRVAR (run_doc,
+"run(benchmark, optimiser, iters, stride=1, best=False)\n--\n\n"
+"Runs the core loop of the optimiser on the benchmark for iters iterations,\n"
+"without the GIL, and returns the trace as a buffer of float64: every\n"
+"stride-th result, or the best so far if best is set.");
+
+static PyObject *
+optk_run (PyObject *mod, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {
+        "benchmark", "optimiser", "iters", "stride", "best", NULL
+    };
+    benchmark_obj *b;
+    optimiser_obj *o;
+    unsigned int iters, stride = 1;
+    int best = 0;
+    if (!PyArg_ParseTupleAndKeywords (args, kwds, "O!O!I|Ip", (char **) kwlist,
+                &benchmark_type, &b, &optimiser_type, &o, &iters, &stride,
+                &best))
+        return NULL;
+    if (!ready (b))
+        return NULL;
+    if (!o->opt) {
+        PyErr_SetString (PyExc_RuntimeError, "uninitialised optimiser");
+        return NULL;
+    }
+    if (!stride) {
+        PyErr_SetString (PyExc_ValueError, "stride must be positive");
+        return NULL;
+    }
+    if (!claim (b))
+        return NULL;
+
+    optk::trace tr (iters, stride, best);
+    std::string err;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        optk::core_loop (b->bench, o->opt, tr);
+    } catch (const std::exception &e) {
+        err = e.what ();
+    }
+    Py_END_ALLOW_THREADS
+    b->busy = false;
+    if (!err.empty ()) {
+        PyErr_SetString (PyExc_RuntimeError, err.c_str ());
+        return NULL;
+    }
+
+    PyObject *bytes;
+    PyObject *ret = new_doubles (tr.size (), &bytes);
+    if (ret)
+        std::memcpy (PyByteArray_AS_STRING (bytes), tr.data (),
+                tr.size () * sizeof (double));
+    Py_XDECREF (bytes);
+    return ret;
+}
+
+PyDoc_STRVAR (benchmarks_doc,
+"benchmarks(spec='')\n--\n\n"
+"Lists the synthetic benchmarks selected by spec (a comma-separated list of\n"
+"names and properties; see optk -l), as (name, dims, properties) tuples.");
+
+static PyObject *
+optk_benchmarks (PyObject *mod, PyObject *args)
+{
+    const char *spec = "";
+    if (!PyArg_ParseTuple (args, "|s", &spec))
+        return NULL;
+
+    syn::registry reg;
+    std::vector<syn::entry> sel;
+    try {
+        sel = reg.select (spec);
+    } catch (const std::invalid_argument &e) {
+        PyErr_SetString (PyExc_ValueError, e.what ());
+        return NULL;
+    }
+
+    PyObject *list = PyList_New (sel.size ());
+    if (!list)
+        return NULL;
+    for (size_t i = 0; i < sel.size (); i++) {
+        PyObject *props = PyList_New (sel[i].props.size ());
+        if (!props) {
+            Py_DECREF (list);
+            return NULL;
+        }
+        for (size_t j = 0; j < sel[i].props.size (); j++)
+            PyList_SET_ITEM (props, j, PyUnicode_FromString (
+                        syn::property_name (sel[i].props[j]).c_str ()));
+        PyObject *t = Py_BuildValue ("(sIN)", sel[i].name.c_str (),
+                sel[i].dims, props);
+        if (!t) {
+            Py_DECREF (list);
+            return NULL;
+        }
+        PyList_SET_ITEM (list, i, t);
+    }
+    return list;
+}
+
+PyDoc_STRVAR (optimisers_doc,
+"optimisers()\n--\n\n"
+"Lists the names of the optimisers which Optimiser accepts.");
+
+static PyObject *
+optk_optimisers (PyObject *mod, PyObject *Py_UNUSED (ignored))
+{
+    PyObject *list = PyList_New (0);
+    for (const char **n = optimiser_names; list && *n; n++) {
+        PyObject *s = PyUnicode_FromString (*n);
+        if (!s || PyList_Append (list, s)) {
+            Py_XDECREF (s);
+            Py_CLEAR (list);
+            break;
+        }
+        Py_DECREF (s);
+    }
+    return list;
+}
+
+static PyMethodDef optk_methods[] = {
+    {"run", (PyCFunction) optk_run, METH_VARARGS | METH_KEYWORDS, run_doc},
+    {"benchmarks", optk_benchmarks, METH_VARARGS, benchmarks_doc},
+    {"optimisers", optk_optimisers, METH_NOARGS, optimisers_doc},
+    {NULL}
+};
+
+static struct PyModuleDef optk_module = {
+    PyModuleDef_HEAD_INIT,
+    "optk",
+    "Bindings for the OPTK synthetic benchmarks and optimisers.",
+    -1,
+    optk_methods
+};
+
+PyMODINIT_FUNC
+PyInit_optk (void)
+{
+    benchmark_type.tp_name = "optk.Benchmark";
+    benchmark_type.tp_doc = "Benchmark(name, dims=0)\n--\n\n"
+        "A synthetic benchmark, by name; dims picks between the sizes of a "
+        "scalable benchmark, and defaults to the first registered.";
+    benchmark_type.tp_basicsize = sizeof (benchmark_obj);
+    benchmark_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    benchmark_type.tp_new = PyType_GenericNew;
+    benchmark_type.tp_init = (initproc) benchmark_init;
+    benchmark_type.tp_dealloc = (destructor) benchmark_dealloc;
+    benchmark_type.tp_methods = benchmark_methods;
+    benchmark_type.tp_getset = benchmark_getset;
+
+    optimiser_type.tp_name = "optk.Optimiser";
+    optimiser_type.tp_doc = "Optimiser(name, seed=None)\n--\n\n"
+        "An optimiser, by name (see optimisers()).";
+    optimiser_type.tp_basicsize = sizeof (optimiser_obj);
+    optimiser_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    optimiser_type.tp_new = PyType_GenericNew;
+    optimiser_type.tp_init = (initproc) optimiser_init;
+    optimiser_type.tp_dealloc = (destructor) optimiser_dealloc;
+    optimiser_type.tp_getset = optimiser_getset;
+
+    if (PyType_Ready (&benchmark_type) < 0 ||
+            PyType_Ready (&optimiser_type) < 0)
+        return NULL;
+
+    PyObject *m = PyModule_Create (&optk_module);
+    if (!m)
+        return NULL;
+    Py_INCREF (&benchmark_type);
+    Py_INCREF (&optimiser_type);
+    if (PyModule_AddObject (m, "Benchmark", (PyObject *) &benchmark_type) ||
+            PyModule_AddObject (m, "Optimiser", (PyObject *) &optimiser_type)) {
+        Py_DECREF (&benchmark_type);
+        Py_DECREF (&optimiser_type);
+        Py_DECREF (m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,136 @@
+# Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+#
+# Written for the ACRC, University of Bristol
+#
+# Licensed under the Educational Community License, Version 2.0
+# (the "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+# http://www.osedu.org/licenses/ECL-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""
+Serves an optimiser written in Python to ``optk remote:<path>``, over the ask
+/ tell protocol described in includes/optimisers/remote.hpp.
+
+An optimiser is any object with three methods:
+
+  - ``start(space)``: begins a run; ``space`` is a list of
+    ``(name, type, a, b, q)`` tuples, with ``type`` the numeric sspace type.
+  - ``ask(k)``: returns up to k points, each a sequence of floats in the
+    order of the space; fewer than k means there are no more.
+  - ``tell(ids, values)``: the results of the points with those ids, which
+    count up from 0 in the order in which the points were asked for.
+
+Run as a script, this serves a uniform random search, e.g.
+
+    python3 python/optk_remote.py /tmp/rs.sock &
+    bin/optk -b synthetic:ackley1 remote:/tmp/rs.sock
+"""
+
+import random
+import socket
+import socketserver
+import struct
+import sys
+
+SPACE, ASK, POINTS, TELL, BYE = 1, 2, 3, 4, 5
+UNIFORM, QUNIFORM, LOGUNIFORM, QLOGUNIFORM = 5, 6, 7, 8
+
+
+def _read(f, n):
+    b = f.read(n)
+    if len(b) < n:
+        raise EOFError
+    return b
+
+
+def serve_connection(sock, opt):
+    """Serves opt to one client, until it says bye or disconnects."""
+    r = sock.makefile('rb')
+    w = sock.makefile('wb')
+    d = 0
+    try:
+        while True:
+            try:
+                length, kind = struct.unpack('=IB', _read(r, 5))
+            except EOFError:
+                return
+            body = _read(r, length)
+            if kind == BYE:
+                return
+            if kind == SPACE:
+                (d,), off, space = struct.unpack_from('=I', body), 4, []
+                for _ in range(d):
+                    t, n = struct.unpack_from('=BH', body, off)
+                    off += 3
+                    name = body[off:off + n].decode()
+                    off += n
+                    a, b, q = struct.unpack_from('=3d', body, off)
+                    off += 24
+                    space.append((name, t, a, b, q))
+                opt.start(space)
+            elif kind == ASK:
+                first, k = struct.unpack('=II', body)
+                pts = list(opt.ask(k))[:k]
+                out = struct.pack('=II', first, len(pts))
+                out += b''.join(struct.pack('=%dd' % d, *p) for p in pts)
+                w.write(struct.pack('=IB', len(out), POINTS) + out)
+                w.flush()
+            elif kind == TELL:
+                (n,) = struct.unpack_from('=I', body)
+                pairs = [struct.unpack_from('=Id', body, 4 + 12 * i)
+                         for i in range(n)]
+                opt.tell([p[0] for p in pairs], [p[1] for p in pairs])
+    finally:
+        r.close()
+        w.close()
+
+
+def serve(path, make):
+    """Listens at path, serving a new optimiser from make() per client."""
+    class Handler(socketserver.BaseRequestHandler):
+        def handle(self):
+            serve_connection(self.request, make())
+
+    class Server(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+        daemon_threads = True
+
+    import os
+    if os.path.exists(path):
+        os.unlink(path)
+    with Server(path, Handler) as s:
+        s.serve_forever()
+
+
+class RandomSearch:
+    """Samples uniformly within the bounds of uniform parameters."""
+
+    def start(self, space):
+        for name, t, a, b, q in space:
+            if t not in (UNIFORM, QUNIFORM):
+                raise ValueError('unsupported parameter ' + name)
+        self.space = space
+
+    def ask(self, k):
+        for _ in range(k):
+            p = []
+            for _, t, a, b, q in self.space:
+                x = random.uniform(a, b)
+                if q:
+                    x = min(max(round(x / q) * q, a), b)
+                p.append(x)
+            yield p
+
+    def tell(self, ids, values):
+        pass
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit('usage: optk_remote.py <socket path>')
+    serve(sys.argv[1], RandomSearch)
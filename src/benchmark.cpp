@@ -20,10 +20,19 @@
  */
 
 #include <optk/benchmark.hpp>
+#include <optk/checkpoint.hpp>
+#include <optk/results.hpp>
+#include <optk/threadpool.hpp>
+#include <optk/timing.hpp>
+#include <optk/trace.hpp>
+
+#include <fstream>
+#include <memory>
 
 // benchmark ------------------------------------------------------------------
 
-optk::benchmark::benchmark (const std::string &name)
+optk::benchmark::benchmark (const std::string &name) :
+    m_validate (true)
 {
     m_name = name;
 }
@@ -34,11 +43,111 @@ optk::benchmark::get_name ()
     return m_name;
 }
 
+void
+optk::benchmark::evaluate_batch (const double *x, u_int n, double *out)
+{
+    sspace::sspace_t *ss = get_search_space ();
+    u_int d = ss->size();
+
+    for (u_int i = 0; i < n; i++) {
+        inst::node *point = new inst::node ("batch point");
+        for (u_int j = 0; j < d; j++)
+            point->add_item (
+                    new inst::dbl_val (ss->at(j)->get_name(), x[j * n + i])
+                    );
+        // free the point even if evaluation throws
+        try {
+            out[i] = evaluate (point);
+        } catch (...) {
+            inst::free_node (point);
+            throw;
+        }
+        inst::free_node (point);
+    }
+}
+
 // benchmark set --------------------------------------------------------------
 
 optk::benchmark_set::~benchmark_set()
 { }
 
+void
+optk::benchmark_set::run (optk::optimisers *opts, optk::ctx_t *ctx)
+{
+    std::vector<optk::optimiser *> *optc = opts->collection();
+    uint nbench = size ();
+    uint npairs = optc->size() * nbench;
+    uint reps = std::max (ctx->repeats, 1u);
+
+    // The replicates of each pair are queued together, so that few pairs are
+    // being aggregated at any one time.
+    optk::sweep_rows rows (ctx->results, npairs, reps,
+            ctx->costs && !ctx->summary);
+
+#ifdef __OPTK_TIMING
+    // the phase timings of each job, written beside the results at the end
+    std::vector<std::string> timing_rows (npairs * reps);
+#endif
+
+    optk::thread_pool pool (ctx->threads);
+
+    // for all the optimisers in the set, and all the benchmarks
+    for (uint i = 0; i < optc->size(); i++) {
+        optk::optimiser *proto = optc->at(i);
+        for (uint j = 0; j < nbench; j++) {
+            uint pair = i * nbench + j;
+            std::string bench = benchmark_name (j);
+            std::vector<std::string> props = benchmark_properties (j);
+
+            for (uint r = 0; r < reps; r++) {
+                uint job = pair + r * npairs;
+                pool.submit ([&, proto, bench, props, pair, job, j, r] () {
+                    // each job owns its optimiser and trace
+                    std::unique_ptr<optk::optimiser> opt (proto->clone ());
+                    uint64_t seed = optk::rng::derive (ctx->seed, job);
+                    opt->seed (seed);
+                    optk::trace tr (ctx->max_iters, ctx->stride,
+                            ctx->best || rows.aggregate (), ctx->costs,
+                            ctx->summary);
+
+                    std::vector<double> saved;
+                    if (ctx->ckpt && ctx->ckpt->finished (get_name (), job,
+                                &saved)) {
+                        rows.add (pair, r, seed, saved.data (), saved.size (),
+                                bench, opt->get_name (), props);
+                        return;
+                    }
+
+                    std::unique_ptr<optk::progress> prog (ctx->ckpt ?
+                        ctx->ckpt->start (get_name (), job) : NULL);
+                    run_one (j, opt.get (), tr, ctx, &pool, prog.get (), seed);
+                    prog.reset ();
+                    if (ctx->ckpt)
+                        ctx->ckpt->finish (get_name (), job, tr.data (),
+                                tr.span ());
+                    rows.add (pair, r, seed, tr.data(), tr.span(), bench,
+                            opt->get_name(), props);
+#ifdef __OPTK_TIMING
+                    timing_rows[job] = tr.timings ()->csv_rows (
+                            bench, opt->get_name());
+#endif
+                });
+            }
+        }
+    }
+
+    pool.wait ();
+
+    ctx->results->flush ();
+
+#ifdef __OPTK_TIMING
+    std::ofstream tf (ctx->outfile + ".timing.csv");
+    tf << optk::timings::csv_header ();
+    for (const std::string &r: timing_rows)
+        tf << r;
+#endif
+}
+
 // benchmarks -----------------------------------------------------------------
 
 optk::benchmarks::benchmarks ()
@@ -0,0 +1,715 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the vectorised synthetic benchmark kernels.
+ *
+ * The kernels are written once, against GCC's generic vector types, and
+ * instantiated for each instruction set inside functions carrying the
+ * corresponding target attribute; the vector operations are only lowered to
+ * machine instructions after inlining, so each instantiation uses the full
+ * register width of its target. The same templates instantiated with a plain
+ * double handle the points or coordinates left over at the end of a vector.
+ *
+ * exp, log, sin, cos and sqrt are computed with branch-free polynomial
+ * approximations; they agree with the C library to within a few ulps over
+ * the domains of the benchmarks.
+ */
+
+#include <benchmarks/simd.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+// GCC warns that returning wide vectors changes the ABI; every function
+// below which does so is inlined into its caller.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define SIMD_INLINE inline __attribute__ ((always_inline))
+
+#if defined (__x86_64__) && defined (__GNUC__)
+#define SIMD_X86 1
+#endif
+
+namespace syn {
+namespace simd {
+namespace {
+
+/**
+ * Properties of the types the kernels are instantiated for: the unsigned
+ * integer type of the same shape, and the number of lanes.
+ */
+template <typename V> struct lanes;
+
+template <> struct lanes<double> {
+    typedef uint64_t U;
+    static constexpr u_int width = 1;
+};
+
+#ifdef SIMD_X86
+typedef double v4d __attribute__ ((vector_size (32)));
+typedef uint64_t v4u __attribute__ ((vector_size (32)));
+typedef double v8d __attribute__ ((vector_size (64)));
+typedef uint64_t v8u __attribute__ ((vector_size (64)));
+
+template <> struct lanes<v4d> {
+    typedef v4u U;
+    static constexpr u_int width = 4;
+};
+
+template <> struct lanes<v8d> {
+    typedef v8u U;
+    static constexpr u_int width = 8;
+};
+#endif
+
+template <typename To, typename From> SIMD_INLINE To
+bitcast (const From &v)
+{
+    static_assert (sizeof (To) == sizeof (From), "bitcast between sizes");
+    To r;
+    __builtin_memcpy (&r, &v, sizeof (r));
+    return r;
+}
+
+template <typename V> SIMD_INLINE V
+splat (double c)
+{
+    return V{} + c;
+}
+
+template <typename V> SIMD_INLINE V
+load (const double *p)
+{
+    V v;
+    __builtin_memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+template <typename V> SIMD_INLINE void
+store (double *p, const V &v)
+{
+    __builtin_memcpy (p, &v, sizeof (v));
+}
+
+/** @returns 0, 1, ..., width - 1 */
+template <typename V> SIMD_INLINE V
+iota ()
+{
+    double l[lanes<V>::width];
+    for (u_int k = 0; k < lanes<V>::width; k++)
+        l[k] = (double) k;
+    return load<V> (l);
+}
+
+template <typename V, typename M> SIMD_INLINE V
+select (const M &m, const V &a, const V &b)
+{
+    return m ? a : b;
+}
+
+/** 1.5 * 2^52: adding this rounds to an integer held in the low bits. */
+static constexpr double round_magic = 6755399441055744.0;
+
+static constexpr double inf = std::numeric_limits<double>::infinity ();
+
+template <typename V> SIMD_INLINE V
+vabs (const V &x)
+{
+    typedef typename lanes<V>::U U;
+    return bitcast<V> (bitcast<U> (x) & 0x7fffffffffffffffull);
+}
+
+template <typename V> SIMD_INLINE V
+vexp (const V &x)
+{
+    typedef typename lanes<V>::U U;
+    const double lo = -708., hi = 709.78;
+    V xc = select (x < lo, splat<V> (lo), x);
+    xc = select (xc > hi, splat<V> (hi), xc);
+
+    // x = k ln 2 + r, |r| <= ln 2 / 2
+    V kd = xc * M_LOG2E + round_magic;
+    U k = bitcast<U> (kd);
+    kd -= round_magic;
+    V r = (xc - kd * 6.93147180369123816490e-01) - kd * 1.90821492927058770002e-10;
+
+    V p = splat<V> (1. / 6227020800.);
+    p = p * r + 1. / 479001600.;
+    p = p * r + 1. / 39916800.;
+    p = p * r + 1. / 3628800.;
+    p = p * r + 1. / 362880.;
+    p = p * r + 1. / 40320.;
+    p = p * r + 1. / 5040.;
+    p = p * r + 1. / 720.;
+    p = p * r + 1. / 120.;
+    p = p * r + 1. / 24.;
+    p = p * r + 1. / 6.;
+    p = p * r + 0.5;
+    p = p * r + 1.;
+    p = p * r + 1.;
+
+    // 2^(k-1) * 2, so that k = 1024 does not overflow the exponent
+    V scale = bitcast<V> (((k - 1ull) << 52) + 0x3ff0000000000000ull);
+    V res = p * scale * 2.;
+    res = select (x < lo, splat<V> (0.), res);
+    res = select (x > hi, splat<V> (inf), res);
+    return select (x != x, x, res);
+}
+
+template <typename V> SIMD_INLINE V
+vlog (const V &x)
+{
+    typedef typename lanes<V>::U U;
+
+    // scale subnormals into the normal range
+    auto tiny = x < std::numeric_limits<double>::min ();
+    V xs = select (tiny, x * 4503599627370496.0, x);
+    U b = bitcast<U> (xs);
+
+    // x = 2^e m, with m in [sqrt(2)/2, sqrt(2))
+    V e = bitcast<V> (((b >> 52) & 0x7ffull) | 0x4330000000000000ull)
+        - 4503599627370496.0 - 1023.;
+    e = select (tiny, e - 52., e);
+    V m = bitcast<V> ((b & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+    auto big = m > M_SQRT2;
+    m = select (big, m * 0.5, m);
+    e = select (big, e + 1., e);
+
+    // log m = 2 atanh (s), s = (m - 1) / (m + 1)
+    V f = m - 1.;
+    V s = f / (f + 2.);
+    V z = s * s;
+    V p = splat<V> (1. / 21.);
+    p = p * z + 1. / 19.;
+    p = p * z + 1. / 17.;
+    p = p * z + 1. / 15.;
+    p = p * z + 1. / 13.;
+    p = p * z + 1. / 11.;
+    p = p * z + 1. / 9.;
+    p = p * z + 1. / 7.;
+    p = p * z + 1. / 5.;
+    p = p * z + 1. / 3.;
+    p = p * z;
+    V res = e * 6.93147180369123816490e-01
+        + (2. * s + 2. * s * p + e * 1.90821492927058770002e-10);
+    res = select (x == 0., splat<V> (-inf), res);
+    res = select (x < 0., splat<V> (std::numeric_limits<double>::quiet_NaN ()), res);
+    res = select (x == inf, splat<V> (inf), res);
+    return select (x != x, x, res);
+}
+
+/**
+ * Computes sin (x) if quadrant is 0, or cos (x) = sin (x + pi / 2) if it is 1.
+ */
+template <typename V> SIMD_INLINE V
+vsincos (const V &x, uint64_t quadrant)
+{
+    typedef typename lanes<V>::U U;
+
+    // x = k pi / 2 + r, |r| <= pi / 4
+    V kd = x * M_2_PI + round_magic;
+    U q = bitcast<U> (kd) + quadrant;
+    kd -= round_magic;
+    V r = ((x - kd * 1.57079632673412561417e+00)
+            - kd * 6.07710050630396597660e-11)
+        - kd * 2.02226624879595063154e-21;
+
+    V z = r * r;
+    V s = splat<V> (1.58969099521155010221e-10);
+    s = s * z - 2.50507602534068634195e-08;
+    s = s * z + 2.75573137070700676789e-06;
+    s = s * z - 1.98412698298579493134e-04;
+    s = s * z + 8.33333333332248946124e-03;
+    s = s * z - 1.66666666666666324348e-01;
+    s = r + r * z * s;
+
+    V c = splat<V> (-1.13596475577881948265e-11);
+    c = c * z + 2.08757232129817482790e-09;
+    c = c * z - 2.75573143513906633035e-07;
+    c = c * z + 2.48015872894767294178e-05;
+    c = c * z - 1.38888888888741095749e-03;
+    c = c * z + 4.16666666666666019037e-02;
+    c = (1. - 0.5 * z) + z * z * c;
+
+    V res = select ((q & 1ull) == 0ull, s, c);
+    return bitcast<V> (bitcast<U> (res) ^ ((q & 2ull) << 62));
+}
+
+template <typename V> SIMD_INLINE V
+vsin (const V &x)
+{
+    return vsincos (x, 0);
+}
+
+template <typename V> SIMD_INLINE V
+vcos (const V &x)
+{
+    return vsincos (x, 1);
+}
+
+template <typename V> SIMD_INLINE V
+vsqrt (const V &x)
+{
+    typedef typename lanes<V>::U U;
+    // the usual bit trick gives 1 / sqrt (x) to within 4%, and each Newton
+    // step doubles the number of correct bits without dividing; a final step
+    // of Heron's method corrects the rounding of the product.
+    V r = bitcast<V> (0x5fe6eb50c7b537a9ull - (bitcast<U> (x) >> 1));
+    for (int k = 0; k < 4; k++)
+        r = r * (1.5 - 0.5 * x * r * r);
+    V y = x * r;
+    y = 0.5 * (y + x / y);
+    y = select (x == 0., x, y);
+    y = select (x == inf, x, y);
+    return select (x < 0., splat<V> (std::numeric_limits<double>::quiet_NaN ()), y);
+}
+
+/*
+ * Each kernel describes its function as reductions over the coordinates:
+ *
+ * - accs accumulators, starting at init, are updated by term at every
+ *   coordinate j with the value x_j, the next value x_{j+1} (only meaningful
+ *   when pairs is set, in which case j stops at d - 2) and j itself;
+ * - prod marks the accumulators which are products rather than sums;
+ * - finish computes the function from the reduced accumulators, the number
+ *   of dimensions and the first coordinate.
+ */
+
+struct ackley1_k {
+    static constexpr u_int accs = 2;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0., 0.};
+    static constexpr bool prod[accs] = {false, false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] += x * x;
+        acc[1] += vcos (2. * M_PI * x);
+    }
+
+    static double
+    finish (const double *acc, u_int d, double)
+    {
+        double rD = 1. / (double) d;
+        return -20. * std::exp (-0.2 * std::sqrt (rD * acc[0]))
+            - std::exp (rD * acc[1]) + 20. + M_E;
+    }
+};
+
+struct alpine1_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] += vabs (x * vsin (x) + 0.1 * x);
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return acc[0];
+    }
+};
+
+struct alpine2_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {1.};
+    static constexpr bool prod[accs] = {true};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] *= vsqrt (x) * vsin (x);
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return acc[0];
+    }
+};
+
+struct brown_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = true;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &xn, const V &)
+    {
+        V x2 = x * x, xn2 = xn * xn;
+        acc[0] += vexp ((xn2 + 1.) * vlog (x2)) + vexp ((x2 + 1.) * vlog (xn2));
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return acc[0];
+    }
+};
+
+struct chung_reynolds_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] += x * x;
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return acc[0] * acc[0];
+    }
+};
+
+struct cosine_mixture_k {
+    static constexpr u_int accs = 2;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0., 0.};
+    static constexpr bool prod[accs] = {false, false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] += vcos (5. * M_PI * x);
+        acc[1] += x * x;
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return 0.1 * acc[0] - acc[1];
+    }
+};
+
+struct deb1_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        V s = vsin (5. * M_PI * x);
+        V s2 = s * s;
+        acc[0] += s2 * s2 * s2;
+    }
+
+    static double
+    finish (const double *acc, u_int d, double)
+    {
+        return -1. / (double) d * acc[0];
+    }
+};
+
+struct dixon_price_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = true;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &xn, const V &j)
+    {
+        V t = 2. * xn * xn - x;
+        acc[0] += (j + 2.) * t * t;
+    }
+
+    static double
+    finish (const double *acc, u_int, double x0)
+    {
+        return (x0 - 1.) * (x0 - 1.) + acc[0];
+    }
+};
+
+struct exponential_k {
+    static constexpr u_int accs = 1;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0.};
+    static constexpr bool prod[accs] = {false};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &)
+    {
+        acc[0] += x * x;
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return -std::exp (-0.5 * acc[0]);
+    }
+};
+
+struct griewank_k {
+    static constexpr u_int accs = 2;
+    static constexpr bool pairs = false;
+    static constexpr double init[accs] = {0., 1.};
+    static constexpr bool prod[accs] = {false, true};
+
+    template <typename V> static SIMD_INLINE void
+    term (V *acc, const V &x, const V &, const V &j)
+    {
+        acc[0] += x * x;
+        acc[1] *= vcos (x / vsqrt (j + 1.));
+    }
+
+    static double
+    finish (const double *acc, u_int, double)
+    {
+        return 1. / 4000. * acc[0] - acc[1] + 1.;
+    }
+};
+
+/**
+ * Evaluates the width points starting at column i of the d by n matrix x.
+ */
+template <typename K, typename V> SIMD_INLINE void
+block (const double *x, u_int d, u_int n, u_int i, double *out)
+{
+    const u_int w = lanes<V>::width;
+    u_int m = K::pairs && d > 0 ? d - 1 : d;
+
+    V acc[K::accs];
+    for (u_int a = 0; a < K::accs; a++)
+        acc[a] = splat<V> (K::init[a]);
+    for (u_int j = 0; j < m; j++) {
+        V xj = load<V> (x + j * n + i);
+        V xn = K::pairs ? load<V> (x + (j + 1) * n + i) : xj;
+        K::template term<V> (acc, xj, xn, splat<V> ((double) j));
+    }
+
+    double lane_acc[K::accs][w];
+    for (u_int a = 0; a < K::accs; a++)
+        store (lane_acc[a], acc[a]);
+    for (u_int l = 0; l < w; l++) {
+        double pt[K::accs];
+        for (u_int a = 0; a < K::accs; a++)
+            pt[a] = lane_acc[a][l];
+        out[i + l] = K::finish (pt, d, x[i + l]);
+    }
+}
+
+template <typename K, typename V> SIMD_INLINE void
+batch (const double *x, u_int d, u_int n, double *out)
+{
+    u_int i = 0;
+    for (; i + lanes<V>::width <= n; i += lanes<V>::width)
+        block<K, V> (x, d, n, i, out);
+    for (; i < n; i++)
+        block<K, double> (x, d, n, i, out);
+}
+
+template <typename K, typename V> SIMD_INLINE double
+point (const double *x, u_int d)
+{
+    const u_int w = lanes<V>::width;
+    u_int m = K::pairs && d > 0 ? d - 1 : d;
+
+    V acc[K::accs];
+    for (u_int a = 0; a < K::accs; a++)
+        acc[a] = splat<V> (K::init[a]);
+    V idx = iota<V> ();
+    u_int j = 0;
+    for (; j + w <= m; j += w) {
+        V xj = load<V> (x + j);
+        V xn = K::pairs ? load<V> (x + j + 1) : xj;
+        K::template term<V> (acc, xj, xn, idx + (double) j);
+    }
+
+    // reduce the lanes, then carry on with the remaining coordinates
+    double res[K::accs];
+    for (u_int a = 0; a < K::accs; a++) {
+        double lane_acc[w];
+        store (lane_acc, acc[a]);
+        res[a] = K::init[a];
+        for (u_int l = 0; l < w; l++)
+            res[a] = K::prod[a] ? res[a] * lane_acc[l] : res[a] + lane_acc[l];
+    }
+    for (; j < m; j++)
+        K::template term<double> (res, x[j], K::pairs ? x[j + 1] : x[j], (double) j);
+
+    return K::finish (res, d, x[0]);
+}
+
+typedef void (*batch_fn) (const double *, u_int, u_int, double *);
+typedef double (*point_fn) (const double *, u_int);
+
+struct kernels {
+    batch_fn batch;
+    point_fn point;
+};
+
+#ifdef SIMD_X86
+template <typename K> __attribute__ ((target ("avx2,fma"))) void
+batch_avx2 (const double *x, u_int d, u_int n, double *out)
+{
+    batch<K, v4d> (x, d, n, out);
+}
+
+template <typename K> __attribute__ ((target ("avx2,fma"))) double
+point_avx2 (const double *x, u_int d)
+{
+    return point<K, v4d> (x, d);
+}
+
+template <typename K> __attribute__ ((target ("avx512f"))) void
+batch_avx512 (const double *x, u_int d, u_int n, double *out)
+{
+    batch<K, v8d> (x, d, n, out);
+}
+
+template <typename K> __attribute__ ((target ("avx512f"))) double
+point_avx512 (const double *x, u_int d)
+{
+    return point<K, v8d> (x, d);
+}
+
+#define SIMD_KERNELS(level, K) { batch_##level<K>, point_##level<K> }
+
+// in the order of simd::function
+#define SIMD_TABLE(level) {                       \
+    SIMD_KERNELS (level, ackley1_k),              \
+    SIMD_KERNELS (level, alpine1_k),              \
+    SIMD_KERNELS (level, alpine2_k),              \
+    SIMD_KERNELS (level, brown_k),                \
+    SIMD_KERNELS (level, chung_reynolds_k),       \
+    SIMD_KERNELS (level, cosine_mixture_k),       \
+    SIMD_KERNELS (level, deb1_k),                 \
+    SIMD_KERNELS (level, dixon_price_k),          \
+    SIMD_KERNELS (level, exponential_k),          \
+    SIMD_KERNELS (level, griewank_k)              \
+}
+
+static const kernels avx2_table[] = SIMD_TABLE (avx2);
+static const kernels avx512_table[] = SIMD_TABLE (avx512);
+#endif
+
+static const kernels *
+table (level l)
+{
+    switch (l) {
+#ifdef SIMD_X86
+        case level::avx2: return avx2_table;
+        case level::avx512: return avx512_table;
+#endif
+        default: return nullptr;
+    }
+}
+
+static std::atomic<level> &
+current ()
+{
+    static std::atomic<level> l (best ());
+    return l;
+}
+
+} // namespace
+
+std::string
+level_name (level l)
+{
+    switch (l) {
+        case level::scalar: return "scalar";
+        case level::avx2: return "avx2";
+        case level::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool
+supported (level l)
+{
+    switch (l) {
+        case level::scalar:
+            return true;
+#ifdef SIMD_X86
+        case level::avx2:
+            return __builtin_cpu_supports ("avx2") &&
+                __builtin_cpu_supports ("fma");
+        case level::avx512:
+            return __builtin_cpu_supports ("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+level
+best ()
+{
+    if (supported (level::avx512))
+        return level::avx512;
+    if (supported (level::avx2))
+        return level::avx2;
+    return level::scalar;
+}
+
+level
+active ()
+{
+    return current ().load ();
+}
+
+void
+set_active (level l)
+{
+    if (!supported (l))
+        throw std::invalid_argument (
+                level_name (l) + " is not supported on this machine");
+    current ().store (l);
+}
+
+bool
+evaluate (function f, const double *x, u_int d, double *res)
+{
+    const kernels *t = table (active ());
+    if (!t || d == 0)
+        return false;
+    *res = t[static_cast<int> (f)].point (x, d);
+    return true;
+}
+
+bool
+evaluate_batch (function f, const double *x, u_int d, u_int n, double *out)
+{
+    const kernels *t = table (active ());
+    if (!t || d == 0)
+        return false;
+    t[static_cast<int> (f)].batch (x, d, n, out);
+    return true;
+}
+
+} // namespace simd
+} // namespace syn
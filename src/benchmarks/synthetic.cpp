@@ -22,6 +22,10 @@
  */
 
 #include <benchmarks/synthetic.hpp>
+#include <benchmarks/simd.hpp>
+#include <benchmarks/variant.hpp>
+#include <optk/cache.hpp>
+#include <optk/timing.hpp>
 #include <sys/types.h>
 
 /** This namespace contains all free functions and types relating to the
@@ -55,17 +59,60 @@ synthetic::~synthetic()
         inst::free_node (opt_params);
 }
 
+double
+synthetic::evaluate (inst::set x)
+{
+    if (m_validate) {
+        OPTK_TIME (optk::timings::current (), optk::phase::validate);
+        validate_param_set (x);
+    }
+    return evaluate_dense (x->dense (m_dims));
+}
+
+void
+synthetic::evaluate_batch (const double *x, u_int n, double *out)
+{
+    if (m_validate) {
+        OPTK_TIME (optk::timings::current (), optk::phase::validate);
+        compile_space ();
+        for (u_int j = 0; j < m_dims; j++)
+            m_compiled.validate (j, x + j * n, n);
+    }
+    evaluate_dense_batch (x, n, out);
+}
+
+void
+synthetic::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    std::vector<double> point (m_dims);
+    for (u_int i = 0; i < n; i++) {
+        for (u_int j = 0; j < m_dims; j++)
+            point[j] = x[j * n + i];
+        out[i] = evaluate_dense (point.data());
+    }
+}
+
 void
 synthetic::validate_param_set(inst::set x)
 {
-    inst::value_map *vals = x->get_values();
-    sspace::validate_param_values (vals, &m_sspace);
+    compile_space ();
+    m_compiled.validate (x->get_values());
+}
+
+void
+synthetic::compile_space ()
+{
+    std::call_once (m_compile_once, [this] { m_compiled.compile (&m_sspace); });
 }
 
 void
 synthetic::set_opt_param(inst::set op)
 {
     opt_params = op;
+    // build the dense view now, so that later reads do not modify the node;
+    // the optimum of some functions is unknown, and left empty.
+    if (opt_params->get_values()->size() == m_dims)
+        opt_params->dense (m_dims);
 }
 
 ackley1::ackley1 (int d) :
@@ -86,20 +133,29 @@ ackley1::ackley1 (int d) :
 }
 
 double
-ackley1::evaluate (inst::set x)
+ackley1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::ackley1, x, m_dims, &vres))
+        return vres;
 
     double e1 = 0., e2 = 0.;
     double rD = 1. / (double) m_dims;
     for (u_int i = 0u; i < m_dims; i++) {
-        e1 += x->getdbl(i) * x->getdbl(i);
-        e2 += std::cos(2. * M_PI * x->getdbl(i));
+        e1 += x[i] * x[i];
+        e2 += std::cos(2. * M_PI * x[i]);
     }
     return -20. * std::exp(-0.2 * std::sqrt(rD * e1))
         - std::exp(rD * e2) + 20. + M_E;
 };
 
+void
+ackley1::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::ackley1, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
+}
+
 ackley2::ackley2 ():
     synthetic ("ackley2", 2, -32, 32, -200)
 {
@@ -118,12 +174,10 @@ ackley2::ackley2 ():
 }
 
 double
-ackley2::evaluate (inst::set x)
+ackley2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x12 = x->getdbl(0) * x->getdbl(0);
-    double x22 = x->getdbl(1) * x->getdbl(1);
+    double x12 = x[0] * x[0];
+    double x22 = x[1] * x[1];
     return -200 * std::exp(-0.02 * std::sqrt (x12 + x22));
 }
 
@@ -145,14 +199,12 @@ ackley3::ackley3 ():
 }
 
 double
-ackley3::evaluate (inst::set x)
+ackley3::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x12 = std::pow(x->getdbl("0"), 2.);
-    double x22 = std::pow(x->getdbl("1"), 2.);
+    double x12 = std::pow(x[0], 2.);
+    double x22 = std::pow(x[1], 2.);
     double e1 = -0.2 * std::sqrt(x12 + x22);
-    double e2 = std::cos(3 * x->getdbl("0")) + std::sin(3 * x->getdbl("1"));
+    double e2 = std::cos(3 * x[0]) + std::sin(3 * x[1]);
     return -200 * e1 + 5 * e2;
 }
 
@@ -180,12 +232,10 @@ adjiman::adjiman ():
 }
 
 double
-adjiman::evaluate (inst::set x)
+adjiman::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0);
-    double x2 = x->getdbl(1);
+    double x1 = x[0];
+    double x2 = x[1];
     return std::cos(x1) * std::sin(x2) - (x1 / (x2*x2 + 1));
 }
 
@@ -207,18 +257,27 @@ alpine1::alpine1 (int dims):
 }
 
 double
-alpine1::evaluate (inst::set x)
+alpine1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::alpine1, x, m_dims, &vres))
+        return vres;
 
     double res = 0.;
     for (u_int i = 0; i < m_dims; i++) {
-        double tmp = x->getdbl(i);
+        double tmp = x[i];
         res += std::fabs(tmp * std::sin(tmp) + 0.1 * tmp);
     }
     return res;
 }
 
+void
+alpine1::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::alpine1, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
+}
+
 alpine2::alpine2 (int dims):
     synthetic ("alpine2", dims, 0., 10., 0)
 {
@@ -239,18 +298,27 @@ alpine2::alpine2 (int dims):
 }
 
 double
-alpine2::evaluate (inst::set x)
+alpine2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::alpine2, x, m_dims, &vres))
+        return vres;
 
     double res = 1.;
     for (u_int i = 0; i < m_dims; i++) {
-        double tmp = x->getdbl(i);
+        double tmp = x[i];
         res *= std::sqrt(tmp) * std::sin(tmp);
     }
     return res;
 }
 
+void
+alpine2::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::alpine2, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
+}
+
 brad::brad ():
     synthetic ("brad", 3, 0.00821488)
 {
@@ -278,18 +346,16 @@ brad::brad ():
 }
 
 double
-brad::evaluate (inst::set x)
+brad::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double y[15] = {
         0.14, 0.18, 0.22, 0.25, 0.29, 0.32, 0.35, 0.39,
         0.37, 0.58, 0.73, 0.96, 1.34, 2.10, 4.39
     };
     double res = 0.;
-    double x1 = x->getdbl(0);
-    double x2 = x->getdbl(1);
-    double x3 = x->getdbl(2);
+    double x1 = x[0];
+    double x2 = x[1];
+    double x3 = x[2];
     for (int i = 1; i < 16; i++) {
         res += std::pow(
                 x1 + ((double)i/(x2*(double)(16-i) + x3*(double)std::min(i, 16-i))) - y[i-1]
@@ -317,11 +383,9 @@ bartels_conn::bartels_conn ():
 }
 
 double
-bartels_conn::evaluate (inst::set x)
+bartels_conn::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl("0"), x2 = x->getdbl("1");
+    double x1 = x[0], x2 = x[1];
     double x12 = std::pow(x1, 2.), x22 = std::pow(x2, 2.);
     return
         std::abs(x12 + x22 + x1*x2) +
@@ -346,11 +410,9 @@ beale::beale ():
 }
 
 double
-beale::evaluate (inst::set x)
+beale::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double x22 = std::pow(x2, 2.), x23 = std::pow(x2, 3.);
     return std::pow((1.5 - x1 + x1 * x2), 2.) +
         std::pow((2.25 - x1 + x1 * x22), 2.) +
@@ -375,11 +437,9 @@ biggs_exp2::biggs_exp2 ():
 }
 
 double
-biggs_exp2::evaluate (inst::set x)
+biggs_exp2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double res = 0.;
     for (int i = 1; i < 11; i++) {
         res += std::pow(std::exp (-0.1 * i * x1)
@@ -410,11 +470,9 @@ biggs_exp3::biggs_exp3 ():
 }
 
 double
-biggs_exp3::evaluate (inst::set x)
+biggs_exp3::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
     double res = 0.;
     for (int i = 1; i < 11; i++) {
         res += std::pow(std::exp (-0.1 * i * x1)
@@ -446,12 +504,10 @@ biggs_exp4::biggs_exp4 ():
 }
 
 double
-biggs_exp4::evaluate (inst::set x)
+biggs_exp4::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
-    double x4 = x->getdbl(3);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
+    double x4 = x[3];
     double res = 0.;
     for (int i = 1; i < 11; i++) {
         res += x3 * std::pow(std::exp (-0.1 * i * x1)
@@ -484,12 +540,10 @@ biggs_exp5::biggs_exp5 ():
 }
 
 double
-biggs_exp5::evaluate (inst::set x)
+biggs_exp5::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
-    double x4 = x->getdbl(3), x5 = x->getdbl(4);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
+    double x4 = x[3], x5 = x[4];
     double res = 0.;
     for (int i = 1; i < 11; i++) {
         res += x3 * std::pow(std::exp (-0.1 * i * x1)
@@ -525,12 +579,10 @@ biggs_exp6::biggs_exp6 ():
 }
 
 double
-biggs_exp6::evaluate (inst::set x)
+biggs_exp6::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
-    double x4 = x->getdbl(3), x5 = x->getdbl(4), x6 = x->getdbl(5);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
+    double x4 = x[3], x5 = x[4], x6 = x[5];
     double res = 0.;
     for (int i = 1; i < 11; i++) {
         res += x3 * std::pow(std::exp (-0.1 * i * x1)
@@ -563,11 +615,9 @@ bird::bird ():
 }
 
 double
-bird::evaluate (inst::set x)
+bird::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double e1 = std::exp (std::pow (1 - std::cos (x2), 2.));
     double e2 = std::exp (std::pow (1 - std::sin (x1), 2.));
     return std::sin (x1) * e1 + std::cos (x2) * e2 + std::pow (x1 - x2, 2.);
@@ -591,11 +641,9 @@ bohachevsky1::bohachevsky1 ():
 }
 
 double
-bohachevsky1::evaluate (inst::set x)
+bohachevsky1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1, 2.) + 2 * std::pow (x2, 2.)
         - 0.3 * std::cos (3 * M_PI * x1)
         - 0.4 * std::cos (4 * M_PI * x2)
@@ -620,11 +668,9 @@ bohachevsky2::bohachevsky2 ():
 }
 
 double
-bohachevsky2::evaluate (inst::set x)
+bohachevsky2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1, 2.) + 2 * std::pow (x2, 2.)
         - 0.3 * std::cos (3 * M_PI * x1) * std::cos (4 * M_PI * x2)
         + 0.3;
@@ -648,11 +694,9 @@ bohachevsky3::bohachevsky3 ():
 }
 
 double
-bohachevsky3::evaluate (inst::set x)
+bohachevsky3::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1, 2.) + 2 * std::pow (x2, 2.)
         - 0.3 * std::cos (3 * M_PI * x1 + 4 * M_PI * x2)
         + 0.3;
@@ -675,11 +719,9 @@ booth::booth ():
 }
 
 double
-booth::evaluate (inst::set x)
+booth::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1 + 2 * x2 - 7, 2.) +
         std::pow (2 * x1 + x2 - 5, 2.);
 }
@@ -720,11 +762,9 @@ box_betts_g(int i, double x1, double x2, double x3)
 }
 
 double
-box_betts::evaluate (inst::set x)
+box_betts::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
     double ret = 0.;
     for (int i = 2; i < 13; i++) {
         ret += box_betts_g (i, x1, x2, x3);
@@ -756,11 +796,9 @@ branin1::branin1 ():
 }
 
 double
-branin1::evaluate (inst::set x)
+branin1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x2 -
                 (5.1 / (4. * std::pow (M_PI, 2.))) * std::pow (x1, 2.) +
                 5. * x1 / M_PI - 6
@@ -787,11 +825,9 @@ branin2::branin2 ():
 }
 
 double
-branin2::evaluate (inst::set x)
+branin2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double x12 = std::pow (x1, 2.), x22 = std::pow (x2, 2.);
     return std::pow (x2 -
                      (5.1 / (4 * std::pow (M_PI, 2.))) *
@@ -821,11 +857,9 @@ brent::brent ():
 }
 
 double
-brent::evaluate (inst::set x)
+brent::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double e1 = std::exp (-std::pow (x1, 2.) - std::pow (x2, 2.));
     return std::pow(x1 + 10, 2.) + std::pow (x2 + 10, 2.) + e1;
 }
@@ -848,17 +882,28 @@ brown::brown (int dims):
 }
 
 double
-brown::evaluate (inst::set x)
-{
-    validate_param_set (x);
+brown::evaluate_dense (const double *x)
+{
+    double vres;
+    if (simd::evaluate (simd::function::brown, x, m_dims, &vres))
+        return vres;
+
+    return with_dims (m_dims, [x] (auto d) {
+        double ret = 0.;
+        for (u_int i = 0; i < d-1; i++) {
+            double xi2 = std::pow (x[i], 2.);
+            double xii2 = std::pow (x[i+1], 2.);
+            ret += std::pow (xi2, xii2 + 1) + std::pow (xii2, xi2 + 1);
+        }
+        return ret;
+    });
+}
 
-    double ret = 0.;
-    for (u_int i = 0; i < m_dims-1; i++) {
-        double xi2 = std::pow (x->getdbl(i), 2.);
-        double xii2 = std::pow (x->getdbl(i+1), 2.);
-        ret += std::pow (xi2, xii2 + 1) + std::pow (xii2, xi2 + 1);
-    }
-    return ret;
+void
+brown::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::brown, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
 }
 
 bukin2::bukin2 ():
@@ -885,11 +930,9 @@ bukin2::bukin2 ():
 }
 
 double
-bukin2::evaluate (inst::set x)
+bukin2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return 100 * (x2 - 0.01 * std::pow (x1, 2.) + 1.) +
         0.01 * std::pow(x1 + 10, 2.);
 }
@@ -918,11 +961,9 @@ bukin4::bukin4 ():
 }
 
 double
-bukin4::evaluate (inst::set x)
+bukin4::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x22 = std::pow (x->getdbl(1), 2.);
+    double x1 = x[0], x22 = std::pow (x[1], 2.);
     return 100 * x22 + 0.01 * std::fabs (x1 + 10);
 }
 
@@ -950,11 +991,9 @@ bukin6::bukin6 ():
 }
 
 double
-bukin6::evaluate (inst::set x)
+bukin6::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return 100 * std::sqrt (std::fabs (x2 - 0.01 * std::pow (x1, 2.))) +
             0.01 * std::fabs (x1 + 10);
 }
@@ -977,11 +1016,9 @@ camel3::camel3 ():
 }
 
 double
-camel3::evaluate (inst::set x)
+camel3::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return 2 * std::pow (x1, 2.) -
            1.05 * std::pow (x1, 4.) +
            std::pow (x1, 6.)/6. +
@@ -1007,11 +1044,9 @@ camel6::camel6 ():
 }
 
 double
-camel6::evaluate (inst::set x)
+camel6::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return (4 - 2.1 * std::pow (x1, 2.) +
         std::pow (x1, 4.) / 3.) * std::pow (x1, 2.) +
         x1 * x2 +
@@ -1036,11 +1071,9 @@ chichinadze::chichinadze ():
 }
 
 double
-chichinadze::evaluate (inst::set x)
+chichinadze::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1, 2.) -
         12 * x1 +
         11 +
@@ -1067,15 +1100,36 @@ chung_reynolds::chung_reynolds (int dims):
 }
 
 double
-chung_reynolds::evaluate (inst::set x)
+chung_reynolds::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::chung_reynolds, x, m_dims, &vres))
+        return vres;
 
-    double res = 0.;
-    for (u_int i = 0; i < m_dims; i++) {
-        res += std::pow (x->getdbl(i), 2.);
+    return with_dims (m_dims, [x] (auto d) {
+        double res = 0.;
+        for (u_int i = 0; i < d; i++) {
+            res += std::pow (x[i], 2.);
+        }
+        return std::pow (res, 2.);
+    });
+}
+
+void
+chung_reynolds::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (simd::evaluate_batch (simd::function::chung_reynolds, x, m_dims, n, out))
+        return;
+
+    for (u_int i = 0; i < n; i++)
+        out[i] = 0.;
+    for (u_int j = 0; j < m_dims; j++) {
+        const double *xj = x + j * n;
+        for (u_int i = 0; i < n; i++)
+            out[i] += xj[i] * xj[i];
     }
-    return std::pow (res, 2.);
+    for (u_int i = 0; i < n; i++)
+        out[i] *= out[i];
 }
 
 cola::cola ():
@@ -1108,10 +1162,8 @@ cola::cola ():
 }
 
 double
-cola::evaluate (inst::set x)
+cola::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double d[10][9] = {
         {0, 0, 0, 0, 0, 0, 0, 0, 0},
         {1.27, 0, 0, 0, 0, 0, 0, 0, 0},
@@ -1126,14 +1178,14 @@ cola::evaluate (inst::set x)
     };
 
     int idx = 2;
-    double x1[10] = {0, x->getdbl(0)};
+    double x1[10] = {0, x[0]};
     for (int i = 1; i < 17; i+=2)
-        x1[idx++] = x->getdbl(i);
+        x1[idx++] = x[i];
 
     idx = 2;
     double x2[10] = {0, 0};
     for (int i = 2; i < 17; i+=2)
-        x2[idx++] = x->getdbl(i);
+        x2[idx++] = x[i];
 
     double res = 0.;
     for (int i = 1; i < 10; i++) {
@@ -1168,12 +1220,10 @@ colville::colville ():
 }
 
 double
-colville::evaluate (inst::set x)
+colville::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
-    double x3 = x->getdbl(2), x4 = x->getdbl(3);
+    double x1 = x[0], x2 = x[1];
+    double x3 = x[2], x4 = x[3];
 
     return 100 * std::pow (x1 - std::pow (x2, 2.), 2.) +
            std::pow (1 - x1, 2.) +
@@ -1201,11 +1251,9 @@ corana::corana ():
 }
 
 double
-corana::evaluate (inst::set x)
+corana::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double xs[4] = {x->getdbl(0), x->getdbl(1), x->getdbl(2), x->getdbl(3)};
+    double xs[4] = {x[0], x[1], x[2], x[3]};
     double ds[4] = {1., 1000., 10., 100.};
 
     double res = 0.;
@@ -1242,20 +1290,27 @@ cosine_mixture::cosine_mixture (int dims):
 }
 
 double
-cosine_mixture::evaluate (inst::set x)
+cosine_mixture::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::cosine_mixture, x, m_dims, &vres))
+        return vres;
 
-    double xs[m_dims];
-    for (u_int i = 0; i < m_dims; i++)
-        xs[i] = x->getdbl(i);
+    return with_dims (m_dims, [x] (auto d) {
+        double s1 = 0., s2 = 0.;
+        for (u_int i = 0; i < d; i++) {
+            s1 += std::cos (5. * M_PI * x[i]);
+            s2 += std::pow (x[i], 2.);
+        }
+        return 0.1 * s1 - s2;
+    });
+}
 
-    double s1 = 0., s2 = 0.;
-    for (u_int i = 0; i < m_dims; i++) {
-        s1 += std::cos (5. * M_PI * xs[i]);
-        s2 += std::pow (xs[i], 2.);
-    }
-    return 0.1 * s1 - s2;
+void
+cosine_mixture::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::cosine_mixture, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
 }
 
 cross_in_tray::cross_in_tray ():
@@ -1275,9 +1330,9 @@ cross_in_tray::cross_in_tray ():
 }
 
 double
-cross_in_tray::evaluate (inst::set x)
+cross_in_tray::evaluate_dense (const double *x)
 {
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double e1 = std::exp (std::fabs (
                 100 -
                 std::sqrt (std::pow (x1, 2.) + std::pow (x2, 2.)) / M_PI
@@ -1308,13 +1363,11 @@ csendes::csendes (int dims):
 }
 
 double
-csendes::evaluate (inst::set x)
+csendes::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double res = 0.;
     for (u_int i = 0; i < m_dims; i++) {
-        double x_tmp = x->getdbl(i);
+        double x_tmp = x[i];
         double x_tmp6 = std::pow (x_tmp, 6.);
         res += x_tmp6 * (2 +
                 std::sin (1. /
@@ -1343,11 +1396,9 @@ cube::cube ():
 }
 
 double
-cube::evaluate (inst::set x)
+cube::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return 100. * std::pow (x2 - std::pow (x1, 3.), 2.) + std::pow (1 - x1, 2.);
 }
 
@@ -1369,11 +1420,9 @@ damavandi::damavandi ():
 }
 
 double
-damavandi::evaluate (inst::set x)
+damavandi::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double t1 = M_PI * (x1 - 2), t2 = M_PI * (x2 - 2);
     double q1;
     if (std::fabs (x1-2) > 1e-3 && std::fabs(x2-2) > 1e-3) {
@@ -1412,17 +1461,26 @@ deb1::deb1 (int dims):
 }
 
 double
-deb1::evaluate (inst::set x)
+deb1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::deb1, x, m_dims, &vres))
+        return vres;
 
     double res = 0.;
     double q = -1. / (double) m_dims;
     for (u_int i = 0; i < m_dims; i++)
-        res += std::pow (std::sin (5. * M_PI * x->getdbl(i)), 6.);
+        res += std::pow (std::sin (5. * M_PI * x[i]), 6.);
     return q * res;
 }
 
+void
+deb1::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::deb1, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
+}
+
 deb2::deb2 (int dims):
     synthetic ("deb 2", dims, -1., 1., -1.)
 {
@@ -1441,18 +1499,18 @@ deb2::deb2 (int dims):
 }
 
 double
-deb2::evaluate (inst::set x)
+deb2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double res = 0.;
-    double q = -1. / (double) m_dims;
-    for (u_int i = 0; i < m_dims; i++)
-        res += std::pow (std::sin (
-                    5 * M_PI * (std::pow (x->getdbl(i), 0.75) - 0.05)
-                    ),
-                6.);
-    return q * res;
+    return with_dims (m_dims, [x] (auto d) {
+        double res = 0.;
+        double q = -1. / (double) d;
+        for (u_int i = 0; i < d; i++)
+            res += std::pow (std::sin (
+                        5 * M_PI * (std::pow (x[i], 0.75) - 0.05)
+                        ),
+                    6.);
+        return q * res;
+    });
 }
 
 deckkers_aarts::deckkers_aarts ():
@@ -1473,11 +1531,9 @@ deckkers_aarts::deckkers_aarts ():
 }
 
 double
-deckkers_aarts::evaluate (inst::set x)
+deckkers_aarts::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double x12 = std::pow (x1, 2.), x22 = std::pow (x2, 2.);
 
     return std::pow (10., 5.) * x12 +
@@ -1506,12 +1562,10 @@ devillers_glasser1::devillers_glasser1 ():
 }
 
 double
-devillers_glasser1::evaluate (inst::set x)
+devillers_glasser1::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
-    double x3 = x->getdbl(2), x4 = x->getdbl(3);
+    double x1 = x[0], x2 = x[1];
+    double x3 = x[2], x4 = x[3];
 
     double res = 0.;
     for (int i = 1; i <= 24; i++) {
@@ -1550,12 +1604,10 @@ devillers_glasser2::devillers_glasser2 ():
 }
 
 double
-devillers_glasser2::evaluate (inst::set x)
+devillers_glasser2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
-    double x4 = x->getdbl(3), x5 = x->getdbl(4);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
+    double x4 = x[3], x5 = x[4];
     double res = 0.;
     for (int i = 1; i <= 16; i++) {
         double ti = 0.1 *((double)i - 1.);
@@ -1594,19 +1646,40 @@ dixon_price::dixon_price (int dims):
 }
 
 double
-dixon_price::evaluate (inst::set x)
-{
-    validate_param_set (x);
+dixon_price::evaluate_dense (const double *x)
+{
+    double vres;
+    if (simd::evaluate (simd::function::dixon_price, x, m_dims, &vres))
+        return vres;
+
+    return with_dims (m_dims, [x] (auto d) {
+        double res = std::pow (x[0] - 1, 2.);
+        for (uint i = 2; i <= d; i++) {
+            res += (double) i *
+                std::pow (
+                        2. * std::pow (x[i-1], 2.) -
+                        x[i-2],
+                        2.);
+        }
+        return res;
+    });
+}
 
-    double res = std::pow (x->getdbl(0) - 1, 2.);
-    for (uint i = 2; i <= m_dims; i++) {
-        res += (double) i *
-            std::pow (
-                    2. * std::pow (x->getdbl(i-1), 2.) -
-                    x->getdbl(i-2),
-                    2.);
+void
+dixon_price::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (simd::evaluate_batch (simd::function::dixon_price, x, m_dims, n, out))
+        return;
+
+    for (u_int i = 0; i < n; i++)
+        out[i] = (x[i] - 1.) * (x[i] - 1.);
+    for (u_int j = 2; j <= m_dims; j++) {
+        const double *xj1 = x + (j-1) * n, *xj2 = x + (j-2) * n;
+        for (u_int i = 0; i < n; i++) {
+            double t = 2. * xj1[i] * xj1[i] - xj2[i];
+            out[i] += (double) j * t * t;
+        }
     }
-    return res;
 }
 
 dolan::dolan ():
@@ -1630,12 +1703,10 @@ dolan::dolan ():
 }
 
 double
-dolan::evaluate (inst::set x)
+dolan::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
-    double x4 = x->getdbl(3), x5 = x->getdbl(4);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
+    double x4 = x[3], x5 = x[4];
 
     return (x1 + 1.7 * x2) * std::sin (x1) -
         1.5 * x3 -
@@ -1662,16 +1733,14 @@ deceptive::deceptive (int dims):
 }
 
 double
-deceptive::evaluate (inst::set x)
+deceptive::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     inst::set opt = this->get_opt_param ();
 
     double g = 0.;
     for (uint i = 0; i < m_dims; i++) {
         double ai = opt->getdbl(i);
-        double xi = x->getdbl(i);
+        double xi = x[i];
 
         if (xi <= 0) {
             g += xi;
@@ -1708,14 +1777,14 @@ deflected_corrugated_spring::deflected_corrugated_spring (int dims) :
 }
 
 double
-deflected_corrugated_spring::evaluate (inst::set x)
+deflected_corrugated_spring::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double sum = 0.;
-    for (uint i = 0; i < m_dims; i++)
-        sum += std::pow (x->getdbl(i) - 5, 2.);
-    return 0.1 * sum - std::cos (5. * std::sqrt (sum));
+    return with_dims (m_dims, [x] (auto d) {
+        double sum = 0.;
+        for (uint i = 0; i < d; i++)
+            sum += std::pow (x[i] - 5, 2.);
+        return 0.1 * sum - std::cos (5. * std::sqrt (sum));
+    });
 }
 
 drop_wave::drop_wave ():
@@ -1736,11 +1805,9 @@ drop_wave::drop_wave ():
 }
 
 double
-drop_wave::evaluate (inst::set x)
+drop_wave::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     double d1 = std::pow (x1, 2.) + std::pow (x2, 2.);
     double n = 1 + std::cos (12. * std::sqrt (d1));
     double d = 0.5 * d1 + 2.;
@@ -1765,11 +1832,9 @@ easom::easom ():
 }
 
 double
-easom::evaluate (inst::set x)
+easom::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return -1. *
         std::cos (x1) *
         std::cos (x2) *
@@ -1795,11 +1860,9 @@ egg_crate::egg_crate ():
 }
 
 double
-egg_crate::evaluate (inst::set x)
+egg_crate::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (x1, 2.) +
            std::pow (x2, 2.) +
            25 * (
@@ -1824,11 +1887,9 @@ egg_holder::egg_holder ():
 }
 
 double
-egg_holder::evaluate (inst::set x)
+egg_holder::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return -(x2 + 47) *
            std::sin (std::sqrt (std::fabs (x2 + x1/2. + 47.))) -
            x1 * std::sin (std::sqrt (std::fabs (x1 - (x2 + 47))));
@@ -1852,11 +1913,9 @@ el_attar_vidyasagar_dutta::el_attar_vidyasagar_dutta ():
 }
 
 double
-el_attar_vidyasagar_dutta::evaluate (inst::set x)
+el_attar_vidyasagar_dutta::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
     return std::pow (std::pow (x1, 2.) + x2 - 10, 2.) +
            std::pow (x1 + std::pow (x2, 2.) - 7 , 2.) +
            std::pow (std::pow (x1, 2.) + std::pow (x2, 3.) - 1 , 2.);
@@ -1880,15 +1939,36 @@ exponential::exponential (int dims):
 }
 
 double
-exponential::evaluate (inst::set x)
+exponential::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::exponential, x, m_dims, &vres))
+        return vres;
 
-    double sum = 0.;
-    for (uint i = 0; i < m_dims; i++) {
-        sum += std::pow (x->getdbl(i), 2.);
+    return with_dims (m_dims, [x] (auto d) {
+        double sum = 0.;
+        for (uint i = 0; i < d; i++) {
+            sum += std::pow (x[i], 2.);
+        }
+        return -std::exp (-0.5 * sum);
+    });
+}
+
+void
+exponential::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (simd::evaluate_batch (simd::function::exponential, x, m_dims, n, out))
+        return;
+
+    for (u_int i = 0; i < n; i++)
+        out[i] = 0.;
+    for (u_int j = 0; j < m_dims; j++) {
+        const double *xj = x + j * n;
+        for (u_int i = 0; i < n; i++)
+            out[i] += xj[i] * xj[i];
     }
-    return -std::exp (-0.5 * sum);
+    for (u_int i = 0; i < n; i++)
+        out[i] = -std::exp (-0.5 * out[i]);
 }
 
 exp2::exp2 ():
@@ -1909,11 +1989,9 @@ exp2::exp2 ():
 }
 
 double
-exp2::evaluate (inst::set x)
+exp2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double res = 0.;
     for (int i = 0; i < 10; i++) {
@@ -1945,11 +2023,9 @@ franke::franke ():
 }
 
 double
-franke::evaluate (inst::set x)
+franke::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return
         0.75 * std::exp (-std::pow (9*x1-2, 2.)/4. - std::pow (9*x2-2, 2.)/4.) +
@@ -1976,11 +2052,9 @@ freudenstein_roth::freudenstein_roth ():
 }
 
 double
-freudenstein_roth::evaluate (inst::set x)
+freudenstein_roth::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return
         std::pow ((x1 - 13 + ((5 - x2) * x2 - 2)*x2) ,2.) +
@@ -2007,12 +2081,10 @@ gear::gear ():
 }
 
 double
-gear::evaluate (inst::set x)
+gear::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
-    double x3 = x->getdbl(2), x4 = x->getdbl(3);
+    double x1 = x[0], x2 = x[1];
+    double x3 = x[2], x4 = x[3];
 
     return std::min(
             std::pow ( 1./6.931 -
@@ -2041,11 +2113,9 @@ giunta::giunta ():
 }
 
 double
-giunta::evaluate (inst::set x)
+giunta::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double xs[2] = {x->getdbl(0), x->getdbl(1)};
+    double xs[2] = {x[0], x[1]};
 
     double res = 0.;
     for (int i = 0; i < 2; i++)
@@ -2073,11 +2143,9 @@ goldstein_price::goldstein_price ():
 }
 
 double
-goldstein_price::evaluate (inst::set x)
+goldstein_price::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double f1 = 1 + std::pow(x1 + x2 + 1, 2.) *
                 (19 -
@@ -2115,13 +2183,15 @@ griewank::griewank (int dims):
 }
 
 double
-griewank::evaluate (inst::set x)
+griewank::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
+    double vres;
+    if (simd::evaluate (simd::function::griewank, x, m_dims, &vres))
+        return vres;
 
     double sum = 0., prod = 1.;
     for (uint i = 1; i < m_dims+1; i++) {
-        double xi = x->getdbl(i-1);
+        double xi = x[i-1];
         sum += std::pow (xi, 2.);
         prod *= std::cos (xi / std::sqrt((double) i));
     }
@@ -2129,6 +2199,13 @@ griewank::evaluate (inst::set x)
     return 1./4000. * sum - prod + 1;
 }
 
+void
+griewank::evaluate_dense_batch (const double *x, u_int n, double *out)
+{
+    if (!simd::evaluate_batch (simd::function::griewank, x, m_dims, n, out))
+        synthetic::evaluate_dense_batch (x, n, out);
+}
+
 gulf::gulf ():
     synthetic ("gulf", 3, 0.)
 {
@@ -2156,11 +2233,9 @@ gulf::gulf ():
 }
 
 double
-gulf::evaluate (inst::set x)
+gulf::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
 
     double sum = 0.;
     for (int i = 1; i < 99; i++) {
@@ -2193,11 +2268,9 @@ hansen::hansen ():
 }
 
 double
-hansen::evaluate (inst::set x)
+hansen::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double sum1 = 0., sum2 = 0.;
     for (int i = 0; i < 5; i++) {
@@ -2227,34 +2300,45 @@ hartman3::hartman3 ():
     this->set_opt_param (opt);
 }
 
-double
-hartman3::evaluate (inst::set x)
-{
-    validate_param_set (x);
+/** The coefficients shared by hartman3 and hartman6. */
+static constexpr double hartman_c[4] = {1, 1.2, 3, 3.2};
 
-    double xs[3] = {x->getdbl(0), x->getdbl(1), x->getdbl(2)};
-
-    double a[4][3] = {{3., 10., 30.},
-                      {0.1, 10., 35.},
-                      {3., 10., 30.},
-                      {0.1, 10., 35.}};
-    double c[4] = {1, 1.2, 3, 3.2};
-    double p[4][3] = {{0.36890, 0.11700, 0.26730},
-                      {0.46990, 0.43870, 0.74700},
-                      {0.10910, 0.87320, 0.55470},
-                      {0.03815, 0.57430, 0.88280}};
+static constexpr double hartman3_a[4][3] = {{3., 10., 30.},
+                                            {0.1, 10., 35.},
+                                            {3., 10., 30.},
+                                            {0.1, 10., 35.}};
+static constexpr double hartman3_p[4][3] = {{0.36890, 0.11700, 0.26730},
+                                            {0.46990, 0.43870, 0.74700},
+                                            {0.10910, 0.87320, 0.55470},
+                                            {0.03815, 0.57430, 0.88280}};
 
+/**
+ * Evaluates the D-dimensional hartman function with the coefficients a and
+ * p; the dimension is a template parameter so that the inner loop over the
+ * coordinates is unrolled.
+ */
+template <u_int D>
+static double
+hartman (const double (&a)[4][D], const double (&p)[4][D], const double *x)
+{
     double res = 0.;
     for (int i = 0; i < 4; i++) {
         double s1 = 0.;
-        for (int j = 0; j < 3; j++) {
-            s1 += a[i][j] * std::pow (xs[j] - p[i][j], 2.);
+        for (u_int j = 0; j < D; j++) {
+            double t = x[j] - p[i][j];
+            s1 += a[i][j] * (t * t);
         }
-        res += c[i] * std::exp (- s1);
+        res += hartman_c[i] * std::exp (- s1);
     }
     return -res;
 }
 
+double
+hartman3::evaluate_dense (const double *x)
+{
+    return hartman (hartman3_a, hartman3_p, x);
+}
+
 hartman6::hartman6 ():
     synthetic ("hartman6", 6, 0., 1., -3.32236801141551)
 {
@@ -2276,34 +2360,21 @@ hartman6::hartman6 ():
     this->set_opt_param (opt);
 }
 
+static constexpr double hartman6_a[4][6] = {
+    {10., 3., 17., 3.5, 1.7, 8. },
+    { 0.05,10., 17., 0.1, 8., 14.},
+    { 3., 3.5, 1.7, 10., 17., 8.},
+    {17., 8. , 0.05, 10., 0.1, 14.}};
+static constexpr double hartman6_p[4][6] = {
+    {0.1312, 0.1696, 0.5569, 0.0124, 0.8283, 0.5886},
+    {0.2329, 0.4135, 0.8307, 0.3736, 0.1004, 0.9991},
+    {0.2348, 0.1451, 0.3522, 0.2883, 0.3047, 0.665 },
+    {0.4047, 0.8828, 0.8732, 0.5743, 0.1091, 0.0381}};
+
 double
-hartman6::evaluate (inst::set x)
+hartman6::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double xs[6];
-    for (int i = 0; i < 6; i++) xs[i] = x->getdbl(i);
-
-    double a[4][6] = {{10., 3., 17., 3.5, 1.7, 8. },
-                      { 0.05,10., 17., 0.1, 8., 14.},
-                      { 3., 3.5, 1.7, 10., 17., 8.},
-                      {17., 8. , 0.05, 10., 0.1, 14.}};
-
-    double c[4] = {1, 1.2, 3, 3.2};
-    double p[4][6] = {{0.1312, 0.1696, 0.5569, 0.0124, 0.8283, 0.5886},
-                      {0.2329, 0.4135, 0.8307, 0.3736, 0.1004, 0.9991},
-                      {0.2348, 0.1451, 0.3522, 0.2883, 0.3047, 0.665 },
-                      {0.4047, 0.8828, 0.8732, 0.5743, 0.1091, 0.0381}};
-
-    double res = 0.;
-    for (int i = 0; i < 4; i++) {
-        double s1 = 0.;
-        for (int j = 0; j < 6; j++) {
-            s1 += a[i][j] * std::pow (xs[j] - p[i][j], 2.);
-        }
-        res += c[i] * std::exp (- s1);
-    }
-    return -res;
+    return hartman (hartman6_a, hartman6_p, x);
 }
 
 helical_valley::helical_valley ():
@@ -2325,11 +2396,9 @@ helical_valley::helical_valley ():
 }
 
 double
-helical_valley::evaluate (inst::set x)
+helical_valley::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
 
     return 100. * (
             std::pow (x3 - 10 * (std::atan2 (x2, x1) / (2 * M_PI)), 2.) +
@@ -2361,11 +2430,9 @@ himmelblau::himmelblau ():
 }
 
 double
-himmelblau::evaluate (inst::set x)
+himmelblau::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return std::pow(
             std::pow (x1, 2.) + x2 - 11,
@@ -2393,11 +2460,9 @@ holder_table::holder_table ():
 }
 
 double
-holder_table::evaluate (inst::set x)
+holder_table::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return - std::fabs (
             std::sin (x1) *
@@ -2437,11 +2502,9 @@ hosaki::hosaki ():
 }
 
 double
-hosaki::evaluate (inst::set x)
+hosaki::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return (1 + x1 * (-8 + x1 * (7 + x1 * (-7./3. + x1 * 1./4.))))
         * x2
@@ -2467,11 +2530,9 @@ jennrich_sampson::jennrich_sampson ():
 }
 
 double
-jennrich_sampson::evaluate (inst::set x)
+jennrich_sampson::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double res = 0.;
     for (int i = 0; i < 11; i++) {
@@ -2502,11 +2563,9 @@ judge::judge ():
 }
 
 double
-judge::evaluate (inst::set x)
+judge::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
 
     double A[20] = { 4.284, 4.149, 3.877, 0.533, 2.211, 2.389, 2.145, 3.231,
@@ -2545,11 +2604,9 @@ langermann2::langermann2 ():
 }
 
 double
-langermann2::evaluate (inst::set x)
+langermann2::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double a[5] = {3, 5, 2, 1, 7};
     double b[5] = {5, 2, 1, 4, 9};
@@ -2582,10 +2639,8 @@ langermann5::langermann5 ():
 }
 
 double
-langermann5::evaluate (inst::set x)
+langermann5::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double a[5][10] = {
         {9.681, 0.667, 4.783, 9.095, 3.517, 9.325, 6.544, 0.211, 5.122, 2.020},
         {9.400, 2.041, 3.788, 7.931, 2.882, 2.672, 3.568, 1.284, 7.033, 7.374},
@@ -2599,7 +2654,7 @@ langermann5::evaluate (inst::set x)
     for (int i = 0; i < 5; i++) {
         double s1 = 0.;
         for (int j = 0; j < 10; j++)
-            s1 += std::pow (x->getdbl(i) - a[i][j], 2.);
+            s1 += std::pow (x[i] - a[i][j], 2.);
         res += c[i] *
             std::exp ((-1./M_PI) * s1) *
             std::cos (M_PI * s1);
@@ -2627,19 +2682,17 @@ lennard_jones::lennard_jones ():
 }
 
 double
-lennard_jones::evaluate (inst::set x)
+lennard_jones::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     int k = m_dims/3;
     double res = 0.;
     for (int i = 0; i < k-1; i++) {
         for (int j = i+1; j < k; j++) {
             int a = 3 * i;
             int b = 3 * j;
-            double xd = x->getdbl(a) - x->getdbl(b);
-            double yd = x->getdbl(a+1) - x->getdbl(b+1);
-            double zd = x->getdbl(a+2) - x->getdbl(b+2);
+            double xd = x[a] - x[b];
+            double yd = x[a+1] - x[b+1];
+            double zd = x[a+2] - x[b+2];
             double ed = xd*xd + yd*yd + zd*zd;
             double ud = std::pow (ed, 3.) + 1e-8;
             if (ed > 0)
@@ -2669,11 +2722,9 @@ keane::keane ():
 }
 
 double
-keane::evaluate (inst::set x)
+keane::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return (std::pow (std::sin (x1 - x2), 2.) *
             std::pow (std::sin (x1 + x2), 2.)) /
@@ -2701,11 +2752,9 @@ leon::leon ():
 }
 
 double
-leon::evaluate (inst::set x)
+leon::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return 100. *
         std::pow (x2 - std::pow (x1, 2.), 2.) +
@@ -2730,34 +2779,34 @@ levy3::levy3 (int dims):
 }
 
 static double
-levy3_w (int i, inst::set x)
+levy3_w (int i, const double *x)
 {
-    return 1 + (x->getdbl(i)-1.)/4.;
+    return 1 + (x[i]-1.)/4.;
 }
 
 double
-levy3::evaluate (inst::set x)
-{
-    validate_param_set (x);
-
-    double res = std::pow (std::sin (M_PI * levy3_w(0, x)), 2.);
-    for (uint i = 0; i < m_dims-1; i++)
-        res += std::pow ( levy3_w(i, x) - 1, 2.) *
-            ( 1. +
-              10. * std::pow (
-                  std::sin ( M_PI * levy3_w(i, x) + 1),
-                  2.)
-              );
-
-    return res +
-        std::pow (levy3_w(m_dims-1,x)-1, 2.) *
-        (1 +
-         std::pow (
-             std::sin (
-                 2 * M_PI * levy3_w(m_dims-1, x)
-                 ),
-             2.)
-         );
+levy3::evaluate_dense (const double *x)
+{
+    return with_dims (m_dims, [x] (auto d) {
+        double res = std::pow (std::sin (M_PI * levy3_w(0, x)), 2.);
+        for (uint i = 0; i < d-1; i++)
+            res += std::pow ( levy3_w(i, x) - 1, 2.) *
+                ( 1. +
+                  10. * std::pow (
+                      std::sin ( M_PI * levy3_w(i, x) + 1),
+                      2.)
+                  );
+
+        return res +
+            std::pow (levy3_w(d-1,x)-1, 2.) *
+            (1 +
+             std::pow (
+                 std::sin (
+                     2 * M_PI * levy3_w(d-1, x)
+                     ),
+                 2.)
+             );
+    });
 }
 
 levy5::levy5 ():
@@ -2778,11 +2827,9 @@ levy5::levy5 ():
 }
 
 double
-levy5::evaluate (inst::set x)
+levy5::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double s1 = 0., s2 = 0.;
     for (int i = 1; i < 6; i++) {
@@ -2813,11 +2860,9 @@ levy13::levy13 ():
 }
 
 double
-levy13::evaluate (inst::set x)
+levy13::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return
         std::pow (std::sin (3 * M_PI * x1), 2.) +
@@ -2843,11 +2888,9 @@ matyas::matyas ():
 }
 
 double
-matyas::evaluate (inst::set x)
+matyas::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return 0.26 * (std::pow (x1, 2.) + std::pow (x2, 2.)) -
         0.48 * x1 * x2;
@@ -2877,11 +2920,9 @@ mccormick::mccormick():
 }
 
 double
-mccormick::evaluate (inst::set x)
+mccormick::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return
         std::sin (x1 + x2) +
@@ -2921,12 +2962,11 @@ regression::regression (
 }
 
 double
-regression::evaluate (inst::set x) {
-    validate_param_set (x);
-
+regression::evaluate_dense (const double *x)
+{
     double *ret = (double *) calloc (sizeof (double), m_dims.coef);
     double xs[m_dims.prob];
-    for (int i = 0; i < m_dims.prob; i++) xs[i] = x->getdbl(i);
+    for (int i = 0; i < m_dims.prob; i++) xs[i] = x[i];
 
     kernel (xs, ret);
     double res = 0.;
@@ -3691,12 +3731,10 @@ michalewicz02::michalewicz02():
 }
 
 double
-michalewicz02::evaluate (inst::set x)
+michalewicz02::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double xs[2];
-    xs[0] = x->getdbl(0), xs[1] = x->getdbl(1);
+    xs[0] = x[0], xs[1] = x[1];
 
     double res = 0.;
     for (int i = 0; i < 2; i++) {
@@ -3730,13 +3768,11 @@ michalewicz06::michalewicz06():
 }
 
 double
-michalewicz06::evaluate (inst::set x)
+michalewicz06::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double xs[6];
     for (int i = 0; i < 6; i++)
-        xs[i] = x->getdbl(i);
+        xs[i] = x[i];
 
     double res = 0.;
     for (int i = 0; i < 6; i++) {
@@ -3776,13 +3812,11 @@ michalewicz12::michalewicz12():
 }
 
 double
-michalewicz12::evaluate (inst::set x)
+michalewicz12::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
     double xs[12];
     for (int i = 0; i < 12; i++)
-        xs[i] = x->getdbl(i);
+        xs[i] = x[i];
 
     double res = 0.;
     for (int i = 0; i < 12; i++) {
@@ -3814,12 +3848,10 @@ miele_cantrell::miele_cantrell():
 }
 
 double
-miele_cantrell::evaluate (inst::set x)
+miele_cantrell::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
-    double x3 = x->getdbl(2), x4 = x->getdbl(3);
+    double x1 = x[0], x2 = x[1];
+    double x3 = x[2], x4 = x[3];
 
     return
         std::pow (std::exp (-x1) - x2, 4.) +
@@ -3847,15 +3879,15 @@ mishra01::mishra01(int dims):
 }
 
 double
-mishra01::evaluate (inst::set x)
+mishra01::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double sx = 0.;
-    for (uint i = 0; i < m_dims-1; i++)
-        sx += x->getdbl(i);
-    double gn = m_dims - sx;
-    return std::pow (1 + gn, gn);
+    return with_dims (m_dims, [x] (auto d) {
+        double sx = 0.;
+        for (uint i = 0; i < d-1; i++)
+            sx += x[i];
+        double gn = d - sx;
+        return std::pow (1 + gn, gn);
+    });
 }
 
 mishra02::mishra02(int dims):
@@ -3876,15 +3908,15 @@ mishra02::mishra02(int dims):
 }
 
 double
-mishra02::evaluate (inst::set x)
+mishra02::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double sx = 0.;
-    for (uint i = 0; i < m_dims-1; i++)
-        sx += (x->getdbl(i) + x->getdbl(i+1)) / 2.;
-    double gn = m_dims - sx;
-    return std::pow (1 + gn, gn);
+    return with_dims (m_dims, [x] (auto d) {
+        double sx = 0.;
+        for (uint i = 0; i < d-1; i++)
+            sx += (x[i] + x[i+1]) / 2.;
+        double gn = d - sx;
+        return std::pow (1 + gn, gn);
+    });
 }
 
 mishra03::mishra03():
@@ -3905,11 +3937,9 @@ mishra03::mishra03():
 }
 
 double
-mishra03::evaluate (inst::set x)
+mishra03::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return std::pow (
             std::fabs(
@@ -3941,11 +3971,9 @@ mishra04::mishra04():
 }
 
 double
-mishra04::evaluate (inst::set x)
+mishra04::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return std::pow (
             std::fabs(
@@ -3977,11 +4005,9 @@ mishra05::mishra05():
 }
 
 double
-mishra05::evaluate (inst::set x)
+mishra05::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double f1 =
         std::pow (std::sin (std::pow(std::cos(x1) + std::cos(x2), 2.)), 2.);
@@ -4009,11 +4035,9 @@ mishra06::mishra06():
 }
 
 double
-mishra06::evaluate (inst::set x)
+mishra06::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double f1 =
         std::pow (std::sin (std::pow (std::cos (x1) + std::cos (x2), 2.)), 2.);
@@ -4044,11 +4068,9 @@ mishra08::mishra08():
 }
 
 double
-mishra08::evaluate (inst::set x)
+mishra08::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     double gc[11] =
         {1, -20, 180, -960, 3360, -8064, 11340, -15360, 11520, -5120, 2624};
@@ -4082,11 +4104,9 @@ mishra09::mishra09():
 }
 
 double
-mishra09::evaluate (inst::set x)
+mishra09::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1), x3 = x->getdbl(2);
+    double x1 = x[0], x2 = x[1], x3 = x[2];
 
     double a =
         2. * std::pow (x1, 3.) +
@@ -4132,11 +4152,9 @@ mishra10::mishra10():
 }
 
 double
-mishra10::evaluate (inst::set x)
+mishra10::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl(0), x2 = x->getdbl(1);
+    double x1 = x[0], x2 = x[1];
 
     return std::pow (
                 (std::floor (x1) * std::floor(x2)) -
@@ -4163,20 +4181,20 @@ mishra11::mishra11 (int dims):
 }
 
 double
-mishra11::evaluate (inst::set x)
+mishra11::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double sx = 0., px = 1.;
-    for (uint i = 0; i < m_dims; i++) {
-        double xi = std::fabs (x->getdbl(i)); sx += xi;
-        px *= xi;
-    }
+    return with_dims (m_dims, [x] (auto d) {
+        double sx = 0., px = 1.;
+        for (uint i = 0; i < d; i++) {
+            double xi = std::fabs (x[i]); sx += xi;
+            px *= xi;
+        }
 
-    return std::pow (
-            (1./(double) m_dims) * sx -
-            std::pow (px, 1./(double) m_dims)
-            , 2.);
+        return std::pow (
+                (1./(double) d) * sx -
+                std::pow (px, 1./(double) d)
+                , 2.);
+    });
 }
 
 manifoldmin::manifoldmin (int dims):
@@ -4194,16 +4212,16 @@ manifoldmin::manifoldmin (int dims):
 }
 
 double
-manifoldmin::evaluate (inst::set x)
+manifoldmin::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double sum = 0., prod = 1.;
-    for (uint i = 0; i < m_dims; i++) {
-        double xi = std::fabs (x->getdbl(i));
-        sum += xi; prod *= xi;
-    }
-    return sum * prod;
+    return with_dims (m_dims, [x] (auto d) {
+        double sum = 0., prod = 1.;
+        for (uint i = 0; i < d; i++) {
+            double xi = std::fabs (x[i]);
+            sum += xi; prod *= xi;
+        }
+        return sum * prod;
+    });
 }
 
 
@@ -4224,11 +4242,9 @@ mog01::mog01 ():
 }
 
 double
-mog01::evaluate (inst::set x)
+mog01::evaluate_dense (const double *x)
 {
-    validate_param_set (x);
-
-    double x1 = x->getdbl("0"), x2 = x->getdbl("1");
+    double x1 = x[0], x2 = x[1];
 
     return - (
             0.5 * std::exp ( -10 * (
@@ -4244,166 +4260,299 @@ mog01::evaluate (inst::set x)
         );
 }
 
-synthetic_benchmark::synthetic_benchmark ():
+// registry -------------------------------------------------------------------
+
+static const std::vector<std::tuple<properties, std::string>> property_names = {
+    {properties::continuous, "continuous"},
+    {properties::discontinuous, "discontinuous"},
+    {properties::differentiable, "differentiable"},
+    {properties::non_differentiable, "non_differentiable"},
+    {properties::separable, "separable"},
+    {properties::partially_separable, "partially_separable"},
+    {properties::non_separable, "non_separable"},
+    {properties::scalable, "scalable"},
+    {properties::non_scalable, "non_scalable"},
+    {properties::multimodal, "multimodal"},
+    {properties::unimodal, "unimodal"}
+};
+
+std::string
+property_name (properties p)
+{
+    for (u_int i = 0; i < property_names.size(); i++)
+        if (std::get<0>(property_names[i]) == p)
+            return std::get<1>(property_names[i]);
+    return "";
+}
+
+bool
+parse_property (const std::string &n, properties *p)
+{
+    for (u_int i = 0; i < property_names.size(); i++) {
+        if (std::get<1>(property_names[i]) == n) {
+            *p = std::get<0>(property_names[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Benchmark names may contain spaces, which are awkward to pass on the
+ * command line; this replaces them with underscores.
+ */
+static std::string
+normalise_name (const std::string &n)
+{
+    std::string res = n;
+    std::replace (res.begin(), res.end(), ' ', '_');
+    return res;
+}
+
+static bool
+has_property (entry *e, properties p)
+{
+    return std::find (e->props.begin(), e->props.end(), p) != e->props.end();
+}
+
+registry::registry ()
+{
+    add<syn::ackley1>(10);
+    add<syn::ackley2>();
+    add<syn::ackley3>();
+    add<syn::adjiman>();
+    add<syn::alpine1>(10);
+    add<syn::alpine2>(10);
+    add<syn::brad>();
+    add<syn::bartels_conn>();
+    add<syn::beale>();
+    add<syn::biggs_exp2>();
+    add<syn::biggs_exp3>();
+    add<syn::biggs_exp4>();
+    add<syn::biggs_exp5>();
+    add<syn::biggs_exp6>();
+    add<syn::bird>();
+    add<syn::bohachevsky1>();
+    add<syn::bohachevsky2>();
+    add<syn::bohachevsky3>();
+    add<syn::booth>();
+    add<syn::box_betts>();
+    add<syn::branin1>();
+    add<syn::branin2>();
+    add<syn::brent>();
+    add<syn::brown>(10);
+    add<syn::bukin2>();
+    add<syn::bukin4>();
+    add<syn::bukin6>();
+    add<syn::camel3>();
+    add<syn::camel6>();
+    add<syn::chichinadze>();
+    add<syn::chung_reynolds>(10);
+    add<syn::cola>();
+    add<syn::colville>();
+    add<syn::cosine_mixture>(4);
+    add<syn::cosine_mixture>(15);
+    add<syn::cross_in_tray>();
+    add<syn::csendes>(10);
+    add<syn::cube>();
+    add<syn::damavandi>();
+    add<syn::deb1>(10);
+    add<syn::deb2>(10);
+    add<syn::deckkers_aarts>();
+    add<syn::devillers_glasser1>();
+    add<syn::devillers_glasser2>();
+    add<syn::dixon_price>(10);
+    add<syn::dolan>();
+    add<syn::deceptive>(10);
+    add<syn::deceptive>(10);
+    add<syn::drop_wave>();
+    add<syn::easom>();
+    add<syn::egg_crate>();
+    add<syn::egg_holder>();
+    add<syn::el_attar_vidyasagar_dutta>();
+    add<syn::exponential>(10);
+    add<syn::exp2>();
+    add<syn::franke>();
+    add<syn::freudenstein_roth>();
+    add<syn::gear>();
+    add<syn::giunta>();
+    add<syn::goldstein_price>();
+    add<syn::griewank>(10);
+    add<syn::gulf>();
+    add<syn::hansen>();
+    add<syn::hartman3>();
+    add<syn::hartman6>();
+    add<syn::helical_valley>();
+    add<syn::himmelblau>();
+    add<syn::holder_table>();
+    add<syn::hosaki>();
+    add<syn::jennrich_sampson>();
+    add<syn::judge>();
+    add<syn::langermann2>();
+    add<syn::lennard_jones>();
+    add<syn::keane>();
+    add<syn::keane>();
+    add<syn::levy3>(10);
+    add<syn::levy5>();
+    add<syn::levy13>();
+    add<syn::matyas>();
+    add<syn::mccormick>();
+    add<syn::michalewicz02>();
+    add<syn::michalewicz06>();
+    add<syn::michalewicz12>();
+    add<syn::miele_cantrell>();
+    add<syn::mishra01>(10);
+    add<syn::mishra02>(10);
+    add<syn::mishra03>();
+    add<syn::mishra04>();
+    add<syn::mishra05>();
+    add<syn::mishra06>();
+    // TODO fix this one - output seems wrong
+    // add<syn::mishra08>();
+    add<syn::mishra09>();
+    add<syn::mishra10>();
+    add<syn::mishra11>(10);
+
+    add<syn::court01>();
+    add<syn::court02>();
+    add<syn::court03>();
+    add<syn::court04>();
+    add<syn::court05>();
+    add<syn::court06>();
+    add<syn::court07>();
+    add<syn::court08>();
+    add<syn::court09>();
+    add<syn::court10>();
+    add<syn::court11>();
+    add<syn::court13>();
+    add<syn::court14>();
+    add<syn::court15>();
+    add<syn::court16>();
+    add<syn::court17>();
+    add<syn::court18>();
+    add<syn::court19>();
+    add<syn::court20>();
+    add<syn::court21>();
+    add<syn::court22>();
+    add<syn::court24>();
+    add<syn::court25>();
+    add<syn::court26>();
+    add<syn::court27>();
+    add<syn::court28>();
+}
+
+std::vector<entry>
+registry::select (const std::string &spec)
+{
+    std::vector<std::string> names;
+    std::vector<properties> props;
+
+    std::stringstream ss (spec);
+    std::string tok;
+    while (std::getline (ss, tok, ',')) {
+        if (tok.empty ())
+            continue;
+        properties p;
+        if (parse_property (tok, &p)) {
+            props.push_back (p);
+            continue;
+        }
+        bool found = false;
+        for (u_int i = 0; i < m_entries.size() && !found; i++)
+            found = normalise_name (m_entries[i].name) == normalise_name (tok);
+        if (!found)
+            throw std::invalid_argument (
+                    "'" + tok + "' is neither a synthetic benchmark nor a property"
+                    );
+        names.push_back (normalise_name (tok));
+    }
+
+    std::vector<entry> res;
+    for (u_int i = 0; i < m_entries.size(); i++) {
+        entry *e = &m_entries[i];
+
+        bool named = std::find (
+                names.begin(), names.end(), normalise_name (e->name)
+                ) != names.end();
+
+        bool tagged = !props.empty();
+        for (u_int j = 0; j < props.size() && tagged; j++)
+            tagged = has_property (e, props[j]);
+
+        if ((names.empty() && props.empty()) || named || tagged)
+            res.push_back (*e);
+    }
+
+    if (res.empty ())
+        throw std::invalid_argument (
+                "no synthetic benchmarks match '" + spec + "'"
+                );
+
+    return res;
+}
+
+// synthetic benchmark set ------------------------------------------------------
+
+synthetic_benchmark::synthetic_benchmark (const std::string &spec):
     benchmark_set ("synthetic")
-{ }
+{
+    m_selected = m_registry.select (spec);
+}
+
+synthetic_benchmark::~synthetic_benchmark () {}
 
-#define bench(benchmark, b) \
-    benchmark b; \
-    of << b.get_name() << "," << opt->get_name(); \
-    optk::core_loop (&b, opt, trace); \
-    for (uint i = 0; i < ctx->max_iters; i++) \
-        of << "," << trace[i]; \
-    of << std::endl;
-
-#define bench_scalable(benchmark, b, dims) \
-    benchmark b(dims); \
-    of << b.get_name() << "," << opt->get_name(); \
-    optk::core_loop (&b, opt, trace); \
-    for (uint i = 0; i < ctx->max_iters; i++) \
-        of << "," << trace[i]; \
-    of << std::endl;
-
-//* @todo parallelise this function - embarrassing! */
 void
-synthetic_benchmark::run (optk::optimisers *opts, optk::ctx_t *ctx)
-{
-    double trace[ctx->max_iters];
-
-    std::ofstream of;
-    of.open(ctx->outfile, std::ios::app);
-
-    // for all the optimisers in the set
-    std::vector<optk::optimiser *> *optc = opts->collection();
-    for (uint i = 0; i < optc->size(); i++) {
-        optk::optimiser *opt = optc->at(i);
-
-        // for all the synthetic benchmarks
-        bench_scalable(syn::ackley1, a1, 10);
-        bench(syn::ackley2, a2);
-        bench(syn::ackley3, a3);
-        bench(syn::adjiman, am);
-        bench_scalable(syn::alpine1, al1, 10);
-        bench_scalable(syn::alpine2, al2, 10);
-        bench(syn::brad, bd);
-        bench(syn::bartels_conn, bc);
-        bench(syn::beale, be);
-        bench(syn::biggs_exp2, bx2);
-        bench(syn::biggs_exp3, bx3);
-        bench(syn::biggs_exp4, bx4);
-        bench(syn::biggs_exp5, bx5);
-        bench(syn::biggs_exp6, bx6);
-        bench(syn::bird, brd);
-        bench(syn::bohachevsky1, bchy1);
-        bench(syn::bohachevsky2, bchy2);
-        bench(syn::bohachevsky3, bchy3);
-        bench(syn::booth, booth);
-        bench(syn::box_betts, bb);
-        bench(syn::branin1, br1);
-        bench(syn::branin2, br2);
-        bench(syn::brent, br);
-        bench_scalable(syn::brown, brn, 10);
-        bench(syn::bukin2, bk2);
-        bench(syn::bukin4, bk4);
-        bench(syn::bukin6, bk6);
-        bench(syn::camel3, c3);
-        bench(syn::camel6, c6);
-        bench(syn::chichinadze, cz);
-        bench_scalable(syn::chung_reynolds, cr, 10);
-        bench(syn::cola, cla);
-        bench(syn::colville, cv);
-        bench_scalable(syn::cosine_mixture, cm4, 4);
-        bench_scalable(syn::cosine_mixture, cm15, 15);
-        bench(syn::cross_in_tray, cit);
-        bench_scalable(syn::csendes, cs, 10);
-        bench(syn::cube, cbe);
-        bench(syn::damavandi, dam);
-        bench_scalable(syn::deb1, deb1, 10);
-        bench_scalable(syn::deb2, deb2, 10);
-        bench(syn::deckkers_aarts, da);
-        bench(syn::devillers_glasser1, dvg1);
-        bench(syn::devillers_glasser2, dvg2);
-        bench_scalable(syn::dixon_price, dxp, 10);
-        bench(syn::dolan, dln);
-        bench_scalable(syn::deceptive, dec, 10);
-        bench_scalable(syn::deceptive, dcs, 10);
-        bench(syn::drop_wave, dw);
-        bench(syn::easom, esm);
-        bench(syn::egg_crate, egc);
-        bench(syn::egg_holder, egh);
-        bench(syn::el_attar_vidyasagar_dutta, elatt);
-        bench_scalable(syn::exponential, exp, 10);
-        bench(syn::exp2, exp2);
-        bench(syn::franke, fnk);
-        bench(syn::freudenstein_roth, frr);
-        bench(syn::gear, gear);
-        bench(syn::giunta, gta);
-        bench(syn::goldstein_price, gsp);
-        bench_scalable(syn::griewank, gwk, 10);
-        bench(syn::gulf, gulf);
-        bench(syn::hansen, hsn);
-        bench(syn::hartman3, hrt3);
-        bench(syn::hartman6, hrt6);
-        bench(syn::helical_valley, hv);
-        bench(syn::himmelblau, hb);
-        bench(syn::holder_table, ht);
-        bench(syn::hosaki, hki);
-        bench(syn::jennrich_sampson, js);
-        bench(syn::judge, jd);
-        bench(syn::langermann2, l2);
-        bench(syn::lennard_jones, lj);
-        bench(syn::keane, kn);
-        bench(syn::keane, ln);
-        bench_scalable(syn::levy3, lv3, 10);
-        bench(syn::levy5, lv5);
-        bench(syn::levy13, lv13);
-        bench(syn::matyas, mts);
-        bench(syn::mccormick, mck);
-        bench(syn::michalewicz02, mcz02);
-        bench(syn::michalewicz06, mcz06);
-        bench(syn::michalewicz12, mcz12);
-        bench(syn::miele_cantrell, mcll);
-        bench_scalable(syn::mishra01, mish01,10);
-        bench_scalable(syn::mishra02, mish02, 10);
-        bench(syn::mishra03, mish03);
-        bench(syn::mishra04, mish04);
-        bench(syn::mishra05, mish05);
-        bench(syn::mishra06, mish06);
-        // TODO fix this one - output seems wrong
-        // bench(syn::mishra08, mish08);
-        bench(syn::mishra09, mish09);
-        bench(syn::mishra10, mish10);
-        bench_scalable(syn::mishra11, mish11, 10);
-
-        bench(syn::court01, crt1);
-        bench(syn::court02, crt2);
-        bench(syn::court03, crt3);
-        bench(syn::court04, crt4);
-        bench(syn::court05, crt5);
-        bench(syn::court06, crt6);
-        bench(syn::court07, crt7);
-        bench(syn::court08, crt8);
-        bench(syn::court09, crt9);
-        bench(syn::court10, crt10);
-        bench(syn::court11, crt11);
-        bench(syn::court13, crt13);
-        bench(syn::court14, crt14);
-        bench(syn::court15, crt15);
-        bench(syn::court16, crt16);
-        bench(syn::court17, crt17);
-        bench(syn::court18, crt18);
-        bench(syn::court19, crt19);
-        bench(syn::court20, crt20);
-        bench(syn::court21, crt21);
-        bench(syn::court22, crt22);
-        bench(syn::court24, crt24);
-        bench(syn::court25, crt25);
-        bench(syn::court26, crt26);
-        bench(syn::court27, crt27);
-        bench(syn::court28, crt28);
-    }
+synthetic_benchmark::set_variant (const variant_spec &v)
+{
+    m_variant.reset (is_variant (v) ? new variant_spec (v) : NULL);
+}
 
-    of.close();
+std::string
+synthetic_benchmark::benchmark_name (uint j)
+{
+    return m_selected.at(j).name;
+}
+
+std::vector<std::string>
+synthetic_benchmark::benchmark_properties (uint j)
+{
+    std::vector<std::string> props;
+    for (properties p: m_selected.at(j).props)
+        props.push_back (property_name (p));
+    return props;
+}
+
+void
+synthetic_benchmark::run_one (
+        uint j,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        optk::ctx_t *ctx,
+        optk::thread_pool *pool,
+        optk::progress *prog,
+        uint64_t seed)
+{
+    std::unique_ptr<synthetic> sb (m_selected.at(j).make ());
+    if (ctx->summary)
+        tr.target (sb->get_opt (), ctx->eps);
+    // a variant owns the benchmark which it varies
+    std::unique_ptr<optk::benchmark> vb;
+    if (m_variant)
+        vb.reset (new variant (sb.release (), *m_variant, seed));
+    else
+        vb = std::move (sb);
+    optk::benchmark *b = vb.get ();
+    std::unique_ptr<optk::cached_benchmark> cb;
+    if (ctx->cache != NULL) {
+        cb.reset (new optk::cached_benchmark (vb.get (), ctx->cache));
+        b = cb.get ();
+    }
+    if (ctx->async)
+        optk::core_loop_async (b, opt, tr, ctx->threads, pool);
+    else if (ctx->batch > 1)
+        optk::core_loop_batch (b, opt, tr, ctx->batch, pool, prog);
+    else
+        optk::core_loop (b, opt, tr, prog);
 }
 
 } // end namespace syn
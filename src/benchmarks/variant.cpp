@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the noisy, costly and multi-fidelity variants of the
+ * synthetic benchmarks.
+ */
+
+#include <benchmarks/variant.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <optk/cache.hpp>
+#include <optk/rng.hpp>
+#include <optk/timing.hpp>
+
+namespace syn {
+
+/** @returns The value of a setting, which must be a finite number. */
+static double
+parse_setting (const std::string &key, const std::string &val)
+{
+    size_t end = 0;
+    double v;
+    try {
+        v = std::stod (val, &end);
+    } catch (const std::exception &) {
+        end = 0;
+    }
+    if (end == 0 || end != val.size () || !std::isfinite (v))
+        throw std::invalid_argument (
+                "the variant setting " + key + " must be a number, not '" +
+                val + "'");
+    return v;
+}
+
+variant_spec
+parse_variant (const std::string &s)
+{
+    variant_spec v;
+    std::stringstream ss (s);
+    std::string tok;
+    while (std::getline (ss, tok, ',')) {
+        if (tok.empty ())
+            continue;
+        size_t eq = tok.find ('=');
+        std::string key = tok.substr (0, eq);
+        std::string val = eq == std::string::npos ? "" : tok.substr (eq + 1);
+        if (key == "noise") {
+            v.noise = parse_setting (key, val);
+        } else if (key == "cost") {
+            v.cost = parse_setting (key, val);
+        } else if (key == "jitter") {
+            v.jitter = parse_setting (key, val);
+        } else if (key == "fidelity") {
+            v.fidelity = parse_setting (key, val);
+        } else if (key == "bias") {
+            v.bias = parse_setting (key, val);
+        } else if (key == "wait") {
+            if (val == "none")
+                v.wait = latency::none;
+            else if (val == "sleep")
+                v.wait = latency::sleep;
+            else if (val == "spin")
+                v.wait = latency::spin;
+            else
+                throw std::invalid_argument (
+                        "the variant setting wait must be none, sleep or "
+                        "spin, not '" + val + "'");
+        } else {
+            throw std::invalid_argument (
+                    "unknown variant setting '" + key + "'");
+        }
+    }
+
+    if (v.noise < 0. || v.cost < 0.)
+        throw std::invalid_argument (
+                "the noise and cost of a variant cannot be negative");
+    if (v.jitter < 0. || v.jitter >= 1.)
+        throw std::invalid_argument ("the jitter must be in [0, 1)");
+    if (v.fidelity < 0. || v.fidelity >= 1.)
+        throw std::invalid_argument ("the lowest fidelity must be in [0, 1)");
+    return v;
+}
+
+bool
+is_variant (const variant_spec &v)
+{
+    return v.noise > 0. || v.cost > 0. || v.fidelity > 0.;
+}
+
+// variant ---------------------------------------------------------------------
+
+variant::variant (synthetic *base, const variant_spec &spec, uint64_t seed):
+    benchmark (base->get_name ()),
+    m_base (base),
+    m_spec (spec),
+    m_seed (seed),
+    m_dims (base->get_dims ()),
+    m_sspace (*base->get_search_space ()),
+    m_fidelity (NULL),
+    m_evals (0)
+{
+    if (spec.fidelity > 0.) {
+        m_fidelity = new sspace::uniform ("fidelity", spec.fidelity, 1.);
+        m_sspace.push_back (m_fidelity);
+    }
+    m_compiled.compile (&m_sspace);
+}
+
+variant::~variant ()
+{
+    // the other parameters of the space belong to the base benchmark
+    delete m_fidelity;
+    delete m_base;
+}
+
+uint64_t
+variant::index (u_int n)
+{
+    int64_t t = optk::benchmark::trial ();
+    return t >= 0 ? (uint64_t) t : m_evals.fetch_add (n);
+}
+
+double
+variant::offset (uint64_t k, uint64_t n, const double *x, u_int stride,
+        double s)
+{
+    double res = 0.;
+    if (m_fidelity != NULL && s < 1.) {
+        double sum = 0.;
+        for (u_int i = 0; i < m_dims; i++)
+            sum += std::cos (x[i * stride]);
+        res += (1. - s) * m_spec.bias * sum / m_dims;
+    }
+    if (m_spec.noise > 0.) {
+        optk::rng r (optk::rng::derive (optk::rng::derive (m_seed, k), n));
+        res += r.normal (0., m_spec.noise);
+    }
+    return res;
+}
+
+double
+variant::cost_of (const double *x, u_int stride, double s)
+{
+    if (m_spec.cost <= 0.)
+        return 0.;
+    optk::rng r (optk::eval_cache::key (m_name, m_base->get_search_space (),
+                x, stride));
+    return m_spec.cost * s * (1. + m_spec.jitter * (2. * r.uniform () - 1.));
+}
+
+void
+variant::wait (double secs)
+{
+    if (secs <= 0. || m_spec.wait == latency::none)
+        return;
+    std::chrono::duration<double> d (secs);
+    if (m_spec.wait == latency::sleep) {
+        std::this_thread::sleep_for (d);
+        return;
+    }
+    auto until = std::chrono::steady_clock::now () +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration> (d);
+    while (std::chrono::steady_clock::now () < until)
+        ;
+}
+
+double
+variant::evaluate (inst::set x)
+{
+    if (m_validate) {
+        OPTK_TIME (optk::timings::current (), optk::phase::validate);
+        m_compiled.validate (x->get_values ());
+    }
+    const double *p = x->dense (m_dims);
+    double s = m_fidelity != NULL ? x->getdbl ("fidelity") : 1.;
+    uint64_t k = 0, n = 0;
+    if (m_spec.noise > 0.) {
+        k = optk::eval_cache::key (m_name, x);
+        n = index ();
+    }
+    double res = m_base->evaluate_dense (p) + offset (k, n, p, 1, s);
+    wait (cost_of (p, 1, s));
+    return res;
+}
+
+void
+variant::evaluate_batch (const double *x, u_int n, double *out)
+{
+    if (m_validate) {
+        OPTK_TIME (optk::timings::current (), optk::phase::validate);
+        for (u_int j = 0; j < m_compiled.dims (); j++)
+            m_compiled.validate (j, x + j * n, n);
+    }
+    m_base->evaluate_dense_batch (x, n, out);
+
+    // the points of a batch take consecutive indices
+    uint64_t first = m_spec.noise > 0. ? index (n) : 0;
+    double secs = 0.;
+    for (u_int i = 0; i < n; i++) {
+        double s = m_fidelity != NULL ? x[m_dims * n + i] : 1.;
+        uint64_t k = m_spec.noise > 0. ?
+            optk::eval_cache::key (m_name, &m_sspace, x + i, n) : 0;
+        out[i] += offset (k, first + i, x + i, n, s);
+        secs += cost_of (x + i, n, s);
+    }
+    wait (secs);
+}
+
+double
+variant::cost (inst::set x)
+{
+    if (m_spec.cost <= 0.)
+        return 0.;
+    double s = m_fidelity != NULL ? x->getdbl ("fidelity") : 1.;
+    return cost_of (x->dense (m_dims), 1, s);
+}
+
+double
+variant::exact (inst::set x, double v)
+{
+    if (m_spec.noise <= 0. && m_fidelity == NULL)
+        return v;
+    return m_base->evaluate_dense (x->dense (m_dims));
+}
+
+} // end namespace syn
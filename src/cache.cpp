@@ -0,0 +1,372 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the cache of objective function values.
+ */
+
+#include <optk/cache.hpp>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char magic[] = "OPTKEVC1";
+static const size_t header_len = 64;
+
+/** The tags which distinguish the types of values in a key. */
+enum class tag: uint64_t {
+    node = 1,
+    int_val = 2,
+    dbl_val = 3,
+    str_val = 4
+};
+
+/** The splitmix64 finaliser, which mixes the bits of x thoroughly. */
+static inline uint64_t
+mix (uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/** @returns The 64 bit FNV-1a hash of a string. */
+static uint64_t
+fnv (const std::string &s)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c: s)
+        h = (h ^ c) * 0x100000001b3ull;
+    return h;
+}
+
+/** @returns The bits of v, with all zeros and all NaNs made alike. */
+static inline uint64_t
+dbl_bits (double v)
+{
+    if (v == 0.)
+        v = 0.;
+    else if (std::isnan (v))
+        v = std::nan ("");
+    uint64_t b;
+    std::memcpy (&b, &v, sizeof b);
+    return b;
+}
+
+/** @returns The hash of one named value. */
+static inline uint64_t
+item (const std::string &name, tag t, uint64_t v)
+{
+    return mix (mix (fnv (name) + (uint64_t) t) ^ v);
+}
+
+/**
+ * @returns The hash of the values of a node; the hashes of the values are
+ * summed, so that the order in which they are held does not matter.
+ */
+static uint64_t
+node_hash (inst::node *n)
+{
+    uint64_t h = 0;
+    inst::value_map *vals = n->get_values ();
+    for (inst::value_map::iterator it = vals->begin (); it != vals->end ();
+            it++) {
+        const std::string &name = std::get<0>(*it);
+        inst::param *p = std::get<1>(*it);
+        switch (p->get_type ()) {
+            case inst::inst_t::int_val:
+                h += item (name, tag::int_val, (uint64_t) (int64_t)
+                        static_cast<inst::int_val *>(p)->get_val ());
+                break;
+            case inst::inst_t::dbl_val:
+                h += item (name, tag::dbl_val,
+                        dbl_bits (static_cast<inst::dbl_val *>(p)->get_val ()));
+                break;
+            case inst::inst_t::str_val:
+                h += item (name, tag::str_val,
+                        fnv (static_cast<inst::str_val *>(p)->get_val ()));
+                break;
+            case inst::inst_t::node:
+                h += item (name, tag::node,
+                        node_hash (static_cast<inst::node *>(p)));
+                break;
+        }
+    }
+    return h;
+}
+
+/** @returns A key which is never 0, the key of empty slots. */
+static inline uint64_t
+finish_key (const std::string &bench, uint64_t h)
+{
+    uint64_t k = mix (fnv (bench) ^ mix (h));
+    return k ? k : 1;
+}
+
+/** @returns The check word of a slot. */
+static inline uint64_t
+check_word (uint64_t k, uint64_t bits)
+{
+    return mix (k ^ mix (bits + 0x9e3779b97f4a7c15ull));
+}
+
+uint64_t
+optk::eval_cache::key (const std::string &bench, inst::set x)
+{
+    return finish_key (bench, node_hash (x));
+}
+
+uint64_t
+optk::eval_cache::key (const std::string &bench, sspace::sspace_t *ss,
+        const double *x, u_int stride)
+{
+    uint64_t h = 0;
+    for (u_int j = 0; j < ss->size (); j++)
+        h += item (ss->at (j)->get_name (), tag::dbl_val,
+                dbl_bits (x[(size_t) j * stride]));
+    return finish_key (bench, h);
+}
+
+// eval_cache -----------------------------------------------------------------
+
+optk::eval_cache::eval_cache () :
+    m_fd (-1), m_map (NULL), m_len (0), m_count (NULL), m_slots (NULL),
+    m_nslots (0), m_hits (0), m_misses (0)
+{ }
+
+optk::eval_cache::eval_cache (const std::string &path, uint64_t slots) :
+    eval_cache ()
+{
+    m_fd = open (path.c_str (), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0)
+        throw std::runtime_error ("cannot open the cache " + path + ": " +
+                strerror (errno));
+
+    // the first process to open the file initialises its header
+    std::string err;
+    flock (m_fd, LOCK_EX);
+    struct stat st;
+    char head[header_len] = {0};
+    if (fstat (m_fd, &st) < 0) {
+        err = strerror (errno);
+    } else if (st.st_size == 0) {
+        if (slots < 1)
+            slots = 1;
+        std::memcpy (head, magic, 8);
+        std::memcpy (head + 8, &slots, sizeof slots);
+        m_len = header_len + slots * sizeof (slot_t);
+        if (ftruncate (m_fd, m_len) < 0 ||
+                pwrite (m_fd, head, header_len, 0) != (ssize_t) header_len)
+            err = strerror (errno);
+    } else if ((size_t) st.st_size < header_len ||
+            pread (m_fd, head, header_len, 0) != (ssize_t) header_len ||
+            std::memcmp (head, magic, 8)) {
+        err = "not a cache file";
+    } else {
+        std::memcpy (&slots, head + 8, sizeof slots);
+        m_len = header_len + slots * sizeof (slot_t);
+        if ((size_t) st.st_size != m_len)
+            err = "the file has been truncated";
+    }
+    flock (m_fd, LOCK_UN);
+
+    if (err.empty ()) {
+        m_map = mmap (NULL, m_len, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd,
+                0);
+        if (m_map == MAP_FAILED) {
+            m_map = NULL;
+            err = strerror (errno);
+        }
+    }
+    if (!err.empty ()) {
+        close (m_fd);
+        m_fd = -1;
+        throw std::runtime_error ("cannot use the cache " + path + ": " +
+                err);
+    }
+
+    m_nslots = slots;
+    m_count = reinterpret_cast<uint64_t *>(static_cast<char *>(m_map) + 16);
+    m_slots = reinterpret_cast<slot_t *>(
+            static_cast<char *>(m_map) + header_len);
+}
+
+optk::eval_cache::~eval_cache ()
+{
+    if (m_map != NULL)
+        munmap (m_map, m_len);
+    if (m_fd >= 0)
+        close (m_fd);
+}
+
+uint64_t
+optk::eval_cache::persisted () const
+{
+    return m_count ? __atomic_load_n (m_count, __ATOMIC_RELAXED) : 0;
+}
+
+bool
+optk::eval_cache::find (uint64_t k, double *v)
+{
+    shard &s = m_shards[k % nshards];
+    {
+        std::lock_guard<std::mutex> lock (s.lock);
+        std::unordered_map<uint64_t, double>::iterator it = s.values.find (k);
+        if (it != s.values.end ()) {
+            *v = it->second;
+            m_hits++;
+            return true;
+        }
+    }
+    if (m_slots != NULL && find_file (k, v)) {
+        std::lock_guard<std::mutex> lock (s.lock);
+        s.values.emplace (k, *v);
+        m_hits++;
+        return true;
+    }
+    m_misses++;
+    return false;
+}
+
+void
+optk::eval_cache::insert (uint64_t k, double v)
+{
+    {
+        shard &s = m_shards[k % nshards];
+        std::lock_guard<std::mutex> lock (s.lock);
+        s.values.emplace (k, v);
+    }
+    if (m_slots != NULL)
+        insert_file (k, v);
+}
+
+/** The number of slots probed before a lookup or insertion gives up. */
+static const uint64_t max_probes = 64;
+
+bool
+optk::eval_cache::find_file (uint64_t k, double *v)
+{
+    for (uint64_t p = 0; p < max_probes; p++) {
+        slot_t *sl = &m_slots[(k + p) % m_nslots];
+        uint64_t sk = __atomic_load_n (&sl->key, __ATOMIC_ACQUIRE);
+        if (sk == 0)
+            return false;
+        if (sk != k)
+            continue;
+        uint64_t bits = __atomic_load_n (&sl->bits, __ATOMIC_ACQUIRE);
+        uint64_t check = __atomic_load_n (&sl->check, __ATOMIC_ACQUIRE);
+        if (check != check_word (k, bits))
+            return false;
+        std::memcpy (v, &bits, sizeof bits);
+        return true;
+    }
+    return false;
+}
+
+void
+optk::eval_cache::insert_file (uint64_t k, double v)
+{
+    if (persisted () >= m_nslots - m_nslots / 4)
+        return;
+
+    uint64_t bits;
+    std::memcpy (&bits, &v, sizeof bits);
+    for (uint64_t p = 0; p < max_probes; p++) {
+        slot_t *sl = &m_slots[(k + p) % m_nslots];
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n (&sl->key, &expected, k, false,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            // the check word is written last, which publishes the value
+            __atomic_store_n (&sl->bits, bits, __ATOMIC_RELEASE);
+            __atomic_store_n (&sl->check, check_word (k, bits),
+                    __ATOMIC_RELEASE);
+            __atomic_add_fetch (m_count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        // another process holds (or is writing) this value already
+        if (expected == k)
+            return;
+    }
+}
+
+// cached_benchmark -----------------------------------------------------------
+
+optk::cached_benchmark::cached_benchmark (optk::benchmark *b,
+        optk::eval_cache *cache) :
+    benchmark (b->get_name ()), m_bench (b), m_cache (cache)
+{
+    m_validate = b->validation ();
+}
+
+void
+optk::cached_benchmark::set_validation (bool v)
+{
+    m_validate = v;
+    m_bench->set_validation (v);
+}
+
+double
+optk::cached_benchmark::evaluate (inst::set x)
+{
+    uint64_t k = eval_cache::key (m_name, x);
+    double v;
+    if (m_cache->find (k, &v))
+        return v;
+    v = m_bench->evaluate (x);
+    m_cache->insert (k, v);
+    return v;
+}
+
+void
+optk::cached_benchmark::evaluate_batch (const double *x, u_int n, double *out)
+{
+    sspace::sspace_t *ss = get_search_space ();
+    u_int d = ss->size ();
+
+    // gather the points which are not found into a batch of their own
+    std::vector<u_int> miss;
+    std::vector<uint64_t> keys;
+    for (u_int i = 0; i < n; i++) {
+        uint64_t k = eval_cache::key (m_name, ss, x + i, n);
+        if (!m_cache->find (k, &out[i])) {
+            miss.push_back (i);
+            keys.push_back (k);
+        }
+    }
+    if (miss.empty ())
+        return;
+
+    u_int m = miss.size ();
+    std::vector<double> mx ((size_t) d * m), mout (m);
+    for (u_int j = 0; j < d; j++)
+        for (u_int i = 0; i < m; i++)
+            mx[(size_t) j * m + i] = x[(size_t) j * n + miss[i]];
+    m_bench->evaluate_batch (mx.data (), m, mout.data ());
+    for (u_int i = 0; i < m; i++) {
+        out[miss[i]] = mout[i];
+        m_cache->insert (keys[i], mout[i]);
+    }
+}
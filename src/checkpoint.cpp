@@ -0,0 +1,311 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements checkpoints, from which a stopped sweep can be resumed.
+ */
+
+#include <optk/checkpoint.hpp>
+#include <optk/net.hpp>
+#include <optk/optimiser.hpp>
+#include <optk/trace.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using optk::net::get_num;
+using optk::net::get_vec;
+using optk::net::put_num;
+using optk::net::put_vec;
+
+/** The types of the messages in a checkpoint file. */
+enum class ckpt_msg: uint8_t {
+    header = 1,
+    finished = 2,
+    snapshot = 3
+};
+
+static const char magic[] = "OPTKCKP1";
+
+/**
+ * Writes all of a buffer to a file.
+ * @returns false, with errno set, if that fails.
+ */
+static bool
+write_all (int fd, const std::string &buf)
+{
+    size_t done = 0;
+    while (done < buf.size ()) {
+        ssize_t w = write (fd, buf.data () + done, buf.size () - done);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        done += w;
+    }
+    return true;
+}
+
+namespace optk {
+
+/** The progress of one job, saved into its checkpoint. */
+class run_progress: public progress {
+    public:
+        run_progress (checkpoint *ck, const checkpoint::key_t &k):
+            m_ck (ck), m_key (k), m_last (std::chrono::steady_clock::now ()),
+            m_saves (true)
+        { }
+
+        uint
+        resume (optk::optimiser *opt, optk::trace &tr) override
+        {
+            std::string body;
+            {
+                std::lock_guard<std::mutex> lock (m_ck->m_mtx);
+                auto it = m_ck->m_snapshots.find (m_key);
+                if (it == m_ck->m_snapshots.end ())
+                    return 0;
+                body.swap (it->second);
+                m_ck->m_snapshots.erase (it);
+            }
+
+            size_t off = 0;
+            uint count = get_num<uint32_t> (body, &off);
+            double min = get_num<double> (body, &off);
+            std::vector<double> entries = get_vec<double> (body, &off);
+            if (entries.size () != tr.span () || count > tr.iters ())
+                throw std::runtime_error ("a snapshot in " + m_ck->m_path +
+                        " does not match its run");
+            opt->restore (body.substr (off));
+            std::copy (entries.begin (), entries.end (), tr.data ());
+            tr.resume (count, min);
+            return count;
+        }
+
+        void
+        step (optk::optimiser *opt, optk::trace &tr) override
+        {
+            if (!m_saves)
+                return;
+            auto now = std::chrono::steady_clock::now ();
+            if (std::chrono::duration<double> (now - m_last).count () <
+                    m_ck->m_period)
+                return;
+            m_last = now;
+
+            std::string body;
+            put_num<uint32_t> (&body, tr.count ());
+            put_num (&body, tr.min ());
+            put_vec (&body, std::vector<double> (tr.data (),
+                        tr.data () + tr.span ()));
+            m_saves = opt->save (&body);
+            if (m_saves)
+                m_ck->append ((uint8_t) ckpt_msg::snapshot, m_key, body);
+        }
+
+    private:
+        checkpoint *m_ck;
+        const checkpoint::key_t m_key;
+        std::chrono::steady_clock::time_point m_last;
+        /** Cleared once the optimiser turns out not to save its state.    */
+        bool m_saves;
+};
+
+} // namespace optk
+
+optk::checkpoint::checkpoint (
+        const std::string &path,
+        const std::string &config,
+        uint64_t seed,
+        double period
+) :
+    m_path (path), m_period (period), m_seed (seed), m_restored (0),
+    m_fd (-1), m_failed (false)
+{
+    load (config);
+}
+
+optk::checkpoint::~checkpoint ()
+{
+    if (m_fd >= 0)
+        close (m_fd);
+}
+
+std::string
+optk::checkpoint::encode (const key_t &k, const std::string &body)
+{
+    std::string payload;
+    put_num<uint32_t> (&payload, k.first.size ());
+    payload.append (k.first);
+    put_num<uint32_t> (&payload, k.second);
+    payload.append (body);
+    return payload;
+}
+
+void
+optk::checkpoint::load (const std::string &config)
+{
+    std::string data;
+    {
+        std::ifstream f (m_path, std::ios::binary);
+        if (f) {
+            std::stringstream ss;
+            ss << f.rdbuf ();
+            data = ss.str ();
+        }
+    }
+
+    // read the complete messages, and drop a partly written last one
+    const size_t frame = sizeof (uint32_t) + 1;
+    size_t pos = 0;
+    bool first = true;
+    while (pos + frame <= data.size ()) {
+        uint32_t len;
+        std::memcpy (&len, data.data () + pos, sizeof (len));
+        if (pos + frame + len > data.size ())
+            break;
+        uint8_t type = (uint8_t) data[pos + sizeof (len)];
+        std::string payload = data.substr (pos + frame, len);
+        pos += frame + len;
+
+        size_t off = 0;
+        if (first) {
+            if (type != (uint8_t) ckpt_msg::header ||
+                    payload.compare (0, 8, magic) != 0)
+                throw std::runtime_error (m_path + " is not a checkpoint");
+            off = 8;
+            uint64_t seed = get_num<uint64_t> (payload, &off);
+            if (payload.compare (off, std::string::npos, config) != 0)
+                throw std::runtime_error ("the checkpoint " + m_path +
+                        " was written by a different sweep");
+            m_seed = seed;
+            first = false;
+            continue;
+        }
+
+        uint32_t nlen = get_num<uint32_t> (payload, &off);
+        if (off + nlen > payload.size ())
+            throw std::runtime_error ("truncated message");
+        key_t k (payload.substr (off, nlen), 0);
+        off += nlen;
+        k.second = get_num<uint32_t> (payload, &off);
+
+        if (type == (uint8_t) ckpt_msg::finished) {
+            std::vector<double> entries ((payload.size () - off) /
+                    sizeof (double));
+            std::memcpy (entries.data (), payload.data () + off,
+                    entries.size () * sizeof (double));
+            m_finished[k] = entries;
+            m_snapshots.erase (k);
+        } else if (type == (uint8_t) ckpt_msg::snapshot) {
+            if (!m_finished.count (k))
+                m_snapshots[k] = payload.substr (off);
+        }
+    }
+    if (first && !data.empty ())
+        throw std::runtime_error (m_path + " is not a checkpoint");
+    m_restored = m_finished.size ();
+
+    // rewrite the file with only what is still needed, and replace the old
+    // one once the new one is safely on disk
+    std::string out, hdr (magic, 8);
+    put_num<uint64_t> (&hdr, m_seed);
+    hdr.append (config);
+    net::put_message (&out, (uint8_t) ckpt_msg::header, hdr);
+    for (auto &f: m_finished)
+        net::put_message (&out, (uint8_t) ckpt_msg::finished,
+                encode (f.first, std::string (
+                        reinterpret_cast<const char *>(f.second.data ()),
+                        f.second.size () * sizeof (double))));
+    for (auto &s: m_snapshots)
+        net::put_message (&out, (uint8_t) ckpt_msg::snapshot,
+                encode (s.first, s.second));
+
+    std::string tmp = m_path + ".tmp";
+    int fd = open (tmp.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || !write_all (fd, out) || fsync (fd) != 0 ||
+            rename (tmp.c_str (), m_path.c_str ()) != 0) {
+        std::string err = std::strerror (errno);
+        if (fd >= 0)
+            close (fd);
+        throw std::runtime_error ("could not write the checkpoint " +
+                m_path + ": " + err);
+    }
+    close (fd);
+
+    m_fd = open (m_path.c_str (), O_WRONLY | O_APPEND);
+    if (m_fd < 0)
+        throw std::runtime_error ("could not open the checkpoint " +
+                m_path + ": " + std::strerror (errno));
+}
+
+void
+optk::checkpoint::append (uint8_t type, const key_t &k, const std::string &body)
+{
+    std::string buf;
+    net::put_message (&buf, type, encode (k, body));
+
+    std::lock_guard<std::mutex> lock (m_mtx);
+    if (m_failed)
+        return;
+    if (!write_all (m_fd, buf)) {
+        // the sweep carries on; it just can no longer be resumed
+        std::cerr << "Warning: could not write the checkpoint " << m_path <<
+            ": " << std::strerror (errno) << std::endl;
+        m_failed = true;
+    }
+}
+
+bool
+optk::checkpoint::finished (
+        const std::string &set,
+        uint job,
+        std::vector<double> *entries
+) {
+    std::lock_guard<std::mutex> lock (m_mtx);
+    auto it = m_finished.find (key_t (set, job));
+    if (it == m_finished.end ())
+        return false;
+    *entries = it->second;
+    return true;
+}
+
+void
+optk::checkpoint::finish (
+        const std::string &set,
+        uint job,
+        const double *entries,
+        uint n
+) {
+    append ((uint8_t) ckpt_msg::finished, key_t (set, job),
+            std::string (reinterpret_cast<const char *>(entries),
+                n * sizeof (double)));
+}
+
+optk::progress *
+optk::checkpoint::start (const std::string &set, uint job)
+{
+    return new run_progress (this, key_t (set, job));
+}
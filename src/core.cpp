@@ -21,40 +21,381 @@
 
 #include <optk/core.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 namespace optk {
 
+/**
+ * Skips the validation of a benchmark's parameters for the lifetime of the
+ * scope if the optimiser is trusted, then restores the caller's setting,
+ * whether the loop returns or throws.
+ */
+class validation_scope {
+    public:
+        validation_scope (optk::benchmark *bench, optk::optimiser *opt):
+            m_bench (bench), m_prev (bench->validation ())
+        { bench->set_validation (m_prev && !opt->trusted ()); }
+
+        ~validation_scope () { m_bench->set_validation (m_prev); }
+
+    private:
+        optk::benchmark *m_bench;
+        bool m_prev;
+};
+
 void
 core_loop(
         optk::benchmark *bench,
         optk::optimiser *opt,
-        double *trace,
-        uint max_iter
+        optk::trace &tr,
+        optk::progress *prog
 ) {
-    // clear the trace memory region
-    memset(trace, 0, sizeof (double) * max_iter);
+    tr.clear ();
+    const uint max_iter = tr.iters ();
 
     sspace::sspace_t *ss = bench->get_search_space();
 
     opt->update_search_space(ss);
+    validation_scope validation (bench, opt);
 
     inst::set params = NULL;
-    uint idx = 0;
+    const bool costed = tr.costed (), summary = tr.summary ();
+    uint idx = prog ? prog->resume (opt, tr) : 0;
 
-    do {
-        params = opt->generate_parameters (idx);
-        // std::cout << "after genp" << std::endl;
+    while (idx < max_iter) {
+        {
+            OPTK_TIME (tr.timings (), optk::phase::generate);
+            params = opt->generate_parameters (idx);
+        }
         if (params == NULL)
             break;
-        double res = bench->evaluate (params);
-        opt->receive_trial_results (idx, params, res);
-        trace[idx++] = res;
-    } while (params != NULL && idx < max_iter);
+        double res, cost = 0., exact;
+        {
+            OPTK_TIME_SINK (tr.timings ());
+            OPTK_TIME (tr.timings (), optk::phase::evaluate);
+            optk::scoped_trial trial (idx);
+            res = bench->evaluate (params);
+            if (costed)
+                cost = bench->cost (params);
+            exact = summary ? bench->exact (params, res) : res;
+        }
+        {
+            OPTK_TIME (tr.timings (), optk::phase::receive);
+            opt->receive_trial_results (idx++, params, res);
+        }
+        tr.record (res, cost, exact);
+        if (prog)
+            prog->step (opt, tr);
+    }
 
     opt->clear();
 
     return;
 }
 
+void
+core_loop(
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        double *trace,
+        uint max_iter
+) {
+    optk::trace tr (max_iter);
+    core_loop (bench, opt, tr);
+    std::copy (tr.data (), tr.data () + max_iter, trace);
+}
+
+void
+core_loop_batch (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        uint batch,
+        optk::thread_pool *pool,
+        optk::progress *prog
+) {
+    tr.clear ();
+    const uint max_iter = tr.iters ();
+
+    sspace::sspace_t *ss = bench->get_search_space();
+
+    opt->update_search_space(ss);
+    validation_scope validation (bench, opt);
+
+    if (batch < 1)
+        batch = 1;
+
+    std::vector<inst::set> params;
+    const bool costed = tr.costed (), summary = tr.summary ();
+    std::vector<double> results (batch), costs (batch, 0.), exacts (batch);
+    uint idx = prog ? prog->resume (opt, tr) : 0;
+
+    while (idx < max_iter) {
+        uint k = std::min (batch, max_iter - idx);
+        params.clear ();
+        uint got;
+        {
+            OPTK_TIME (tr.timings (), optk::phase::generate);
+            got = opt->generate_batch (idx, k, &params);
+        }
+        if (got == 0)
+            break;
+
+        double *res = results.data ();
+        auto eval = [&] (uint i) {
+            OPTK_TIME_SINK (tr.timings ());
+            OPTK_TIME (tr.timings (), optk::phase::evaluate);
+            optk::scoped_trial trial (idx + i);
+            res[i] = bench->evaluate (params[i]);
+            if (costed)
+                costs[i] = bench->cost (params[i]);
+            exacts[i] = summary ? bench->exact (params[i], res[i]) : res[i];
+        };
+        if (pool) {
+            pool->parallel_for (got, eval);
+        } else {
+            for (uint i = 0; i < got; i++)
+                eval (i);
+        }
+
+        {
+            OPTK_TIME (tr.timings (), optk::phase::receive);
+            opt->receive_batch (idx, &params, res);
+        }
+        for (uint i = 0; i < got; i++)
+            tr.record (res[i], costs[i], exacts[i]);
+        idx += got;
+        if (prog)
+            prog->step (opt, tr);
+        if (got < k)
+            break;
+    }
+
+    opt->clear();
+}
+
+void
+core_loop_batch (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        double *trace,
+        uint max_iter,
+        uint batch,
+        optk::thread_pool *pool
+) {
+    optk::trace tr (max_iter);
+    core_loop_batch (bench, opt, tr, batch, pool);
+    std::copy (tr.data (), tr.data () + max_iter, trace);
+}
+
+/** A trial in flight in an asynchronous loop. */
+typedef struct {
+    uint id;
+    inst::set params;
+    double result, cost, exact;
+} async_slot;
+
+/**
+ * The state of an asynchronous loop, shared between the caller and the
+ * evaluation tasks, which may still be dequeued after the loop has returned.
+ * The trials in flight are held in one slot each, so that the state is
+ * O(inflight) whatever the budget; a slot is reused once its result has
+ * been received.
+ */
+typedef struct {
+    optk::benchmark *bench;
+    /** Whether the costs of the evaluations are wanted                     */
+    bool costed;
+    /** Whether the exact values of the evaluations are wanted              */
+    bool summary;
+#ifdef __OPTK_TIMING
+    optk::timings *timings;
+#endif
+    /** The trials in flight; a slot is written before being queued         */
+    std::vector<async_slot> slots;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    /** The slots of the trials waiting to be evaluated                     */
+    std::deque<uint> queued;
+    /** The slots of evaluated trials, in order of completion               */
+    std::deque<uint> completed;
+    std::exception_ptr err;
+} async_state;
+
+/**
+ * Evaluates one queued trial, if there is any left.
+ * @returns false if there was nothing to evaluate.
+ */
+static bool
+async_evaluate (async_state *st)
+{
+    uint s;
+    {
+        std::lock_guard<std::mutex> lock (st->mtx);
+        if (st->queued.empty ())
+            return false;
+        s = st->queued.front ();
+        st->queued.pop_front ();
+    }
+
+    async_slot *slot = &st->slots[s];
+    double res = 0., cost = 0., exact = 0.;
+    std::exception_ptr err;
+    try {
+        OPTK_TIME_SINK (st->timings);
+        OPTK_TIME (st->timings, optk::phase::evaluate);
+        optk::scoped_trial trial (slot->id);
+        res = st->bench->evaluate (slot->params);
+        if (st->costed)
+            cost = st->bench->cost (slot->params);
+        exact = st->summary ? st->bench->exact (slot->params, res) : res;
+    } catch (...) {
+        err = std::current_exception ();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (st->mtx);
+        slot->result = res;
+        slot->cost = cost;
+        slot->exact = exact;
+        if (err && !st->err)
+            st->err = err;
+        st->completed.push_back (s);
+    }
+    st->cv.notify_all ();
+    return true;
+}
+
+void
+core_loop_async (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        optk::trace &tr,
+        uint inflight,
+        optk::thread_pool *pool
+) {
+    tr.clear ();
+    const uint max_iter = tr.iters ();
+
+    sspace::sspace_t *ss = bench->get_search_space();
+
+    opt->update_search_space(ss);
+    validation_scope validation (bench, opt);
+
+    if (inflight < 1)
+        inflight = 1;
+
+    std::shared_ptr<async_state> st = std::make_shared<async_state> ();
+    st->bench = bench;
+    st->costed = tr.costed ();
+    st->summary = tr.summary ();
+#ifdef __OPTK_TIMING
+    st->timings = tr.timings ();
+#endif
+    st->slots.resize (inflight);
+    std::vector<uint> free_slots (inflight);
+    for (uint s = 0; s < inflight; s++)
+        free_slots[s] = inflight - 1 - s;
+
+    uint issued = 0, running = 0;
+    bool exhausted = false, failed = false;
+    // an optimiser which throws is only rethrown once the evaluations in
+    // flight, which refer to the loop's state, have completed
+    std::exception_ptr err;
+
+    while (true) {
+        // keep the pipeline full
+        while (!exhausted && !failed && running < inflight && issued < max_iter) {
+            inst::set params;
+            try {
+                OPTK_TIME (tr.timings (), optk::phase::generate);
+                params = opt->generate_parameters (issued);
+            } catch (...) {
+                err = std::current_exception ();
+                failed = true;
+                break;
+            }
+            if (params == NULL) {
+                exhausted = true;
+                break;
+            }
+            uint s = free_slots.back ();
+            free_slots.pop_back ();
+            st->slots[s].id = issued;
+            st->slots[s].params = params;
+            {
+                std::lock_guard<std::mutex> lock (st->mtx);
+                st->queued.push_back (s);
+            }
+            pool->submit ([st] () { async_evaluate (st.get ()); });
+            issued++;
+            running++;
+        }
+
+        if (running == 0)
+            break;
+
+        // help with the evaluations until one of them completes
+        std::unique_lock<std::mutex> lock (st->mtx);
+        while (st->completed.empty ()) {
+            if (!st->queued.empty ()) {
+                lock.unlock ();
+                async_evaluate (st.get ());
+                lock.lock ();
+            } else {
+                st->cv.wait (lock);
+            }
+        }
+        std::deque<uint> done;
+        done.swap (st->completed);
+        failed = failed || st->err;
+        lock.unlock ();
+
+        for (uint s: done) {
+            running--;
+            free_slots.push_back (s);
+            if (failed)
+                continue;
+            async_slot *slot = &st->slots[s];
+            try {
+                OPTK_TIME (tr.timings (), optk::phase::receive);
+                opt->receive_trial_results (slot->id, slot->params,
+                        slot->result);
+            } catch (...) {
+                err = std::current_exception ();
+                failed = true;
+                continue;
+            }
+            tr.record (slot->result, slot->cost, slot->exact);
+        }
+    }
+
+    opt->clear();
+
+    if (err)
+        std::rethrow_exception (err);
+    if (st->err)
+        std::rethrow_exception (st->err);
+}
+
+void
+core_loop_async (
+        optk::benchmark *bench,
+        optk::optimiser *opt,
+        double *trace,
+        uint max_iter,
+        uint inflight,
+        optk::thread_pool *pool
+) {
+    optk::trace tr (max_iter);
+    core_loop_async (bench, opt, tr, inflight, pool);
+    std::copy (tr.data (), tr.data () + max_iter, trace);
+}
+
 } // namespace optk
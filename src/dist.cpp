@@ -0,0 +1,492 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the coordinator and workers of distributed sweeps.
+ */
+
+#include <optk/checkpoint.hpp>
+#include <optk/dist.hpp>
+#include <optk/results.hpp>
+#include <optk/rng.hpp>
+#include <optk/threadpool.hpp>
+#include <optk/trace.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using optk::net::get_num;
+using optk::net::put_num;
+
+/** A unit of work, located in the sweep. */
+typedef struct {
+    uint set;   /** The index of the benchmark set                          */
+    uint opt;   /** The index of the optimiser                              */
+    uint bench; /** The index of the benchmark in the set                   */
+    uint pair;  /** The index of the (optimiser, benchmark) pair in the set */
+    uint rep;   /** The index of the replicate of the pair                 */
+    uint job;   /** The index of the job in the set, which seeds it       */
+} unit_t;
+
+/**
+ * Lists the units of a sweep, in the order in which benchmark_set::run would
+ * queue them; the index of a unit in the list is its id.
+ */
+static std::vector<unit_t>
+expand (optk::bench_list *bms, optk::optimisers *opts, uint reps)
+{
+    std::vector<unit_t> units;
+    uint nopt = opts->collection ()->size ();
+    for (uint s = 0; s < bms->size (); s++) {
+        uint nbench = bms->at(s)->size ();
+        uint npairs = nopt * nbench;
+        for (uint i = 0; i < nopt; i++)
+            for (uint j = 0; j < nbench; j++)
+                for (uint r = 0; r < reps; r++) {
+                    uint pair = i * nbench + j;
+                    units.push_back ({s, i, j, pair, r, pair + r * npairs});
+                }
+    }
+    return units;
+}
+
+/** @returns The number of doubles in each trace of the sweep. */
+static uint
+trace_entries (optk::ctx_t *ctx)
+{
+    return optk::trace (ctx->max_iters, ctx->stride, false, ctx->costs,
+            ctx->summary).span ();
+}
+
+// coordinator -----------------------------------------------------------------
+
+/** A worker, as seen by the coordinator. */
+typedef struct {
+    int fd;
+    /** The bytes received but not yet handled, and those not yet sent.    */
+    std::string in, out;
+    /** The number of threads, which is zero until the worker says hello. */
+    uint threads;
+    /** The units handed to the worker, whose results have not come back.  */
+    std::set<uint> held;
+} worker_t;
+
+/** The state of a sweep, as seen by the coordinator. */
+typedef struct {
+    optk::bench_list *bms;
+    optk::optimisers *opts;
+    optk::ctx_t *ctx;
+    std::string config;
+    std::vector<unit_t> units;
+    std::vector<std::unique_ptr<optk::sweep_rows>> rows;
+    /** The units yet to be handed out, and the state of each unit.        */
+    std::deque<uint> queue;
+    std::vector<bool> finished;
+    std::vector<uint> holders;
+    uint remaining;
+    uint entries;
+    std::vector<worker_t> workers;
+    /** The error with which a unit failed on a worker, if any.            */
+    std::string failure;
+} sweep_t;
+
+/**
+ * Hands out units to a worker: from the queue, while it has fewer than two
+ * per thread, and then, while it has fewer than one per thread, by stealing
+ * units which are running on exactly one other worker.
+ */
+static void
+assign (sweep_t *sw, worker_t *w)
+{
+    if (!w->threads)
+        return;
+    std::string ids;
+    uint32_t n = 0;
+    auto give = [&] (uint id) {
+        w->held.insert (id);
+        sw->holders[id]++;
+        put_num<uint32_t> (&ids, id);
+        n++;
+    };
+
+    while (w->held.size () < 2 * w->threads && !sw->queue.empty ()) {
+        uint id = sw->queue.front ();
+        sw->queue.pop_front ();
+        if (!sw->finished[id])
+            give (id);
+    }
+    for (worker_t &o: sw->workers) {
+        if (!sw->queue.empty () || w->held.size () >= w->threads)
+            break;
+        for (uint id: o.held) {
+            if (w->held.size () >= w->threads)
+                break;
+            if (sw->holders[id] == 1 && !w->held.count (id))
+                give (id);
+        }
+    }
+
+    if (n) {
+        std::string payload;
+        put_num<uint32_t> (&payload, n);
+        payload.append (ids);
+        optk::net::put_message (&w->out, (uint8_t) optk::dist::msg::units,
+                payload);
+    }
+}
+
+/** Writes the result of a unit, which has just finished. */
+static void
+finish (sweep_t *sw, uint id, const double *trace, uint n)
+{
+    sw->finished[id] = true;
+    sw->remaining--;
+    unit_t u = sw->units[id];
+    optk::benchmark_set *bs = sw->bms->at(u.set);
+    sw->rows[u.set]->add (u.pair, u.rep,
+            optk::rng::derive (sw->ctx->seed, u.job), trace, n,
+            bs->benchmark_name (u.bench),
+            sw->opts->collection ()->at(u.opt)->get_name (),
+            bs->benchmark_properties (u.bench));
+}
+
+/**
+ * Handles a message from a worker.
+ * @exception std::runtime_error if the worker is out of step.
+ */
+static void
+handle (sweep_t *sw, worker_t *w, uint8_t type, const std::string &in)
+{
+    size_t off = 0;
+    switch ((optk::dist::msg) type) {
+        case optk::dist::msg::hello:
+            w->threads = std::max (get_num<uint32_t> (in, &off), 1u);
+            optk::net::put_message (&w->out,
+                    (uint8_t) optk::dist::msg::config, sw->config);
+            break;
+        case optk::dist::msg::result: {
+            uint32_t id = get_num<uint32_t> (in, &off);
+            uint32_t n = get_num<uint32_t> (in, &off);
+            if (id >= sw->units.size () || n != sw->entries ||
+                    off + n * sizeof (double) != in.size ())
+                throw std::runtime_error ("a worker sent a mismatched result");
+            if (w->held.erase (id))
+                sw->holders[id]--;
+            if (sw->finished[id])
+                break;
+
+            // the first result of a unit is kept; they are all the same
+            std::vector<double> trace (n);
+            std::memcpy (trace.data (), in.data () + off, n * sizeof (double));
+            if (sw->ctx->ckpt) {
+                unit_t u = sw->units[id];
+                sw->ctx->ckpt->finish (sw->bms->at(u.set)->get_name (), u.job,
+                        trace.data (), n);
+            }
+            finish (sw, id, trace.data (), n);
+            break;
+        }
+        case optk::dist::msg::error:
+            if (sw->failure.empty ())
+                sw->failure = in.empty () ? "unknown error" : in;
+            break;
+        default:
+            throw std::runtime_error ("unexpected message from a worker");
+    }
+}
+
+/**
+ * Reads what a worker has sent, and handles its complete messages.
+ * @returns false if the worker has gone, or is out of step.
+ */
+static bool
+receive (sweep_t *sw, worker_t *w)
+{
+    char buf[1 << 16];
+    ssize_t r = read (w->fd, buf, sizeof (buf));
+    if (r < 0)
+        return errno == EINTR || errno == EAGAIN;
+    if (r == 0)
+        return false;
+    w->in.append (buf, r);
+
+    uint8_t type;
+    std::string payload;
+    try {
+        while (optk::net::take_message (&w->in, &type, &payload))
+            handle (sw, w, type, payload);
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Warning: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Sends as much as possible of what is queued for a worker.
+ * @returns false if the worker has gone.
+ */
+static bool
+transmit (worker_t *w)
+{
+    while (!w->out.empty ()) {
+        ssize_t r = send (w->fd, w->out.data (), w->out.size (),
+                MSG_NOSIGNAL);
+        if (r < 0)
+            return errno == EINTR || errno == EAGAIN;
+        w->out.erase (0, r);
+    }
+    return true;
+}
+
+/** Disconnects a worker, and queues its unfinished units to be run again. */
+static void
+drop (sweep_t *sw, uint i)
+{
+    worker_t *w = &sw->workers[i];
+    uint lost = 0;
+    for (uint id: w->held) {
+        sw->holders[id]--;
+        if (!sw->finished[id] && !sw->holders[id]) {
+            sw->queue.push_front (id);
+            lost++;
+        }
+    }
+    if (lost)
+        std::cerr << "Warning: lost a worker; handing out its " << lost <<
+            " units again" << std::endl;
+    close (w->fd);
+    sw->workers.erase (sw->workers.begin () + i);
+}
+
+void
+optk::dist::coordinate (
+        int lfd,
+        optk::bench_list *bms,
+        optk::optimisers *opts,
+        optk::ctx_t *ctx,
+        const std::vector<std::string> &config)
+{
+    uint reps = std::max (ctx->repeats, 1u);
+    uint nopt = opts->collection ()->size ();
+
+    sweep_t sw;
+    sw.bms = bms;
+    sw.opts = opts;
+    sw.ctx = ctx;
+    put_num<uint32_t> (&sw.config, config.size ());
+    for (const std::string &a: config) {
+        put_num<uint32_t> (&sw.config, a.size ());
+        sw.config.append (a);
+    }
+    sw.units = expand (bms, opts, reps);
+    for (optk::benchmark_set *bs: *bms)
+        sw.rows.emplace_back (new optk::sweep_rows (ctx->results,
+                    nopt * bs->size (), reps, ctx->costs && !ctx->summary));
+    sw.finished.assign (sw.units.size (), false);
+    sw.holders.assign (sw.units.size (), 0);
+    sw.remaining = sw.units.size ();
+    sw.entries = trace_entries (ctx);
+
+    // the units finished before the sweep was stopped are not handed out
+    for (uint id = 0; id < sw.units.size (); id++) {
+        std::vector<double> saved;
+        unit_t u = sw.units[id];
+        if (ctx->ckpt && ctx->ckpt->finished (bms->at(u.set)->get_name (),
+                    u.job, &saved))
+            finish (&sw, id, saved.data (), saved.size ());
+        else
+            sw.queue.push_back (id);
+    }
+
+    std::vector<pollfd> fds;
+    while (sw.remaining) {
+        fds.assign (1, {lfd, POLLIN, 0});
+        for (worker_t &w: sw.workers)
+            fds.push_back ({w.fd, (short) (POLLIN |
+                        (w.out.empty () ? 0 : POLLOUT)), 0});
+        if (poll (fds.data (), fds.size (), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error ("poll failed");
+        }
+
+        // workers are dropped from the back, so the indices stay valid
+        for (uint i = sw.workers.size (); i-- > 0;) {
+            worker_t *w = &sw.workers[i];
+            short ev = fds[i + 1].revents;
+            bool ok = true;
+            if (ev & (POLLIN | POLLHUP | POLLERR))
+                ok = receive (&sw, w);
+            if (ok)
+                ok = transmit (w);
+            if (!ok)
+                drop (&sw, i);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept (lfd, NULL, NULL);
+            if (fd >= 0) {
+                fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+                sw.workers.push_back ({fd, "", "", 0, {}});
+            }
+        }
+
+        // a unit which failed fails everywhere, so the sweep is abandoned
+        if (!sw.failure.empty ()) {
+            for (worker_t &w: sw.workers)
+                close (w.fd);
+            throw std::runtime_error ("a unit failed on a worker: " +
+                    sw.failure);
+        }
+
+        for (uint i = sw.workers.size (); i-- > 0;) {
+            assign (&sw, &sw.workers[i]);
+            if (!transmit (&sw.workers[i]))
+                drop (&sw, i);
+        }
+    }
+
+    // let the workers go
+    for (worker_t &w: sw.workers) {
+        optk::net::put_message (&w.out, (uint8_t) msg::done, "");
+        fcntl (w.fd, F_SETFL, fcntl (w.fd, F_GETFL) & ~O_NONBLOCK);
+        transmit (&w);
+        close (w.fd);
+    }
+    ctx->results->flush ();
+}
+
+// worker ----------------------------------------------------------------------
+
+std::vector<std::string>
+optk::dist::join (optk::net::channel *chan, uint threads)
+{
+    std::string hello;
+    put_num<uint32_t> (&hello, threads);
+    chan->put ((uint8_t) msg::hello, hello);
+    chan->flush ();
+
+    std::string in;
+    if (chan->get (&in) != (uint8_t) msg::config)
+        throw std::runtime_error ("unexpected message from the coordinator");
+    size_t off = 0;
+    uint32_t argc = get_num<uint32_t> (in, &off);
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < argc; i++) {
+        uint32_t len = get_num<uint32_t> (in, &off);
+        if (off + len > in.size ())
+            throw std::runtime_error ("truncated message");
+        args.push_back (in.substr (off, len));
+        off += len;
+    }
+    return args;
+}
+
+void
+optk::dist::work (
+        optk::net::channel *chan,
+        optk::bench_list *bms,
+        optk::optimisers *opts,
+        optk::ctx_t *ctx)
+{
+    uint reps = std::max (ctx->repeats, 1u);
+    std::vector<unit_t> units = expand (bms, opts, reps);
+    optk::thread_pool pool (ctx->threads);
+    std::mutex send_mtx;
+    std::atomic<bool> lost (false);
+    /** The error of the first unit which failed, guarded by send_mtx.     */
+    std::string failure;
+
+    auto run = [&, reps] (uint32_t id) {
+        if (lost)
+            return;
+        unit_t u = units[id];
+        std::unique_ptr<optk::optimiser> opt (
+                opts->collection ()->at(u.opt)->clone ());
+        uint64_t seed = optk::rng::derive (ctx->seed, u.job);
+        opt->seed (seed);
+        optk::trace tr (ctx->max_iters, ctx->stride, ctx->best || reps > 1,
+                ctx->costs, ctx->summary);
+
+        uint8_t type = (uint8_t) msg::result;
+        std::string res;
+        try {
+            bms->at(u.set)->run_one (u.bench, opt.get (), tr, ctx, &pool,
+                    NULL, seed);
+            put_num<uint32_t> (&res, id);
+            put_num<uint32_t> (&res, tr.span ());
+            res.append (reinterpret_cast<const char *>(tr.data ()),
+                    tr.span () * sizeof (double));
+        } catch (const std::exception &e) {
+            // the coordinator abandons the sweep, rather than waiting on
+            // the unit forever
+            type = (uint8_t) msg::error;
+            res = e.what ();
+        }
+
+        std::lock_guard<std::mutex> lock (send_mtx);
+        if (type == (uint8_t) msg::error) {
+            if (!failure.empty ())
+                return;
+            failure = res;
+            lost = true;
+        }
+        try {
+            chan->put (type, res);
+            chan->flush ();
+        } catch (const std::runtime_error &) {
+            lost = true;
+        }
+    };
+
+    std::string in;
+    try {
+        uint8_t type;
+        while ((type = chan->get (&in)) != (uint8_t) msg::done) {
+            if (type != (uint8_t) msg::units)
+                throw std::runtime_error (
+                        "unexpected message from the coordinator");
+            size_t off = 0;
+            uint32_t n = get_num<uint32_t> (in, &off);
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t id = get_num<uint32_t> (in, &off);
+                if (id >= units.size ())
+                    throw std::runtime_error (
+                            "the coordinator's sweep does not match");
+                pool.submit ([&run, id] () { run (id); });
+            }
+        }
+    } catch (const std::runtime_error &) {
+        lost = true;
+        pool.wait ();
+        if (!failure.empty ())
+            throw std::runtime_error (failure);
+        throw;
+    }
+    pool.wait ();
+}
@@ -0,0 +1,272 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements framed message streams over sockets.
+ */
+
+#include <optk/net.hpp>
+
+#include <cerrno>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** The size of a message's frame: its length and its type. */
+static const size_t frame = sizeof (uint32_t) + 1;
+
+void
+optk::net::put_message (std::string *buf, uint8_t type,
+        const std::string &payload)
+{
+    if (payload.size () > max_payload)
+        throw std::runtime_error ("message too large to send");
+    put_num<uint32_t> (buf, payload.size ());
+    buf->push_back ((char) type);
+    buf->append (payload);
+}
+
+bool
+optk::net::take_message (std::string *buf, uint8_t *type, std::string *payload)
+{
+    if (buf->size () < frame)
+        return false;
+    uint32_t len;
+    std::memcpy (&len, buf->data (), sizeof (len));
+    if (len > max_payload)
+        throw std::runtime_error ("the peer sent an oversized message");
+    if (buf->size () < frame + len)
+        return false;
+    *type = (uint8_t) (*buf)[sizeof (len)];
+    payload->assign (*buf, frame, len);
+    buf->erase (0, frame + len);
+    return true;
+}
+
+// channel ---------------------------------------------------------------------
+
+optk::net::channel::channel (int fd): m_fd (fd) { }
+
+optk::net::channel::~channel ()
+{
+    close (m_fd);
+}
+
+void
+optk::net::channel::put (uint8_t type, const std::string &payload)
+{
+    put_message (&m_out, type, payload);
+}
+
+void
+optk::net::channel::flush ()
+{
+    size_t done = 0;
+    while (done < m_out.size ()) {
+        ssize_t w = send (m_fd, m_out.data () + done, m_out.size () - done,
+                MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            throw std::runtime_error (
+                    std::string ("write failed: ") + std::strerror (errno));
+        done += w;
+    }
+    m_out.clear ();
+}
+
+/**
+ * Reads exactly n bytes.
+ * @returns The number of bytes read, which is less than n only at the end
+ * of the stream.
+ */
+static size_t
+read_all (int fd, char *buf, size_t n)
+{
+    size_t done = 0;
+    while (done < n) {
+        ssize_t r = read (fd, buf + done, n - done);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            throw std::runtime_error (
+                    std::string ("read failed: ") + std::strerror (errno));
+        if (r == 0)
+            break;
+        done += r;
+    }
+    return done;
+}
+
+bool
+optk::net::channel::try_get (uint8_t *type, std::string *payload)
+{
+    char hdr[frame];
+    size_t got = read_all (m_fd, hdr, frame);
+    if (got == 0)
+        return false;
+    if (got < frame)
+        throw std::runtime_error ("connection lost");
+
+    uint32_t len;
+    std::memcpy (&len, hdr, sizeof (len));
+    *type = (uint8_t) hdr[sizeof (len)];
+    if (len > max_payload) {
+        shutdown (m_fd, SHUT_RDWR);
+        throw std::runtime_error ("the peer sent an oversized message");
+    }
+    payload->resize (len);
+    if (read_all (m_fd, &(*payload)[0], len) < len)
+        throw std::runtime_error ("connection lost");
+    return true;
+}
+
+uint8_t
+optk::net::channel::get (std::string *payload)
+{
+    uint8_t type;
+    if (!try_get (&type, payload))
+        throw std::runtime_error ("connection closed");
+    return type;
+}
+
+// sockets ---------------------------------------------------------------------
+
+/** Fills in a Unix socket address. */
+static sockaddr_un
+unix_address (const std::string &path)
+{
+    sockaddr_un addr;
+    std::memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size () >= sizeof (addr.sun_path))
+        throw std::runtime_error ("socket path too long: " + path);
+    std::strcpy (addr.sun_path, path.c_str ());
+    return addr;
+}
+
+int
+optk::net::connect_unix (const std::string &path)
+{
+    sockaddr_un addr = unix_address (path);
+    int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect (fd, (sockaddr *) &addr, sizeof (addr)) < 0) {
+        std::string err = std::strerror (errno);
+        if (fd >= 0)
+            close (fd);
+        throw std::runtime_error ("could not connect to '" + path + "': " +
+                err);
+    }
+    return fd;
+}
+
+int
+optk::net::listen_unix (const std::string &path)
+{
+    sockaddr_un addr = unix_address (path);
+    unlink (path.c_str ());
+    int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind (fd, (sockaddr *) &addr, sizeof (addr)) < 0 ||
+            listen (fd, SOMAXCONN) < 0) {
+        std::string err = std::strerror (errno);
+        if (fd >= 0)
+            close (fd);
+        throw std::runtime_error ("could not listen at '" + path + "': " +
+                err);
+    }
+    return fd;
+}
+
+/**
+ * Resolves a HOST:PORT address.
+ * @param passive Whether the address is to be listened on.
+ * @returns The addresses, to be freed with freeaddrinfo.
+ */
+static addrinfo *
+resolve (const std::string &addr, bool passive)
+{
+    size_t colon = addr.rfind (':');
+    if (colon == std::string::npos)
+        throw std::runtime_error ("invalid address '" + addr +
+                "'; expected HOST:PORT");
+    std::string host = addr.substr (0, colon), port = addr.substr (colon + 1);
+
+    addrinfo hints, *res;
+    std::memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    int err = getaddrinfo (host.empty () ? NULL : host.c_str (), port.c_str (),
+            &hints, &res);
+    if (err)
+        throw std::runtime_error ("could not resolve '" + addr + "': " +
+                gai_strerror (err));
+    return res;
+}
+
+int
+optk::net::connect_tcp (const std::string &addr)
+{
+    addrinfo *res = resolve (addr, false);
+    int fd = -1, err = 0;
+    for (addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket (a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect (fd, a->ai_addr, a->ai_addrlen) < 0) {
+            err = errno;
+            close (fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo (res);
+    if (fd < 0)
+        throw std::runtime_error ("could not connect to '" + addr + "': " +
+                std::strerror (err));
+
+    // the messages are small, and each is flushed when it must go
+    int one = 1;
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    return fd;
+}
+
+int
+optk::net::listen_tcp (const std::string &addr)
+{
+    addrinfo *res = resolve (addr, true);
+    int fd = -1, err = 0;
+    for (addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket (a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0)
+            continue;
+        int one = 1;
+        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+        if (bind (fd, a->ai_addr, a->ai_addrlen) < 0 ||
+                listen (fd, SOMAXCONN) < 0) {
+            err = errno;
+            close (fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo (res);
+    if (fd < 0)
+        throw std::runtime_error ("could not listen on '" + addr + "': " +
+                std::strerror (err));
+    return fd;
+}
@@ -22,7 +22,8 @@
 #include "optk/types.hpp"
 #include <optk/optimiser.hpp>
 
-optk::optimiser::optimiser (std::string name)
+optk::optimiser::optimiser (std::string name) :
+    m_rng (optk::thread_rng () ())
 {
     m_name = name;
 }
@@ -35,6 +36,7 @@ do_destruct (std::unordered_map<int, inst::set> *trials)
     std::unordered_map<int, inst::set>::iterator it;
     for (it = trials->begin (); it != trials->end (); it++)
         inst::free_node (std::get<1>(*it));
+    trials->clear ();
 }
 
 optk::optimiser::~optimiser ()
@@ -76,5 +78,31 @@ optk::optimiser::add_to_trials (int param_id, inst::set n)
 {
     if (trials.count (param_id))
         inst::free_node (trials.at (param_id));
-    trials.emplace (param_id, n);
+    trials[param_id] = n;
+}
+
+uint
+optk::optimiser::generate_batch (
+        int first_id,
+        uint k,
+        std::vector<inst::set> *out
+) {
+    uint i;
+    for (i = 0; i < k; i++) {
+        inst::set params = generate_parameters (first_id + i);
+        if (params == NULL)
+            break;
+        out->push_back (params);
+    }
+    return i;
+}
+
+void
+optk::optimiser::receive_batch (
+        int first_id,
+        std::vector<inst::set> *params,
+        const double *values
+) {
+    for (uint i = 0; i < params->size (); i++)
+        receive_trial_results (first_id + i, params->at (i), values[i]);
 }
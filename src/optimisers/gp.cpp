@@ -20,11 +20,573 @@
  */
 
 #include <optimisers/gp.hpp>
+#include <optk/net.hpp>
 
-gp_opt::gp_opt ():
-    optk::optimiser ("gp optimiser")
+#include <algorithm>
+#include <numeric>
+
+using optk::net::get_num;
+using optk::net::get_vec;
+using optk::net::put_num;
+using optk::net::put_vec;
+
+// GP engine =================================================================
+
+void
+__gp::cholesky::append (const double *k, double kxx)
+{
+    size_t off = m_rows.size ();
+    m_rows.resize (off + m_n + 1);
+    double *l = m_rows.data () + off;
+
+    std::copy (k, k + m_n, l);
+    forward (l);
+
+    double d2 = kxx;
+    for (u_int p = 0; p < m_n; p++)
+        d2 -= l[p] * l[p];
+    l[m_n] = std::sqrt (std::max (d2, 1e-10 * kxx));
+    m_n++;
+}
+
+void
+__gp::cholesky::forward (double *b)
+{
+    for (u_int i = 0; i < m_n; i++) {
+        const double *r = row (i);
+        double s = b[i];
+        for (u_int p = 0; p < i; p++)
+            s -= r[p] * b[p];
+        b[i] = s / r[i];
+    }
+}
+
+void
+__gp::cholesky::backward (double *b)
+{
+    for (u_int i = m_n; i-- > 0;) {
+        const double *r = row (i);
+        double bi = b[i] / r[i];
+        b[i] = bi;
+        for (u_int p = 0; p < i; p++)
+            b[p] -= r[p] * bi;
+    }
+}
+
+void
+__gp::cholesky::forward_multi (double *b)
+{
+    // Rows are solved four at a time, accumulating in a local buffer so that
+    // every finished row of B is loaded once for the four updates it
+    // contributes to.
+    const u_int rb = 4, m = width;
+    double acc[rb][width];
+
+    for (u_int i0 = 0; i0 < m_n; i0 += rb) {
+        const u_int ie = std::min (i0 + rb, m_n);
+
+        for (u_int i = i0; i < ie; i++)
+            std::copy_n (b + (size_t) i * m, m, acc[i - i0]);
+
+        if (ie - i0 == rb) {
+            const double *r0 = row (i0), *r1 = row (i0 + 1),
+                  *r2 = row (i0 + 2), *r3 = row (i0 + 3);
+            for (u_int p = 0; p < i0; p++) {
+                const double *__restrict bp = b + (size_t) p * m;
+                const double l0 = r0[p], l1 = r1[p], l2 = r2[p], l3 = r3[p];
+                for (u_int j = 0; j < m; j++) {
+                    acc[0][j] -= l0 * bp[j];
+                    acc[1][j] -= l1 * bp[j];
+                    acc[2][j] -= l2 * bp[j];
+                    acc[3][j] -= l3 * bp[j];
+                }
+            }
+        } else {
+            for (u_int p = 0; p < i0; p++) {
+                const double *__restrict bp = b + (size_t) p * m;
+                for (u_int i = i0; i < ie; i++) {
+                    const double l = row (i)[p];
+                    for (u_int j = 0; j < m; j++)
+                        acc[i - i0][j] -= l * bp[j];
+                }
+            }
+        }
+
+        // the triangle within this group of rows
+        for (u_int i = i0; i < ie; i++) {
+            const double *r = row (i);
+            for (u_int p = i0; p < i; p++)
+                for (u_int j = 0; j < m; j++)
+                    acc[i - i0][j] -= r[p] * acc[p - i0][j];
+            const double inv = 1. / r[i];
+            for (u_int j = 0; j < m; j++)
+                acc[i - i0][j] *= inv;
+            std::copy_n (acc[i - i0], m, b + (size_t) i * m);
+        }
+    }
+}
+
+/**
+ * The Matern 5/2 kernel with unit signal variance.
+ */
+static double
+matern (const double *a, const double *b, u_int d, double ls)
+{
+    double r2 = 0;
+    for (u_int k = 0; k < d; k++) {
+        double t = a[k] - b[k];
+        r2 += t * t;
+    }
+    double r = std::sqrt (5. * r2) / ls;
+    return (1. + r + r * r / 3.) * std::exp (-r);
+}
+
+void
+__gp::surrogate::record (const double *x, double y)
+{
+    if (y < m_best) {
+        m_best = y;
+        std::copy_n (x, m_d, m_argbest.begin ());
+    }
+}
+
+__gp::model::model (u_int d, double lengthscale, double noise):
+    surrogate (d), m_ls (lengthscale), m_noise (noise), m_alpha_valid (false),
+    m_mean (0), m_scale (1)
+{ }
+
+void
+__gp::model::add (const double *x, double y)
+{
+    u_int n = size ();
+    std::vector<double> k (n);
+    for (u_int i = 0; i < n; i++)
+        k[i] = matern (m_x.data () + (size_t) i * m_d, x, m_d, m_ls);
+
+    m_chol.append (k.data (), 1. + m_noise);
+    m_x.insert (m_x.end (), x, x + m_d);
+    m_y.push_back (y);
+    record (x, y);
+    m_alpha_valid = false;
+}
+
+void
+__gp::model::clear ()
+{
+    m_x.clear ();
+    m_y.clear ();
+    m_chol.clear ();
+    m_alpha_valid = false;
+    m_best = INFINITY;
+}
+
+void
+__gp::model::update_weights ()
+{
+    u_int n = size ();
+    m_mean = std::accumulate (m_y.begin (), m_y.end (), 0.) / n;
+
+    double ss = 0;
+    for (u_int i = 0; i < n; i++)
+        ss += (m_y[i] - m_mean) * (m_y[i] - m_mean);
+    m_scale = std::sqrt (ss / n);
+    if (!(m_scale > 0) || !std::isfinite (m_scale))
+        m_scale = 1.;
+
+    m_alpha.resize (n);
+    for (u_int i = 0; i < n; i++)
+        m_alpha[i] = (m_y[i] - m_mean) / m_scale;
+    m_chol.forward (m_alpha.data ());
+    m_chol.backward (m_alpha.data ());
+    m_alpha_valid = true;
+}
+
+void
+__gp::model::predict (const double *xs, u_int m, double *mu, double *var)
+{
+    u_int n = size ();
+    if (n == 0) {
+        std::fill (mu, mu + m, 0.);
+        std::fill (var, var + m, 1.);
+        return;
+    }
+    if (!m_alpha_valid)
+        update_weights ();
+
+    std::vector<double> kb ((size_t) n * block, 0.);
+    double bmu[block], bvar[block];
+
+    for (u_int j0 = 0; j0 < m; j0 += block) {
+        u_int bm = std::min (block, m - j0);
+        const double *xb = xs + (size_t) j0 * m_d;
+
+        // cross covariances for this block of candidates, one row per
+        // observation so that the solve below streams contiguous rows; the
+        // columns of a partial last block stay zero.
+        for (u_int i = 0; i < n; i++) {
+            const double *xi = m_x.data () + (size_t) i * m_d;
+            double *ki = kb.data () + (size_t) i * block;
+            for (u_int j = 0; j < bm; j++)
+                ki[j] = matern (xi, xb + (size_t) j * m_d, m_d, m_ls);
+        }
+
+        std::fill_n (bmu, block, 0.);
+        for (u_int i = 0; i < n; i++) {
+            const double *ki = kb.data () + (size_t) i * block;
+            for (u_int j = 0; j < block; j++)
+                bmu[j] += m_alpha[i] * ki[j];
+        }
+
+        m_chol.forward_multi (kb.data ());
+
+        std::fill_n (bvar, block, 1.);
+        for (u_int i = 0; i < n; i++) {
+            const double *vi = kb.data () + (size_t) i * block;
+            for (u_int j = 0; j < block; j++)
+                bvar[j] -= vi[j] * vi[j];
+        }
+
+        for (u_int j = 0; j < bm; j++) {
+            mu[j0 + j] = m_mean + m_scale * bmu[j];
+            var[j0 + j] = m_scale * m_scale * std::max (bvar[j], 1e-12);
+        }
+    }
+}
+
+__gp::sparse_model::sparse_model (
+        u_int d,
+        u_int m,
+        double lengthscale,
+        double noise
+) :
+    surrogate (d), m_m (m), m_ls (lengthscale), m_noise (noise), m_n (0),
+    m_exact (d, lengthscale, noise), m_valid (false),
+    m_sy (0), m_syy (0), m_mean (0), m_scale (1)
+{ }
+
+void
+__gp::sparse_model::freeze ()
+{
+    m_z.swap (m_x0);
+    for (u_int i = 0; i < m_m; i++) {
+        std::vector<double> k (i);
+        for (u_int j = 0; j < i; j++)
+            k[j] = matern (m_z.data () + (size_t) j * m_d,
+                    m_z.data () + (size_t) i * m_d, m_d, m_ls);
+        m_lmm.append (k.data (), 1. + m_noise);
+    }
+
+    m_b.assign ((size_t) m_m * m_m, 0.);
+    for (u_int i = 0; i < m_m; i++)
+        m_b[(size_t) i * m_m + i] = 1.;
+    m_cy.assign (m_m, 0.);
+    m_c1.assign (m_m, 0.);
+
+    for (u_int i = 0; i < m_m; i++)
+        accumulate (m_z.data () + (size_t) i * m_d, m_y0[i]);
+
+    m_exact.clear ();
+    std::vector<double> ().swap (m_y0);
+}
+
+void
+__gp::sparse_model::accumulate (const double *x, double y)
+{
+    std::vector<double> v (m_m);
+    for (u_int i = 0; i < m_m; i++)
+        v[i] = matern (m_z.data () + (size_t) i * m_d, x, m_d, m_ls);
+    m_lmm.forward (v.data ());
+
+    double q = 0;
+    for (u_int i = 0; i < m_m; i++)
+        q += v[i] * v[i];
+    const double il = 1. / std::max (1. + m_noise - q, m_noise);
+
+    // only the lower triangle of B is read when factorising it
+    for (u_int i = 0; i < m_m; i++) {
+        double *bi = m_b.data () + (size_t) i * m_m;
+        const double vi = v[i] * il;
+        for (u_int j = 0; j <= i; j++)
+            bi[j] += vi * v[j];
+        m_cy[i] += vi * y;
+        m_c1[i] += vi;
+    }
+    m_valid = false;
+}
+
+void
+__gp::sparse_model::add (const double *x, double y)
+{
+    record (x, y);
+    m_n++;
+    m_sy += y;
+    m_syy += y * y;
+
+    if (!sparse ()) {
+        if (m_exact.size () < m_m) {
+            m_exact.add (x, y);
+            m_x0.insert (m_x0.end (), x, x + m_d);
+            m_y0.push_back (y);
+            return;
+        }
+        freeze ();
+    }
+    accumulate (x, y);
+}
+
+void
+__gp::sparse_model::predict (const double *xs, u_int m, double *mu, double *var)
+{
+    if (!sparse ()) {
+        m_exact.predict (xs, m, mu, var);
+        return;
+    }
+
+    if (!m_valid) {
+        m_lb.clear ();
+        for (u_int i = 0; i < m_m; i++)
+            m_lb.append (m_b.data () + (size_t) i * m_m,
+                    m_b[(size_t) i * m_m + i]);
+
+        m_mean = m_sy / m_n;
+        m_scale = std::sqrt (std::max (m_syy / m_n - m_mean * m_mean, 0.));
+        if (!(m_scale > 0) || !std::isfinite (m_scale))
+            m_scale = 1.;
+
+        m_w.resize (m_m);
+        for (u_int i = 0; i < m_m; i++)
+            m_w[i] = (m_cy[i] - m_mean * m_c1[i]) / m_scale;
+        m_lb.forward (m_w.data ());
+        m_lb.backward (m_w.data ());
+        m_valid = true;
+    }
+
+    const u_int block = cholesky::width;
+    std::vector<double> vb ((size_t) m_m * block, 0.), ub (vb.size ());
+    double bmu[block], bq[block], bs[block];
+
+    for (u_int j0 = 0; j0 < m; j0 += block) {
+        u_int bm = std::min (block, m - j0);
+        const double *xb = xs + (size_t) j0 * m_d;
+
+        for (u_int i = 0; i < m_m; i++) {
+            const double *zi = m_z.data () + (size_t) i * m_d;
+            double *vi = vb.data () + (size_t) i * block;
+            for (u_int j = 0; j < bm; j++)
+                vi[j] = matern (zi, xb + (size_t) j * m_d, m_d, m_ls);
+        }
+        m_lmm.forward_multi (vb.data ());
+        std::copy (vb.begin (), vb.end (), ub.begin ());
+        m_lb.forward_multi (ub.data ());
+
+        std::fill_n (bmu, block, 0.);
+        std::fill_n (bq, block, 0.);
+        std::fill_n (bs, block, 0.);
+        for (u_int i = 0; i < m_m; i++) {
+            const double *vi = vb.data () + (size_t) i * block;
+            const double *ui = ub.data () + (size_t) i * block;
+            for (u_int j = 0; j < block; j++) {
+                bmu[j] += m_w[i] * vi[j];
+                bq[j] += vi[j] * vi[j];
+                bs[j] += ui[j] * ui[j];
+            }
+        }
+
+        for (u_int j = 0; j < bm; j++) {
+            mu[j0 + j] = m_mean + m_scale * bmu[j];
+            var[j0 + j] = m_scale * m_scale *
+                std::max (1. - bq[j] + bs[j], 1e-12);
+        }
+    }
+}
+
+__gp::local_model::local_model (
+        u_int d,
+        u_int k,
+        double lengthscale,
+        double noise
+) :
+    surrogate (d), m_k (k), m_local (d, lengthscale, noise), m_valid (false)
+{ }
+
+void
+__gp::local_model::add (const double *x, double y)
+{
+    record (x, y);
+    m_x.insert (m_x.end (), x, x + m_d);
+    m_y.push_back (y);
+    m_valid = false;
+}
+
+void
+__gp::local_model::predict (const double *xs, u_int m, double *mu, double *var)
+{
+    if (!m_valid) {
+        u_int n = size ();
+        std::vector<u_int> idx (n);
+        std::iota (idx.begin (), idx.end (), 0);
+
+        if (n > m_k) {
+            std::vector<double> dist (n);
+            for (u_int i = 0; i < n; i++) {
+                const double *xi = m_x.data () + (size_t) i * m_d;
+                double r2 = 0;
+                for (u_int k = 0; k < m_d; k++)
+                    r2 += (xi[k] - m_argbest[k]) * (xi[k] - m_argbest[k]);
+                dist[i] = r2;
+            }
+            std::nth_element (idx.begin (), idx.begin () + m_k, idx.end (),
+                    [&](u_int a, u_int b) { return dist[a] < dist[b]; });
+            idx.resize (m_k);
+        }
+
+        m_local.clear ();
+        for (u_int i: idx)
+            m_local.add (m_x.data () + (size_t) i * m_d, m_y[i]);
+        m_valid = true;
+    }
+    m_local.predict (xs, m, mu, var);
+}
+
+// Snapshots =================================================================
+
+void
+__gp::cholesky::save (std::string *out)
+{
+    put_num<uint32_t> (out, m_n);
+    put_vec (out, m_rows);
+}
+
+void
+__gp::cholesky::restore (const std::string &in, size_t *off)
+{
+    m_n = get_num<uint32_t> (in, off);
+    m_rows = get_vec<double> (in, off);
+    if (m_rows.size () != (size_t) m_n * (m_n + 1) / 2)
+        throw std::runtime_error ("malformed Cholesky factor");
+}
+
+void
+__gp::surrogate::save (std::string *out)
+{
+    put_num (out, m_best);
+    put_vec (out, m_argbest);
+}
+
+void
+__gp::surrogate::restore (const std::string &in, size_t *off)
+{
+    m_best = get_num<double> (in, off);
+    m_argbest = get_vec<double> (in, off);
+    if (m_argbest.size () != m_d)
+        throw std::runtime_error ("the saved model has other dimensions");
+}
+
+void
+__gp::model::save (std::string *out)
+{
+    surrogate::save (out);
+    put_vec (out, m_x);
+    put_vec (out, m_y);
+    m_chol.save (out);
+}
+
+void
+__gp::model::restore (const std::string &in, size_t *off)
+{
+    surrogate::restore (in, off);
+    m_x = get_vec<double> (in, off);
+    m_y = get_vec<double> (in, off);
+    m_chol.restore (in, off);
+    if (m_y.size () != m_chol.size () || m_x.size () != m_y.size () * m_d)
+        throw std::runtime_error ("malformed GP snapshot");
+    m_alpha_valid = false;
+}
+
+void
+__gp::sparse_model::save (std::string *out)
+{
+    surrogate::save (out);
+    put_num<uint32_t> (out, m_n);
+    put_num (out, m_sy);
+    put_num (out, m_syy);
+    m_exact.save (out);
+    put_vec (out, m_x0);
+    put_vec (out, m_y0);
+    put_vec (out, m_z);
+    m_lmm.save (out);
+    put_vec (out, m_b);
+    put_vec (out, m_cy);
+    put_vec (out, m_c1);
+}
+
+void
+__gp::sparse_model::restore (const std::string &in, size_t *off)
+{
+    surrogate::restore (in, off);
+    m_n = get_num<uint32_t> (in, off);
+    m_sy = get_num<double> (in, off);
+    m_syy = get_num<double> (in, off);
+    m_exact.restore (in, off);
+    m_x0 = get_vec<double> (in, off);
+    m_y0 = get_vec<double> (in, off);
+    m_z = get_vec<double> (in, off);
+    m_lmm.restore (in, off);
+    m_b = get_vec<double> (in, off);
+    m_cy = get_vec<double> (in, off);
+    m_c1 = get_vec<double> (in, off);
+    if (sparse () && (m_z.size () != (size_t) m_m * m_d ||
+                m_lmm.size () != m_m || m_b.size () != (size_t) m_m * m_m ||
+                m_cy.size () != m_m || m_c1.size () != m_m))
+        throw std::runtime_error ("malformed sparse GP snapshot");
+    m_valid = false;
+}
+
+void
+__gp::local_model::save (std::string *out)
+{
+    surrogate::save (out);
+    put_vec (out, m_x);
+    put_vec (out, m_y);
+}
+
+void
+__gp::local_model::restore (const std::string &in, size_t *off)
+{
+    surrogate::restore (in, off);
+    m_x = get_vec<double> (in, off);
+    m_y = get_vec<double> (in, off);
+    if (m_x.size () != m_y.size () * m_d)
+        throw std::runtime_error ("malformed local GP snapshot");
+    m_valid = false;
+}
+
+// GP optimiser ===============================================================
+
+static const char *
+mode_name (__gp::mode m)
+{
+    switch (m) {
+        case __gp::mode::sparse:
+            return "sparse gp optimiser";
+        case __gp::mode::local:
+            return "local gp optimiser";
+        default:
+            return "gp optimiser";
+    }
+}
+
+gp_opt::gp_opt (__gp::acquisition acq, __gp::mode m):
+    optk::optimiser (mode_name (m)), n_iters (0), m_space (NULL),
+    m_acq (acq), m_mode (m), m_model (NULL), m_design (NULL), m_tr (1), m_succ (0), m_fail (0)
 { }
 
+gp_opt::~gp_opt ()
+{
+    delete m_model;
+    delete m_design;
+}
+
 /**
  * Allows uniform, loguniform, normal and lognormal parameters; throws an
  * std::invalid_argument exception otherwise.
@@ -55,6 +617,233 @@ gp_opt::update_search_space (sspace::sspace_t *space)
         validate_param (*it);
 
     m_space = space;
+
+    // distances in the unit hypercube grow with the square root of the
+    // number of dimensions; scale the lengthscale to match.
+    u_int d = space->size ();
+    double ls = 0.25 * std::sqrt ((double) std::max (d, 1u));
+
+    // the sparse and local models condition on at most this many points
+    const u_int rank = 256;
+
+    delete m_model;
+    switch (m_mode) {
+        case __gp::mode::sparse:
+            m_model = new __gp::sparse_model (d, rank, ls, 1e-6);
+            break;
+        case __gp::mode::local:
+            m_model = new __gp::local_model (d, rank, ls, 1e-6);
+            break;
+        default:
+            m_model = new __gp::model (d, ls, 1e-6);
+    }
+    delete m_design;
+    m_design = new __qmc::generator (__qmc::sequence::sobol, d, m_rng);
+    n_iters = 0;
+    m_tr = m_mode == __gp::mode::local ? .8 : 1.;
+    m_succ = m_fail = 0;
+}
+
+double
+gp_opt::to_unit (u_int i, double v)
+{
+    sspace::param_t *p = m_space->at (i);
+    switch (p->get_type ()) {
+        case pt::uniform:
+        {
+            sspace::uniform *u = static_cast<sspace::uniform *>(p);
+            return (v - u->m_lower) / (u->m_upper - u->m_lower);
+        }
+        case pt::loguniform:
+        {
+            sspace::uniform *u = static_cast<sspace::uniform *>(p);
+            return (std::log (v) - std::log (u->m_lower)) /
+                (std::log (u->m_upper) - std::log (u->m_lower));
+        }
+        case pt::normal:
+        {
+            sspace::normal *n = static_cast<sspace::normal *>(p);
+            return (v - n->m_mu) / (6. * n->m_sigma) + .5;
+        }
+        case pt::lognormal:
+        {
+            sspace::normal *n = static_cast<sspace::normal *>(p);
+            return (std::log (v) - n->m_mu) / (6. * n->m_sigma) + .5;
+        }
+        default:
+            throw std::invalid_argument ("Unsupported parameter type in GP");
+    }
+}
+
+double
+gp_opt::from_unit (u_int i, double x)
+{
+    sspace::param_t *p = m_space->at (i);
+    switch (p->get_type ()) {
+        case pt::uniform:
+        {
+            sspace::uniform *u = static_cast<sspace::uniform *>(p);
+            double v = u->m_lower + x * (u->m_upper - u->m_lower);
+            return std::min (std::max (v, u->m_lower), u->m_upper);
+        }
+        case pt::loguniform:
+        {
+            sspace::uniform *u = static_cast<sspace::uniform *>(p);
+            double v = std::exp (std::log (u->m_lower) + x *
+                    (std::log (u->m_upper) - std::log (u->m_lower)));
+            return std::min (std::max (v, u->m_lower), u->m_upper);
+        }
+        case pt::normal:
+        {
+            sspace::normal *n = static_cast<sspace::normal *>(p);
+            return n->m_mu + n->m_sigma * (6. * x - 3.);
+        }
+        case pt::lognormal:
+        {
+            sspace::normal *n = static_cast<sspace::normal *>(p);
+            return std::exp (n->m_mu + n->m_sigma * (6. * x - 3.));
+        }
+        default:
+            throw std::invalid_argument ("Unsupported parameter type in GP");
+    }
+}
+
+u_int
+gp_opt::initial_design ()
+{
+    return std::min (std::max (m_model->dims () + 1, 2u), 10u);
+}
+
+void
+gp_opt::acquire (const double *xs, u_int m, double *out)
+{
+    m_mu.resize (m);
+    m_var.resize (m);
+    m_model->predict (xs, m, m_mu.data (), m_var.data ());
+
+    const double best = m_model->best ();
+    for (u_int j = 0; j < m; j++) {
+        double s = std::sqrt (m_var[j]);
+        if (m_acq == __gp::acquisition::ucb) {
+            out[j] = -(m_mu[j] - 2. * s);
+        } else {
+            double z = (best - m_mu[j]) / s;
+            double cdf = .5 * std::erfc (-z / M_SQRT2);
+            double pdf = std::exp (-.5 * z * z) / std::sqrt (2. * M_PI);
+            out[j] = (best - m_mu[j]) * cdf + s * pdf;
+        }
+    }
+}
+
+void
+gp_opt::maximise_acquisition (double *x)
+{
+    const u_int d = m_model->dims ();
+    const u_int n = m_model->rank ();
+    const u_int block = __gp::model::block;
+
+    // In local mode the search is restricted to the trust region around the
+    // incumbent; the other modes search the whole hypercube.
+    const double *inc = m_model->argbest ();
+    const bool local = m_mode == __gp::mode::local;
+    std::vector<double> lo (d, 0.), hi (d, 1.);
+    if (local)
+        for (u_int k = 0; k < d; k++) {
+            lo[k] = std::max (inc[k] - m_tr / 2, 0.);
+            hi[k] = std::min (inc[k] + m_tr / 2, 1.);
+        }
+    auto clamp = [&](double v, u_int k) {
+        return std::min (std::max (v, lo[k]), hi[k]);
+    };
+
+    // Bound the number of posterior evaluations so that the cost of a
+    // suggestion stays roughly constant as observations accumulate: each
+    // evaluation costs about n^2 / 2 for the solve plus n d for the kernel.
+    double cost = .5 * n * n + (double) n * d + 1.;
+    u_int budget = (u_int) std::min (1024., std::max (64., 1e8 / cost));
+
+    // Initial candidates: three quarters uniform samples, the rest small
+    // perturbations of the incumbent. The best few start the local search.
+    const u_int starts = 4, per_start = block / starts;
+    u_int ncand = std::max (block, (budget / 2) / block * block);
+    std::vector<double> cand ((size_t) ncand * d), acq (ncand);
+    for (u_int j = 0; j < ncand; j++)
+        for (u_int k = 0; k < d; k++)
+            cand[(size_t) j * d + k] = 4 * j < 3 * ncand ?
+                m_rng.uniform (lo[k], hi[k]) :
+                clamp (inc[k] + m_rng.normal (0, .05 * m_tr), k);
+    acquire (cand.data (), ncand, acq.data ());
+
+    std::vector<u_int> order (ncand);
+    std::iota (order.begin (), order.end (), 0);
+    std::partial_sort (order.begin (), order.begin () + starts, order.end (),
+            [&](u_int a, u_int b) { return acq[a] > acq[b]; });
+
+    std::vector<double> cur ((size_t) starts * d), cur_acq (starts),
+        step (starts, .1 * m_tr);
+    for (u_int s = 0; s < starts; s++) {
+        std::copy_n (cand.data () + (size_t) order[s] * d, d,
+                cur.data () + (size_t) s * d);
+        cur_acq[s] = acq[order[s]];
+    }
+
+    // Local refinement: each round draws a block of Gaussian perturbations
+    // around every start, moving to the best when it improves and halving
+    // the step size otherwise.
+    u_int rounds = std::max (2u, (budget - ncand) / block);
+    std::vector<double> trial ((size_t) block * d), trial_acq (block);
+    for (u_int r = 0; r < rounds; r++) {
+        for (u_int s = 0; s < starts; s++)
+            for (u_int t = 0; t < per_start; t++)
+                for (u_int k = 0; k < d; k++) {
+                    double v = cur[s * d + k] + m_rng.normal (0, step[s]);
+                    trial[(s * per_start + t) * d + k] = clamp (v, k);
+                }
+        acquire (trial.data (), block, trial_acq.data ());
+
+        for (u_int s = 0; s < starts; s++) {
+            u_int bt = s * per_start;
+            for (u_int t = bt + 1; t < (s + 1) * per_start; t++)
+                if (trial_acq[t] > trial_acq[bt])
+                    bt = t;
+            if (trial_acq[bt] > cur_acq[s]) {
+                cur_acq[s] = trial_acq[bt];
+                std::copy_n (trial.data () + (size_t) bt * d, d,
+                        cur.data () + (size_t) s * d);
+            } else {
+                step[s] *= .5;
+            }
+        }
+    }
+
+    u_int bs = std::max_element (cur_acq.begin (), cur_acq.end ()) -
+        cur_acq.begin ();
+    std::copy_n (cur.data () + (size_t) bs * d, d, x);
+}
+
+void
+gp_opt::update_trust_region (bool improved)
+{
+    // Following TuRBO: double the side length after a run of successes and
+    // halve it after as many failures as there are dimensions, starting
+    // over once it has collapsed.
+    if (improved) {
+        m_succ++;
+        m_fail = 0;
+    } else {
+        m_fail++;
+        m_succ = 0;
+    }
+
+    if (m_succ >= 3) {
+        m_tr = std::min (2 * m_tr, 1.);
+        m_succ = 0;
+    } else if (m_fail >= std::max (4u, m_model->dims ())) {
+        m_tr /= 2;
+        m_fail = 0;
+    }
+    if (m_tr < 1. / 128)
+        m_tr = .8;
 }
 
 inst::set
@@ -62,18 +851,96 @@ gp_opt::generate_parameters (int param_id)
 {
     inst::node *root = new inst::node ("gp parameters");
 
-    // TODO implement me
+    const u_int d = m_model->dims ();
+    std::vector<double> x (d);
+
+    // start with a few space-filling points; the GP takes over once it has
+    // seen enough observations to be informative.
+    if (n_iters++ < initial_design () || m_model->size () < 2) {
+        m_design->next_block (1, x.data ());
+    } else {
+        maximise_acquisition (x.data ());
+    }
+
+    for (u_int k = 0; k < d; k++)
+        root->add_item (new inst::dbl_val (
+                    m_space->at (k)->get_name (), from_unit (k, x[k])));
 
     add_to_trials (param_id, root);
 
     return root;
 }
 
+uint
+gp_opt::generate_batch (int first_id, uint k, std::vector<inst::set> *out)
+{
+    // Until the model holds two real observations its points come from the
+    // initial design, whatever it is told.
+    if (k < 2 || m_model->size () < 2)
+        return optimiser::generate_batch (first_id, k, out);
+
+    std::string snap;
+    m_model->save (&snap);
+
+    const u_int d = m_model->dims ();
+    std::vector<double> x (d);
+    for (uint i = 0; i < k; i++) {
+        inst::set params = generate_parameters (first_id + i);
+        out->push_back (params);
+        if (i + 1 == k)
+            break;
+        for (u_int j = 0; j < d; j++)
+            x[j] = to_unit (j, params->getdbl (m_space->at (j)->get_name ()));
+        m_model->add (x.data (), m_model->best ());
+    }
+
+    size_t off = 0;
+    m_model->restore (snap, &off);
+    return k;
+}
+
 void
 gp_opt::receive_trial_results (int pid, inst::set params, double value)
 {
+    if (std::isfinite (value)) {
+        const u_int d = m_model->dims ();
+        std::vector<double> x (d);
+        for (u_int k = 0; k < d; k++)
+            x[k] = to_unit (k, params->getdbl (m_space->at (k)->get_name ()));
+
+        double prev = m_model->best ();
+        m_model->add (x.data (), value);
+        if (m_mode == __gp::mode::local)
+            update_trust_region (value < prev - 1e-3 * std::abs (prev));
+    }
+
     free_node (params);
     trials.erase(pid);
     return;
 }
 
+bool
+gp_opt::save (std::string *out)
+{
+    put_num<uint32_t> (out, n_iters);
+    put_num (out, m_tr);
+    put_num<uint32_t> (out, m_succ);
+    put_num<uint32_t> (out, m_fail);
+    put_num (out, m_rng.state ());
+    m_design->save (out);
+    m_model->save (out);
+    return true;
+}
+
+void
+gp_opt::restore (const std::string &in)
+{
+    size_t off = 0;
+    n_iters = get_num<uint32_t> (in, &off);
+    m_tr = get_num<double> (in, &off);
+    m_succ = get_num<uint32_t> (in, &off);
+    m_fail = get_num<uint32_t> (in, &off);
+    m_rng.restore (get_num<optk::rng::state_t> (in, &off));
+    m_design->restore (in, &off);
+    m_model->restore (in, &off);
+}
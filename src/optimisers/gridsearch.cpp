@@ -21,6 +21,9 @@
 
 #include <optimisers/gridsearch.hpp>
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 /** This namespace contains types which are specific to the gridsearch
  * algorithm */
@@ -40,69 +43,95 @@ param::param (const std::string &k, pspace_t t) :
     m_key(k), m_type(t)
 {}
 
-/** Value contains lists of integers, doubles or strings. */
+/**
+ * Multiplies two cardinalities, saturating rather than overflowing; indices
+ * into a saturated grid still decode correctly, since any representable
+ * index is then smaller than the true cardinality.
+ */
+static uint64_t
+sat_mul (uint64_t a, uint64_t b)
+{
+    if (a != 0 && b > UINT64_MAX / a)
+        return UINT64_MAX;
+    return a * b;
+}
+
+/** Creates an instance of the appropriate type for a value. */
+static inst::param *
+make_inst (const std::string &k, int v) { return new inst::int_val (k, v); }
+
+static inst::param *
+make_inst (const std::string &k, double v) { return new inst::dbl_val (k, v); }
+
+static inst::param *
+make_inst (const std::string &k, const std::string &v)
+{
+    return new inst::str_val (k, v);
+}
+
+template <class T> static pspace_t type_of ();
+template <> pspace_t type_of<int> () { return pspace_t::int_val; }
+template <> pspace_t type_of<double> () { return pspace_t::dbl_val; }
+template <> pspace_t type_of<std::string> () { return pspace_t::str_val; }
+
+/** Value contains an explicit list of integers, doubles or strings, as given
+ * by a categorical parameter. */
 template <class T>
 class value: public param {
     public:
-        value (const std::string &k, pspace_t t) :
-            param (k, t)
-        {
-            m_values = std::vector<T>();
-            m_i = 0; m_max = m_values.size();
-        }
+        value (const std::string &k, const std::vector<T> &v) :
+            param (k, type_of<T> ()), m_values (v)
+        {}
 
-        value (const std::string &k, std::vector<int> v) :
-            param (k, pspace_t::int_val)
-        {
-            m_values = std::vector<int>(v);
-            m_i = 0; m_max = m_values.size();
-        }
+        std::vector<T> *get_vals() { return &m_values; }
+        T at(uint64_t i) { return m_values.at(i); }
 
-        value (const std::string &k, std::vector<double> v) :
-            param (k, pspace_t::dbl_val)
-        {
-            m_values = std::vector<double>(v);
-            m_i = 0; m_max = m_values.size();
-        }
+        /** Returns the cardinality of the set of values for this parmeter. */
+        uint64_t get_count () override { return m_values.size(); }
 
-        value (const std::string &k, std::vector<std::string> v) :
-            param (k, pspace_t::str_val)
+        inst::param *
+        instance (uint64_t i) override
         {
-            m_values = std::vector<std::string>(v);
-            m_i = 0; m_max = m_values.size();
+            return make_inst (get_key (), m_values[i]);
         }
 
-        std::vector<T> *get_vals() { return &m_values; }
-        T at(unsigned int i) { return m_values.at(i); }
-        T current() { return m_values.at((m_i-1+m_max)%m_max); }
-        void set(std::vector<T> vs) { m_values = vs; }
+    private:
+        std::vector<T> m_values;
+};
 
-        /** Returns the cardinality of the set of values for this parmeter. */
-        unsigned int
-        get_count ()
+/** Range describes the arithmetic sequence lower, lower + q, ... of the values
+ * strictly below an upper bound, without storing them. */
+template <class T>
+class range: public param {
+    public:
+        range (const std::string &k, T lower, T upper, T q) :
+            param (k, type_of<T> ()), m_lower (lower), m_q (q)
         {
-            return m_values.size();
+            m_count = 0;
+            if (upper > lower && q > 0) {
+                // start from the closed form, then correct any rounding so
+                // that exactly those values below the bound are included.
+                m_count = (uint64_t) std::ceil ((double) (upper - lower) / q);
+                while (m_count > 0 && at (m_count - 1) >= upper)
+                    m_count--;
+                while (at (m_count) < upper)
+                    m_count++;
+            }
         }
 
-        /**
-         * Next will iterate through the enumerated values for this parameter,
-         * and update the val parameter to be the next one along. If this is
-         * the first value in the set, then this function will return true,
-         * otherwise it will return false.
-         * @param val The value to be updated with the next parameter.
-         * @returns A boolean indicating whether the returned value was the
-         * first in the set. This occurs upon first invokation, as well as when
-         * 'wrapping around'.
-         */
-        bool next (T *val) {
-            *val = m_values.at(m_i);
-            m_i = (m_i + 1)%m_max;
-            return m_i == 1;
+        T at(uint64_t i) { return m_lower + (T) i * m_q; }
+
+        uint64_t get_count () override { return m_count; }
+
+        inst::param *
+        instance (uint64_t i) override
+        {
+            return make_inst (get_key (), at (i));
         }
 
     private:
-        std::vector<T> m_values;
-        unsigned int m_i, m_max;
+        const T m_lower, m_q;
+        uint64_t m_count;
 };
 
 /** A node contains the parameters for this 'level' of the search space,
@@ -120,8 +149,6 @@ class node: public param {
 
         /**
          * Add a parameter or subspace to this 'level' of the search space.
-         * Addition of parameters after the first call to generate_parameters
-         * results in undefined behaviour.
          * @param p The new parameter to add.
          */
         void add_item (param *p);
@@ -136,28 +163,26 @@ class node: public param {
         get_values ()
         { return &values; }
 
-        /**
-         * This creates a full copy of a node and all nested subspaces with the
-         * current values of local_params with memory allocated on the heap.
-         * This is used when iterating through values, and a subspace does not
-         * need to be updated.
-         */
-        inst::param * clone ();
+        /** The number of points in this subspace; the product of the
+         * cardinalities of its parameters and subspaces. */
+        uint64_t get_count () override { return m_count; }
+
+        inst::param *instance (uint64_t i) override;
 
         /**
-         * This will iterate through all the concrete parameters once, before
-         * calling step on each of the the elemnts in the nodes array.
-         * @param parent A pointer to the node instance to which to add
-         * parameter values.
-         * @param complete A pointer to a boolean value which will be set to
-         * true if all values have been iterated over for this node.
-         * @returns A pointer to a root node.
+         * Decodes the i-th point of this subspace into parent. The index is
+         * read as a mixed-radix number: the first parameter at this level is
+         * its least significant digit, followed by the remaining parameters
+         * and then, recursively, the subspaces.
+         *
+         * @param parent The node instance to which to add parameter values.
+         * @param i The index of the point, smaller than get_count ().
          */
-        inst::set step(inst::node *parent, bool *complete);
+        void fill (inst::node *parent, uint64_t i);
 
     private:
         /** A local list of all the values at this level of the search space;
-         * all param pointers in this array have type pspace_t::value. */
+         * all param pointers in this array have a value type. */
         params values;
 
         /** A local list of all the subspaces at this level in the search
@@ -165,252 +190,58 @@ class node: public param {
          * pspace_t::node. */
         subspaces nodes;
 
-        /** This is a vector of all the non-node parameter instances. */
-        std::vector<inst::param *> local_params;
-
-        // bool first_iter;
+        uint64_t m_count;
 };
 
 node::node (const std::string &k) :
-    param (k, pspace_t::node)
-{
-    nodes = subspaces();
-    values = params();
-    // first_iter = true;
-}
+    param (k, pspace_t::node), m_count (1)
+{ }
 
 node::~node ()
 {
-    subspaces::iterator it;
-    for (it = nodes.begin(); it != nodes.end(); it++) {
-        delete std::get<1>(*it);
-    }
-
-    for (unsigned int i = 0; i < values.size(); i++) {
-        param *tmpv = std::get<1>(values.at(i));
-        inst::param *tmp_inst = local_params.at(i);
-        pspace_t t = tmpv->get_type();
-        switch (t) {
-            case pspace_t::int_val:
-            {
-                value<int> *iv = static_cast<value<int> *>(tmpv);
-                inst::int_val *iiv =
-                    static_cast<inst::int_val *>(tmp_inst);
-                delete iv; delete iiv;
-                break;
-            }
-            case pspace_t::dbl_val:
-            {
-                value<double> *dv = static_cast<value<double> *>(tmpv);
-                inst::dbl_val *idv =
-                    static_cast<inst::dbl_val *>(tmp_inst);
-                delete dv; delete idv;
-                break;
-            }
-            case pspace_t::str_val:
-            {
-                value<std::string> *sv =
-                    static_cast<value<std::string> *>(tmpv);
-                inst::str_val *isv =
-                    static_cast<inst::str_val *>(tmp_inst);
-                delete sv; delete isv;
-                break;
-            }
-            default:
-                break;
-        }
-    }
+    for (unsigned int i = 0; i < nodes.size(); i++)
+        delete std::get<1>(nodes.at(i));
+    for (unsigned int i = 0; i < values.size(); i++)
+        delete std::get<1>(values.at(i));
 }
 
 void
 node::add_item (param *p)
 {
-    pspace_t t = p->get_type ();
-    switch (t) {
-        case pspace_t::node:
-        {
-            node *tmp_node = static_cast<node *>(p);
-            nodes.push_back({p->get_key(), tmp_node});
-            break;
-        }
-        case pspace_t::int_val:
-        {
-            values.push_back ({p->get_key (), p});
-            local_params.push_back(new inst::int_val(p->get_key(), 0));
-            break;
-        }
-        case pspace_t::dbl_val:
-        {
-            values.push_back ({p->get_key (), p});
-            local_params.push_back(new inst::dbl_val(p->get_key(),0));
-            break;
-        }
-        case pspace_t::str_val:
-        {
-            values.push_back ({p->get_key (), p});
-            local_params.push_back(new inst::str_val(p->get_key(), ""));
-            break;
-        }
-    }
+    if (p->get_type () == pspace_t::node)
+        nodes.push_back({p->get_key(), static_cast<node *>(p)});
+    else
+        values.push_back ({p->get_key (), p});
+    m_count = sat_mul (m_count, p->get_count ());
 }
 
 inst::param *
-node::clone ()
-{
-    inst::node *parent = new inst::node(this->get_key());
-
-    for (unsigned int i = 0; i < values.size(); i++) {
-        param *p = std::get<1>(values.at(i));
-        pspace_t t = p->get_type();
-        switch (t) {
-            case pspace_t::int_val:
-            {
-                value<int> *tmp_int = static_cast<value<int> *>(p);
-                parent->add_item (
-                        new inst::int_val (p->get_key(), tmp_int->current())
-                        );
-                break;
-            }
-            case pspace_t::dbl_val:
-            {
-                value<double> *tmp_dbl = static_cast<value<double> *>(p);
-                parent->add_item (
-                        new inst::dbl_val (p->get_key(), tmp_dbl->current())
-                        );
-                break;
-            }
-            case pspace_t::str_val:
-            {
-                value<std::string> *tmp_str =
-                    static_cast<value<std::string> *>(p);
-                parent->add_item (
-                        new inst::str_val (p->get_key(), tmp_str->current())
-                        );
-                break;
-            }
-            default:
-                break;
-        }
-    }
-
-    for (unsigned int i = 0; i < nodes.size(); i++)
-        parent->add_item (std::get<1>(nodes.at(i))->clone());
-
-    return parent;
+node::instance (uint64_t i)
+{
+    inst::node *n = new inst::node (get_key ());
+    fill (n, i);
+    return n;
 }
 
-/**
- * This is a local method called from the __gs::node::step function which
- * iterates through the parameters at this point in the search space.
- * @param cont A boolean used to indicate whether the next value should be
- * incremented or simply copied.
- * @param parent The parent node instance to which the parameter instances
- * are added.
- * @param values The description of the parameters at this level of the search
- * space.
- * @param local_params Concrete instances of the parameters at this level of
- * the search space.
- */
-static void
-iterate_local_params (
-        bool *cont,
-        inst::node *parent,
-        params *values,
-        std::vector<inst::param *> *local_params
-) {
-    unsigned int i, max = values->size();
-    for (i = 0; i < max; i++) {
-        param *p = std::get<1>(values->at(i));
-        pspace_t t = p->get_type();
-        switch (t) {
-            case pspace_t::int_val:
-            {
-                value<int> *tmp_int = static_cast<value<int> *>(p);
-                inst::int_val *iinst =
-                    static_cast<inst::int_val *>(local_params->at(i));
-                if (*cont)
-                    *cont = tmp_int->next (iinst->get_addr());
-                parent->add_item (
-                        new inst::int_val (p->get_key(), iinst->get_val())
-                        );
-                break;
-            }
-            case pspace_t::dbl_val:
-            {
-                value<double> *tmp_dbl =
-                    static_cast<value<double> *>(p);
-                inst::dbl_val *dinst =
-                    static_cast<inst::dbl_val *>(local_params->at(i));
-                if (*cont)
-                    *cont = tmp_dbl->next (dinst->get_addr ());
-                parent->add_item (
-                        new inst::dbl_val (p->get_key(), dinst->get_val())
-                        );
-                break;
-            }
-            case pspace_t::str_val:
-            {
-                value<std::string> *tmp_str =
-                    static_cast<value<std::string> *>(p);
-                inst::str_val *sinst =
-                    static_cast<inst::str_val *>(local_params->at(i));
-                if (*cont)
-                    *cont = tmp_str->next (sinst->get_addr ());
-                parent->add_item (
-                        new inst::str_val (p->get_key(), sinst->get_val())
-                        );
-                break;
-            }
-            // This default should never happen, if it did, we wouldn't
-            // care because everything else would be broken:
-            default:
-                break;
-        }
+void
+node::fill (inst::node *parent, uint64_t i)
+{
+    // To do depth-first search, rather than breadth-first search, just swap
+    // the order of the following two loops.
+    for (unsigned int j = 0; j < values.size(); j++) {
+        param *p = std::get<1>(values[j]);
+        uint64_t c = p->get_count ();
+        parent->add_item (p->instance (i % c));
+        i /= c;
     }
-}
-
-/**
- * This function is also called from __gs::node::step. If it is called before
- * iterate_local_params, then a depth-first search is realised, otherwise
- * gridsearch performs a breadth-first search.
- * @param cont A boolean indicating whether or not the next searchspace along
- * in the list should be updated.
- * @param parent The node instance to which to add the instances of each node
- * at this level in the search space.
- * @param nodes The list of nodes registered at this level of the search space.
- */
-static void
-iterate_subspaces (bool *cont, inst::node *parent, subspaces *nodes)
-{
-    // Generate the subspace values; either clones of previous, or updated.
-    unsigned int j, ss_max;
-    ss_max = nodes->size();
-    for (j = 0; j < ss_max; j++) {
-        node *tmp_node = std::get<1>(nodes->at(j));
-        if (*cont) {
-            inst::node *new_node = new inst::node (tmp_node->get_key());
-            parent->add_item (tmp_node->step(new_node, cont));
-        } else {
-            parent->add_item (tmp_node->clone());
-        }
+    for (unsigned int j = 0; j < nodes.size(); j++) {
+        node *n = std::get<1>(nodes[j]);
+        uint64_t c = n->get_count ();
+        parent->add_item (n->instance (i % c));
+        i /= c;
     }
 }
 
-inst::set
-node::step(inst::node *parent, bool *complete)
-{
-    bool cont = true;
-
-    // To do depth-first search, rather than breadth-firse search, just swap
-    // the order of the following two function calls, no problemo.
-    iterate_local_params(&cont, parent, &values, &local_params);
-    iterate_subspaces (&cont, parent, &nodes);
-
-    *complete = cont;
-
-    return parent;
-}
-
 } // namespace __gs
 
 // Actual gridsearch class methods ============================================
@@ -423,16 +254,15 @@ unpack_categorical (sspace::param_t *param, __gs::node *parent)
 {
     sspace::categorical<T> *cat =
         static_cast<sspace::categorical<T> *>(param);
-    std::string name = cat->get_name ();
-    std::vector<T> values = *cat->values ();
-    __gs::param *tmp_val = new __gs::value<T>(name, values);
+    __gs::param *tmp_val = new __gs::value<T>(cat->get_name (), *cat->values ());
     parent->add_item (tmp_val);
 }
 
 /**
  * This function will 'unpack' a parameter in the search space definition,
- * enumerating all its values if it is a concerete parameter, or recursively
- * unpacking nested / conditional parameters.
+ * describing the values it takes if it is a concerete parameter, or
+ * recursively unpacking nested / conditional parameters. Integer and
+ * quantised ranges are not enumerated.
  * @param param The parameter description to 'unpack'
  * @param parent The parameter space node in which to store the resulting
  * unpacked value.
@@ -455,25 +285,16 @@ unpack_param (sspace::param_t *param, __gs::node *parent)
         case pt::randint:
         {
             sspace::randint *ri = static_cast<sspace::randint *>(param);
-            std::string name = ri->get_name ();
-            std::vector<int> values;
-
-            for (int i = ri->m_lower; i < ri->m_upper; i++) {
-                values.push_back (i);
-            }
-
-            __gs::param *tmp_val = new __gs::value<int>(name, values);
+            __gs::param *tmp_val = new __gs::range<int>(
+                    ri->get_name (), ri->m_lower, ri->m_upper, 1);
             parent->add_item (tmp_val);
             break;
         }
         case pt::quniform:
         {
             sspace::quniform *qu = static_cast<sspace::quniform *>(param);
-            std::string name = qu->get_name ();
-            std::vector<double> values;
-            for (double i = qu->m_lower; i < qu->m_upper; i+=qu->m_q)
-                values.push_back (i);
-            __gs::param *tmp_val = new __gs::value<double>(name, values);
+            __gs::param *tmp_val = new __gs::range<double>(
+                    qu->get_name (), qu->m_lower, qu->m_upper, qu->m_q);
             parent->add_item (tmp_val);
             break;
         }
@@ -496,14 +317,16 @@ unpack_param (sspace::param_t *param, __gs::node *parent)
         {
             sspace::choice *c = static_cast <sspace::choice *>(param);
 
-            // instantiate a new node on the heap
+            // instantiate a new node on the heap; it is added to its parent
+            // once complete, so that the parent's cardinality is correct.
             __gs::node *nspace = new __gs::node (c->get_name ());
-            parent->add_item (nspace);
 
             sspace::sspace_t *subspace = c->options ();
             sspace::sspace_t::iterator it;
             for (it = subspace->begin (); it != subspace->end (); it++)
                 unpack_param(*it, nspace);
+
+            parent->add_item (nspace);
             break;
         }
         default:
@@ -517,7 +340,12 @@ gridsearch::gridsearch () :
     optimiser ("gridsearch")
 {
     m_root = NULL;
-    fst_gen = true;
+    m_shard = 0;
+    m_nshards = 1;
+    m_order = __gs::order::contiguous;
+    m_q = 0.05;
+    m_first = m_stride = m_mult = 1;
+    m_next = m_end = 0;
 }
 
 gridsearch::~gridsearch ()
@@ -533,6 +361,16 @@ gridsearch::~gridsearch ()
     }
 }
 
+optk::optimiser *
+gridsearch::clone ()
+{
+    gridsearch *gs = new gridsearch ();
+    gs->set_shard (m_shard, m_nshards);
+    gs->set_order (m_order);
+    gs->set_quantisation (m_q);
+    return gs;
+}
+
 void
 gridsearch::clear ()
 {
@@ -542,7 +380,7 @@ gridsearch::clear ()
     optk::optimiser::clear();
 
     m_root = NULL;
-    fst_gen = true;
+    m_next = m_end = 0;
 }
 
 static bool
@@ -578,7 +416,7 @@ gridsearch::update_search_space (sspace::sspace_t *space)
     if (!validate_space (space)) {
         // attempt to unpack search space for compatability with gridsearch
         // (usually occurs with synthetic benchmark)
-        sspace::sspace_t *newspace = convert_synthetic_ss(space, 0.05);
+        sspace::sspace_t *newspace = convert_synthetic_ss(space, m_q);
 
         if (!validate_space (newspace))
             throw std::invalid_argument ("search space not compatible with gridsearch");
@@ -592,6 +430,116 @@ gridsearch::update_search_space (sspace::sspace_t *space)
     }
 
     m_root = new_root;
+    configure_traversal ();
+}
+
+uint64_t
+gridsearch::size ()
+{
+    return m_root ? m_root->get_count () : 0;
+}
+
+static uint64_t
+gcd (uint64_t a, uint64_t b)
+{
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void
+gridsearch::configure_traversal ()
+{
+    uint64_t n = size ();
+
+    if (m_order == __gs::order::contiguous) {
+        // the shard boundaries are floor (k n / N), computed without
+        // overflowing for large grids
+        auto bound = [&](uint64_t k) {
+            return (uint64_t) ((unsigned __int128) n * k / m_nshards);
+        };
+        m_first = bound (m_shard);
+        m_stride = 1;
+        m_end = bound (m_shard + 1) - m_first;
+    } else {
+        m_first = m_shard;
+        m_stride = m_nshards;
+        m_end = n > m_shard ? (n - m_shard - 1) / m_nshards + 1 : 0;
+    }
+
+    // The golden order visits i * g mod n, for the g coprime to n that is
+    // closest to n / phi above; consecutive points are then spread evenly
+    // over the index space, and so over the most significant parameters.
+    m_mult = 1;
+    if (m_order == __gs::order::golden && n > 2) {
+        m_mult = (uint64_t) ((double) n * 0.6180339887498949);
+        while (gcd (m_mult, n) != 1)
+            m_mult++;
+    }
+
+    m_next = 0;
+}
+
+uint64_t
+gridsearch::index (uint64_t j)
+{
+    uint64_t p = m_first + j * m_stride;
+    if (m_mult == 1)
+        return p;
+    return (uint64_t) ((unsigned __int128) p * m_mult % size ());
+}
+
+void
+gridsearch::set_shard (uint64_t k, uint64_t n)
+{
+    if (n == 0 || k >= n)
+        throw std::invalid_argument ("invalid shard; expected k < n");
+    m_shard = k;
+    m_nshards = n;
+    configure_traversal ();
+}
+
+void
+gridsearch::set_order (__gs::order o)
+{
+    m_order = o;
+    configure_traversal ();
+}
+
+void
+gridsearch::set_quantisation (double q)
+{
+    if (!(q > 0))
+        throw std::invalid_argument ("grid quantisation must be positive");
+    m_q = q;
+}
+
+uint64_t
+gridsearch::shard_size ()
+{
+    return m_end;
+}
+
+void
+gridsearch::set_range (uint64_t begin, uint64_t end)
+{
+    configure_traversal ();
+    m_end = std::min (end, m_end);
+    m_next = std::min (begin, m_end);
+}
+
+inst::set
+gridsearch::point (uint64_t i)
+{
+    if (i >= size ())
+        throw std::out_of_range ("grid index out of range");
+
+    inst::node *root = new inst::node("gridsearch parameters");
+    static_cast<__gs::node *>(m_root)->fill (root, i);
+    return root;
 }
 
 sspace::sspace_t *
@@ -627,22 +575,10 @@ gridsearch::update_search_space_s (sspace::sspace_t *space, double q=0.2)
 inst::set
 gridsearch::generate_parameters (int param_id)
 {
-    inst::node *root = new inst::node("gridsearch parameters");
-
-    __gs::node *r_node = static_cast<__gs::node *>(m_root);
-
-    bool complete;
-    r_node->step(root, &complete);
-
-    if (complete) {
-        if (fst_gen) {
-            fst_gen = false;
-        } else {
-            free_node(root);
-            return NULL;
-        }
-    }
+    if (m_next >= m_end)
+        return NULL;
 
+    inst::set root = point (index (m_next++));
     add_to_trials (param_id, root);
     return root;
 }
@@ -659,6 +595,8 @@ gridsearch::receive_trial_results (int pid, inst::set params, double value)
 
 #ifdef __OPTK_TESTING
 
+#include <benchmarks/synthetic.hpp>
+
 void
 test_update_search_space ()
 {
@@ -700,9 +638,10 @@ test_update_search_space ()
 
     std::tuple<std::string, __gs::param *> p_tri = ps->at (0);
     assert (std::get<0> (p_tri) == std::string ("testrandint"));
-    __gs::value<int> *pv_tri =
-        static_cast<__gs::value<int> *>(std::get<1> (p_tri));
+    __gs::range<int> *pv_tri =
+        static_cast<__gs::range<int> *>(std::get<1> (p_tri));
     assert (pv_tri->get_type () == __gs::pspace_t::int_val);
+    assert (pv_tri->get_count () == 10);
     for (int i = 0; i < 10; i++)
         assert (pv_tri->at (i) == i);
 
@@ -710,10 +649,11 @@ test_update_search_space ()
 
     std::tuple<std::string, __gs::param *> p_tqu = ps->at (1);
     assert (std::get<0> (p_tqu) == std::string("testquniform"));
-    __gs::value<double> *pv_tqu =
-        static_cast<__gs::value<double> *>(std::get<1> (p_tqu));
+    __gs::range<double> *pv_tqu =
+        static_cast<__gs::range<double> *>(std::get<1> (p_tqu));
     assert (pv_tqu->get_type () == __gs::pspace_t::dbl_val);
     assert (pv_tqu->get_key () == "testquniform");
+    assert (pv_tqu->get_count () == 4);
     for (int i = 0; i < 4; i++)
         assert (tutils::dbleq (pv_tqu->at (i), i * 2.5));
 
@@ -771,6 +711,70 @@ test_update_search_space ()
         assert (std::get<1>(vals->at(i))->get_key() == ns[i]);
         assert (std::get<1>(vals->at(i))->get_type() == ts[i]);
     }
+
+    // the grid is the product of the cardinalities
+    assert (fst_node->get_count () == 5 * 5 * 6 * 5 * 3);
+    assert (test.size () == 10 * 4 * 6 * 5 * 3 * fst_node->get_count ());
+}
+
+static void
+test_random_access ()
+{
+    sspace::randint first ("first", 0, 3);
+    sspace::quniform second ("second", 0, 1, 0.1);
+    std::vector<std::string> str_opts = {"a", "b"};
+    sspace::categorical<std::string> third ("third", &str_opts);
+    sspace::sspace_t options ({&third});
+    sspace::choice sub ("subspace", &options);
+    sspace::sspace_t testspace ({&first, &second, &sub});
+
+    gridsearch test = gridsearch ();
+    test.update_search_space (&testspace);
+    assert (test.size () == 3 * 10 * 2);
+
+    // any point may be decoded, and matches its position in the enumeration
+    for (uint64_t i = 0; i < test.size (); i++) {
+        inst::set p = test.point (test.size () - 1 - i);
+        inst::set q = test.generate_parameters (i);
+        GETINT(a, q, "first");
+        GETDBL(b, q, "second");
+        GETNODE(ss, q, "subspace");
+        GETSTR(c, ss, "third");
+        uint64_t j = i;
+        assert (a->get_val () == (int) (j % 3)); j /= 3;
+        assert (tutils::dbleq (b->get_val (), (j % 10) * 0.1)); j /= 10;
+        assert (c->get_val () == str_opts[j]);
+        free_node (p);
+        test.receive_trial_results (i, q, 0.);
+    }
+    assert (test.generate_parameters (60) == NULL);
+
+    bool thrown = false;
+    try {
+        test.point (test.size ());
+    } catch (const std::out_of_range &e) {
+        thrown = true;
+    }
+    assert (thrown);
+
+    // enumerating a sub-range
+    test.update_search_space (&testspace);
+    test.set_range (10, 13);
+    for (int i = 0; i < 3; i++) {
+        inst::set q = test.generate_parameters (i);
+        GETINT(a, q, "first");
+        assert (a->get_val () == (10 + i) % 3);
+        test.receive_trial_results (i, q, 0.);
+    }
+    assert (test.generate_parameters (3) == NULL);
+
+    // grids too large to count saturate, but can still be enumerated
+    syn::ackley1 big (40);
+    test.update_search_space_s (big.get_search_space (), 0.5);
+    assert (test.size () == UINT64_MAX);
+    inst::set q = test.generate_parameters (0);
+    assert (q->getdbl (0) == -35.);
+    test.receive_trial_results (0, q, 0.);
 }
 
 static void
@@ -849,11 +853,96 @@ test_generate_parameters ()
     assert (testspace_2.generate_parameters (65611) == NULL);
 }
 
+static void
+test_sharding ()
+{
+    sspace::randint first ("first", 0, 3);
+    sspace::quniform second ("second", 0, 1, 0.1);
+    std::vector<std::string> str_opts = {"a", "b"};
+    sspace::categorical<std::string> third ("third", &str_opts);
+    sspace::sspace_t testspace ({&first, &second, &third});
+
+    // recovers the grid index from a point
+    auto index_of = [&](inst::set p) {
+        GETINT(a, p, "first");
+        GETDBL(b, p, "second");
+        GETSTR(c, p, "third");
+        return a->get_val () + 3 * (int) std::round (b->get_val () * 10) +
+            30 * (c->get_val () == "b");
+    };
+
+    __gs::order orders[3] = {
+        __gs::order::contiguous, __gs::order::strided, __gs::order::golden
+    };
+    for (int o = 0; o < 3; o++) {
+        std::vector<int> seen (60, 0);
+        for (uint64_t k = 0; k < 7; k++) {
+            gridsearch proto = gridsearch ();
+            proto.set_shard (k, 7);
+            proto.set_order (orders[o]);
+
+            // the shard, and order, are kept by clones
+            optk::optimiser *opt = proto.clone ();
+            gridsearch *test = static_cast<gridsearch *>(opt);
+            test->update_search_space (&testspace);
+            assert (test->shard_size () == 60 / 7 ||
+                    test->shard_size () == 60 / 7 + 1);
+
+            int i = 0;
+            inst::set p;
+            while ((p = test->generate_parameters (i)) != NULL) {
+                int idx = index_of (p);
+                if (orders[o] == __gs::order::strided)
+                    assert (idx == (int) k + 7 * i);
+                seen[idx]++;
+                test->receive_trial_results (i++, p, 0.);
+            }
+            assert (i == (int) test->shard_size ());
+            delete opt;
+        }
+
+        // the shards partition the grid
+        for (int i = 0; i < 60; i++)
+            assert (seen[i] == 1);
+    }
+
+    // the golden order spreads a prefix of the traversal over the grid
+    gridsearch test = gridsearch ();
+    test.set_order (__gs::order::golden);
+    test.update_search_space (&testspace);
+    std::vector<int> idx;
+    for (int i = 0; i < 4; i++) {
+        inst::set p = test.generate_parameters (i);
+        idx.push_back (index_of (p));
+        test.receive_trial_results (i, p, 0.);
+    }
+    std::sort (idx.begin (), idx.end ());
+    for (int i = 1; i < 4; i++)
+        assert (idx[i] - idx[i - 1] >= 10);
+
+    bool thrown = false;
+    try {
+        test.set_shard (3, 3);
+    } catch (const std::invalid_argument &e) {
+        thrown = true;
+    }
+    assert (thrown);
+
+    // the quantisation of continuous spaces
+    syn::ackley1 a (2);
+    test.set_order (__gs::order::contiguous);
+    test.set_quantisation (7);
+    test.update_search_space (a.get_search_space ());
+    assert (test.size () == 100);
+}
+
 void
 run_static_gridsearch_tests ()
 {
     test_update_search_space ();
     test_generate_parameters ();
+    test_random_access ();
+    test_sharding ();
 }
 
 #endif // __OPTK_TESTING
@@ -0,0 +1,327 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief This file implements quasi-random (Sobol, Halton and Latin
+ * hypercube) sampling of the search space.
+ */
+
+#include <optimisers/qmc.hpp>
+#include <optk/net.hpp>
+
+namespace __qmc {
+
+/** The Joe-Kuo initial direction numbers for dimensions 2 to 16. */
+static const uint32_t jk_m[15][6] = {
+    {1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3}, {1, 3, 5, 13},
+    {1, 1, 5, 5, 17}, {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}, {1, 1, 5, 1, 1},
+    {1, 1, 1, 3, 11}, {1, 3, 5, 5, 31}, {1, 3, 3, 9, 7, 49},
+    {1, 1, 1, 15, 21, 21}, {1, 3, 1, 13, 27, 49}
+};
+
+/**
+ * Multiplies two polynomials over GF(2), modulo p of degree s.
+ */
+static uint64_t
+gf2_mulmod (uint64_t a, uint64_t b, uint64_t p, u_int s)
+{
+    uint64_t r = 0;
+    for (; b; b >>= 1) {
+        if (b & 1)
+            r ^= a;
+        a <<= 1;
+        if (a >> s & 1)
+            a ^= p;
+    }
+    return r;
+}
+
+static uint64_t
+gf2_powmod (uint64_t e, uint64_t p, u_int s)
+{
+    uint64_t r = 1, b = s > 1 ? 2 : 2 ^ p;
+    for (; e; e >>= 1) {
+        if (e & 1)
+            r = gf2_mulmod (r, b, p, s);
+        b = gf2_mulmod (b, b, p, s);
+    }
+    return r;
+}
+
+/**
+ * A polynomial of degree s is primitive iff x has multiplicative order
+ * exactly 2^s - 1 modulo it.
+ */
+static bool
+primitive (uint64_t p, u_int s)
+{
+    uint64_t order = (1ull << s) - 1;
+    if (gf2_powmod (order, p, s) != 1)
+        return false;
+    uint64_t n = order;
+    for (uint64_t q = 2; q * q <= n; q++) {
+        if (n % q)
+            continue;
+        if (gf2_powmod (order / q, p, s) == 1)
+            return false;
+        while (n % q == 0)
+            n /= q;
+    }
+    return n == 1 || gf2_powmod (order / n, p, s) != 1;
+}
+
+generator::generator (sequence s, u_int d, optk::rng &r):
+    m_seq (s), m_d (d), m_index (0), m_rng (r ())
+{
+    if (s == sequence::sobol)
+        sobol_init (r);
+    else if (s == sequence::halton)
+        halton_init (r);
+}
+
+void
+generator::sobol_init (optk::rng &r)
+{
+    // unscrambled direction numbers, v[k] holding the (k+1)th binary digit
+    std::vector<uint32_t> v (32 * m_d);
+    optk::rng fixed (0x50b01);
+    uint64_t p = 1;
+    u_int deg = 0;
+
+    for (u_int j = 0; j < m_d; j++) {
+        uint32_t *vj = v.data () + 32 * j;
+        if (j == 0) {
+            for (u_int k = 0; k < 32; k++)
+                vj[k] = 1u << (31 - k);
+            continue;
+        }
+
+        // the next primitive polynomial, in order of degree then value
+        do {
+            p += 2;
+            if (p >> (deg + 1)) {
+                deg++;
+                p = (1ull << deg) | 1;
+            }
+        } while (!primitive (p, deg));
+
+        const u_int s = deg;
+        const uint64_t a = (p >> 1) & ((1ull << (s - 1)) - 1);
+        for (u_int k = 0; k < s && k < 32; k++) {
+            uint32_t m = j <= 15 ? jk_m[j - 1][k] :
+                (uint32_t) (fixed () & ((1ull << (k + 1)) - 1)) | 1;
+            vj[k] = m << (31 - k);
+        }
+        for (u_int k = s; k < 32; k++) {
+            vj[k] = vj[k - s] ^ (vj[k - s] >> s);
+            for (u_int l = 1; l < s; l++)
+                if ((a >> (s - 1 - l)) & 1)
+                    vj[k] ^= vj[k - l];
+        }
+    }
+
+    // Random linear matrix scramble: each output digit is the input digit
+    // plus a random combination of the more significant ones.
+    m_v.resize (32 * m_d);
+    m_x.assign (m_d, 0);
+    m_shift.resize (m_d);
+    for (u_int j = 0; j < m_d; j++) {
+        uint32_t rows[32];
+        for (u_int b = 0; b < 32; b++) {
+            uint32_t bit = 1u << (31 - b);
+            uint32_t above = ~(bit | (bit - 1));
+            rows[b] = bit | ((uint32_t) r () & above);
+        }
+        for (u_int k = 0; k < 32; k++) {
+            uint32_t in = v[32 * j + k], out = 0;
+            for (u_int b = 0; b < 32; b++)
+                out |= (uint32_t) __builtin_parity (rows[b] & in) << (31 - b);
+            m_v[32 * j + k] = out;
+        }
+        m_shift[j] = (uint32_t) r ();
+    }
+}
+
+void
+generator::halton_init (optk::rng &r)
+{
+    u_int p = 2;
+    while (m_bases.size () < m_d) {
+        bool prime = true;
+        for (u_int q = 2; q * q <= p && prime; q++)
+            prime = p % q;
+        if (prime)
+            m_bases.push_back (p);
+        p++;
+    }
+
+    // One permutation of the digits per base, fixing 0 so that the
+    // representation of each index stays finite.
+    for (u_int j = 0; j < m_d; j++) {
+        u_int b = m_bases[j];
+        m_poff.push_back (m_perm.size ());
+        for (u_int i = 0; i < b; i++)
+            m_perm.push_back (i);
+        uint16_t *perm = m_perm.data () + m_poff.back ();
+        for (u_int i = b - 1; i > 1; i--)
+            std::swap (perm[i], perm[r.uniform_int (1, i)]);
+    }
+    m_index = 1;
+}
+
+void
+generator::next_block (u_int n, double *out)
+{
+    switch (m_seq) {
+        case sequence::sobol:
+            for (u_int i = 0; i < n; i++, m_index++) {
+                if (m_index) {
+                    u_int c = __builtin_ctzll (m_index);
+                    c = c < 32 ? c : 31;
+                    for (u_int j = 0; j < m_d; j++)
+                        m_x[j] ^= m_v[32 * j + c];
+                }
+                for (u_int j = 0; j < m_d; j++)
+                    out[i * m_d + j] = (m_x[j] ^ m_shift[j]) * 0x1.0p-32;
+            }
+            break;
+        case sequence::halton:
+            for (u_int i = 0; i < n; i++, m_index++) {
+                for (u_int j = 0; j < m_d; j++) {
+                    const u_int b = m_bases[j];
+                    const uint16_t *perm = m_perm.data () + m_poff[j];
+                    const double ib = 1. / b;
+                    double u = 0, f = ib;
+                    for (uint64_t k = m_index; k; k /= b, f *= ib)
+                        u += perm[k % b] * f;
+                    out[i * m_d + j] = u;
+                }
+            }
+            break;
+        case sequence::lhs:
+            m_strata.resize (n);
+            for (u_int j = 0; j < m_d; j++) {
+                for (u_int i = 0; i < n; i++)
+                    m_strata[i] = i;
+                for (u_int i = n - 1; i > 0; i--)
+                    std::swap (m_strata[i], m_strata[m_rng.uniform_int (0, i)]);
+                for (u_int i = 0; i < n; i++)
+                    out[i * m_d + j] = (m_strata[i] + m_rng.uniform ()) / n;
+            }
+            m_index += n;
+            break;
+    }
+}
+
+void
+generator::save (std::string *out)
+{
+    optk::net::put_num<uint64_t> (out, m_index);
+    optk::net::put_vec (out, m_x);
+    optk::net::put_num (out, m_rng.state ());
+}
+
+void
+generator::restore (const std::string &in, size_t *off)
+{
+    m_index = optk::net::get_num<uint64_t> (in, off);
+    std::vector<uint32_t> x = optk::net::get_vec<uint32_t> (in, off);
+    if (x.size () != m_x.size ())
+        throw std::runtime_error ("the saved sequence does not match");
+    m_x = x;
+    m_rng.restore (optk::net::get_num<optk::rng::state_t> (in, off));
+}
+
+} // end namespace __qmc
+
+static const char *
+seq_name (__qmc::sequence s)
+{
+    switch (s) {
+        case __qmc::sequence::halton:
+            return "halton search optimiser";
+        case __qmc::sequence::lhs:
+            return "lhs search optimiser";
+        default:
+            return "sobol search optimiser";
+    }
+}
+
+qmc_search::qmc_search (__qmc::sequence s, u_int block):
+    optk::optimiser (seq_name (s)),
+    m_seq (s), m_block (block ? block : 1), m_gen (NULL),
+    m_next (0)
+{ }
+
+qmc_search::~qmc_search ()
+{
+    delete m_gen;
+}
+
+void
+qmc_search::update_search_space (sspace::sspace_t *space)
+{
+    m_space.compile (space);
+    delete m_gen;
+    m_gen = new __qmc::generator (m_seq, m_space.dims (), m_rng);
+    m_points.resize ((size_t) m_block * m_gen->dims ());
+    m_next = m_block;
+}
+
+inst::set
+qmc_search::generate_parameters (int param_id)
+{
+    if (m_next == m_block) {
+        m_gen->next_block (m_block, m_points.data ());
+        m_next = 0;
+    }
+
+    inst::node *root = new inst::node ("qmc parameters");
+    const double *u = m_points.data () + (size_t) m_next++ * m_gen->dims ();
+    m_space.map (root, u);
+
+    add_to_trials (param_id, root);
+
+    return root;
+}
+
+void
+qmc_search::receive_trial_results (int pid, inst::set params, double value)
+{
+    free_node (params);
+    trials.erase(pid);
+}
+
+bool
+qmc_search::save (std::string *out)
+{
+    optk::net::put_num<uint32_t> (out, m_next);
+    optk::net::put_vec (out, m_points);
+    m_gen->save (out);
+    return true;
+}
+
+void
+qmc_search::restore (const std::string &in)
+{
+    size_t off = 0;
+    m_next = optk::net::get_num<uint32_t> (in, &off);
+    m_points = optk::net::get_vec<double> (in, &off);
+    if (m_next > m_block || m_points.size () != (size_t) m_block * m_gen->dims ())
+        throw std::runtime_error ("the saved sequence does not match");
+    m_gen->restore (in, &off);
+}
@@ -20,6 +20,7 @@
  */
 
 #include <optimisers/random.hpp>
+#include <optk/net.hpp>
 
 random_search::random_search ():
     optk::optimiser ("random search optimiser")
@@ -28,121 +29,7 @@ random_search::random_search ():
 void
 random_search::update_search_space (sspace::sspace_t *space)
 {
-    m_space = space;
-}
-
-#define get_val(type, ctype) \
-    { \
-    type *tmp = static_cast<type *>(p); \
-    parent->add_item ( \
-            new ctype (p->get_name(), tmp->sample()) \
-            ); \
-    break; \
-    }
-
-
-/**
- * Samples a single value from a parameter which returns a double, and adds it
- * to the parent parameter instance.
- * @param parent The 'level' of the searh space instance to which to add the
- * sampled value
- * @param p The parameter description.
- */
-static void
-sample_double (inst::node *parent, sspace::param_t *p)
-{
-    pt t = p->get_type();
-    switch (t) {
-        case pt::categorical_dbl:
-            get_val(sspace::categorical<double>, inst::dbl_val)
-        case pt::normal:
-            get_val(sspace::normal, inst::dbl_val)
-        case pt::qnormal:
-            get_val(sspace::qnormal, inst::dbl_val)
-        case pt::lognormal:
-            get_val(sspace::lognormal, inst::dbl_val)
-        case pt::qlognormal:
-            get_val(sspace::qlognormal, inst::dbl_val)
-        case pt::uniform:
-            get_val(sspace::uniform, inst::dbl_val)
-        case pt::quniform:
-            get_val(sspace::quniform, inst::dbl_val)
-        case pt::loguniform:
-            get_val(sspace::loguniform, inst::dbl_val)
-        case pt::qloguniform:
-            get_val(sspace::qloguniform, inst::dbl_val)
-        default:
-            // won't happen
-            break;
-    }
-}
-
-/**
- * As above, samples a single value from a parameter returning an integer.
- * @param parent The 'level' of the searh space instance to which to add the
- * sampled value
- * @param p The parameter description.
- */
-static void
-sample_int (inst::node *parent, sspace::param_t *p)
-{
-    pt t = p->get_type();
-    switch (t) {
-        case pt::categorical_int:
-            get_val(sspace::categorical<int>, inst::int_val)
-        case pt::randint:
-            get_val(sspace::randint, inst::int_val)
-        default:
-            break;
-    }
-}
-
-void
-random_search::sample_ss (inst::node *parent)
-{
-    std::vector<sspace::param_t *>::iterator it;
-    for (it = m_space->begin (); it != m_space->end (); it++) {
-
-        pt t = (*it)->get_type();
-
-        switch (t) {
-            case pt::categorical_dbl:
-            case pt::normal:
-            case pt::qnormal:
-            case pt::lognormal:
-            case pt::qlognormal:
-            case pt::uniform:
-            case pt::quniform:
-            case pt::loguniform:
-            case pt::qloguniform:
-            {
-                sample_double (parent, *it);
-                break;
-            }
-            case pt::categorical_int:
-            case pt::randint:
-            {
-                sample_int (parent, *it);
-                break;
-            }
-            case pt::categorical_str:
-            {
-                sspace::categorical<std::string> *tmp =
-                    static_cast<sspace::categorical<std::string> *>(*it);
-                parent->add_item (
-                        new inst::str_val ((*it)->get_name(), tmp->sample())
-                        );
-                break;
-            }
-            case pt::choice:
-            {
-                inst::node *ss = new inst::node ((*it)->get_name());
-                this->sample_ss (ss);
-                parent->add_item (ss);
-                break;
-            }
-        }
-    }
+    m_space.compile (space);
 }
 
 inst::set
@@ -150,7 +37,7 @@ random_search::generate_parameters (int param_id)
 {
     inst::node *root = new inst::node ("random parameters");
 
-    sample_ss (root);
+    m_space.sample (root, m_rng);
 
     add_to_trials (param_id, root);
 
@@ -164,3 +51,17 @@ random_search::receive_trial_results (int pid, inst::set params, double value)
     trials.erase(pid);
     return;
 }
+
+bool
+random_search::save (std::string *out)
+{
+    optk::net::put_num (out, m_rng.state ());
+    return true;
+}
+
+void
+random_search::restore (const std::string &in)
+{
+    size_t off = 0;
+    m_rng.restore (optk::net::get_num<optk::rng::state_t> (in, &off));
+}
@@ -0,0 +1,377 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the remote optimiser, and its protocol.
+ */
+
+#include <optimisers/remote.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace __remote {
+
+using optk::net::get_num;
+using optk::net::put_num;
+
+// search spaces ---------------------------------------------------------------
+
+/**
+ * Encodes a flat search space as the payload of a space message; every entry
+ * is sent as its type, name and numeric description (see sspace::compiled).
+ * @exception std::invalid_argument if a parameter cannot be sent.
+ */
+static std::string
+encode_space (sspace::sspace_t *space)
+{
+    sspace::compiled cs (space);
+    std::string s;
+    put_num<uint32_t> (&s, cs.size ());
+    for (uint32_t i = 0; i < cs.size (); i++) {
+        switch (cs.type (i)) {
+            case pt::categorical_int:
+            case pt::categorical_dbl:
+            case pt::categorical_str:
+            case pt::choice:
+                throw std::invalid_argument ("parameter '" + cs.name (i) +
+                        "' cannot be sent to a remote optimiser; only flat "
+                        "spaces of real-valued and randint parameters can");
+            default:
+                break;
+        }
+        put_num<uint8_t> (&s, (uint8_t) cs.type (i));
+        put_num<uint16_t> (&s, cs.name (i).size ());
+        s.append (cs.name (i));
+        put_num<double> (&s, cs.a (i));
+        put_num<double> (&s, cs.b (i));
+        put_num<double> (&s, cs.q (i));
+    }
+    return s;
+}
+
+/** Decodes the payload of a space message into a new search space. */
+static void
+decode_space (const std::string &s, sspace::sspace_t *space)
+{
+    size_t off = 0;
+    uint32_t d = get_num<uint32_t> (s, &off);
+    for (uint32_t j = 0; j < d; j++) {
+        pt t = (pt) get_num<uint8_t> (s, &off);
+        uint16_t len = get_num<uint16_t> (s, &off);
+        if (off + len > s.size ())
+            throw std::runtime_error ("truncated remote optimiser message");
+        std::string name = s.substr (off, len);
+        off += len;
+        double a = get_num<double> (s, &off);
+        double b = get_num<double> (s, &off);
+        double q = get_num<double> (s, &off);
+
+        sspace::param_t *p;
+        switch (t) {
+            case pt::uniform: p = new sspace::uniform (name, a, b); break;
+            case pt::quniform: p = new sspace::quniform (name, a, b, q); break;
+            case pt::loguniform: p = new sspace::loguniform (name, a, b); break;
+            case pt::qloguniform:
+                p = new sspace::qloguniform (name, a, b, q); break;
+            case pt::normal: p = new sspace::normal (name, a, b); break;
+            case pt::qnormal: p = new sspace::qnormal (name, a, b, q); break;
+            case pt::lognormal: p = new sspace::lognormal (name, a, b); break;
+            case pt::qlognormal:
+                p = new sspace::qlognormal (name, a, b, q); break;
+            case pt::randint: p = new sspace::randint (name, a, b); break;
+            default:
+                throw std::runtime_error ("unsupported parameter type in "
+                        "remote optimiser message");
+        }
+        space->push_back (p);
+    }
+}
+
+/** Frees the parameters of a decoded search space. */
+static void
+free_space (sspace::sspace_t *space)
+{
+    for (sspace::param_t *p: *space)
+        delete p;
+    space->clear ();
+}
+
+// server ----------------------------------------------------------------------
+
+void
+serve (int fd, optk::optimiser *opt)
+{
+    optk::net::channel chan (fd);
+    sspace::sspace_t space;
+    // the trials handed out and not yet told, by id
+    std::unordered_map<uint32_t, inst::set> pending;
+    std::vector<inst::set> sets;
+    std::string in, out;
+    uint8_t t;
+
+    try {
+        while (chan.try_get (&t, &in)) {
+            msg type = (msg) t;
+            size_t off = 0;
+            if (type == msg::bye)
+                break;
+            switch (type) {
+                case msg::space:
+                    // the optimiser owns (and clear frees) the pending trials
+                    opt->clear ();
+                    pending.clear ();
+                    free_space (&space);
+                    decode_space (in, &space);
+                    opt->update_search_space (&space);
+                    break;
+                case msg::ask: {
+                    uint32_t first = get_num<uint32_t> (in, &off);
+                    uint32_t k = get_num<uint32_t> (in, &off);
+                    sets.clear ();
+                    uint got = k ? opt->generate_batch (first, k, &sets) : 0;
+
+                    out.clear ();
+                    put_num<uint32_t> (&out, first);
+                    put_num<uint32_t> (&out, got);
+                    for (uint i = 0; i < got; i++) {
+                        pending[first + i] = sets[i];
+                        for (sspace::param_t *p: space) {
+                            inst::param *v = sets[i]->get_item (p->get_name ());
+                            double x = std::nan ("");
+                            if (v && v->get_type () == inst::inst_t::int_val)
+                                x = static_cast<inst::int_val *>(v)->get_val ();
+                            else if (v && v->get_type () ==
+                                    inst::inst_t::dbl_val)
+                                x = static_cast<inst::dbl_val *>(v)->get_val ();
+                            put_num<double> (&out, x);
+                        }
+                    }
+                    chan.put ((uint8_t) msg::points, out);
+                    chan.flush ();
+                    break;
+                }
+                case msg::tell: {
+                    uint32_t n = get_num<uint32_t> (in, &off);
+                    for (uint32_t i = 0; i < n; i++) {
+                        uint32_t id = get_num<uint32_t> (in, &off);
+                        double v = get_num<double> (in, &off);
+                        auto it = pending.find (id);
+                        if (it == pending.end ())
+                            continue;
+                        opt->receive_trial_results (id, it->second, v);
+                        pending.erase (it);
+                    }
+                    break;
+                }
+                default:
+                    throw std::runtime_error ("unexpected remote optimiser "
+                            "message");
+            }
+        }
+    } catch (...) {
+        opt->clear ();
+        free_space (&space);
+        throw;
+    }
+    opt->clear ();
+    free_space (&space);
+}
+
+} // namespace __remote
+
+// client ----------------------------------------------------------------------
+
+remote_optimiser::remote_optimiser (const std::string &path, uint lookahead):
+    optk::optimiser ("remote optimiser " + path),
+    m_path (path),
+    m_lookahead (lookahead),
+    m_chan (NULL),
+    m_space (NULL),
+    m_asked (0),
+    m_next (0),
+    m_exhausted (false),
+    m_ntells (0)
+{ }
+
+remote_optimiser::~remote_optimiser ()
+{
+    if (m_chan) {
+        try {
+            clear ();
+            m_chan->put ((uint8_t) __remote::msg::bye, "");
+            m_chan->flush ();
+        } catch (const std::runtime_error &) {
+            // the server has gone already
+        }
+        delete m_chan;
+    }
+}
+
+void
+remote_optimiser::update_search_space (sspace::sspace_t *space)
+{
+    std::string payload = __remote::encode_space (space);
+    if (!m_chan)
+        m_chan = new optk::net::channel (optk::net::connect_unix (m_path));
+    else
+        clear ();
+
+    m_space = space;
+    m_next = 0;
+    m_exhausted = false;
+    m_chan->put ((uint8_t) __remote::msg::space, payload);
+}
+
+void
+remote_optimiser::put_tells ()
+{
+    if (!m_ntells)
+        return;
+    std::string t;
+    optk::net::put_num<uint32_t> (&t, m_ntells);
+    t.append (m_tells);
+    m_chan->put ((uint8_t) __remote::msg::tell, t);
+    m_tells.clear ();
+    m_ntells = 0;
+}
+
+void
+remote_optimiser::ask (uint k)
+{
+    put_tells ();
+    std::string a;
+    optk::net::put_num<uint32_t> (&a, m_next);
+    optk::net::put_num<uint32_t> (&a, k);
+    m_chan->put ((uint8_t) __remote::msg::ask, a);
+    m_chan->flush ();
+
+    m_asks.push_back (k);
+    m_asked += k;
+    m_next += k;
+}
+
+void
+remote_optimiser::receive_points ()
+{
+    std::string in;
+    if (m_chan->get (&in) != (uint8_t) __remote::msg::points)
+        throw std::runtime_error ("unexpected remote optimiser message");
+
+    size_t off = 0;
+    uint32_t first = optk::net::get_num<uint32_t> (in, &off);
+    uint32_t k = optk::net::get_num<uint32_t> (in, &off);
+    uint32_t asked = m_asks.front ();
+    if (k > asked)
+        throw std::runtime_error ("remote optimiser sent too many trials");
+    for (uint32_t i = 0; i < k; i++) {
+        m_ids.push_back (first + i);
+        for (size_t j = 0; j < m_space->size (); j++)
+            m_values.push_back (optk::net::get_num<double> (in, &off));
+    }
+    if (k < asked)
+        m_exhausted = true;
+    m_asks.pop_front ();
+    m_asked -= asked;
+}
+
+void
+remote_optimiser::fill (uint n)
+{
+    while (m_ids.size () < n && !m_exhausted) {
+        uint have = m_ids.size () + m_asked;
+        if (have < n)
+            ask (n - have);
+        receive_points ();
+    }
+
+    // ask ahead, so that the next trials arrive while these are evaluated
+    uint left = m_ids.size () > n ? m_ids.size () - n : 0;
+    if (!m_exhausted && left + m_asked < m_lookahead)
+        ask (m_lookahead - left - m_asked);
+}
+
+inst::set
+remote_optimiser::pop (int param_id)
+{
+    inst::node *root = new inst::node ("remote parameters");
+    for (sspace::param_t *p: *m_space) {
+        double x = m_values.front ();
+        m_values.pop_front ();
+        if (p->get_type () == pt::randint)
+            root->add_item (new inst::int_val (p->get_name (), std::lround (x)));
+        else
+            root->add_item (new inst::dbl_val (p->get_name (), x));
+    }
+    m_remote[param_id] = m_ids.front ();
+    m_ids.pop_front ();
+    add_to_trials (param_id, root);
+    return root;
+}
+
+inst::set
+remote_optimiser::generate_parameters (int param_id)
+{
+    fill (1);
+    return m_ids.empty () ? NULL : pop (param_id);
+}
+
+uint
+remote_optimiser::generate_batch (
+        int first_id,
+        uint k,
+        std::vector<inst::set> *out
+) {
+    fill (k);
+    uint got = std::min<size_t> (k, m_ids.size ());
+    for (uint i = 0; i < got; i++)
+        out->push_back (pop (first_id + i));
+    return got;
+}
+
+void
+remote_optimiser::receive_trial_results (
+        int param_id,
+        inst::set params,
+        double value
+) {
+    auto it = m_remote.find (param_id);
+    if (it != m_remote.end ()) {
+        optk::net::put_num<uint32_t> (&m_tells, it->second);
+        optk::net::put_num<double> (&m_tells, value);
+        m_ntells++;
+        m_remote.erase (it);
+    }
+    inst::free_node (params);
+    trials.erase (param_id);
+}
+
+void
+remote_optimiser::clear ()
+{
+    if (m_chan) {
+        // tell the results so far, and drain the replies to the asks ahead
+        put_tells ();
+        m_chan->flush ();
+        while (!m_asks.empty ())
+            receive_points ();
+    }
+    m_ids.clear ();
+    m_values.clear ();
+    m_remote.clear ();
+    optk::optimiser::clear ();
+}
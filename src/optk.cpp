@@ -48,7 +48,12 @@ static struct argp_option options[] = {
         "Store the benchmark results in this directory",        0 },
 
     { "benchmark", 'b', "BENCHMARKS", 0,
-        "Only run the specified <benchmark>",                   0 },
+        "Only run the specified <benchmark>; a subset of the synthetic "
+        "benchmarks may be selected by name or property, as in "
+        "synthetic:scalable,multimodal",                        0 },
+
+    { "list",      'l', 0,            0,
+        "List the available benchmarks and exit",               0 },
 
     { "threads",   't', "THREADS",    0,
         "The number of threads to use",                         0 },
@@ -56,6 +61,78 @@ static struct argp_option options[] = {
     { "iterations",   'i', "ITERATIONS",    0,
         "The maximum number of iterations for each benchmark.", 0 },
 
+    { "every",     'e', "K",          0,
+        "Record only one entry per K iterations in each trace, so that long "
+        "runs need less memory and output",                    0 },
+
+    { "best",      'm', 0,            0,
+        "Record the best value found so far at each entry of the trace, "
+        "rather than the latest value",                         0 },
+
+    { "repeats",   'n', "N",          0,
+        "Run N differently seeded replicates of every (benchmark, optimiser) "
+        "pair, and write the mean, standard deviation, extremes and "
+        "quartiles of their best values so far",              0 },
+
+    { "batch",     'q', "BATCH",      0,
+        "Ask the optimiser for BATCH trials at a time, and evaluate them in "
+        "parallel",                                             0 },
+
+    { "async",     'a', 0,            0,
+        "Keep THREADS evaluations running at all times, passing results to "
+        "the optimiser as they complete",                       0 },
+
+    { "seed",      's', "SEED",       0,
+        "Seed the random number generators, to reproduce a run", 0 },
+
+    { "shard",     'k', "K/N",        0,
+        "Only visit shard K of N (counting from 0) of the grid, so that N "
+        "gridsearch processes can split a grid between them",  0 },
+
+    { "order",     'r', "ORDER",      0,
+        "The order in which gridsearch visits the grid; one of contiguous "
+        "(the default), strided or golden",                     0 },
+
+    { "grid",      'g', "Q",          0,
+        "The quantisation of continuous parameters for gridsearch (0.05 by "
+        "default)",                                             0 },
+
+    { "format",    'f', "FORMAT",     0,
+        "The layout of the results file; csv (the default), or columnar "
+        "for a compact binary file which may be memory-mapped", 0 },
+
+    { "coordinate", 'c', "HOST:PORT", 0,
+        "Rather than running the sweep, hand its runs out to workers which "
+        "connect on HOST:PORT, and write their results",       0 },
+
+    { "worker",    'w', "HOST:PORT",  0,
+        "Work for the coordinator at HOST:PORT, with THREADS threads; the "
+        "coordinator chooses everything else",                  0 },
+
+    { "checkpoint", 'C', "FILE",      0,
+        "Save the progress of the sweep into FILE as it runs; if FILE "
+        "exists, resume the sweep saved there rather than starting afresh", 0 },
+
+    { "period",    'p', "SECS",       0,
+        "Save a snapshot of every unfinished run at most once per SECS "
+        "seconds (60 by default)",                              0 },
+
+    { "cache",     'x', "FILE",       0,
+        "Look every evaluation up in the cache held in FILE, which is shared "
+        "between runs, before making it, and add new ones to the cache; only "
+        "deterministic benchmarks should be cached",            0 },
+
+    { "variant",   'v', "SETTINGS",   0,
+        "Run noisy, costly or multi-fidelity variants of the synthetic "
+        "benchmarks, as in noise=0.1,cost=0.01,jitter=0.5,fidelity=0.1, and "
+        "write the total cost so far of each run as a row of its own", 0 },
+
+    { "target",    'T', "EPS",        0,
+        "Write a summary of each run rather than its trace: its best value, "
+        "the regret of that value from the benchmark's known optimum, and "
+        "the evaluations, seconds (and cost) which it took to come within "
+        "EPS of the optimum",                                   0 },
+
     { 0 }
 };
 
@@ -76,12 +153,66 @@ parse_opt (int key, char *arg, struct argp_state *state)
             // benchmarks
             arguments->benchmark = arg;
             break;
+        case 'l':
+            arguments->list = true;
+            break;
         case 't':
             arguments->threads = atoi(arg);
             break;
         case 'i':
             arguments->max_iters = atoi(arg);
             break;
+        case 'e':
+            arguments->stride = atoi(arg);
+            break;
+        case 'm':
+            arguments->best = true;
+            break;
+        case 'n':
+            arguments->repeats = atoi(arg);
+            break;
+        case 'q':
+            arguments->batch = atoi(arg);
+            break;
+        case 'a':
+            arguments->async = true;
+            break;
+        case 's':
+            arguments->seed = arg;
+            break;
+        case 'k':
+            arguments->shard = arg;
+            break;
+        case 'r':
+            arguments->order = arg;
+            break;
+        case 'g':
+            arguments->grid_q = atof(arg);
+            break;
+        case 'f':
+            arguments->format = arg;
+            break;
+        case 'c':
+            arguments->coordinate = arg;
+            break;
+        case 'w':
+            arguments->worker = arg;
+            break;
+        case 'C':
+            arguments->checkpoint = arg;
+            break;
+        case 'p':
+            arguments->period = atof(arg);
+            break;
+        case 'x':
+            arguments->cache = arg;
+            break;
+        case 'v':
+            arguments->variant = arg;
+            break;
+        case 'T':
+            arguments->target = atof(arg);
+            break;
         case ARGP_KEY_ARG:
             arguments->algorithm = arg;
             break;
@@ -96,6 +227,40 @@ struct argp argp = { options, parse_opt, args_doc, doc };
 
 /* Setup and teardown ------------------------------------------------------- */
 
+// these only serve main, which the test build replaces
+#ifndef __OPTK_TESTING
+
+/** @returns The arguments which are not given on the command line. */
+static optk::arguments
+default_arguments ()
+{
+    return optk::arguments{
+        .threads = 1,
+        .max_iters = 20,
+        .stride = 1,
+        .best = false,
+        .repeats = 1,
+        .batch = 1,
+        .async = false,
+        .seed = NULL,
+        .shard = NULL,
+        .order = "contiguous",
+        .grid_q = 0.05,
+        .format = "csv",
+        .coordinate = NULL,
+        .worker = NULL,
+        .checkpoint = NULL,
+        .period = 60,
+        .cache = NULL,
+        .variant = NULL,
+        .target = -1,
+        .output = "outputs",
+        .benchmark = "synthetic",
+        .algorithm = "random_search",
+        .list = false
+    };
+}
+
 static bool
 validate_args (
         optk::arguments *args,
@@ -116,11 +281,157 @@ validate_args (
         error = true;
     }
 
+    if (args->seed != NULL) {
+        char *end;
+        errno = 0;
+        strtoull (args->seed, &end, 0);
+        if (errno != 0 || *args->seed == '\0' || *end != '\0') {
+            std::cerr << "Error: invalid seed " << args->seed << std::endl;
+            error = true;
+        }
+    }
+
+    if (args->stride <= 0) {
+        std::cerr <<
+            "Error: trace stride must be strictly positive" << std::endl;
+        error = true;
+    }
+
+    if (args->repeats <= 0) {
+        std::cerr <<
+            "Error: number of repeats must be strictly positive" << std::endl;
+        error = true;
+    }
+
+    if (args->batch <= 0) {
+        std::cerr <<
+            "Error: batch size must be strictly positive" << std::endl;
+        error = true;
+    }
+
+    if (args->period < 0) {
+        std::cerr <<
+            "Error: snapshot period must not be negative" << std::endl;
+        error = true;
+    }
+
+    if (args->async && args->checkpoint != NULL) {
+        std::cerr <<
+            "Error: asynchronous runs (-a) cannot be checkpointed (-C)"
+            << std::endl;
+        error = true;
+    }
+
     // TODO validate output file directory
 
     return error;
 }
 
+/**
+ * Applies the grid-specific arguments to the gridsearch optimiser; throws
+ * std::invalid_argument if any is malformed.
+ *
+ * @param args The parsed command line arguments
+ * @param gs The gridsearch optimiser to configure
+ */
+static void
+configure_grid (optk::arguments *args, gridsearch *gs)
+{
+    if (args->shard != NULL) {
+        unsigned long long k, n;
+        char end;
+        if (sscanf (args->shard, "%llu/%llu%c", &k, &n, &end) != 2)
+            throw std::invalid_argument (
+                    "invalid shard " + std::string (args->shard) +
+                    "; expected K/N");
+        gs->set_shard (k, n);
+    }
+
+    std::string order = args->order;
+    if (order == "contiguous")
+        gs->set_order (__gs::order::contiguous);
+    else if (order == "strided")
+        gs->set_order (__gs::order::strided);
+    else if (order == "golden")
+        gs->set_order (__gs::order::golden);
+    else
+        throw std::invalid_argument ("unknown grid order " + order);
+
+    gs->set_quantisation (args->grid_q);
+}
+
+/**
+ * @returns The arguments which determine the results of the sweep, other than
+ * its seed; these are also what the workers of a distributed sweep are
+ * configured with.
+ */
+static std::vector<std::string>
+sweep_config (optk::arguments *args)
+{
+    char q[32];
+    std::snprintf (q, sizeof (q), "%.17g", args->grid_q);
+    std::vector<std::string> conf = {
+        "-b", args->benchmark,
+        "-i", std::to_string (args->max_iters),
+        "-e", std::to_string (args->stride),
+        "-n", std::to_string (args->repeats),
+        "-q", std::to_string (args->batch),
+        "-r", args->order,
+        "-g", q
+    };
+    if (args->best)
+        conf.push_back ("-m");
+    if (args->async)
+        conf.push_back ("-a");
+    if (args->shard != NULL) {
+        conf.push_back ("-k");
+        conf.push_back (args->shard);
+    }
+    if (args->variant != NULL) {
+        conf.push_back ("-v");
+        conf.push_back (args->variant);
+    }
+    if (args->target >= 0) {
+        char eps[32];
+        std::snprintf (eps, sizeof (eps), "%.17g", args->target);
+        conf.push_back ("-T");
+        conf.push_back (eps);
+    }
+    conf.push_back (args->algorithm);
+    return conf;
+}
+
+/**
+ * Opens the checkpoint named by the arguments, adopting the seed of the sweep
+ * saved there, if any.
+ * @returns false if it cannot be opened, or belongs to another sweep.
+ */
+static bool
+open_checkpoint (optk::arguments *args, optk::ctx_t *ctx)
+{
+    std::string conf;
+    for (const std::string &a: sweep_config (args))
+        conf += a + '\n';
+    try {
+        ctx->ckpt = new optk::checkpoint (args->checkpoint, conf, ctx->seed,
+                args->period);
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    if (args->seed != NULL && ctx->ckpt->seed () != ctx->seed) {
+        std::cerr << "Error: the checkpoint " << args->checkpoint <<
+            " was saved with seed " << ctx->ckpt->seed () << std::endl;
+        return false;
+    }
+    ctx->seed = ctx->ckpt->seed ();
+    if (ctx->ckpt->restored ())
+        std::cout << "Resuming the sweep saved in " << args->checkpoint <<
+            ", of which " << ctx->ckpt->restored () << " runs had finished" <<
+            std::endl;
+    return true;
+}
+
 /**
  * In this setup function we 'register' all the optimisation algorithms, as
  * well as the bechmarks.
@@ -137,11 +448,36 @@ do_setup (
 ) {
     // Program context
     optk::ctx_t *ctx = new optk::ctx_t;
-
-    // initialise the relevant benchmarks
-    if (std::string(args->benchmark) == "synthetic") {
-        syn::synthetic_benchmark *sbm = new syn::synthetic_benchmark;
-        bmks->register_benchmark (sbm);
+    ctx->results = NULL;
+    ctx->ckpt = NULL;
+    ctx->cache = NULL;
+    ctx->costs = false;
+    ctx->summary = false;
+
+    // initialise the relevant benchmarks; the name of a benchmark set may be
+    // followed by a selection of its benchmarks, e.g. synthetic:scalable
+    std::string bspec = std::string(args->benchmark);
+    std::string bset = bspec.substr(0, bspec.find(':'));
+    std::string bsel = bset.size() < bspec.size() ?
+        bspec.substr(bset.size() + 1) : "";
+
+    if (bset == "synthetic") {
+        try {
+            syn::variant_spec v;
+            if (args->variant != NULL)
+                v = syn::parse_variant (args->variant);
+            if (args->cache != NULL && v.noise > 0.)
+                throw std::invalid_argument (
+                        "the values of noisy benchmarks cannot be cached");
+            syn::synthetic_benchmark *sbm = new syn::synthetic_benchmark (bsel);
+            sbm->set_variant (v);
+            ctx->costs = v.cost > 0.;
+            bmks->register_benchmark (sbm);
+        } catch (const std::invalid_argument &e) {
+            ctx->error = true;
+            std::cerr << "Error: " << e.what() << std::endl;
+            return ctx;
+        }
     }
     // TODO add other benchmark sets here.
 
@@ -157,15 +493,48 @@ do_setup (
     if (std::string (args->algorithm) == "gridsearch") {
         gridsearch *gs = new gridsearch ();
         opts->register_optimiser (gs);
+        try {
+            configure_grid (args, gs);
+        } catch (const std::invalid_argument &e) {
+            ctx->error = true;
+            std::cerr << "Error: " << e.what() << std::endl;
+            return ctx;
+        }
     }
     if (std::string (args->algorithm) == "random_search") {
         random_search *rs = new random_search ();
         opts->register_optimiser (rs);
     }
+    if (std::string (args->algorithm) == "sobol_search") {
+        qmc_search *qs = new qmc_search (__qmc::sequence::sobol);
+        opts->register_optimiser (qs);
+    }
+    if (std::string (args->algorithm) == "halton_search") {
+        qmc_search *qs = new qmc_search (__qmc::sequence::halton);
+        opts->register_optimiser (qs);
+    }
+    if (std::string (args->algorithm) == "lhs_search") {
+        qmc_search *qs = new qmc_search (__qmc::sequence::lhs);
+        opts->register_optimiser (qs);
+    }
     if (std::string (args->algorithm) == "gp_optimiser") {
         gp_opt *gp = new gp_opt ();
         opts->register_optimiser (gp);
     }
+    if (std::string (args->algorithm) == "sparse_gp_optimiser") {
+        gp_opt *gp = new gp_opt (__gp::acquisition::ei, __gp::mode::sparse);
+        opts->register_optimiser (gp);
+    }
+    if (std::string (args->algorithm) == "local_gp_optimiser") {
+        gp_opt *gp = new gp_opt (__gp::acquisition::ei, __gp::mode::local);
+        opts->register_optimiser (gp);
+    }
+    // an optimiser served over a Unix socket, e.g. remote:/tmp/smac.sock
+    if (std::string (args->algorithm).rfind ("remote:", 0) == 0) {
+        remote_optimiser *ro =
+            new remote_optimiser (std::string (args->algorithm).substr (7));
+        opts->register_optimiser (ro);
+    }
 
     // no matching optimisation algorithms were added
     if (!opts->collection()->size()) {
@@ -183,23 +552,88 @@ do_setup (
     // other arguments:
     ctx->threads = args->threads;
     ctx->max_iters = args->max_iters;
+    ctx->stride = args->stride;
+    ctx->best = args->best;
+    ctx->repeats = args->repeats;
+    ctx->batch = args->batch;
+    ctx->async = args->async;
+    ctx->summary = args->target >= 0;
+    ctx->eps = args->target;
+    if (args->seed != NULL)
+        optk::set_seed (strtoull (args->seed, NULL, 0));
+    ctx->seed = optk::get_seed ();
+
+    optk::result_format format;
+    if (std::string (args->format) == "csv") {
+        format = optk::result_format::csv;
+    } else if (std::string (args->format) == "columnar") {
+        format = optk::result_format::columnar;
+    } else {
+        ctx->error = true;
+        std::cerr << "Error: unknown output format '" << args->format <<
+            "'; expected csv or columnar." << std::endl;
+        return ctx;
+    }
+
+    if (args->cache != NULL) {
+        try {
+            ctx->cache = new optk::eval_cache (args->cache);
+        } catch (const std::runtime_error &e) {
+            ctx->error = true;
+            std::cerr << "Error: " << e.what() << std::endl;
+            return ctx;
+        }
+    }
+
+    // workers send their results to the coordinator
+    if (args->worker != NULL)
+        return ctx;
+
+    if (args->checkpoint != NULL && !open_checkpoint (args, ctx)) {
+        ctx->error = true;
+        return ctx;
+    }
 
     ctx->outfile =
-        std::string(args->output) + "/" + std::string(args->benchmark) +
-        "-" + std::to_string(std::time(0)) + ".csv";
-
-    // Write the header of the csv output file.
-    std::ofstream f;
-    f.open(ctx->outfile);
-    f << "Benchmark, Optimiser";
-    for (int i = 0; i < args->max_iters; i++)
-        f << "," << std::to_string(i);
-    f << std::endl;
-    f.close();
+        std::string(args->output) + "/" + bset +
+        "-" + std::to_string(std::time(0)) +
+        (format == optk::result_format::csv ? ".csv" : ".optk");
+
+    // Create the results file, and write its header.
+    try {
+        ctx->results = new optk::result_writer (ctx->outfile, format);
+    } catch (const std::runtime_error &e) {
+        ctx->error = true;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return ctx;
+    }
+    if (ctx->summary)
+        ctx->results->header (optk::trace::summary_columns (ctx->costs),
+                args->repeats > 1);
+    else
+        ctx->results->header (args->max_iters, args->stride,
+                args->repeats > 1 || ctx->costs);
 
     return ctx;
 }
 
+/**
+ * Prints the name, dimensions and properties of every registered benchmark.
+ */
+static void
+list_benchmarks ()
+{
+    syn::registry reg;
+    std::vector<syn::entry> *es = reg.entries();
+    for (uint i = 0; i < es->size(); i++) {
+        syn::entry *e = &es->at(i);
+        std::cout << "synthetic:" << e->name << " (" << e->dims << "D)";
+        for (uint j = 0; j < e->props.size(); j++)
+            std::cout << (j ? ", " : " ") << syn::property_name (e->props[j]);
+        std::cout << std::endl;
+    }
+}
+
 /**
  * In this teardown function we free all memory allocated by the setup and
  * during the program.
@@ -207,9 +641,83 @@ do_setup (
 static void
 do_teardown (optk::ctx_t *ctx)
 {
+    delete ctx->results;
+    delete ctx->ckpt;
+    if (ctx->cache != NULL && !ctx->error)
+        std::cout << "Evaluation cache: " << ctx->cache->hits () <<
+            " hits, " << ctx->cache->misses () << " misses, " <<
+            ctx->cache->persisted () << " values held" << std::endl;
+    delete ctx->cache;
     delete ctx;
 }
 
+/* Distributed sweeps ------------------------------------------------------ */
+
+/**
+ * @returns The arguments with which to configure workers, so that they run
+ * the same sweep as the coordinator, with the same seed.
+ */
+static std::vector<std::string>
+worker_config (optk::arguments *args, optk::ctx_t *ctx)
+{
+    std::vector<std::string> conf = sweep_config (args);
+    conf.insert (conf.begin (), {"-s", std::to_string (ctx->seed)});
+    return conf;
+}
+
+/**
+ * Joins the coordinator named by args->worker, and runs the work which it
+ * hands out until it is done.
+ * @returns The exit status.
+ */
+static int
+run_worker (optk::arguments *args)
+{
+    optk::net::channel *chan;
+    std::vector<std::string> conf;
+    try {
+        chan = new optk::net::channel (optk::net::connect_tcp (args->worker));
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    try {
+        conf = optk::dist::join (chan, args->threads);
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        delete chan;
+        return 1;
+    }
+
+    // configure the worker as the coordinator says, but with its own threads
+    optk::arguments wargs = default_arguments ();
+    std::vector<char *> argv = {(char *) "optk"};
+    for (std::string &a: conf)
+        argv.push_back (&a[0]);
+    argp_parse (&argp, argv.size (), argv.data (), 0, 0, &wargs);
+    wargs.threads = args->threads;
+    wargs.cache = args->cache;
+    wargs.worker = args->worker;
+
+    optk::optimisers opts;
+    optk::benchmarks bmks;
+    optk::ctx_t *ctx = do_setup (&wargs, &opts, &bmks);
+    int status = ctx->error;
+    if (!status) {
+        try {
+            optk::dist::work (chan, bmks.collection (), &opts, ctx);
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    delete chan;
+    do_teardown (ctx);
+    return status;
+}
+
+#endif // __OPTK_TESTING
+
 /* Main --------------------------------------------------------------------- */
 
 /**
@@ -230,16 +738,18 @@ main (int argc, char **argv)
     return 0;
 #else
 
-    optk::arguments args{
-        .threads = 1,
-        .max_iters = 20,
-        .output = "outputs",
-        .benchmark = "synthetic",
-        .algorithm = "random_search"
-    };
+    optk::arguments args = default_arguments ();
 
     argp_parse (&argp, argc, argv, 0, 0, &args);
 
+    if (args.list) {
+        list_benchmarks ();
+        return 0;
+    }
+
+    if (args.worker != NULL)
+        return run_worker (&args);
+
     optk::ctx_t *ctx = do_setup (&args, &opts, &bmks);
 
     if (ctx->error) {
@@ -248,9 +758,20 @@ main (int argc, char **argv)
     }
 
     optk::bench_list *bms = bmks.collection();
-    optk::bench_list::iterator it;
-    for (it = bms->begin (); it != bms->end(); it++)
-        (*it)->run(&opts, ctx);
+    if (args.coordinate != NULL) {
+        try {
+            int lfd = optk::net::listen_tcp (args.coordinate);
+            optk::dist::coordinate (lfd, bms, &opts, ctx,
+                    worker_config (&args, ctx));
+            close (lfd);
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    } else {
+        optk::bench_list::iterator it;
+        for (it = bms->begin (); it != bms->end(); it++)
+            (*it)->run(&opts, ctx);
+    }
 
     do_teardown (ctx);
 
@@ -0,0 +1,231 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the small-object memory pool.
+ */
+
+#include <optk/pool.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+const std::size_t granularity = 16;
+const std::size_t n_classes = optk::pool::max_size / granularity;
+const std::size_t chunk_size = 64 * 1024;
+
+struct free_block {
+    free_block *next;
+};
+
+/**
+ * The free lists and current chunk of one thread, and the lists of blocks
+ * which other threads have freed into its chunks.
+ */
+struct cache {
+    free_block *free[n_classes];
+    std::atomic<free_block *> remote[n_classes];
+    char *bump;
+    char *end;
+};
+
+/**
+ * The start of every chunk, which is aligned to chunk_size so that the
+ * header of a block's chunk can be found from the block's address; the
+ * header takes up the first granularity bytes.
+ */
+struct chunk_header {
+    cache *owner;
+};
+
+/**
+ * The registry of every chunk, so that the blocks of exited threads remain
+ * reachable, and of the caches of exited threads, waiting to be adopted. It
+ * is built on first use, since the pool may be used during static
+ * initialisation, and never destroyed, since it may be used after it.
+ */
+struct registry {
+    std::mutex mtx;
+    std::vector<char *> chunks;
+    std::vector<cache *> orphans;
+    /** The cache shared by threads whose own cache has gone, under its
+     * own lock, which is taken before mtx.                               */
+    std::mutex shared_mtx;
+    cache *shared = NULL;
+};
+
+registry &
+global ()
+{
+    static registry *r = new registry ();
+    return *r;
+}
+
+/**
+ * The calling thread's cache, and whether it has gone as the thread exits.
+ * These are trivially destructible, so that they may still be read by the
+ * destructors of other thread-local and static objects.
+ */
+thread_local cache *t_cache = NULL;
+thread_local bool t_exited = false;
+
+/**
+ * Orphans the calling thread's cache as the thread exits, for another thread
+ * to adopt. Caches are never freed, since other threads may still free
+ * blocks into their chunks.
+ */
+struct local {
+    cache *c = NULL;
+
+    ~local ()
+    {
+        t_cache = NULL;
+        t_exited = true;
+        if (c == NULL)
+            return;
+        registry &g = global ();
+        std::lock_guard<std::mutex> lock (g.mtx);
+        g.orphans.push_back (c);
+    }
+};
+
+thread_local local t_local;
+
+/** @returns The calling thread's cache, or NULL once it has gone. */
+cache *
+this_cache ()
+{
+    if (t_cache != NULL || t_exited)
+        return t_cache;
+    registry &g = global ();
+    std::lock_guard<std::mutex> lock (g.mtx);
+    if (!g.orphans.empty ()) {
+        t_local.c = g.orphans.back ();
+        g.orphans.pop_back ();
+    } else {
+        t_local.c = new cache ();
+    }
+    t_cache = t_local.c;
+    return t_cache;
+}
+
+/** Allocates a new chunk, owned by the cache tc. */
+char *
+new_chunk (cache *tc)
+{
+    char *c = static_cast<char *>(::operator new (chunk_size,
+                std::align_val_t (chunk_size)));
+    reinterpret_cast<chunk_header *>(c)->owner = tc;
+    registry &g = global ();
+    std::lock_guard<std::mutex> lock (g.mtx);
+    g.chunks.push_back (c);
+    return c;
+}
+
+/** @returns The cache which owns the chunk of a block. */
+cache *
+owner (void *p)
+{
+    std::uintptr_t c = reinterpret_cast<std::uintptr_t>(p) & ~(chunk_size - 1);
+    return reinterpret_cast<chunk_header *>(c)->owner;
+}
+
+/** Allocates a block of size class c from the cache tc. */
+void *
+take (cache *tc, std::size_t c)
+{
+    free_block *b = tc->free[c];
+    if (b == NULL)
+        b = tc->remote[c].exchange (NULL, std::memory_order_acquire);
+    if (b) {
+        tc->free[c] = b->next;
+        return b;
+    }
+
+    std::size_t sz = (c + 1) * granularity;
+    if (tc->bump == NULL || (std::size_t) (tc->end - tc->bump) < sz) {
+        tc->bump = new_chunk (tc) + granularity;
+        tc->end = tc->bump - granularity + chunk_size;
+    }
+    void *p = tc->bump;
+    tc->bump += sz;
+    return p;
+}
+
+} // namespace
+
+void *
+optk::pool::allocate (std::size_t n)
+{
+    if (n == 0)
+        n = 1;
+    if (n > max_size)
+        return ::operator new (n);
+
+    std::size_t c = (n - 1) / granularity;
+    cache *tc = this_cache ();
+    if (tc != NULL)
+        return take (tc, c);
+
+    registry &g = global ();
+    std::lock_guard<std::mutex> lock (g.shared_mtx);
+    if (g.shared == NULL)
+        g.shared = new cache ();
+    return take (g.shared, c);
+}
+
+void
+optk::pool::deallocate (void *p, std::size_t n) noexcept
+{
+    if (p == NULL)
+        return;
+    if (n == 0)
+        n = 1;
+    if (n > max_size) {
+        ::operator delete (p);
+        return;
+    }
+
+    std::size_t c = (n - 1) / granularity;
+    cache *oc = owner (p);
+    free_block *b = static_cast<free_block *>(p);
+    if (oc == t_cache) {
+        b->next = oc->free[c];
+        oc->free[c] = b;
+        return;
+    }
+
+    // hand the block back to the thread whose chunk it is in
+    free_block *head = oc->remote[c].load (std::memory_order_relaxed);
+    do {
+        b->next = head;
+    } while (!oc->remote[c].compare_exchange_weak (head, b,
+                std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::size_t
+optk::pool::chunks ()
+{
+    registry &g = global ();
+    std::lock_guard<std::mutex> lock (g.mtx);
+    return g.chunks.size ();
+}
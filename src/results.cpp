@@ -0,0 +1,429 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the buffered results writer.
+ */
+
+#include <optk/results.hpp>
+#include <optk/trace.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+optk::result_writer::result_writer (
+        const std::string &path, result_format format, uint flush_ms,
+        size_t capacity):
+    m_format (format), m_capacity (capacity), m_interval (flush_ms),
+    m_stop (false), m_next (0), m_reserved (0), m_entries (0), m_written (0),
+    m_statistics (false)
+{
+    m_file = std::fopen (path.c_str (), "w");
+    if (m_file == NULL)
+        throw std::runtime_error (
+                "could not open '" + path + "' for writing"
+                );
+    m_buf.reserve (m_capacity);
+    if (flush_ms)
+        m_thread = std::thread (&result_writer::flusher, this);
+}
+
+optk::result_writer::~result_writer ()
+{
+    {
+        std::lock_guard<std::mutex> lock (m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all ();
+    if (m_thread.joinable ())
+        m_thread.join ();
+
+    // rows which never had their predecessors submitted are still written,
+    // in order, rather than being lost.
+    for (auto &r: m_pending)
+        emit (r.second);
+    m_pending.clear ();
+    drain ();
+    if (m_format == result_format::columnar)
+        finish_columnar ();
+    std::fclose (m_file);
+}
+
+void
+optk::result_writer::format (std::string &out, double v)
+{
+    char tmp[32];
+    std::to_chars_result r =
+        std::to_chars (tmp, tmp + sizeof (tmp), v,
+                std::chars_format::general, 6);
+    out.append (tmp, r.ptr);
+}
+
+/** Appends a little-endian integer of the given width to a string. */
+template <typename T>
+static void
+put (std::string &out, T v)
+{
+    out.append (reinterpret_cast<const char *>(&v), sizeof (T));
+}
+
+void
+optk::result_writer::header (uint iters, uint stride, bool statistics)
+{
+    stride = std::max (stride, 1u);
+    const uint entries = (iters + stride - 1) / stride;
+
+    std::vector<std::string> labels;
+    for (uint j = 0; j < entries; j++)
+        labels.push_back (std::to_string (trace::iteration (j, iters, stride)));
+    write_header (labels, stride, statistics);
+}
+
+void
+optk::result_writer::header (const std::vector<std::string> &columns,
+        bool statistics)
+{
+    {
+        std::lock_guard<std::mutex> lock (m_mtx);
+        m_columns = columns;
+    }
+    write_header (columns, 0, statistics);
+}
+
+void
+optk::result_writer::write_header (const std::vector<std::string> &labels,
+        uint stride, bool statistics)
+{
+    std::lock_guard<std::mutex> lock (m_mtx);
+    m_entries = labels.size ();
+    m_statistics = statistics;
+
+    if (m_format == result_format::columnar) {
+        // the run count and trailing offsets are filled in as they become
+        // known; until then, the values simply follow the header.
+        std::string h = "OPTKCOL1";
+        put<uint32_t> (h, m_entries);
+        put<uint32_t> (h, stride);
+        put<uint64_t> (h, 0);
+        put<uint64_t> (h, columnar_header_size);
+        h.resize (columnar_header_size, '\0');
+        m_buf += h;
+    } else {
+        m_buf += statistics ? "Benchmark, Optimiser,Statistic" :
+            "Benchmark, Optimiser";
+        for (const std::string &l: labels)
+            m_buf += "," + l;
+        m_buf += "\n";
+    }
+    drain ();
+}
+
+uint
+optk::result_writer::reserve (uint n)
+{
+    std::lock_guard<std::mutex> lock (m_mtx);
+    uint first = m_reserved;
+    m_reserved += n;
+    return first;
+}
+
+void
+optk::result_writer::submit (
+        uint row,
+        const std::string &bench,
+        const std::string &opt,
+        const double *trace,
+        uint n,
+        uint64_t seed,
+        const std::vector<std::string> &props,
+        const std::string &stat)
+{
+    // format outside of the lock, so that the rows of parallel jobs are
+    // formatted in parallel
+    entry e;
+    if (m_format == result_format::columnar) {
+        if (n != m_entries)
+            throw std::invalid_argument (
+                    "columnar results need traces of exactly " +
+                    std::to_string (m_entries) + " entries"
+                    );
+        e.data.assign (reinterpret_cast<const char *>(trace),
+                n * sizeof (double));
+        e.bench = bench;
+        e.opt = opt;
+        e.props = props;
+        e.seed = seed;
+        e.stat = stat;
+    } else {
+        std::string &line = e.data;
+        line.reserve (bench.size () + opt.size () + 12 * n + 2);
+        line += bench;
+        line += ",";
+        line += opt;
+        if (m_statistics) {
+            line += ",";
+            line += stat;
+        }
+        for (uint i = 0; i < n; i++) {
+            line += ",";
+            format (line, trace[i]);
+        }
+        line += "\n";
+    }
+
+    std::lock_guard<std::mutex> lock (m_mtx);
+    if (row != m_next) {
+        m_pending.emplace (row, std::move (e));
+        return;
+    }
+    emit (e);
+    m_next++;
+    std::map<uint, entry>::iterator it;
+    while ((it = m_pending.begin ()) != m_pending.end () &&
+            it->first == m_next) {
+        emit (it->second);
+        m_pending.erase (it);
+        m_next++;
+    }
+    if (m_buf.size () >= m_capacity)
+        drain ();
+}
+
+/**
+ * @returns The index of a name in a list, adding it if it is new.
+ */
+static uint32_t
+intern (
+        std::unordered_map<std::string, uint32_t> &idx,
+        std::vector<std::string> &names,
+        const std::string &name)
+{
+    auto r = idx.emplace (name, (uint32_t) names.size ());
+    if (r.second)
+        names.push_back (name);
+    return r.first->second;
+}
+
+void
+optk::result_writer::emit (entry &e)
+{
+    m_buf += e.data;
+    if (m_format != result_format::columnar)
+        return;
+
+    size_t nbench = m_benches.size ();
+    m_bench_ids.push_back (intern (m_bench_idx, m_benches, e.bench));
+    if (m_benches.size () > nbench)
+        m_props.push_back (e.props);
+    m_opt_ids.push_back (intern (m_opt_idx, m_opts, e.opt));
+    m_stat_ids.push_back (intern (m_stat_idx, m_stats, e.stat));
+    m_seeds.push_back (e.seed);
+}
+
+void
+optk::result_writer::flush ()
+{
+    std::lock_guard<std::mutex> lock (m_mtx);
+    drain ();
+}
+
+void
+optk::result_writer::drain ()
+{
+    if (!m_buf.empty ()) {
+        std::fwrite (m_buf.data (), 1, m_buf.size (), m_file);
+        m_buf.clear ();
+    }
+
+    // every run emitted so far is now on disk; record them in the header.
+    if (m_format == result_format::columnar && m_written != m_seeds.size ()) {
+        m_written = m_seeds.size ();
+        long end = std::ftell (m_file);
+        std::fseek (m_file, 16, SEEK_SET);
+        std::fwrite (&m_written, sizeof (m_written), 1, m_file);
+        std::fseek (m_file, end, SEEK_SET);
+    }
+    std::fflush (m_file);
+}
+
+/** Appends a string to a JSON document, quoted and escaped. */
+static void
+json_string (std::string &out, const std::string &s)
+{
+    out += '"';
+    for (char c: s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char) c < 0x20) {
+            char tmp[8];
+            snprintf (tmp, sizeof (tmp), "\\u%04x", c);
+            out += tmp;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void
+optk::result_writer::finish_columnar ()
+{
+    uint64_t table = columnar_header_size +
+        (uint64_t) m_seeds.size () * m_entries * sizeof (double);
+
+    std::string out;
+    out.append (reinterpret_cast<const char *>(m_seeds.data ()),
+            m_seeds.size () * sizeof (uint64_t));
+    out.append (reinterpret_cast<const char *>(m_bench_ids.data ()),
+            m_bench_ids.size () * sizeof (uint32_t));
+    out.append (reinterpret_cast<const char *>(m_opt_ids.data ()),
+            m_opt_ids.size () * sizeof (uint32_t));
+    out.append (reinterpret_cast<const char *>(m_stat_ids.data ()),
+            m_stat_ids.size () * sizeof (uint32_t));
+
+    uint64_t meta = table + out.size ();
+    std::string json = "{\"benchmarks\": [";
+    for (size_t i = 0; i < m_benches.size (); i++) {
+        json += i ? ", {\"name\": " : "{\"name\": ";
+        json_string (json, m_benches[i]);
+        json += ", \"properties\": [";
+        for (size_t j = 0; j < m_props[i].size (); j++) {
+            if (j)
+                json += ", ";
+            json_string (json, m_props[i][j]);
+        }
+        json += "]}";
+    }
+    json += "], \"optimisers\": [";
+    for (size_t i = 0; i < m_opts.size (); i++) {
+        if (i)
+            json += ", ";
+        json_string (json, m_opts[i]);
+    }
+    json += "], \"statistics\": [";
+    for (size_t i = 0; i < m_stats.size (); i++) {
+        if (i)
+            json += ", ";
+        json_string (json, m_stats[i]);
+    }
+    json += "]";
+    if (!m_columns.empty ()) {
+        json += ", \"columns\": [";
+        for (size_t i = 0; i < m_columns.size (); i++) {
+            if (i)
+                json += ", ";
+            json_string (json, m_columns[i]);
+        }
+        json += "]";
+    }
+    json += "}\n";
+    out += json;
+
+    std::fwrite (out.data (), 1, out.size (), m_file);
+
+    uint64_t offsets[3] = { table, meta, json.size () };
+    std::fseek (m_file, 32, SEEK_SET);
+    std::fwrite (offsets, sizeof (uint64_t), 3, m_file);
+    std::fflush (m_file);
+}
+
+void
+optk::result_writer::flusher ()
+{
+    std::unique_lock<std::mutex> lock (m_mtx);
+    while (!m_stop) {
+        m_cv.wait_for (lock, m_interval);
+        if (!m_buf.empty ())
+            drain ();
+    }
+}
+
+// sweep rows ------------------------------------------------------------------
+
+optk::sweep_rows::sweep_rows (result_writer *out, uint pairs, uint reps,
+        bool costs):
+    m_out (out),
+    m_reps (std::max (reps, 1u)),
+    m_costs (costs),
+    m_pairs (m_reps > 1 ? pairs : 0)
+{
+    m_first = out->reserve (pairs * (aggregate () ? trace_stats::count : 1) *
+            (costs ? 2 : 1));
+}
+
+void
+optk::sweep_rows::add (
+        uint pair,
+        uint rep,
+        uint64_t seed,
+        const double *trace,
+        uint n,
+        const std::string &bench,
+        const std::string &opt,
+        const std::vector<std::string> &props)
+{
+    // the costs, if any, are the second half of the trace
+    uint half = m_costs ? n / 2 : n;
+    if (!aggregate ()) {
+        if (!m_costs) {
+            m_out->submit (m_first + pair, bench, opt, trace, n, seed, props);
+            return;
+        }
+        uint row = m_first + 2 * pair;
+        m_out->submit (row, bench, opt, trace, half, seed, props);
+        m_out->submit (row + 1, bench, opt, trace + half, half, seed, props,
+                "cost");
+        return;
+    }
+
+    pair_state *ps = &m_pairs[pair];
+    std::lock_guard<std::mutex> lock (ps->mtx);
+    if (rep != ps->done) {
+        ps->early[rep].assign (trace, trace + n);
+        return;
+    }
+    if (!ps->stats)
+        ps->stats.reset (new trace_stats (n));
+    ps->stats->add (trace);
+    ps->done++;
+    for (auto it = ps->early.begin ();
+            it != ps->early.end () && it->first == ps->done;
+            it = ps->early.erase (it)) {
+        ps->stats->add (it->second.data ());
+        ps->done++;
+    }
+    if (ps->done < m_reps)
+        return;
+
+    std::vector<double> vals (n);
+    const uint count = trace_stats::count;
+    uint row = m_first + pair * count * (m_costs ? 2 : 1);
+    for (uint s = 0; s < count; s++) {
+        ps->stats->row (s, vals.data ());
+        m_out->submit (row + s, bench, opt, vals.data (), half, 0, props,
+                trace_stats::name (s));
+        if (m_costs)
+            m_out->submit (row + count + s, bench, opt, vals.data () + half,
+                    half, 0, props,
+                    std::string ("cost_") + trace_stats::name (s));
+    }
+    ps->stats.reset ();
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the global seed and the per-thread generators.
+ */
+
+#include <optk/rng.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <random>
+
+namespace {
+
+std::once_flag g_seed_once;
+std::atomic<uint64_t> g_seed (0);
+/** Incremented whenever the seed changes, to reseed the threads lazily.     */
+std::atomic<uint64_t> g_epoch (1);
+/** Counts the threads which have been given a generator so far.            */
+std::atomic<uint64_t> g_threads (0);
+
+void
+init_seed ()
+{
+    std::call_once (g_seed_once, [] {
+        std::random_device rd;
+        g_seed.store (((uint64_t) rd () << 32) ^ rd ());
+    });
+}
+
+struct local {
+    optk::rng gen;
+    uint64_t epoch;
+    uint64_t index;
+};
+
+} // namespace
+
+optk::rng &
+optk::thread_rng ()
+{
+    thread_local local l = { rng (), 0, g_threads++ };
+
+    uint64_t epoch = g_epoch.load (std::memory_order_acquire);
+    if (l.epoch != epoch) {
+        l.gen.seed (rng::derive (get_seed (), l.index));
+        l.epoch = epoch;
+    }
+    return l.gen;
+}
+
+void
+optk::set_seed (uint64_t s)
+{
+    init_seed ();
+    g_seed.store (s);
+    g_epoch++;
+}
+
+uint64_t
+optk::get_seed ()
+{
+    init_seed ();
+    return g_seed.load ();
+}
@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the streaming statistics.
+ */
+
+#include <optk/stats.hpp>
+
+#include <algorithm>
+
+// p2_quantile ----------------------------------------------------------------
+
+optk::p2_quantile::p2_quantile (double p):
+    m_p (p), m_count (0)
+{
+    for (int i = 0; i < 5; i++)
+        m_n[i] = i;
+    m_np[0] = 0;
+    m_np[1] = 2 * p;
+    m_np[2] = 4 * p;
+    m_np[3] = 2 + 2 * p;
+    m_np[4] = 4;
+}
+
+void
+optk::p2_quantile::add (double x)
+{
+    // the first five observations are kept, sorted, as the markers
+    if (m_count < 5) {
+        m_q[m_count++] = x;
+        std::sort (m_q, m_q + m_count);
+        return;
+    }
+    m_count++;
+
+    int k;
+    if (x < m_q[0]) {
+        m_q[0] = x;
+        k = 0;
+    } else if (x >= m_q[4]) {
+        m_q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= m_q[k + 1])
+            k++;
+    }
+
+    for (int i = k + 1; i < 5; i++)
+        m_n[i]++;
+    const double dn[5] = { 0, m_p / 2, m_p, (1 + m_p) / 2, 1 };
+    for (int i = 0; i < 5; i++)
+        m_np[i] += dn[i];
+
+    // adjust the heights of the middle markers, piecewise-parabolically where
+    // that keeps them in order, and otherwise linearly
+    for (int i = 1; i < 4; i++) {
+        double d = m_np[i] - m_n[i];
+        if ((d >= 1 && m_n[i + 1] - m_n[i] > 1) ||
+                (d <= -1 && m_n[i - 1] - m_n[i] < -1)) {
+            int s = d > 0 ? 1 : -1;
+            double q = m_q[i] + s / (m_n[i + 1] - m_n[i - 1]) * (
+                    (m_n[i] - m_n[i - 1] + s) * (m_q[i + 1] - m_q[i]) /
+                    (m_n[i + 1] - m_n[i]) +
+                    (m_n[i + 1] - m_n[i] - s) * (m_q[i] - m_q[i - 1]) /
+                    (m_n[i] - m_n[i - 1]));
+            if (m_q[i - 1] < q && q < m_q[i + 1])
+                m_q[i] = q;
+            else
+                m_q[i] += s * (m_q[i + s] - m_q[i]) / (m_n[i + s] - m_n[i]);
+            m_n[i] += s;
+        }
+    }
+}
+
+double
+optk::p2_quantile::value ()
+{
+    if (m_count == 0)
+        return std::numeric_limits<double>::quiet_NaN ();
+    if (m_count <= 5) {
+        // interpolate between the order statistics
+        double h = (m_count - 1) * m_p;
+        uint lo = (uint) h;
+        uint hi = std::min (lo + 1, (uint) m_count - 1);
+        return m_q[lo] + (h - lo) * (m_q[hi] - m_q[lo]);
+    }
+    return m_q[2];
+}
+
+// trace_stats ----------------------------------------------------------------
+
+const char *
+optk::trace_stats::name (uint s)
+{
+    static const char *names[count] = {
+        "mean", "std", "min", "q25", "median", "q75", "max"
+    };
+    return s < count ? names[s] : "";
+}
+
+optk::trace_stats::trace_stats (uint entries):
+    m_entries (entries), m_n (0), m_moments (entries),
+    m_min (entries, std::numeric_limits<double>::infinity ()),
+    m_max (entries, -std::numeric_limits<double>::infinity ()),
+    m_q25 (entries, p2_quantile (.25)), m_median (entries, p2_quantile (.5)),
+    m_q75 (entries, p2_quantile (.75))
+{ }
+
+void
+optk::trace_stats::add (const double *trace)
+{
+    m_n++;
+    for (uint j = 0; j < m_entries; j++) {
+        double v = trace[j];
+        m_moments[j].add (v);
+        m_min[j] = std::min (m_min[j], v);
+        m_max[j] = std::max (m_max[j], v);
+        m_q25[j].add (v);
+        m_median[j].add (v);
+        m_q75[j].add (v);
+    }
+}
+
+void
+optk::trace_stats::row (uint s, double *out)
+{
+    for (uint j = 0; j < m_entries; j++) {
+        switch (s) {
+            case mean:   out[j] = m_moments[j].mean (); break;
+            case stddev: out[j] = m_moments[j].stddev (); break;
+            case min:    out[j] = m_min[j]; break;
+            case q25:    out[j] = m_q25[j].value (); break;
+            case median: out[j] = m_median[j].value (); break;
+            case q75:    out[j] = m_q75[j].value (); break;
+            default:     out[j] = m_max[j]; break;
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the fixed-size thread pool.
+ */
+
+#include <optk/threadpool.hpp>
+
+#include <algorithm>
+
+optk::thread_pool::thread_pool (uint n) :
+    m_pending (0), m_stop (false)
+{
+    if (n < 1)
+        n = 1;
+    for (uint i = 0; i < n; i++)
+        m_workers.push_back (std::thread (&thread_pool::worker, this));
+}
+
+optk::thread_pool::~thread_pool ()
+{
+    {
+        std::unique_lock<std::mutex> lock (m_mtx);
+        m_done_cv.wait (lock, [this] { return m_pending == 0; });
+        m_stop = true;
+    }
+    m_task_cv.notify_all ();
+
+    std::vector<std::thread>::iterator it;
+    for (it = m_workers.begin (); it != m_workers.end (); it++)
+        it->join ();
+}
+
+void
+optk::thread_pool::submit (std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock (m_mtx);
+        m_tasks.push (task);
+        m_pending++;
+    }
+    m_task_cv.notify_one ();
+}
+
+void
+optk::thread_pool::wait ()
+{
+    std::unique_lock<std::mutex> lock (m_mtx);
+    m_done_cv.wait (lock, [this] { return m_pending == 0; });
+
+    if (m_err) {
+        std::exception_ptr err = m_err;
+        m_err = nullptr;
+        std::rethrow_exception (err);
+    }
+}
+
+void
+optk::thread_pool::parallel_for (uint n, std::function<void(uint)> f)
+{
+    if (n == 0)
+        return;
+
+    // The state is shared with the helper tasks, which may only be dequeued
+    // after this call has returned.
+    struct loop {
+        std::function<void(uint)> f;
+        uint n;
+        std::atomic<uint> next;
+        std::mutex mtx;
+        std::condition_variable done_cv;
+        uint done;
+        std::exception_ptr err;
+    };
+    std::shared_ptr<loop> l = std::make_shared<loop> ();
+    l->f = f;
+    l->n = n;
+    l->next = 0;
+    l->done = 0;
+
+    auto work = [l] () {
+        uint i;
+        while ((i = l->next++) < l->n) {
+            std::exception_ptr err;
+            try {
+                l->f (i);
+            } catch (...) {
+                err = std::current_exception ();
+            }
+            std::lock_guard<std::mutex> lock (l->mtx);
+            if (err && !l->err)
+                l->err = err;
+            if (++l->done == l->n)
+                l->done_cv.notify_all ();
+        }
+    };
+
+    uint helpers = std::min (n - 1, size ());
+    for (uint h = 0; h < helpers; h++)
+        submit (work);
+    work ();
+
+    // every iteration has been claimed; wait for those running elsewhere.
+    std::unique_lock<std::mutex> lock (l->mtx);
+    l->done_cv.wait (lock, [&l] { return l->done == l->n; });
+    if (l->err)
+        std::rethrow_exception (l->err);
+}
+
+void
+optk::thread_pool::worker ()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock (m_mtx);
+            m_task_cv.wait (lock, [this] { return m_stop || !m_tasks.empty (); });
+            if (m_stop && m_tasks.empty ())
+                return;
+            task = m_tasks.front ();
+            m_tasks.pop ();
+        }
+
+        try {
+            task ();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock (m_mtx);
+            if (!m_err)
+                m_err = std::current_exception ();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock (m_mtx);
+            if (--m_pending == 0)
+                m_done_cv.notify_all ();
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements the formatting of phase timings.
+ */
+
+#include <optk/timing.hpp>
+
+const char *
+optk::phase_name (phase p)
+{
+    switch (p) {
+        case phase::generate:
+            return "generate";
+        case phase::evaluate:
+            return "evaluate";
+        case phase::validate:
+            return "validate";
+        default:
+            return "receive";
+    }
+}
+
+std::string
+optk::timings::csv_header ()
+{
+    std::string h =
+        "Benchmark, Optimiser,Phase,Calls,Total (ns),Mean (ns),Max (ns)";
+    for (uint b = 0; b < buckets; b++)
+        h += "," + std::to_string (b);
+    return h + "\n";
+}
+
+std::string
+optk::timings::csv_rows (const std::string &bench, const std::string &opt)
+{
+    std::string out;
+    for (uint i = 0; i < n_phases; i++) {
+        phase p = (phase) i;
+        uint64_t n = calls (p);
+        if (!n)
+            continue;
+        out += bench + "," + opt + "," + phase_name (p) + "," +
+            std::to_string (n) + "," + std::to_string (total (p)) + "," +
+            std::to_string (total (p) / n) + "," + std::to_string (max (p));
+        for (uint b = 0; b < buckets; b++)
+            out += "," + std::to_string (hist (p, b));
+        out += "\n";
+    }
+    return out;
+}
@@ -24,27 +24,40 @@
 // concrete values tyeps ======================================================
 
 inst::param::param
-(const std::string &k, inst::inst_t t) : key(k), type(t)
+(const std::string &k, inst::inst_t t) : key(k), type(t), owner(NULL)
 {}
 
+void
+inst::param::changed ()
+{
+    if (owner)
+        owner->m_dense_valid = false;
+}
+
 inst::node::node (const std::string &k):
-    inst::param (k, inst::inst_t::node)
+    inst::param (k, inst::inst_t::node),
+    m_dense_valid (false)
 {
-    values = std::unordered_map<std::string, param *>();
+    values = value_map();
 }
 
 void
 inst::node::add_item (param *p)
 {
     values.insert({p->get_key(), p});
+    p->owner = this;
+    m_dense_valid = false;
 }
 
 void
 inst::node::add_items (std::vector<param *> items)
 {
     std::vector<param *>::iterator it;
-    for (it = items.begin(); it != items.end(); it++)
+    for (it = items.begin(); it != items.end(); it++) {
         values.insert({(*it)->get_key(), *it});
+        (*it)->owner = this;
+    }
+    m_dense_valid = false;
 }
 
 int
@@ -69,10 +82,27 @@ inst::node::getdbl (const std::string &key)
 double
 inst::node::getdbl (int i)
 {
+    if (m_dense_valid && i >= 0 && (u_int) i < m_dense.size())
+        return m_dense[i];
     std::string key = std::to_string(i);
     return getdbl(key);
 }
 
+const double *
+inst::node::dense (u_int n)
+{
+    if (m_dense_valid && m_dense.size() == n)
+        return m_dense.data();
+
+    m_dense_valid = false;
+    m_dense.resize(n);
+    for (u_int i = 0; i < n; i++)
+        m_dense[i] = getdbl(std::to_string(i));
+    m_dense_valid = true;
+
+    return m_dense.data();
+}
+
 std::string
 inst::node::getstr (const std::string &key)
 {
@@ -100,7 +130,12 @@ inst::node::get_item (const std::string &k)
 void
 inst::node::remove_item (const std::string &k)
 {
-    values.erase(k);
+    value_map::iterator it = values.find(k);
+    if (it == values.end())
+        return;
+    it->second->owner = NULL;
+    values.erase(it);
+    m_dense_valid = false;
 }
 
 inst::int_val::int_val (const std::string &k, int v):
@@ -122,8 +157,8 @@ void
 inst::free_node (inst::node *n)
 {
     // iterate through the elements of this node, freeing them as we do so
-    std::unordered_map<std::string, param *> *vals = n->get_values();
-    std::unordered_map<std::string, param *>::iterator it;
+    value_map *vals = n->get_values();
+    value_map::iterator it;
 
     for (it = vals->begin (); it != vals->end (); it++) {
         inst::param *p = std::get<1>(*it);
@@ -191,17 +226,28 @@ sspace::choice::get (long unsigned int i)
 sspace::randint::randint (std::string n, int l, int u) :
     param_t (n, pt::randint)
 {
-    // initialise Mersenne twister prng using the random device.
     m_lower = l;
     m_upper = u;
-    generator = std::mt19937 (rd());
-    dist = std::uniform_int_distribution<int> (l, u);
 }
 
 int
 sspace::randint::sample()
 {
-    return dist(generator);
+    return sample (optk::thread_rng ());
+}
+
+int
+sspace::randint::sample (optk::rng &r)
+{
+    return r.uniform_int (m_lower, m_upper);
+}
+
+int
+sspace::randint::quantile (double u)
+{
+    long range = (long) m_upper - m_lower + 1;
+    long i = (long) (u * range);
+    return m_lower + (int) std::min (std::max (i, 0L), range - 1);
 }
 
 // uniform ---------------------------------------------------------------------
@@ -211,8 +257,6 @@ sspace::uniform::uniform (std::string n, double l, double u, pt t)
 {
     m_lower = l;
     m_upper = u;
-    generator = std::mt19937 (rd());
-    dist = std::uniform_real_distribution<double> (l, u);
 }
 
 sspace::uniform::uniform (std::string n, double l, double u)
@@ -220,14 +264,18 @@ sspace::uniform::uniform (std::string n, double l, double u)
 {
     m_lower = l;
     m_upper = u;
-    generator = std::mt19937 (rd());
-    dist = std::uniform_real_distribution<double> (l, u);
 }
 
 double
-sspace::uniform::sample()
+sspace::uniform::sample (optk::rng &r)
 {
-    return dist (generator);
+    return r.uniform (m_lower, m_upper);
+}
+
+double
+sspace::uniform::quantile (double u)
+{
+    return m_lower + u * (m_upper - m_lower);
 }
 
 // quniform --------------------------------------------------------------------
@@ -239,9 +287,9 @@ sspace::quniform::quniform (std::string n, double l, double u, double q):
 }
 
 double
-sspace::quniform::sample ()
+sspace::quniform::sample (optk::rng &r)
 {
-    double value = round(dist (generator) / m_q) * m_q;
+    double value = round(uniform::sample (r) / m_q) * m_q;
     if (value < m_lower) {
         value = m_lower;
     } else if (value > m_upper) {
@@ -251,6 +299,15 @@ sspace::quniform::sample ()
     return value;
 }
 
+double
+sspace::quniform::quantile (double u)
+{
+    // clamp to the outermost multiples of q which lie within the bounds
+    double value = round(uniform::quantile (u) / m_q) * m_q;
+    return std::min (std::max (value, std::ceil (m_lower / m_q) * m_q),
+            std::floor (m_upper / m_q) * m_q);
+}
+
 // loguniform ------------------------------------------------------------------
 
 sspace::loguniform::loguniform (std::string n, double l, double u):
@@ -258,7 +315,6 @@ sspace::loguniform::loguniform (std::string n, double l, double u):
 {
    if (l <= 0 || u <= 0)
         throw std::invalid_argument ("bounds cannot be negative or zero");
-    dist = std::uniform_real_distribution<double> (log (l), log (u));
 }
 
 sspace::loguniform::loguniform (std::string n, double l, double u, pt t):
@@ -266,13 +322,19 @@ sspace::loguniform::loguniform (std::string n, double l, double u, pt t):
 {
    if (l <= 0 || u <= 0)
         throw std::invalid_argument ("bounds cannot be negative or zero");
-    dist = std::uniform_real_distribution<double> (log (l), log (u));
 }
 
 double
-sspace::loguniform::sample ()
+sspace::loguniform::sample (optk::rng &r)
 {
-    return exp (dist (generator));
+    return exp (r.uniform (log (m_lower), log (m_upper)));
+}
+
+double
+sspace::loguniform::quantile (double u)
+{
+    double value = exp (log (m_lower) + u * (log (m_upper) - log (m_lower)));
+    return std::min (std::max (value, m_lower), m_upper);
 }
 
 // qloguniform ----------------------------------------------------------------
@@ -289,9 +351,9 @@ sspace::qloguniform::qloguniform (
 }
 
 double
-sspace::qloguniform::sample ()
+sspace::qloguniform::sample (optk::rng &r)
 {
-    double value = round(loguniform::sample()/m_q) * m_q;
+    double value = round(loguniform::sample(r)/m_q) * m_q;
 
     if (value < m_lower) {
         value = m_lower;
@@ -302,6 +364,15 @@ sspace::qloguniform::sample ()
     return value;
 }
 
+double
+sspace::qloguniform::quantile (double u)
+{
+    // clamp to the outermost multiples of q which lie within the bounds
+    double value = round(loguniform::quantile (u) / m_q) * m_q;
+    return std::min (std::max (value, std::ceil (m_lower / m_q) * m_q),
+            std::floor (m_upper / m_q) * m_q);
+}
+
 // normal ----------------------------------------------------------------------
 
 sspace::normal::normal (std::string n, double mu, double sigma) :
@@ -309,8 +380,6 @@ sspace::normal::normal (std::string n, double mu, double sigma) :
 {
     m_mu = mu;
     m_sigma = sigma;
-    generator = std::mt19937 (rd());
-    dist = std::normal_distribution<double> (mu, sigma);
 }
 
 sspace::normal::normal (std::string n, double mu, double sigma, pt t) :
@@ -318,14 +387,69 @@ sspace::normal::normal (std::string n, double mu, double sigma, pt t) :
 {
     m_mu = mu;
     m_sigma = sigma;
-    generator = std::mt19937 (rd());
-    dist = std::normal_distribution<double> (mu, sigma);
 }
 
 double
-sspace::normal::sample ()
+sspace::normal::sample (optk::rng &r)
+{
+    return r.normal (m_mu, m_sigma);
+}
+
+/**
+ * The standard normal quantile function: Acklam's rational approximation,
+ * refined with a single Halley step, giving close to full double precision.
+ * @param p The cumulative probability, in (0, 1).
+ */
+static double
+std_normal_quantile (double p)
+{
+    static const double a[] = {
+        -3.969683028665376e+01,  2.209460984245205e+02,
+        -2.759285104469687e+02,  1.383577518672690e+02,
+        -3.066479806614716e+01,  2.506628277459239e+00
+    };
+    static const double b[] = {
+        -5.447609879822406e+01,  1.615858368580409e+02,
+        -1.556989798598866e+02,  6.680131188771972e+01,
+        -1.328068155288572e+01
+    };
+    static const double c[] = {
+        -7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549732539343734e+00,
+         4.374664141464968e+00,  2.938163982698783e+00
+    };
+    static const double d[] = {
+         7.784695709041462e-03,  3.224671290700398e-01,
+         2.445134137142996e+00,  3.754408661907416e+00
+    };
+    const double plow = 0.02425;
+
+    double x;
+    if (p < plow) {
+        double q = std::sqrt (-2 * std::log (p));
+        x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+            ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    } else if (p <= 1 - plow) {
+        double q = p - 0.5, r = q * q;
+        x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+            (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+    } else {
+        double q = std::sqrt (-2 * std::log (1 - p));
+        x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+            ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    }
+
+    double e = 0.5 * std::erfc (-x / M_SQRT2) - p;
+    double u = e * std::sqrt (2 * M_PI) * std::exp (x * x / 2);
+    return x - u / (1 + x * u / 2);
+}
+
+double
+sspace::normal::quantile (double u)
 {
-    return dist (generator);
+    const double eps = 1e-16;
+    u = std::min (std::max (u, eps), 1 - eps);
+    return m_mu + m_sigma * std_normal_quantile (u);
 }
 
 // qnormal ---------------------------------------------------------------------
@@ -337,9 +461,15 @@ sspace::qnormal::qnormal (std::string n, double mu, double sigma, double q) :
 }
 
 double
-sspace::qnormal::sample ()
+sspace::qnormal::sample (optk::rng &r)
+{
+    return round(normal::sample (r) / m_q) * m_q;
+}
+
+double
+sspace::qnormal::quantile (double u)
 {
-    return round(normal::sample () / m_q) * m_q;
+    return round(normal::quantile (u) / m_q) * m_q;
 }
 
 // lognormal -------------------------------------------------------------------
@@ -353,9 +483,15 @@ sspace::lognormal::lognormal (std::string n, double mu, double sigma, pt t) :
 {}
 
 double
-sspace::lognormal::sample ()
+sspace::lognormal::sample (optk::rng &r)
+{
+    return exp(normal::sample(r));
+}
+
+double
+sspace::lognormal::quantile (double u)
 {
-    return exp(normal::sample());
+    return exp(normal::quantile (u));
 }
 
 // qlognormal ------------------------------------------------------------------
@@ -372,9 +508,15 @@ sspace::qlognormal::qlognormal (
 }
 
 double
-sspace::qlognormal::sample ()
+sspace::qlognormal::sample (optk::rng &r)
 {
-    return round(lognormal::sample() / m_q) * m_q;
+    return round(lognormal::sample(r) / m_q) * m_q;
+}
+
+double
+sspace::qlognormal::quantile (double u)
+{
+    return round(lognormal::quantile (u) / m_q) * m_q;
 }
 
 // validation =================================================================
@@ -401,9 +543,7 @@ find_key (const std::string &k, sspace::sspace_t *sspace)
             return *it;
         }
     }
-    throw std::invalid_argument(
-            "No key match for parameter " + (*it)->get_name()
-            );
+    throw std::invalid_argument("No key match for parameter " + k);
 }
 
 /** Validates an integer-valued parameter.
@@ -600,47 +740,59 @@ validate_str_value (std::string sval, sspace::param_t *sparam)
     }
 }
 
+/** Validates a single concrete value against its description.
+ * @param p The concrete value
+ * @param sp The corresponding description of the parameter
+ * @exception std::invalid_argument if p is invalid under sp.
+ */
+static void
+validate_value (inst::param *p, sspace::param_t *sp)
+{
+    inst::inst_t t = p->get_type();
+    switch (t) {
+        case inst::inst_t::int_val:
+        {
+            inst::int_val *ival = static_cast<inst::int_val *>(p);
+            validate_int_value (ival->get_val (), sp);
+            break;
+        }
+        case inst::inst_t::dbl_val:
+        {
+            inst::dbl_val *dval = static_cast<inst::dbl_val *>(p);
+            validate_dbl_value (dval->get_val(), sp);
+            break;
+        }
+        case inst::inst_t::str_val:
+        {
+            inst::str_val *sval = static_cast<inst::str_val *>(p);
+            validate_str_value (sval->get_val(), sp);
+            break;
+        }
+        case inst::inst_t::node:
+        {
+            inst::node *n = static_cast<inst::node *>(p);
+            if (sp->get_type () != pt::choice)
+                throw std::invalid_argument("Invalid type for subspace");
+            sspace::choice *cs = static_cast<sspace::choice *>(sp);
+            sspace::validate_param_values (n->get_values(), cs->options());
+            break;
+        }
+    }
+}
+
 void
 sspace::validate_param_values (inst::value_map *vals, sspace::sspace_t *sspace)
 {
     inst::value_map::iterator it;
-    for (it = vals->begin(); it != vals->end(); it++) {
-        inst::param *p = std::get<1>(*it);
-        inst::inst_t t = p->get_type();
-        switch (t) {
-            case inst::inst_t::int_val:
-            {
-                inst::int_val *ival = static_cast<inst::int_val *>(p);
-                sspace::param_t *iparam = find_key (std::get<0>(*it), sspace);
-                validate_int_value (ival->get_val (), iparam);
-                break;
-            }
-            case inst::inst_t::dbl_val:
-            {
-                inst::dbl_val *dval = static_cast<inst::dbl_val *>(p);
-                sspace::param_t *dparam = find_key (std::get<0>(*it), sspace);
-                validate_dbl_value (dval->get_val(), dparam);
-                break;
-            }
-            case inst::inst_t::str_val:
-            {
-                inst::str_val *sval = static_cast<inst::str_val *>(p);
-                sspace::param_t *sparam = find_key (std::get<0>(*it), sspace);
-                validate_str_value (sval->get_val(), sparam);
-                break;
-            }
-            case inst::inst_t::node:
-            {
-                inst::node *n = static_cast<inst::node *>(p);
-                sspace::param_t *node = find_key (std::get<0>(*it), sspace);
-                if (node->get_type () != pt::choice)
-                    throw std::invalid_argument("Invalid type for subspace");
-                sspace::choice *cs = static_cast<sspace::choice *>(node);
-                validate_param_values (n->get_values(), cs->options());
-                break;
-            }
-        }
-    }
+    for (it = vals->begin(); it != vals->end(); it++)
+        validate_value (std::get<1>(*it), find_key (std::get<0>(*it), sspace));
+}
+
+void
+sspace::validate_dbl_values (const double *vals, u_int n, sspace::param_t *param)
+{
+    for (u_int i = 0; i < n; i++)
+        validate_dbl_value (vals[i], param);
 }
 
 #define deltype(type, src) \
@@ -689,3 +841,412 @@ sspace::free_ss (sspace::sspace_t *ss)
     // delete ss;
 }
 
+
+// compiled search spaces =====================================================
+
+void
+sspace::compiled::compile (sspace::sspace_t *space)
+{
+    m_type.clear ();
+    m_name.clear ();
+    m_a.clear ();
+    m_b.clear ();
+    m_q.clear ();
+    m_end.clear ();
+    m_off.clear ();
+    m_count.clear ();
+    m_ints.clear ();
+    m_dbls.clear ();
+    m_strs.clear ();
+    m_index.clear ();
+    m_dims = 0;
+
+    compile_range (space);
+
+    for (uint32_t i = 0; i < size (); i = m_end[i])
+        m_index.emplace (m_name[i], i);
+}
+
+/** Appends the options of a categorical parameter to the pool of its type. */
+template <typename T>
+static void
+pool_options (sspace::param_t *p, std::vector<T> *pool, uint32_t *off,
+        uint32_t *count)
+{
+    std::vector<T> *opts = static_cast<sspace::categorical<T> *>(p)->values ();
+    *off = pool->size ();
+    *count = opts->size ();
+    pool->insert (pool->end (), opts->begin (), opts->end ());
+}
+
+void
+sspace::compiled::compile_range (sspace::sspace_t *space)
+{
+    for (sspace::param_t *p: *space) {
+        uint32_t i = size ();
+        double a = 0., b = 0., q = 0.;
+        uint32_t off = 0, count = 0;
+
+        m_type.push_back (p->get_type ());
+        m_name.push_back (p->get_name ());
+        switch (p->get_type ()) {
+            case pt::categorical_int:
+                pool_options<int> (p, &m_ints, &off, &count);
+                break;
+            case pt::categorical_dbl:
+                pool_options<double> (p, &m_dbls, &off, &count);
+                break;
+            case pt::categorical_str:
+                pool_options<std::string> (p, &m_strs, &off, &count);
+                break;
+            case pt::randint:
+                a = static_cast<sspace::randint *>(p)->m_lower;
+                b = static_cast<sspace::randint *>(p)->m_upper;
+                break;
+            case pt::quniform:
+                q = static_cast<sspace::quniform *>(p)->m_q;
+                // fall through
+            case pt::uniform:
+            case pt::loguniform:
+                a = static_cast<sspace::uniform *>(p)->m_lower;
+                b = static_cast<sspace::uniform *>(p)->m_upper;
+                break;
+            case pt::qloguniform:
+                q = static_cast<sspace::qloguniform *>(p)->m_q;
+                a = static_cast<sspace::uniform *>(p)->m_lower;
+                b = static_cast<sspace::uniform *>(p)->m_upper;
+                break;
+            case pt::qnormal:
+                q = static_cast<sspace::qnormal *>(p)->m_q;
+                // fall through
+            case pt::normal:
+            case pt::lognormal:
+                a = static_cast<sspace::normal *>(p)->m_mu;
+                b = static_cast<sspace::normal *>(p)->m_sigma;
+                break;
+            case pt::qlognormal:
+                q = static_cast<sspace::qlognormal *>(p)->m_q;
+                a = static_cast<sspace::normal *>(p)->m_mu;
+                b = static_cast<sspace::normal *>(p)->m_sigma;
+                break;
+            case pt::choice:
+                count = static_cast<sspace::choice *>(p)->count ();
+                break;
+        }
+        m_a.push_back (a);
+        m_b.push_back (b);
+        m_q.push_back (q);
+        m_off.push_back (off);
+        m_count.push_back (count);
+        m_end.push_back (i + 1);
+
+        if (p->get_type () == pt::choice) {
+            compile_range (static_cast<sspace::choice *>(p)->options ());
+            m_end[i] = size ();
+        } else {
+            m_dims++;
+        }
+    }
+}
+
+/** Rounds v to a multiple of q. */
+static inline double
+quantise (double v, double q)
+{
+    return round (v / q) * q;
+}
+
+/** Clamps v to [lower, upper]. */
+static inline double
+clamp (double v, double lower, double upper)
+{
+    return std::min (std::max (v, lower), upper);
+}
+
+/**
+ * Samples a real-valued entry, as the sample method of its parameter does.
+ * @param t The type of the entry.
+ * @param a, b, q The numeric description of the entry.
+ * @param r The generator to draw from.
+ */
+static double
+sample_real (pt t, double a, double b, double q, optk::rng &r)
+{
+    switch (t) {
+        case pt::uniform:
+            return r.uniform (a, b);
+        case pt::quniform:
+            return clamp (quantise (r.uniform (a, b), q), a, b);
+        case pt::loguniform:
+            return exp (r.uniform (log (a), log (b)));
+        case pt::qloguniform:
+            return clamp (quantise (exp (r.uniform (log (a), log (b))), q),
+                    a, b);
+        case pt::normal:
+            return r.normal (a, b);
+        case pt::qnormal:
+            return quantise (r.normal (a, b), q);
+        case pt::lognormal:
+            return exp (r.normal (a, b));
+        case pt::qlognormal:
+            return quantise (exp (r.normal (a, b)), q);
+        default:
+            return 0.;
+    }
+}
+
+/**
+ * Maps u onto a real-valued entry, as the quantile method of its parameter
+ * does.
+ * @param t The type of the entry.
+ * @param a, b, q The numeric description of the entry.
+ * @param u The cumulative probability.
+ */
+static double
+quantile_real (pt t, double a, double b, double q, double u)
+{
+    switch (t) {
+        case pt::uniform:
+            return a + u * (b - a);
+        case pt::quniform:
+            return clamp (quantise (a + u * (b - a), q),
+                    std::ceil (a / q) * q, std::floor (b / q) * q);
+        case pt::loguniform:
+            return clamp (exp (log (a) + u * (log (b) - log (a))), a, b);
+        case pt::qloguniform:
+            return clamp (
+                    quantise (quantile_real (pt::loguniform, a, b, 0., u), q),
+                    std::ceil (a / q) * q, std::floor (b / q) * q);
+        case pt::normal:
+        {
+            const double eps = 1e-16;
+            u = std::min (std::max (u, eps), 1 - eps);
+            return a + b * std_normal_quantile (u);
+        }
+        case pt::qnormal:
+            return quantise (quantile_real (pt::normal, a, b, 0., u), q);
+        case pt::lognormal:
+            return exp (quantile_real (pt::normal, a, b, 0., u));
+        case pt::qlognormal:
+            return quantise (
+                    exp (quantile_real (pt::normal, a, b, 0., u)), q);
+        default:
+            return 0.;
+    }
+}
+
+uint32_t
+sspace::compiled::pick (uint32_t i, optk::rng &r) const
+{
+    return m_off[i] + r.uniform_int (0, m_count[i] - 1);
+}
+
+void
+sspace::compiled::sample (inst::node *parent, optk::rng &r) const
+{
+    sample_range (parent, 0, size (), r);
+}
+
+void
+sspace::compiled::sample_range (inst::node *parent, uint32_t first,
+        uint32_t last, optk::rng &r) const
+{
+    for (uint32_t i = first; i < last; i = m_end[i]) {
+        const std::string &n = m_name[i];
+        switch (m_type[i]) {
+            case pt::categorical_int:
+                parent->add_item (new inst::int_val (n, m_ints[pick (i, r)]));
+                break;
+            case pt::categorical_dbl:
+                parent->add_item (new inst::dbl_val (n, m_dbls[pick (i, r)]));
+                break;
+            case pt::categorical_str:
+                parent->add_item (new inst::str_val (n, m_strs[pick (i, r)]));
+                break;
+            case pt::randint:
+                parent->add_item (new inst::int_val (n,
+                            r.uniform_int ((int) m_a[i], (int) m_b[i])));
+                break;
+            case pt::choice:
+            {
+                inst::node *ss = new inst::node (n);
+                sample_range (ss, i + 1, m_end[i], r);
+                parent->add_item (ss);
+                break;
+            }
+            default:
+                parent->add_item (new inst::dbl_val (n, sample_real (
+                                m_type[i], m_a[i], m_b[i], m_q[i], r)));
+                break;
+        }
+    }
+}
+
+void
+sspace::compiled::map (inst::node *parent, const double *u) const
+{
+    map_range (parent, 0, size (), &u);
+}
+
+void
+sspace::compiled::map_range (inst::node *parent, uint32_t first,
+        uint32_t last, const double **u) const
+{
+    for (uint32_t i = first; i < last; i = m_end[i]) {
+        const std::string &n = m_name[i];
+        if (m_type[i] == pt::choice) {
+            inst::node *ss = new inst::node (n);
+            map_range (ss, i + 1, m_end[i], u);
+            parent->add_item (ss);
+            continue;
+        }
+
+        double v = **u;
+        (*u)++;
+        // the option of a categorical entry, as categorical::quantile
+        size_t opt = m_off[i] + std::min ((size_t) (v * m_count[i]),
+                (size_t) m_count[i] - 1);
+        switch (m_type[i]) {
+            case pt::categorical_int:
+                parent->add_item (new inst::int_val (n, m_ints[opt]));
+                break;
+            case pt::categorical_dbl:
+                parent->add_item (new inst::dbl_val (n, m_dbls[opt]));
+                break;
+            case pt::categorical_str:
+                parent->add_item (new inst::str_val (n, m_strs[opt]));
+                break;
+            case pt::randint:
+            {
+                long range = (long) m_b[i] - (long) m_a[i] + 1;
+                long k = (long) (v * range);
+                parent->add_item (new inst::int_val (n, (int) m_a[i] +
+                            (int) std::min (std::max (k, 0L), range - 1)));
+                break;
+            }
+            default:
+                parent->add_item (new inst::dbl_val (n, quantile_real (
+                                m_type[i], m_a[i], m_b[i], m_q[i], v)));
+                break;
+        }
+    }
+}
+
+void
+sspace::compiled::validate (inst::value_map *vals) const
+{
+    inst::value_map::iterator it;
+    for (it = vals->begin (); it != vals->end (); it++) {
+        auto sp = m_index.find (std::get<0>(*it));
+        if (sp == m_index.end ())
+            throw std::invalid_argument (
+                    "No key match for parameter " + std::get<0>(*it));
+        validate_value (std::get<1>(*it), std::get<1>(*sp));
+    }
+}
+
+void
+sspace::compiled::validate_range (inst::value_map *vals, uint32_t first,
+        uint32_t last) const
+{
+    inst::value_map::iterator it;
+    for (it = vals->begin (); it != vals->end (); it++) {
+        uint32_t i = first;
+        while (i < last && m_name[i] != std::get<0>(*it))
+            i = m_end[i];
+        if (i >= last)
+            throw std::invalid_argument (
+                    "No key match for parameter " + std::get<0>(*it));
+        validate_value (std::get<1>(*it), i);
+    }
+}
+
+void
+sspace::compiled::validate (uint32_t i, const double *vals, u_int n) const
+{
+    for (u_int j = 0; j < n; j++)
+        validate_dbl (vals[j], i);
+}
+
+void
+sspace::compiled::validate_value (inst::param *p, uint32_t i) const
+{
+    switch (p->get_type ()) {
+        case inst::inst_t::int_val:
+        {
+            int v = static_cast<inst::int_val *>(p)->get_val ();
+            if (m_type[i] == pt::categorical_int) {
+                const int *opts = m_ints.data () + m_off[i];
+                if (std::find (opts, opts + m_count[i], v) == opts + m_count[i])
+                    throw std::invalid_argument ("Categorical integer value "
+                            "for " + m_name[i] + " not in allowed values.");
+            } else if (m_type[i] == pt::randint) {
+                if (v < m_a[i] || v > m_b[i])
+                    throw std::invalid_argument (
+                            "Value for " + m_name[i] + " out of range.");
+            } else {
+                throw std::invalid_argument ("Integer value was incorrectly "
+                        "provided for parameter: " + m_name[i]);
+            }
+            break;
+        }
+        case inst::inst_t::dbl_val:
+            validate_dbl (static_cast<inst::dbl_val *>(p)->get_val (), i);
+            break;
+        case inst::inst_t::str_val:
+        {
+            if (m_type[i] != pt::categorical_str)
+                throw std::invalid_argument ("String value was incorrectly "
+                        "provided for parameter: " + m_name[i]);
+            std::string v = static_cast<inst::str_val *>(p)->get_val ();
+            const std::string *opts = m_strs.data () + m_off[i];
+            if (std::find (opts, opts + m_count[i], v) == opts + m_count[i])
+                throw std::invalid_argument ("Categorical string value for " +
+                        m_name[i] + " not in allowed values list.");
+            break;
+        }
+        case inst::inst_t::node:
+            if (m_type[i] != pt::choice)
+                throw std::invalid_argument ("Invalid type for subspace");
+            validate_range (static_cast<inst::node *>(p)->get_values (),
+                    i + 1, m_end[i]);
+            break;
+    }
+}
+
+void
+sspace::compiled::validate_dbl (double v, uint32_t i) const
+{
+    pt t = m_type[i];
+    switch (t) {
+        case pt::categorical_dbl:
+        {
+            const double *opts = m_dbls.data () + m_off[i];
+            for (uint32_t j = 0; j < m_count[i]; j++)
+                if (dbleq (v, opts[j]))
+                    return;
+            throw std::invalid_argument ("Categorical double value for " +
+                    m_name[i] + " not in allowed values.");
+        }
+        case pt::uniform:
+        case pt::quniform:
+        case pt::loguniform:
+        case pt::qloguniform:
+            if (v < m_a[i] || v > m_b[i])
+                throw std::invalid_argument (
+                        "Value for " + m_name[i] + " out of range.");
+            break;
+        case pt::normal:
+        case pt::qnormal:
+        case pt::lognormal:
+        case pt::qlognormal:
+            break;
+        default:
+            throw std::invalid_argument ("Double value was incorrectly "
+                    "provided for parameter: " + m_name[i]);
+    }
+    double q = m_q[i];
+    if (q != 0. && !dbleq (v - (double) std::round (v / q) * q, 0))
+        throw std::invalid_argument (
+                "Value for " + m_name[i] + " is not properly quantised.");
+}
@@ -22,6 +22,12 @@
 #include <tests/benchmark_test.hpp>
 
 #include <benchmarks/synthetic.hpp>
+#include <benchmarks/simd.hpp>
+#include <benchmarks/variant.hpp>
+#include <optk/core.hpp>
+#include <optk/threadpool.hpp>
+#include <optk/trace.hpp>
+#include <optimisers/random.hpp>
 
 static int64_t
 ulps_distance(const double a, const double b)
@@ -758,11 +764,320 @@ test_unknown_benchmarks ()
     }
 }
 
+static void
+test_registry ()
+{
+    syn::registry reg;
+    std::vector<syn::entry> *all = reg.entries ();
+    assert (all->size () > 100u);
+
+    // the entries describe the benchmarks they construct
+    syn::entry *fst = &all->at (0);
+    assert (fst->name == std::string ("ackley1"));
+    assert (fst->dims == 10u);
+    syn::synthetic *a1 = fst->make ();
+    assert (a1->get_name () == fst->name);
+    assert (a1->get_dims () == fst->dims);
+    delete a1;
+
+    // an empty selection selects everything
+    assert (reg.select ("").size () == all->size ());
+
+    // selection by name, with underscores in place of spaces
+    std::vector<syn::entry> named = reg.select ("bartels_conn,hartman6");
+    assert (named.size () == 2u);
+    assert (named[0].name == std::string ("bartels conn"));
+    assert (named[1].name == std::string ("hartman6"));
+
+    // selection by properties requires all of them
+    std::vector<syn::entry> tagged = reg.select ("scalable,multimodal");
+    assert (tagged.size () > 0u);
+    for (uint i = 0; i < tagged.size (); i++) {
+        std::vector<syn::properties> *ps = &tagged[i].props;
+        assert (std::find (ps->begin (), ps->end (),
+                    syn::properties::scalable) != ps->end ());
+        assert (std::find (ps->begin (), ps->end (),
+                    syn::properties::multimodal) != ps->end ());
+    }
+
+    // property names round-trip
+    syn::properties p;
+    assert (syn::parse_property (
+                syn::property_name (syn::properties::non_separable), &p));
+    assert (p == syn::properties::non_separable);
+    assert (!syn::parse_property ("not a property", &p));
+
+    bool caught = false;
+    try {
+        reg.select ("not_a_benchmark");
+    } catch (const std::invalid_argument &e) {
+        caught = true;
+    }
+    assert (caught);
+}
+
+static void
+test_batch_evaluation ()
+{
+    syn::registry reg;
+    std::vector<syn::entry> *all = reg.entries ();
+    const u_int n = 7;
+
+    for (u_int e = 0; e < all->size (); e++) {
+        syn::synthetic *b = all->at (e).make ();
+        u_int d = b->get_dims ();
+        sspace::sspace_t *ss = b->get_search_space ();
+
+        // points are stored one parameter per row
+        std::vector<double> x (d * n);
+        for (u_int j = 0; j < d; j++)
+            for (u_int i = 0; i < n; i++)
+                x[j * n + i] = static_cast<sspace::uniform *>(ss->at (j))->sample ();
+
+        // the default implementation goes through inst::node and evaluate
+        std::vector<double> expected (n), got (n);
+        b->optk::benchmark::evaluate_batch (x.data (), n, expected.data ());
+        b->evaluate_batch (x.data (), n, got.data ());
+        for (u_int i = 0; i < n; i++)
+            assert ((std::isnan (expected[i]) && std::isnan (got[i])) ||
+                    nearly_equal (expected[i], got[i]));
+
+        // out of bounds coordinates are rejected
+        x[(d - 1) * n + n / 2] =
+            static_cast<sspace::uniform *>(ss->at (d - 1))->m_upper + 1.;
+        bool caught = false;
+        try {
+            b->evaluate_batch (x.data (), n, got.data ());
+        } catch (const std::invalid_argument &e) {
+            caught = true;
+        }
+        assert (caught);
+
+        // unless validation is disabled
+        b->set_validation (false);
+        b->evaluate_batch (x.data (), n, got.data ());
+        delete b;
+    }
+}
+
+static void
+test_simd_kernels ()
+{
+    std::vector<std::function<syn::synthetic *(u_int)>> makers = {
+        [](u_int d) { return new syn::ackley1 (d); },
+        [](u_int d) { return new syn::alpine1 (d); },
+        [](u_int d) { return new syn::alpine2 (d); },
+        [](u_int d) { return new syn::brown (d); },
+        [](u_int d) { return new syn::chung_reynolds (d); },
+        [](u_int d) { return new syn::cosine_mixture (d); },
+        [](u_int d) { return new syn::deb1 (d); },
+        [](u_int d) { return new syn::dixon_price (d); },
+        [](u_int d) { return new syn::exponential (d); },
+        [](u_int d) { return new syn::griewank (d); },
+    };
+    const syn::simd::level levels[] = {
+        syn::simd::level::avx2, syn::simd::level::avx512
+    };
+    const u_int dims[] = {2, 3, 10, 101, 1000};
+    const u_int n = 13;
+    syn::simd::level orig = syn::simd::active ();
+
+    for (auto make: makers) {
+        for (u_int d: dims) {
+            syn::synthetic *b = make (d);
+            sspace::sspace_t *ss = b->get_search_space ();
+            std::vector<double> x (d * n), pt (d);
+            for (u_int j = 0; j < d; j++)
+                for (u_int i = 0; i < n; i++)
+                    x[j * n + i] =
+                        static_cast<sspace::uniform *>(ss->at (j))->sample ();
+
+            // the scalar level gives the plain C++ implementation
+            syn::simd::set_active (syn::simd::level::scalar);
+            std::vector<double> expected (n);
+            b->evaluate_batch (x.data (), n, expected.data ());
+
+            for (syn::simd::level l: levels) {
+                if (!syn::simd::supported (l))
+                    continue;
+                syn::simd::set_active (l);
+                std::vector<double> got (n);
+                b->evaluate_batch (x.data (), n, got.data ());
+                for (u_int i = 0; i < n; i++) {
+                    for (u_int j = 0; j < d; j++)
+                        pt[j] = x[j * n + i];
+                    double single = b->evaluate_dense (pt.data ());
+                    double tol = 1e-11 * std::max (1., std::fabs (expected[i]));
+                    assert (std::fabs (got[i] - expected[i]) <= tol);
+                    assert (std::fabs (single - expected[i]) <= tol);
+                }
+            }
+            delete b;
+        }
+    }
+    syn::simd::set_active (orig);
+
+    assert (syn::simd::supported (syn::simd::level::scalar));
+    assert (syn::simd::supported (syn::simd::best ()));
+    for (syn::simd::level l: levels) {
+        if (syn::simd::supported (l))
+            continue;
+        bool caught = false;
+        try {
+            syn::simd::set_active (l);
+        } catch (const std::invalid_argument &e) {
+            caught = true;
+        }
+        assert (caught);
+    }
+}
+
+/** @returns A point of the space of a variant of ackley1. */
+static inst::set
+variant_point (double x0, double x1, double s = -1)
+{
+    inst::node *n = new inst::node ("x");
+    n->add_item (new inst::dbl_val ("0", x0));
+    n->add_item (new inst::dbl_val ("1", x1));
+    if (s >= 0)
+        n->add_item (new inst::dbl_val ("fidelity", s));
+    return n;
+}
+
+static void
+test_variants ()
+{
+    syn::variant_spec v = syn::parse_variant (
+            "noise=0.5,cost=2,jitter=0.25,fidelity=0.1,bias=3,wait=spin");
+    assert (v.noise == .5 && v.cost == 2 && v.jitter == .25 &&
+            v.fidelity == .1 && v.bias == 3 && v.wait == syn::latency::spin);
+    assert (syn::is_variant (v) && !syn::is_variant (syn::parse_variant ("")));
+    for (const char *bad: {"noise", "noise=-1", "cost=x", "jitter=1",
+            "fidelity=1", "wait=often", "speed=2"}) {
+        bool caught = false;
+        try {
+            syn::parse_variant (bad);
+        } catch (const std::invalid_argument &) {
+            caught = true;
+        }
+        assert (caught);
+    }
+
+    syn::ackley1 ref (2);
+    inst::set p = variant_point (1., 2.);
+    const double f = ref.evaluate (p);
+
+    // the noise is reproducible, but differs between evaluations of a point
+    syn::variant_spec noisy = syn::parse_variant ("noise=0.1");
+    syn::variant a (new syn::ackley1 (2), noisy, 5);
+    syn::variant b (new syn::ackley1 (2), noisy, 5);
+    syn::variant c (new syn::ackley1 (2), noisy, 6);
+    double a0 = a.evaluate (p), a1 = a.evaluate (p);
+    assert (a0 != a1 && a0 != f && std::fabs (a0 - f) < 1.);
+    assert (b.evaluate (p) == a0 && b.evaluate (p) == a1);
+    assert (c.evaluate (p) != a0);
+    assert (a.exact (p, a0) == f && ref.exact (p, f) == f);
+    assert (a.get_search_space ()->size () == 2 && a.cost (p) == 0.);
+
+    // a batch draws the same noise as single evaluations
+    syn::variant d (new syn::ackley1 (2), noisy, 5);
+    const double x[] = { 1., 1., 2., 2. };
+    double out[2];
+    d.evaluate_batch (x, 2, out);
+    assert (out[0] == a0 && out[1] == a1);
+
+    // the fidelity is a parameter, and full fidelity is the benchmark itself
+    syn::variant m (new syn::ackley1 (2),
+            syn::parse_variant ("cost=2,jitter=0.5,fidelity=0.25"), 0);
+    assert (m.get_search_space ()->size () == 3);
+    inst::set full = variant_point (1., 2., 1.);
+    inst::set low = variant_point (1., 2., .25);
+    assert (m.evaluate (full) == f);
+    assert (nearly_equal (m.evaluate (low),
+                f + .75 * (std::cos (1.) + std::cos (2.)) / 2));
+    assert (m.cost (full) == m.cost (full));
+    assert (m.cost (full) >= 1. && m.cost (full) <= 3.);
+    assert (nearly_equal (m.cost (low), .25 * m.cost (full)));
+    assert (m.exact (low, m.evaluate (low)) == f);
+    inst::set under = variant_point (1., 2., .2);
+    bool caught = false;
+    try {
+        m.evaluate (under);
+    } catch (const std::invalid_argument &) {
+        caught = true;
+    }
+    assert (caught);
+    inst::free_node (under);
+
+    // the core loops total the costs, however the trials are evaluated
+    syn::variant_spec costly = syn::parse_variant ("cost=1,jitter=0.5");
+    optk::thread_pool pool (3);
+    double total = -1;
+    for (int loop = 0; loop < 3; loop++) {
+        syn::variant vb (new syn::ackley1 (2), costly, 0);
+        random_search rs;
+        rs.seed (11);
+        optk::trace tr (12, 1, false, true);
+        if (loop == 0)
+            optk::core_loop (&vb, &rs, tr);
+        else if (loop == 1)
+            optk::core_loop_batch (&vb, &rs, tr, 4, &pool);
+        else
+            optk::core_loop_async (&vb, &rs, tr, 3, &pool);
+        double last = tr.costs ()[tr.size () - 1];
+        assert (last >= 6. && last <= 18.);
+        assert (loop == 0 || nearly_equal (last, total));
+        total = last;
+    }
+
+    // the noise of a run follows its trials, however they are evaluated
+    std::vector<double> first;
+    for (int loop = 0; loop < 3; loop++) {
+        syn::variant vb (new syn::ackley1 (2), noisy, 9);
+        random_search rs;
+        rs.seed (11);
+        optk::trace tr (12);
+        if (loop == 0)
+            optk::core_loop (&vb, &rs, tr);
+        else if (loop == 1)
+            optk::core_loop_batch (&vb, &rs, tr, 4, &pool);
+        else
+            optk::core_loop_async (&vb, &rs, tr, 3, &pool);
+        std::vector<double> vals (tr.data (), tr.data () + 12);
+        std::sort (vals.begin (), vals.end ());
+        assert (loop == 0 || vals == first);
+        first = vals;
+    }
+
+    // summaries measure the exact values, so that cheap evaluations which
+    // fall below the optimum do not reach the target
+    syn::variant_spec biased = syn::parse_variant ("fidelity=0.1,bias=-50");
+    optk::trace seen (60), sum (60, 1, false, false, true);
+    for (optk::trace *tr: {&seen, &sum}) {
+        syn::variant vb (new syn::ackley1 (2), biased, 0);
+        random_search rs;
+        rs.seed (4);
+        tr->target (ref.get_opt (), 1e-3);
+        optk::core_loop (&vb, &rs, *tr);
+    }
+    assert (seen.min () < ref.get_opt () - 1.);
+    assert (sum.min () > ref.get_opt () + 1e-3);
+    assert (sum.data ()[0] == sum.min () && sum.data ()[5] == 0.);
+
+    inst::free_node (p);
+    inst::free_node (full);
+    inst::free_node (low);
+}
+
 void
 run_benchmark_tests()
 {
+    test_registry ();
+    test_batch_evaluation ();
+    test_simd_kernels ();
     test_synthetic_benchmarks ();
     test_regression_benchmarks ();
     test_unknown_benchmarks ();
+    test_variants ();
     std::cout << "All gridsearch tests pass" << std::endl;
 }
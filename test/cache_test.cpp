@@ -0,0 +1,242 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for the cache of evaluations.
+ */
+
+#include <optimisers/gridsearch.hpp>
+#include <optimisers/random.hpp>
+#include <optk/cache.hpp>
+#include <optk/core.hpp>
+#include <optk/threadpool.hpp>
+#include <optk/trace.hpp>
+
+#include <tests/core_test.hpp>
+#include <benchmarks/synthetic.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static const std::string cache_path = "/tmp/optk_cache_test.cache";
+
+/** Wraps a benchmark, and counts the points which it evaluates. */
+class counting: public optk::benchmark {
+    public:
+        counting (optk::benchmark *b):
+            optk::benchmark (b->get_name ()), m_b (b), m_calls (0)
+        { }
+
+        sspace::sspace_t *get_search_space () { return m_b->get_search_space (); }
+
+        double
+        evaluate (inst::set x)
+        {
+            m_calls++;
+            return m_b->evaluate (x);
+        }
+
+        void
+        evaluate_batch (const double *x, u_int n, double *out)
+        {
+            m_calls += n;
+            m_b->evaluate_batch (x, n, out);
+        }
+
+        int calls () { return m_calls; }
+
+    private:
+        optk::benchmark *m_b;
+        std::atomic<int> m_calls;
+};
+
+/** Checks that keys depend on the values, and only on the values. */
+static void
+test_keys ()
+{
+    inst::node a ("a"), b ("b");
+    inst::dbl_val x0 ("0", 1.5), x1 ("1", -0.), y1 ("1", 0.), y0 ("0", 1.5);
+    a.add_items ({&x0, &x1});
+    b.add_items ({&y1, &y0});
+    uint64_t k = optk::eval_cache::key ("f", &a);
+    assert (k == optk::eval_cache::key ("f", &b));
+    assert (k != optk::eval_cache::key ("g", &a));
+
+    // a point of a flat space hashes as the parameter set would
+    sspace::uniform u0 ("0", -2, 2), u1 ("1", -2, 2);
+    sspace::sspace_t ss ({&u0, &u1});
+    double pt[] = {1.5, 0};
+    assert (k == optk::eval_cache::key ("f", &ss, pt));
+    double soa[] = {9, 1.5, 9, 0};
+    assert (k == optk::eval_cache::key ("f", &ss, soa + 1, 2));
+
+    // values of other types or names, or in a nested node, differ
+    inst::node c ("c"), d ("d"), e ("e"), sub ("sub");
+    inst::int_val i0 ("0", 1);
+    inst::dbl_val z0 ("0", 1.5), z1 ("1", 1e-300), w ("2", 0.);
+    c.add_items ({&z0, &z1});
+    d.add_items ({&i0, &w});
+    sub.add_item (&w);
+    e.add_items ({&x0, &x1, &sub});
+    assert (k != optk::eval_cache::key ("f", &c));
+    assert (k != optk::eval_cache::key ("f", &d));
+    assert (k != optk::eval_cache::key ("f", &e));
+    assert (optk::eval_cache::key ("f", &e) == optk::eval_cache::key ("f", &e));
+}
+
+/** Checks the memory tier, and the file tier shared between caches. */
+static void
+test_tiers ()
+{
+    optk::eval_cache mem;
+    double v;
+    assert (!mem.find (42, &v) && mem.misses () == 1);
+    mem.insert (42, 3.25);
+    assert (mem.find (42, &v) && v == 3.25 && mem.hits () == 1);
+    assert (mem.persisted () == 0);
+
+    std::remove (cache_path.c_str ());
+    {
+        optk::eval_cache c (cache_path, 64);
+        for (uint64_t k = 1; k <= 10; k++)
+            c.insert (k * 977, (double) k / 3);
+        assert (c.persisted () == 10);
+    }
+    {
+        // a new cache starts warm, and the requested size is ignored
+        optk::eval_cache c (cache_path, 4);
+        assert (c.persisted () == 10);
+        for (uint64_t k = 1; k <= 10; k++)
+            assert (c.find (k * 977, &v) && v == (double) k / 3);
+        assert (!c.find (5, &v));
+
+        // the table stops growing once it is three quarters full
+        for (uint64_t k = 11; k <= 100; k++)
+            c.insert (k * 977, (double) k);
+        assert (c.persisted () == 48);
+        assert (c.find (100 * 977, &v) && v == 100.);
+    }
+
+    // caches in several threads (or processes) share the file
+    std::remove (cache_path.c_str ());
+    {
+        optk::eval_cache a (cache_path, 1 << 12), b (cache_path);
+        std::thread t1 ([&] { for (uint64_t k = 1; k <= 1000; k++)
+                a.insert (2 * k, (double) k); });
+        std::thread t2 ([&] { for (uint64_t k = 1; k <= 1000; k++)
+                b.insert (2 * k + 1, (double) -k); });
+        t1.join ();
+        t2.join ();
+        optk::eval_cache c (cache_path);
+        assert (c.persisted () == 2000);
+        for (uint64_t k = 1; k <= 1000; k++) {
+            assert (c.find (2 * k, &v) && v == (double) k);
+            assert (c.find (2 * k + 1, &v) && v == (double) -k);
+        }
+    }
+
+    // other files are refused
+    {
+        std::ofstream f (cache_path, std::ios::trunc);
+        f << "not a cache, but long enough to hold the header of one .........";
+    }
+    bool caught = false;
+    try {
+        optk::eval_cache c (cache_path);
+    } catch (const std::runtime_error &) {
+        caught = true;
+    }
+    assert (caught);
+    std::remove (cache_path.c_str ());
+}
+
+/**
+ * Checks that a cached benchmark gives the same values, and that a second,
+ * identical run makes no evaluations at all.
+ */
+static void
+test_cached_runs ()
+{
+    syn::ackley1 bench (3);
+    std::remove (cache_path.c_str ());
+
+    optk::trace plain (40);
+    {
+        random_search rs;
+        rs.seed (3);
+        optk::core_loop (&bench, &rs, plain);
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        optk::eval_cache cache (cache_path);
+        counting cnt (&bench);
+        optk::cached_benchmark cb (&cnt, &cache);
+        random_search rs;
+        rs.seed (3);
+        optk::trace tr (40);
+        optk::core_loop (&cb, &rs, tr);
+        assert (cnt.calls () == (pass ? 0 : 40));
+        for (uint i = 0; i < 40; i++)
+            assert (tr.data ()[i] == plain.data ()[i]);
+    }
+
+    // gridsearch revisits nothing, but a second sweep is free, including
+    // through the batched loop
+    optk::thread_pool pool (2);
+    optk::eval_cache cache;
+    for (int pass = 0; pass < 2; pass++) {
+        counting cnt (&bench);
+        optk::cached_benchmark cb (&cnt, &cache);
+        gridsearch gs;
+        optk::trace tr (50);
+        optk::core_loop_batch (&cb, &gs, tr, 5, &pool);
+        assert (cnt.calls () == (pass ? 0 : 50));
+    }
+
+    // only the points which are not found are evaluated in a batch
+    counting cnt (&bench);
+    optk::cached_benchmark cb (&cnt, &cache);
+    double x2[] = {.1, .7,   .2, .8,   .3, .9}, out[3], ref[3];
+    cb.evaluate_batch (x2, 2, out);
+    assert (cnt.calls () == 2);
+    double x[] = {.1, .4, .7,   .2, .5, .8,   .3, .6, .9};
+    cb.evaluate_batch (x, 3, out);
+    assert (cnt.calls () == 3);
+    cb.evaluate_batch (x, 3, out);
+    assert (cnt.calls () == 3);
+    bench.evaluate_batch (x, 3, ref);
+    for (int i = 0; i < 3; i++)
+        assert (out[i] == ref[i]);
+
+    // validation is passed through to the cached benchmark
+    cb.set_validation (false);
+    assert (!cnt.validation ());
+    cb.set_validation (true);
+    assert (cnt.validation ());
+    std::remove (cache_path.c_str ());
+}
+
+void
+run_cache_tests ()
+{
+    test_keys ();
+    test_tiers ();
+    test_cached_runs ();
+    std::cout << "All evaluation cache tests pass" << std::endl;
+}
@@ -0,0 +1,279 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for checkpoints, and the resumption of runs.
+ */
+
+#include <optimisers/gp.hpp>
+#include <optimisers/gridsearch.hpp>
+#include <optimisers/qmc.hpp>
+#include <optimisers/random.hpp>
+#include <optk/checkpoint.hpp>
+
+#include <tests/core_test.hpp>
+#include <benchmarks/synthetic.hpp>
+
+#include <memory>
+
+static const std::string ckpt_path = "/tmp/optk_checkpoint_test.ckpt";
+
+/**
+ * Wraps a benchmark, and stops the run, as if the process had been killed,
+ * after a number of evaluations.
+ */
+class stopping: public optk::benchmark {
+    public:
+        stopping (optk::benchmark *b, int n):
+            optk::benchmark (b->get_name ()), m_b (b), m_left (n), m_calls (0)
+        { }
+
+        sspace::sspace_t *get_search_space () { return m_b->get_search_space (); }
+
+        double
+        evaluate (inst::set x)
+        {
+            if (m_left-- <= 0)
+                throw std::runtime_error ("stopped");
+            m_calls++;
+            return m_b->evaluate (x);
+        }
+
+        /** @returns The number of completed evaluations. */
+        int calls () { return m_calls; }
+
+    private:
+        optk::benchmark *m_b;
+        std::atomic<int> m_left, m_calls;
+};
+
+/**
+ * Runs an optimiser to completion, then stops it part of the way through a
+ * run which takes a snapshot after every iteration, and resumes that run in
+ * a new checkpoint; the resumed trace must be the same as the complete one.
+ * @param proto The optimiser to test.
+ * @param batch The batch size, or 1 to run the sequential core loop.
+ * @param saves Whether the optimiser can save its state; if not, the run is
+ * started again.
+ */
+static void
+test_resume (optk::optimiser *proto, uint batch, bool saves)
+{
+    const uint iters = 30;
+    const int stop = 13;
+    syn::ackley1 bench (3);
+    optk::thread_pool pool (2);
+
+    auto run = [&] (optk::benchmark *b, optk::trace &tr, optk::progress *prog) {
+        std::unique_ptr<optk::optimiser> opt (proto->clone ());
+        opt->seed (7);
+        if (batch > 1)
+            optk::core_loop_batch (b, opt.get (), tr, batch, &pool, prog);
+        else
+            optk::core_loop (b, opt.get (), tr, prog);
+    };
+
+    optk::trace whole (iters);
+    run (&bench, whole, NULL);
+
+    std::remove (ckpt_path.c_str ());
+    {
+        optk::checkpoint ck (ckpt_path, "test", 1, 0);
+        std::unique_ptr<optk::progress> prog (ck.start ("set", 0));
+        stopping b (&bench, stop);
+        optk::trace tr (iters);
+        bool stopped = false;
+        try {
+            run (&b, tr, prog.get ());
+        } catch (const std::runtime_error &) {
+            stopped = true;
+        }
+        assert (stopped);
+    }
+
+    // the seed is that of the saved sweep
+    optk::checkpoint ck (ckpt_path, "test", 2, 0);
+    assert (ck.seed () == 1);
+    assert (ck.restored () == 0);
+    std::unique_ptr<optk::progress> prog (ck.start ("set", 0));
+    stopping b (&bench, iters);
+    optk::trace tr (iters);
+    run (&b, tr, prog.get ());
+
+    // only the iterations after the last snapshot are run again
+    uint saved = batch > 1 ? stop / batch * batch : stop;
+    assert (b.calls () == (int) (saves ? iters - saved : iters));
+    assert (tr.count () == iters);
+    assert (tr.min () == whole.min ());
+    for (uint i = 0; i < iters; i++)
+        assert (tr.data ()[i] == whole.data ()[i]);
+    std::remove (ckpt_path.c_str ());
+}
+
+static void
+test_resume_optimisers ()
+{
+    random_search rs;
+    test_resume (&rs, 1, true);
+    test_resume (&rs, 4, true);
+
+    qmc_search sobol (__qmc::sequence::sobol, 8);
+    test_resume (&sobol, 1, true);
+    qmc_search lhs (__qmc::sequence::lhs, 8);
+    test_resume (&lhs, 4, true);
+
+    gp_opt gp;
+    test_resume (&gp, 1, true);
+    gp_opt local (__gp::acquisition::ei, __gp::mode::local);
+    test_resume (&local, 1, true);
+
+    // gridsearch does not save its state, so its run is started again
+    gridsearch gs;
+    test_resume (&gs, 1, false);
+}
+
+/** @returns The contents of a file, which is then removed. */
+static std::string
+take_file (const std::string &path)
+{
+    std::ifstream f (path);
+    std::stringstream ss;
+    ss << f.rdbuf ();
+    std::remove (path.c_str ());
+    std::remove ((path + ".timing.csv").c_str ());
+    return ss.str ();
+}
+
+/** @returns The output of a sweep, saved into ck if it is not NULL. */
+static std::string
+run_sweep (optk::checkpoint *ck)
+{
+    const std::string path = "/tmp/optk_checkpoint_test.csv";
+    syn::synthetic_benchmark sb ("ackley1,alpine1");
+    random_search rs;
+    optk::optimisers opts;
+    opts.register_optimiser (&rs);
+
+    {
+        optk::result_writer out (path);
+        out.header (20, 1, true);
+        optk::ctx_t ctx;
+        ctx.outfile = path;
+        ctx.results = &out;
+        ctx.max_iters = 20;
+        ctx.stride = 1;
+        ctx.best = false;
+        ctx.costs = false;
+        ctx.summary = false;
+        ctx.repeats = 2;
+        ctx.threads = 2;
+        ctx.batch = 1;
+        ctx.async = false;
+        ctx.seed = 5;
+        ctx.ckpt = ck;
+        ctx.cache = NULL;
+        ctx.error = false;
+        sb.run (&opts, &ctx);
+    }
+    return take_file (path);
+}
+
+/**
+ * Checks that the finished runs of a sweep are read back rather than run
+ * again, and that checkpoints of other sweeps, or of nothing, are refused.
+ */
+static void
+test_resume_sweep ()
+{
+    std::remove (ckpt_path.c_str ());
+    std::string plain = run_sweep (NULL);
+    assert (!plain.empty ());
+    {
+        optk::checkpoint ck (ckpt_path, "sweep", 5);
+        assert (run_sweep (&ck) == plain);
+    }
+
+    // a message cut short by a crash is dropped
+    {
+        std::ofstream f (ckpt_path, std::ios::app | std::ios::binary);
+        f.write ("\x40\x00\x00", 3);
+    }
+    {
+        optk::checkpoint ck (ckpt_path, "sweep", 5);
+        assert (ck.restored () == 4);
+        assert (run_sweep (&ck) == plain);
+    }
+
+    bool caught = false;
+    try {
+        optk::checkpoint ck (ckpt_path, "another sweep", 5);
+    } catch (const std::runtime_error &) {
+        caught = true;
+    }
+    assert (caught);
+
+    // and files which are not checkpoints are left alone
+    {
+        std::ofstream f (ckpt_path);
+        f << "x,y\n1,2\n";
+    }
+    caught = false;
+    try {
+        optk::checkpoint ck (ckpt_path, "sweep", 5);
+    } catch (const std::runtime_error &) {
+        caught = true;
+    }
+    assert (caught);
+    assert (take_file (ckpt_path) == "x,y\n1,2\n");
+}
+
+/** Records the iterations at which a run offers to save its state. */
+class recording: public optk::progress {
+    public:
+        uint resume (optk::optimiser *, optk::trace &) { return 0; }
+        void step (optk::optimiser *, optk::trace &tr) { counts.push_back (tr.count ()); }
+
+        std::vector<uint> counts;
+};
+
+/** Checks that the batched loop offers a snapshot after every batch. */
+static void
+test_batch_steps ()
+{
+    syn::ackley1 bench (2);
+    optk::thread_pool pool (2);
+    random_search rs;
+    rs.seed (3);
+    recording prog;
+    optk::trace tr (30);
+    optk::core_loop_batch (&bench, &rs, tr, 4, &pool, &prog);
+
+    // the last batch is short, and is offered too
+    assert (prog.counts.size () == 8);
+    for (uint i = 0; i < 7; i++)
+        assert (prog.counts[i] == 4 * (i + 1));
+    assert (prog.counts.back () == 30);
+}
+
+void
+run_checkpoint_tests ()
+{
+    test_resume_optimisers ();
+    test_batch_steps ();
+    test_resume_sweep ();
+    std::cout << "All checkpoint tests pass" << std::endl;
+}
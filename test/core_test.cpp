@@ -0,0 +1,655 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for the core framework.
+ */
+
+#include <tests/core_test.hpp>
+
+#include <benchmarks/synthetic.hpp>
+#include <optimisers/gridsearch.hpp>
+
+static void
+test_thread_pool ()
+{
+    optk::thread_pool pool (4);
+    assert (pool.size () == 4u);
+
+    // every task is run exactly once
+    std::atomic<int> count (0);
+    std::vector<int> seen (1000, 0);
+    for (int i = 0; i < 1000; i++)
+        pool.submit ([&count, &seen, i] () { seen[i]++; count++; });
+    pool.wait ();
+    assert (count == 1000);
+    for (int i = 0; i < 1000; i++)
+        assert (seen[i] == 1);
+
+    // exceptions are propagated to the waiting thread
+    bool caught = false;
+    pool.submit ([] () { throw std::invalid_argument ("test"); });
+    try {
+        pool.wait ();
+    } catch (const std::invalid_argument &e) {
+        caught = true;
+    }
+    assert (caught);
+
+    // the pool remains usable after an exception
+    pool.submit ([&count] () { count++; });
+    pool.wait ();
+    assert (count == 1001);
+
+    // a pool with zero threads is given one thread
+    optk::thread_pool single (0);
+    assert (single.size () == 1u);
+}
+
+static void
+test_parallel_for ()
+{
+    optk::thread_pool pool (3);
+
+    std::vector<int> seen (500, 0);
+    pool.parallel_for (500, [&seen] (uint i) { seen[i]++; });
+    for (int i = 0; i < 500; i++)
+        assert (seen[i] == 1);
+
+    // nested loops complete even when every worker is inside a task
+    std::atomic<int> count (0);
+    for (int t = 0; t < 6; t++)
+        pool.submit ([&pool, &count] () {
+            pool.parallel_for (50, [&count] (uint) { count++; });
+        });
+    pool.wait ();
+    assert (count == 300);
+
+    bool caught = false;
+    try {
+        pool.parallel_for (10, [] (uint i) {
+            if (i == 7)
+                throw std::invalid_argument ("test");
+        });
+    } catch (const std::invalid_argument &e) {
+        caught = true;
+    }
+    assert (caught);
+}
+
+static void
+test_core_loop_batch ()
+{
+    const uint iters = 25;
+    syn::ackley1 bench (4);
+    gridsearch gs;
+    std::vector<double> seq (iters), par (iters);
+
+    optk::core_loop (&bench, &gs, seq.data (), iters);
+    // validation is skipped for the trusted gridsearch, then re-enabled
+    assert (gs.trusted ());
+    assert (bench.validation ());
+
+    // batched with a batch size that does not divide the iteration count
+    optk::thread_pool pool (3);
+    optk::core_loop_batch (&bench, &gs, par.data (), iters, 4, &pool);
+    for (uint i = 0; i < iters; i++)
+        assert (par[i] == seq[i]);
+
+    // and sequentially, without a pool
+    std::fill (par.begin (), par.end (), 0.);
+    optk::core_loop_batch (&bench, &gs, par.data (), iters, 7, NULL);
+    for (uint i = 0; i < iters; i++)
+        assert (par[i] == seq[i]);
+}
+
+/** A gridsearch which fails part of the way through a run. */
+class failing_grid: public gridsearch {
+    public:
+        inst::set
+        generate_parameters (int param_id) override
+        {
+            if (param_id == 5)
+                throw std::runtime_error ("failed");
+            return gridsearch::generate_parameters (param_id);
+        }
+};
+
+/**
+ * Checks that the core loops leave a benchmark's validation as the caller
+ * set it, whether they return or throw.
+ */
+static void
+test_core_loop_validation ()
+{
+    const uint iters = 10;
+    syn::ackley1 bench (2);
+    optk::thread_pool pool (2);
+    for (int loop = 0; loop < 3; loop++) {
+        for (bool v: {false, true}) {
+            gridsearch gs;
+            failing_grid f;
+            for (optk::optimiser *opt: {(optk::optimiser *) &gs,
+                    (optk::optimiser *) &f}) {
+                bench.set_validation (v);
+                optk::trace tr (iters);
+                try {
+                    if (loop == 0)
+                        optk::core_loop (&bench, opt, tr);
+                    else if (loop == 1)
+                        optk::core_loop_batch (&bench, opt, tr, 3, &pool);
+                    else
+                        optk::core_loop_async (&bench, opt, tr, 3, &pool);
+                    assert (opt == &gs);
+                } catch (const std::runtime_error &) {
+                    assert (opt == &f);
+                }
+                assert (bench.validation () == v);
+            }
+        }
+    }
+}
+
+/**
+ * A benchmark which, when told to, holds the first evaluation run off the
+ * loop's own thread until the evaluation of trial held () + 3 has begun.
+ * With three trials in flight, the loop only issues that one once held () + 1
+ * others have been recorded, so the held trial cannot be recorded in its own
+ * position. Until then the loop's thread, which would otherwise take every
+ * trial, waits for the pool to take one.
+ */
+class slow_start: public optk::benchmark {
+    public:
+        slow_start (bool hold):
+            optk::benchmark ("slow start"), m_hold (hold), m_calls (0),
+            m_held (-1), m_loop (std::this_thread::get_id ())
+        {
+            m_sspace.push_back (new sspace::uniform ("x", 0., 1.));
+        }
+
+        ~slow_start () { delete m_sspace[0]; }
+
+        sspace::sspace_t *get_search_space () { return &m_sspace; }
+
+        double
+        evaluate (inst::set x)
+        {
+            std::unique_lock<std::mutex> lock (m_mtx);
+            m_calls++;
+            bool loop = std::this_thread::get_id () == m_loop;
+            if (m_hold && loop) {
+                m_cv.wait (lock, [this] () { return m_held >= 0; });
+            } else if (m_hold && m_held < 0) {
+                m_held = optk::benchmark::trial ();
+                m_cv.notify_all ();
+                m_cv.wait (lock, [this] () { return m_calls > m_held + 3; });
+            }
+            m_cv.notify_all ();
+            return x->getdbl (0) + 1.;
+        }
+
+        /** @returns The id of the trial which was held, or -1. */
+        int held () { return m_held; }
+
+    private:
+        sspace::sspace_t m_sspace;
+        const bool m_hold;
+        int m_calls, m_held;
+        const std::thread::id m_loop;
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+};
+
+static void
+test_core_loop_async ()
+{
+    const uint iters = 25;
+    syn::ackley1 bench (4);
+    gridsearch gs;
+    std::vector<double> seq (iters), async (iters);
+    optk::thread_pool pool (3);
+
+    // the same trials are evaluated, in some order
+    optk::core_loop (&bench, &gs, seq.data (), iters);
+    optk::core_loop_async (&bench, &gs, async.data (), iters, 3, &pool);
+    std::sort (seq.begin (), seq.end ());
+    std::sort (async.begin (), async.end ());
+    for (uint i = 0; i < iters; i++)
+        assert (async[i] == seq[i]);
+
+    // a slow evaluation does not hold up the others
+    slow_start slow_seq (false), slow_async (true);
+    std::vector<double> first (iters), trace (iters);
+    optk::core_loop (&slow_seq, &gs, first.data (), iters);
+    optk::core_loop_async (&slow_async, &gs, trace.data (), iters, 3, &pool);
+    int h = slow_async.held ();
+    assert (h >= 0 && trace[h] != first[h]);
+    assert (std::find (trace.begin (), trace.end (), first[h]) != trace.end ());
+}
+
+static void
+test_trace ()
+{
+    const uint iters = 100;
+    syn::ackley1 bench (3);
+    gridsearch gs;
+    std::vector<double> full (iters);
+    optk::core_loop (&bench, &gs, full.data (), iters);
+
+    // entry j holds iteration min(7 (j + 1), n) - 1, or the best up to it
+    optk::trace every (iters, 7), best (iters, 7, true);
+    optk::core_loop (&bench, &gs, every);
+    optk::core_loop (&bench, &gs, best);
+    assert (every.size () == 15 && every.count () == iters);
+    double min = std::numeric_limits<double>::infinity ();
+    for (uint i = 0; i < iters; i++) {
+        min = std::min (min, full[i]);
+        if (i == optk::trace::iteration (i / 7, iters, 7)) {
+            assert (every.data ()[i / 7] == full[i]);
+            assert (best.data ()[i / 7] == min);
+        }
+    }
+    assert (optk::trace::iteration (14, iters, 7) == 99);
+
+    // reduced traces are also recorded by the parallel loops
+    optk::thread_pool pool (2);
+    optk::trace batch (iters, 7, true);
+    optk::core_loop_batch (&bench, &gs, batch, 4, &pool);
+    for (uint j = 0; j < best.size (); j++)
+        assert (batch.data ()[j] == best.data ()[j]);
+    optk::trace async (iters, 10, true);
+    optk::core_loop_async (&bench, &gs, async, 3, &pool);
+    assert (async.data ()[9] == min);
+
+    // entries past the end of a run are left at zero
+    optk::trace tr (10, 3);
+    tr.record (1);
+    tr.record (2);
+    assert (tr.size () == 4 && tr.data ()[0] == 2 && tr.data ()[1] == 0);
+    tr.clear ();
+    assert (tr.count () == 0 && tr.data ()[0] == 0);
+
+    // costs are totalled, and follow the values
+    optk::trace costed (10, 3, false, true);
+    assert (!tr.costed () && tr.costs () == NULL && tr.span () == 4);
+    assert (costed.costed () && costed.size () == 4 && costed.span () == 8);
+    for (uint i = 0; i < 4; i++)
+        costed.record (i, .5);
+    assert (costed.costs () == costed.data () + 4);
+    assert (costed.costs ()[0] == 1.5 && costed.costs ()[1] == 2.);
+    assert (costed.data ()[1] == 3);
+
+    // and carry on from where a resumed trace stopped
+    optk::trace resumed (10, 3, false, true);
+    std::copy (costed.data (), costed.data () + costed.span (),
+            resumed.data ());
+    resumed.resume (costed.count (), costed.min ());
+    resumed.record (4, 1.);
+    assert (resumed.costs ()[1] == 3.);
+
+    // summaries are updated online, in O(1) entries
+    std::vector<std::string> cols = optk::trace::summary_columns (false);
+    assert (cols.size () == 8 && cols[0] == "best" && cols[5] == "reached");
+    assert (optk::trace::summary_columns (true).size () == 10);
+    optk::trace sum (1000000, 1, false, false, true);
+    assert (sum.summary () && sum.size () == 8 && sum.span () == 8);
+    sum.target (1., .5);
+    for (double v: {5., 3., 2., 1.25, 4.})
+        sum.record (v);
+    const double *s = sum.data ();
+    assert (s[0] == 1.25 && s[1] == .25);
+    assert (std::abs (s[2] - std::log10 (.25)) < 1e-12);
+    assert (s[3] == 5 && s[4] >= 0 && s[5] == 1 && s[6] == 4);
+    assert (s[7] >= 0 && s[7] <= s[4]);
+
+    // the costs to the target are those so far, until it is reached
+    optk::trace far (100, 1, false, true, true);
+    far.target (0., .1);
+    assert (far.costs () == NULL && far.size () == 10);
+    far.record (3., 2.);
+    far.record (2., 1.);
+    assert (far.data ()[5] == 0 && far.data ()[6] == 2);
+    assert (far.data ()[8] == 3. && far.data ()[9] == 3.);
+
+    // and a resumed summary carries on
+    optk::trace later (100, 1, false, true, true);
+    later.target (0., .1);
+    std::copy (far.data (), far.data () + far.span (), later.data ());
+    later.resume (far.count (), far.min ());
+    later.record (0.05, 4.);
+    later.record (1., 1.);
+    assert (later.data ()[3] == 4 && later.data ()[5] == 1);
+    assert (later.data ()[6] == 3 && later.data ()[8] == 8.);
+    assert (later.data ()[9] == 7.);
+
+    // the core loops fill summaries in as they do traces
+    syn::ackley1 a1 (2);
+    gridsearch grid;
+    optk::trace run (50, 1, false, false, true);
+    run.target (a1.get_opt (), 1e9);
+    optk::core_loop (&a1, &grid, run);
+    assert (run.data ()[3] == 50 && run.data ()[5] == 1 && run.data ()[6] == 1);
+}
+
+#ifdef __OPTK_TIMING
+static void
+test_timing ()
+{
+    const uint iters = 30;
+    syn::ackley1 bench (3);
+    gridsearch gs;
+    optk::trace tr (iters);
+    optk::core_loop (&bench, &gs, tr);
+
+    optk::timings *t = tr.timings ();
+    assert (t->calls (optk::phase::generate) == iters);
+    assert (t->calls (optk::phase::evaluate) == iters);
+    assert (t->calls (optk::phase::receive) == iters);
+    assert (t->calls (optk::phase::validate) == (gs.trusted () ? 0 : iters));
+    uint64_t n = 0;
+    for (uint b = 0; b < optk::timings::buckets; b++)
+        n += t->hist (optk::phase::evaluate, b);
+    assert (n == iters);
+    assert (t->max (optk::phase::evaluate) * iters >=
+            t->total (optk::phase::evaluate));
+
+    // validation is attributed to the loop's timings, even on the pool
+    optk::thread_pool pool (2);
+    bench.set_validation (true);
+    optk::core_loop_batch (&bench, &gs, tr, 8, &pool);
+    assert (t->calls (optk::phase::generate) == 4);
+    assert (t->calls (optk::phase::evaluate) == iters);
+    optk::trace async (iters);
+    optk::core_loop_async (&bench, &gs, async, 3, &pool);
+    assert (async.timings ()->calls (optk::phase::evaluate) == iters);
+
+    optk::timings manual;
+    {
+        OPTK_TIME_SINK (&manual);
+        bench.evaluate (bench.get_opt_param ());
+    }
+    assert (manual.calls (optk::phase::validate) == 1);
+    manual.add (optk::phase::receive, 1500);
+    assert (manual.hist (optk::phase::receive, 10) == 1);
+
+    std::string rows = t->csv_rows ("b", "o");
+    assert (rows.compare (0, 15, "b,o,generate,4,") == 0);
+    assert (std::count (rows.begin (), rows.end (), '\n') == 3);
+}
+#endif
+
+/** @returns The contents of a file. */
+static std::string
+read_file (const std::string &path)
+{
+    std::ifstream f (path);
+    std::stringstream ss;
+    ss << f.rdbuf ();
+    return ss.str ();
+}
+
+static void
+test_result_writer ()
+{
+    // doubles are formatted exactly as ostream's defaults would
+    const double vals[] = {
+        0, -0., 1, 0.1, 1. / 3, 123456, 1234567, 1e-5, 12.5e-7, -2.75e100,
+        3.14159265, std::numeric_limits<double>::infinity (),
+        std::numeric_limits<double>::quiet_NaN ()
+    };
+    for (double v: vals) {
+        std::ostringstream os;
+        os << v;
+        std::string s;
+        optk::result_writer::format (s, v);
+        assert (s == os.str ());
+    }
+
+    const std::string path = "/tmp/optk_results_test.csv";
+    const uint rows = 40, iters = 5;
+    {
+        optk::result_writer out (path, optk::result_format::csv, 10, 64);
+        out.header (iters);
+        uint first = out.reserve (rows);
+        assert (first == 0 && out.reserve (0) == rows);
+
+        // rows submitted from many threads, in any order, come out in order
+        optk::thread_pool pool (4);
+        pool.parallel_for (rows, [&] (uint i) {
+            uint r = rows - 1 - i;
+            std::vector<double> trace (iters, r + .5);
+            out.submit (r, "b" + std::to_string (r), "opt",
+                    trace.data (), iters);
+        });
+
+        // completed rows reach the disk without an explicit flush; the file
+        // is polled, as the flusher runs on its own schedule
+        const std::string last = "b39,opt,39.5,39.5,39.5,39.5,39.5\n";
+        auto deadline = std::chrono::steady_clock::now () +
+            std::chrono::seconds (10);
+        while (read_file (path).find (last) == std::string::npos) {
+            assert (std::chrono::steady_clock::now () < deadline);
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        }
+    }
+
+    std::istringstream in (read_file (path));
+    std::string line;
+    std::getline (in, line);
+    assert (line == "Benchmark, Optimiser,0,1,2,3,4");
+    for (uint r = 0; r < rows; r++) {
+        std::getline (in, line);
+        std::ostringstream expect;
+        expect << "b" << r << ",opt";
+        for (uint i = 0; i < iters; i++)
+            expect << "," << r + .5;
+        assert (line == expect.str ());
+    }
+    assert (!std::getline (in, line));
+    std::remove (path.c_str ());
+
+    {
+        optk::result_writer out (path);
+        out.header (10, 4);
+    }
+    assert (read_file (path) == "Benchmark, Optimiser,3,7,9\n");
+    std::remove (path.c_str ());
+
+    // summarised runs have named columns
+    {
+        optk::result_writer out (path);
+        out.header ({"best", "regret"}, true);
+    }
+    assert (read_file (path) == "Benchmark, Optimiser,Statistic,best,regret\n");
+    std::remove (path.c_str ());
+
+    // the costs of a sweep are written as rows of their own
+    {
+        optk::result_writer out (path);
+        out.header (2, 1, true);
+        optk::sweep_rows single (&out, 1, 1, true);
+        const double tr[] = { 5, 4, .5, 1.5 };
+        single.add (0, 0, 7, tr, 4, "b", "opt", {});
+        optk::sweep_rows reps (&out, 1, 2, true);
+        const double tr2[] = { 3, 2, 1.5, 2.5 };
+        reps.add (0, 1, 8, tr2, 4, "b", "opt", {});
+        reps.add (0, 0, 7, tr, 4, "b", "opt", {});
+    }
+    in.clear ();
+    in.str (read_file (path));
+    std::getline (in, line);
+    std::getline (in, line);
+    assert (line == "b,opt,value,5,4");
+    std::getline (in, line);
+    assert (line == "b,opt,cost,0.5,1.5");
+    std::getline (in, line);
+    assert (line == "b,opt,mean,4,3");
+    for (uint s = 1; s < optk::trace_stats::count; s++)
+        std::getline (in, line);
+    std::getline (in, line);
+    assert (line == "b,opt,cost_mean,1,2");
+    std::remove (path.c_str ());
+
+    try {
+        optk::result_writer bad ("/nonexistent/dir/out.csv");
+        assert (1 == 0);
+    } catch (const std::runtime_error &) { }
+}
+
+static void
+test_columnar_results ()
+{
+    const std::string path = "/tmp/optk_results_test.optk";
+    const uint rows = 6, iters = 7;
+    {
+        optk::result_writer out (path, optk::result_format::columnar, 0);
+        out.header (iters);
+        out.reserve (rows);
+        for (uint i = 0; i < rows; i++) {
+            uint r = (i + 3) % rows;
+            std::vector<double> trace (iters);
+            for (uint k = 0; k < iters; k++)
+                trace[k] = r * 100. + k;
+            out.submit (r, r % 2 ? "b\"odd\"" : "even", "opt" +
+                    std::to_string (r / 3), trace.data (), iters, 10 + r,
+                    {"scalable"});
+        }
+        std::vector<double> short_trace (iters - 1);
+        try {
+            out.submit (rows, "x", "y", short_trace.data (), iters - 1);
+            assert (1 == 0);
+        } catch (const std::invalid_argument &) { }
+    }
+
+    std::string f = read_file (path);
+    assert (f.compare (0, 8, "OPTKCOL1") == 0);
+    uint32_t fi;
+    uint64_t hdr[6];
+    std::memcpy (&fi, f.data () + 8, 4);
+    std::memcpy (hdr, f.data () + 16, sizeof (hdr));
+    assert (fi == iters && hdr[0] == rows && hdr[1] == 64);
+
+    // the values can be read in place, in row order
+    const double *vals = reinterpret_cast<const double *>(f.data () + hdr[1]);
+    for (uint r = 0; r < rows; r++)
+        for (uint k = 0; k < iters; k++)
+            assert (vals[r * iters + k] == r * 100. + k);
+
+    const char *table = f.data () + hdr[2];
+    const uint64_t *seeds = reinterpret_cast<const uint64_t *>(table);
+    const uint32_t *bench = reinterpret_cast<const uint32_t *>(
+            table + rows * 8);
+    const uint32_t *opt = bench + rows, *stat = opt + rows;
+    for (uint r = 0; r < rows; r++) {
+        assert (seeds[r] == 10 + r);
+        assert (bench[r] == r % 2 && opt[r] == r / 3 && stat[r] == 0);
+    }
+
+    std::string meta = f.substr (hdr[3], hdr[4]);
+    assert (hdr[3] + hdr[4] == f.size ());
+    assert (meta == "{\"benchmarks\": [{\"name\": \"even\", \"properties\": "
+            "[\"scalable\"]}, {\"name\": \"b\\\"odd\\\"\", \"properties\": "
+            "[\"scalable\"]}], \"optimisers\": [\"opt0\", \"opt1\"], "
+            "\"statistics\": [\"value\"]}\n");
+    std::remove (path.c_str ());
+
+    // the columns of summaries are named in the metadata, and have no stride
+    {
+        optk::result_writer out (path, optk::result_format::columnar);
+        out.header ({"best", "evals"});
+        const double row[] = { 1.5, 20 };
+        out.submit (out.reserve (1), "b", "opt", row, 2);
+    }
+    f = read_file (path);
+    std::memcpy (&fi, f.data () + 8, 4);
+    assert (fi == 2 && f[12] == 0);
+    std::memcpy (hdr, f.data () + 16, sizeof (hdr));
+    meta = f.substr (hdr[3], hdr[4]);
+    assert (meta.find (", \"columns\": [\"best\", \"evals\"]}\n") !=
+            std::string::npos);
+    std::remove (path.c_str ());
+}
+
+static void
+test_stats ()
+{
+    const double xs[] = {4., 7., 13., 16., 1.};
+    optk::welford w;
+    for (double x: xs)
+        w.add (x);
+    assert (w.count () == 5);
+    assert (std::abs (w.mean () - 8.2) < 1e-12);
+    assert (std::abs (w.variance () - 38.7) < 1e-12);
+
+    // exact on few observations
+    optk::p2_quantile med, q25 (.25);
+    assert (std::isnan (med.value ()));
+    for (double x: xs) {
+        med.add (x);
+        q25.add (x);
+    }
+    assert (med.value () == 7.);
+    assert (q25.value () == 4.);
+
+    // and close on many
+    optk::rng r (3);
+    optk::p2_quantile big (.5), big75 (.75);
+    for (uint i = 0; i < 10000; i++) {
+        double u = r.uniform ();
+        big.add (u);
+        big75.add (u);
+    }
+    assert (std::abs (big.value () - .5) < .02);
+    assert (std::abs (big75.value () - .75) < .02);
+
+    // entry by entry over replicated traces
+    optk::trace_stats ts (2);
+    for (uint i = 0; i < 5; i++) {
+        double trace[2] = {xs[i], -xs[i]};
+        ts.add (trace);
+    }
+    assert (ts.replicates () == 5);
+    double row[2];
+    ts.row (optk::trace_stats::mean, row);
+    assert (std::abs (row[0] - 8.2) < 1e-12 && std::abs (row[1] + 8.2) < 1e-12);
+    ts.row (optk::trace_stats::min, row);
+    assert (row[0] == 1. && row[1] == -16.);
+    ts.row (optk::trace_stats::max, row);
+    assert (row[0] == 16. && row[1] == -1.);
+    ts.row (optk::trace_stats::median, row);
+    assert (row[0] == 7. && row[1] == -7.);
+    assert (std::string (optk::trace_stats::name (optk::trace_stats::stddev))
+            == "std");
+}
+
+void
+run_core_tests ()
+{
+    test_thread_pool ();
+    test_parallel_for ();
+    test_core_loop_batch ();
+    test_core_loop_validation ();
+    test_core_loop_async ();
+    test_trace ();
+#ifdef __OPTK_TIMING
+    test_timing ();
+#endif
+    test_result_writer ();
+    test_columnar_results ();
+    test_stats ();
+    std::cout << "All core tests pass" << std::endl;
+}
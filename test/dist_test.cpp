@@ -0,0 +1,255 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for distributed sweeps.
+ */
+
+#include <optimisers/random.hpp>
+#include <optk/dist.hpp>
+
+#include <tests/core_test.hpp>
+#include <benchmarks/synthetic.hpp>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char *selection = "ackley1,alpine1,brown,csendes";
+
+/** @returns The contents of a file, which is then removed. */
+static std::string
+take_file (const std::string &path)
+{
+    std::ifstream f (path);
+    std::stringstream ss;
+    ss << f.rdbuf ();
+    std::remove (path.c_str ());
+    std::remove ((path + ".timing.csv").c_str ());
+    return ss.str ();
+}
+
+static optk::ctx_t
+make_ctx (const std::string &path, optk::result_writer *out, uint reps)
+{
+    optk::ctx_t ctx;
+    ctx.outfile = path;
+    ctx.results = out;
+    ctx.max_iters = 25;
+    ctx.stride = 2;
+    ctx.best = false;
+    ctx.costs = false;
+    ctx.summary = false;
+    ctx.repeats = reps;
+    ctx.threads = 2;
+    ctx.batch = 1;
+    ctx.async = false;
+    ctx.seed = 11;
+    ctx.ckpt = NULL;
+    ctx.cache = NULL;
+    ctx.error = false;
+    return ctx;
+}
+
+/** Runs a worker, with its own benchmarks and optimisers. */
+static void
+work (const std::string &addr, uint reps)
+{
+    syn::synthetic_benchmark sb (selection);
+    optk::bench_list bl = {&sb};
+    random_search rs;
+    optk::optimisers opts;
+    opts.register_optimiser (&rs);
+    optk::ctx_t ctx = make_ctx ("", NULL, reps);
+
+    optk::net::channel chan (optk::net::connect_tcp (addr));
+    assert (optk::dist::join (&chan, 2).size () == 1);
+    optk::dist::work (&chan, &bl, &opts, &ctx);
+}
+
+/**
+ * Runs a sweep locally and distributed between workers, one of which goes
+ * away with the units it was given, and checks that the outputs agree.
+ */
+static void
+test_dist_sweep (uint reps)
+{
+    const std::string path = "/tmp/optk_dist_test.csv";
+    syn::synthetic_benchmark sb (selection);
+    optk::bench_list bl = {&sb};
+    random_search rs;
+    optk::optimisers opts;
+    opts.register_optimiser (&rs);
+
+    std::string local;
+    {
+        optk::result_writer out (path);
+        out.header (25, 2, reps > 1);
+        optk::ctx_t ctx = make_ctx (path, &out, reps);
+        sb.run (&opts, &ctx);
+    }
+    local = take_file (path);
+    assert (!local.empty ());
+
+    int lfd = optk::net::listen_tcp ("127.0.0.1:0");
+    sockaddr_in a;
+    socklen_t len = sizeof (a);
+    getsockname (lfd, (sockaddr *) &a, &len);
+    std::string addr = "127.0.0.1:" + std::to_string (ntohs (a.sin_port));
+
+    {
+        optk::result_writer out (path);
+        out.header (25, 2, reps > 1);
+        optk::ctx_t ctx = make_ctx (path, &out, reps);
+        std::thread coord ([&] () {
+                optk::dist::coordinate (lfd, &bl, &opts, &ctx, {"-x"});
+            });
+
+        // a worker which takes its units and vanishes
+        {
+            optk::net::channel chan (optk::net::connect_tcp (addr));
+            std::vector<std::string> conf = optk::dist::join (&chan, 3);
+            assert (conf.size () == 1 && conf[0] == "-x");
+            std::string in;
+            assert (chan.get (&in) == (uint8_t) optk::dist::msg::units);
+        }
+
+        std::thread w1 (work, addr, reps), w2 (work, addr, reps);
+        coord.join ();
+        w1.join ();
+        w2.join ();
+    }
+    close (lfd);
+    assert (take_file (path) == local);
+}
+
+/** A random search which fails as soon as it is run. */
+class failing_search: public random_search {
+    public:
+        optk::optimiser *clone () override { return new failing_search (); }
+
+        inst::set
+        generate_parameters (int param_id) override
+        {
+            throw std::runtime_error ("failed");
+        }
+};
+
+/**
+ * Checks that a unit which fails on a worker abandons the sweep, on the
+ * coordinator and on the worker, rather than leaving both waiting.
+ */
+static void
+test_dist_failure ()
+{
+    const std::string path = "/tmp/optk_dist_test.csv";
+    syn::synthetic_benchmark sb (selection);
+    optk::bench_list bl = {&sb};
+    random_search rs;
+    optk::optimisers opts;
+    opts.register_optimiser (&rs);
+
+    int lfd = optk::net::listen_tcp ("127.0.0.1:0");
+    sockaddr_in a;
+    socklen_t len = sizeof (a);
+    getsockname (lfd, (sockaddr *) &a, &len);
+    std::string addr = "127.0.0.1:" + std::to_string (ntohs (a.sin_port));
+
+    bool coord_failed = false, worker_failed = false;
+    {
+        optk::result_writer out (path);
+        out.header (25, 2, false);
+        optk::ctx_t ctx = make_ctx (path, &out, 1);
+        std::thread coord ([&] () {
+                try {
+                    optk::dist::coordinate (lfd, &bl, &opts, &ctx, {});
+                } catch (const std::runtime_error &e) {
+                    coord_failed = std::string (e.what ()).find ("failed")
+                        != std::string::npos;
+                }
+            });
+
+        syn::synthetic_benchmark wsb (selection);
+        optk::bench_list wbl = {&wsb};
+        failing_search f;
+        optk::optimisers wopts;
+        wopts.register_optimiser (&f);
+        optk::ctx_t wctx = make_ctx ("", NULL, 1);
+        optk::net::channel chan (optk::net::connect_tcp (addr));
+        optk::dist::join (&chan, 2);
+        try {
+            optk::dist::work (&chan, &wbl, &wopts, &wctx);
+        } catch (const std::runtime_error &e) {
+            worker_failed = std::string (e.what ()) == "failed";
+        }
+        coord.join ();
+    }
+    close (lfd);
+    take_file (path);
+    assert (coord_failed && worker_failed);
+}
+
+/** Checks that a frame announcing a huge payload is refused, unread. */
+static void
+test_oversized_frame ()
+{
+    std::string frame ("\xff\xff\xff\xff\x01", 5);
+    std::string buf = frame, payload;
+    uint8_t type;
+    bool threw = false;
+    try {
+        optk::net::take_message (&buf, &type, &payload);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert (threw && payload.empty ());
+
+    int fds[2];
+    assert (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    assert (write (fds[1], frame.data (), frame.size ()) == 5);
+    optk::net::channel chan (fds[0]);
+    threw = false;
+    try {
+        chan.try_get (&type, &payload);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert (threw && payload.empty ());
+    // the connection has been shut down, so the peer sees it close
+    char c;
+    assert (read (fds[1], &c, 1) == 0);
+    close (fds[1]);
+
+    threw = false;
+    try {
+        std::string big (optk::net::max_payload + 1, 0);
+        optk::net::put_message (&buf, 1, big);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert (threw);
+}
+
+void
+run_dist_tests ()
+{
+    test_oversized_frame ();
+    test_dist_sweep (1);
+    test_dist_sweep (3);
+    test_dist_failure ();
+    std::cout << "All distributed sweep tests pass" << std::endl;
+}
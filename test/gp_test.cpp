@@ -0,0 +1,403 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for the Gaussian process optimiser.
+ */
+
+#include <optimisers/gp.hpp>
+
+#include <tests/optimiser_test.hpp>
+#include <tests/testutils.hpp>
+#include <benchmarks/synthetic.hpp>
+
+void
+test_gp_cholesky ()
+{
+    optk::rng r (7);
+    const u_int n = 40;
+
+    // a well-conditioned SPD matrix, built one row at a time
+    std::vector<double> a (n * n);
+    for (u_int i = 0; i < n; i++)
+        for (u_int j = 0; j <= i; j++)
+            a[i * n + j] = a[j * n + i] = i == j ? n : r.uniform (-1, 1);
+
+    __gp::cholesky l;
+    for (u_int i = 0; i < n; i++)
+        l.append (a.data () + i * n, a[i * n + i]);
+    assert (l.size () == n);
+
+    // L L^T reproduces the matrix
+    for (u_int i = 0; i < n; i++)
+        for (u_int j = 0; j <= i; j++) {
+            double s = 0;
+            for (u_int p = 0; p <= j; p++)
+                s += l.row (i)[p] * l.row (j)[p];
+            assert (std::abs (s - a[i * n + j]) < 1e-10);
+        }
+
+    // the single and multiple right-hand side solves agree, and solve A
+    const u_int w = __gp::cholesky::width;
+    std::vector<double> b (n), bm (n * w);
+    for (u_int i = 0; i < n; i++) {
+        b[i] = r.uniform ();
+        for (u_int j = 0; j < w; j++)
+            bm[i * w + j] = b[i] * (j + 1);
+    }
+    std::vector<double> x (b);
+    l.forward (x.data ());
+    l.forward_multi (bm.data ());
+    for (u_int i = 0; i < n; i++)
+        for (u_int j = 0; j < w; j++)
+            assert (std::abs (bm[i * w + j] - x[i] * (j + 1)) < 1e-9);
+    l.backward (x.data ());
+    for (u_int i = 0; i < n; i++) {
+        double s = 0;
+        for (u_int j = 0; j < n; j++)
+            s += a[i * n + j] * x[j];
+        assert (std::abs (s - b[i]) < 1e-10);
+    }
+}
+
+void
+test_gp_model ()
+{
+    optk::rng r (11);
+    const u_int d = 3, n = 50;
+    __gp::model m (d, 0.5, 1e-8);
+
+    std::vector<double> xs (n * d), ys (n);
+    for (u_int i = 0; i < n; i++) {
+        for (u_int k = 0; k < d; k++)
+            xs[i * d + k] = r.uniform ();
+        ys[i] = std::sin (3 * xs[i * d]) + xs[i * d + 1] * xs[i * d + 2];
+        m.add (xs.data () + i * d, ys[i]);
+    }
+    assert (m.size () == n);
+    assert (m.best () == *std::min_element (ys.begin (), ys.end ()));
+
+    // the posterior interpolates the observations (more candidates than one
+    // block, to exercise the blocking)
+    std::vector<double> mu (n), var (n);
+    m.predict (xs.data (), n, mu.data (), var.data ());
+    for (u_int i = 0; i < n; i++) {
+        assert (std::abs (mu[i] - ys[i]) < 1e-3);
+        assert (var[i] >= 0 && var[i] < 1e-4);
+    }
+
+    // far away from the data the variance reverts towards the prior
+    double far[d] = {10, 10, 10}, fmu, fvar;
+    m.predict (far, 1, &fmu, &fvar);
+    assert (fvar > var[0]);
+}
+
+void
+test_gp_sparse_model ()
+{
+    optk::rng r (13);
+    const u_int d = 2, m = 64, n = 400;
+    __gp::model exact (d, 0.5, 1e-6);
+    __gp::sparse_model sparse (d, m, 0.5, 1e-6);
+
+    auto f = [](const double *x) { return std::sin (3 * x[0]) + x[1] * x[1]; };
+
+    std::vector<double> xs (n * d), ys (n);
+    for (u_int i = 0; i < n; i++) {
+        for (u_int k = 0; k < d; k++)
+            xs[i * d + k] = r.uniform ();
+        ys[i] = f (xs.data () + i * d);
+    }
+
+    // with no more observations than inducing inputs the model is exact
+    for (u_int i = 0; i < m; i++) {
+        exact.add (xs.data () + i * d, ys[i]);
+        sparse.add (xs.data () + i * d, ys[i]);
+    }
+    assert (!sparse.sparse ());
+    std::vector<double> emu (n), evar (n), smu (n), svar (n);
+    exact.predict (xs.data (), n, emu.data (), evar.data ());
+    sparse.predict (xs.data (), n, smu.data (), svar.data ());
+    double eerr = 0;
+    for (u_int i = 0; i < n; i++) {
+        assert (emu[i] == smu[i]);
+        assert (evar[i] == svar[i]);
+        eerr += std::abs (emu[i] - ys[i]);
+    }
+
+    for (u_int i = m; i < n; i++)
+        sparse.add (xs.data () + i * d, ys[i]);
+    assert (sparse.sparse ());
+    assert (sparse.size () == n);
+    assert (sparse.rank () == m);
+    assert (sparse.best () == *std::min_element (ys.begin (), ys.end ()));
+
+    // the later observations (mildly) improve the mean absolute error, while
+    // the variance no longer vanishes at the observations
+    sparse.predict (xs.data (), n, smu.data (), svar.data ());
+    double err = 0;
+    for (u_int i = 0; i < n; i++) {
+        err += std::abs (smu[i] - ys[i]);
+        assert (svar[i] > 0);
+    }
+    assert (err <= eerr);
+    assert (err / n < 1e-2);
+}
+
+void
+test_gp_local_model ()
+{
+    optk::rng r (17);
+    const u_int d = 2, k = 16, n = 100;
+    __gp::local_model local (d, k, 0.5, 1e-8);
+
+    std::vector<double> xs (n * d), ys (n);
+    for (u_int i = 0; i < n; i++) {
+        for (u_int j = 0; j < d; j++)
+            xs[i * d + j] = r.uniform ();
+        ys[i] = (xs[i * d] - .3) * (xs[i * d] - .3) + xs[i * d + 1];
+        local.add (xs.data () + i * d, ys[i]);
+    }
+    assert (local.size () == n);
+    assert (local.rank () == k);
+
+    // the incumbent is interpolated, and its distant observations are not
+    // part of the fit
+    u_int ib = std::min_element (ys.begin (), ys.end ()) - ys.begin ();
+    assert (local.argbest ()[0] == xs[ib * d]);
+    double mu, var;
+    local.predict (xs.data () + ib * d, 1, &mu, &var);
+    assert (std::abs (mu - ys[ib]) < 1e-4);
+
+    double far = 0;
+    for (u_int i = 0; i < n; i++) {
+        double r2 = std::pow (xs[i * d] - xs[ib * d], 2) +
+            std::pow (xs[i * d + 1] - xs[ib * d + 1], 2);
+        if (r2 > far) {
+            far = r2;
+            local.predict (xs.data () + i * d, 1, &mu, &var);
+        }
+    }
+    assert (var > 1e-4);
+}
+
+void
+test_gp_functionality ()
+{
+    syn::chung_reynolds cr (2);
+
+    double best[2];
+    __gp::acquisition acqs[2] = {
+        __gp::acquisition::ei, __gp::acquisition::ucb
+    };
+
+    for (int a = 0; a < 2; a++) {
+        gp_opt test = gp_opt (acqs[a]);
+        test.seed (5);
+        test.update_search_space (cr.get_search_space ());
+        assert (test.trusted ());
+
+        best[a] = INFINITY;
+        for (int i = 0; i < 40; i++) {
+            inst::set ss = test.generate_parameters (i);
+            cr.validate_param_set (ss);
+            double res = cr.evaluate (ss);
+            best[a] = std::min (best[a], res);
+            test.receive_trial_results (i, ss, res);
+        }
+    }
+
+    // the search space is [-100, 100]^2 with a minimum of 0 at the origin; a
+    // random point typically scores ~4e7, and 40 random points only reach
+    // 1e4 about a quarter of the time.
+    assert (best[0] < 1e4);
+    assert (best[1] < 1e4);
+
+    // the scalable modes
+    __gp::mode modes[2] = { __gp::mode::sparse, __gp::mode::local };
+    for (int m = 0; m < 2; m++) {
+        gp_opt test = gp_opt (__gp::acquisition::ei, modes[m]);
+        test.seed (5);
+        test.update_search_space (cr.get_search_space ());
+
+        double b = INFINITY;
+        for (int i = 0; i < 40; i++) {
+            inst::set ss = test.generate_parameters (i);
+            cr.validate_param_set (ss);
+            double res = cr.evaluate (ss);
+            b = std::min (b, res);
+            test.receive_trial_results (i, ss, res);
+        }
+        assert (b < 1e4);
+
+        optk::optimiser *c = test.clone ();
+        assert (c->get_name () == test.get_name ());
+        delete c;
+    }
+
+    // the same seed reproduces the same suggestions
+    gp_opt g1, g2;
+    g1.seed (3);
+    g2.seed (3);
+    g1.update_search_space (cr.get_search_space ());
+    g2.update_search_space (cr.get_search_space ());
+    for (int i = 0; i < 8; i++) {
+        inst::set s1 = g1.generate_parameters (i);
+        inst::set s2 = g2.generate_parameters (i);
+        assert (s1->getdbl (0) == s2->getdbl (0));
+        assert (s1->getdbl (1) == s2->getdbl (1));
+        double res = cr.evaluate (s1);
+        g1.receive_trial_results (i, s1, res);
+        g2.receive_trial_results (i, s2, res);
+    }
+}
+
+void
+test_gp_mapping ()
+{
+    sspace::sspace_t space;
+    sspace::uniform u ("u", -2, 3);
+    sspace::loguniform lu ("lu", 1e-3, 10);
+    sspace::normal nm ("n", 1, 2);
+    sspace::lognormal lnm ("ln", 0, 1);
+    space.push_back (&u);
+    space.push_back (&lu);
+    space.push_back (&nm);
+    space.push_back (&lnm);
+
+    gp_opt test = gp_opt ();
+    test.seed (1);
+    test.update_search_space (&space);
+    for (int i = 0; i < 20; i++) {
+        inst::set ss = test.generate_parameters (i);
+        sspace::validate_param_values (ss->get_values (), &space);
+        double res = ss->getdbl ("u") + std::log (ss->getdbl ("lu")) +
+            ss->getdbl ("n") * ss->getdbl ("n") + ss->getdbl ("ln");
+        test.receive_trial_results (i, ss, res);
+    }
+
+    sspace::randint ri ("ri", 0, 5);
+    space.push_back (&ri);
+    bool thrown = false;
+    try {
+        test.update_search_space (&space);
+    } catch (const std::invalid_argument &e) {
+        thrown = true;
+    }
+    assert (thrown);
+}
+
+/**
+ * The exact GP searches the whole hypercube for the maximum of its
+ * acquisition function, rather than a trust region around the incumbent.
+ */
+void
+test_gp_global_search ()
+{
+    sspace::sspace_t space;
+    sspace::uniform u0 ("0", 0, 1), u1 ("1", 0, 1);
+    space.push_back (&u0);
+    space.push_back (&u1);
+
+    gp_opt test = gp_opt ();
+    test.seed (3);
+    test.update_search_space (&space);
+
+    double best = INFINITY, inc[2] = {0, 0}, furthest = 0;
+    for (int i = 0; i < 40; i++) {
+        inst::set ss = test.generate_parameters (i);
+        double x[2] = { ss->getdbl ("0"), ss->getdbl ("1") };
+        // skip the initial design of d + 1 space-filling points
+        if (i > 2)
+            furthest = std::max (furthest, std::max (
+                        std::abs (x[0] - inc[0]), std::abs (x[1] - inc[1])));
+        double res = std::sin (20 * x[0]) * std::cos (20 * x[1]);
+        if (res < best) {
+            best = res;
+            inc[0] = x[0];
+            inc[1] = x[1];
+        }
+        test.receive_trial_results (i, ss, res);
+    }
+    assert (furthest > .5);
+}
+
+/**
+ * The points of a batch are spread out by the fantasised results of the
+ * earlier ones, which are forgotten once the batch has been generated.
+ */
+void
+test_gp_batch ()
+{
+    sspace::sspace_t space;
+    sspace::uniform u0 ("0", 0, 1), u1 ("1", 0, 1);
+    space.push_back (&u0);
+    space.push_back (&u1);
+
+    gp_opt test = gp_opt ();
+    test.seed (5);
+    test.update_search_space (&space);
+
+    auto f = [](inst::set s) {
+        double a = s->getdbl ("0") - .3, b = s->getdbl ("1") - .6;
+        return a * a + b * b;
+    };
+    for (int i = 0; i < 6; i++) {
+        inst::set ss = test.generate_parameters (i);
+        test.receive_trial_results (i, ss, f (ss));
+    }
+
+    for (int first = 6; first < 30; first += 4) {
+        std::string before, after;
+        test.save (&before);
+
+        std::vector<inst::set> batch;
+        assert (test.generate_batch (first, 4, &batch) == 4);
+        auto gap = [&](uint i, uint j, const char *k) {
+            return std::abs (batch[i]->getdbl (k) - batch[j]->getdbl (k));
+        };
+        double closest = INFINITY;
+        for (uint i = 0; i < 4; i++)
+            for (uint j = 0; j < i; j++)
+                closest = std::min (closest,
+                        std::max (gap (i, j, "0"), gap (i, j, "1")));
+        assert (closest > 1e-3);
+
+        // the snapshot is as long as before: no lie was kept
+        test.save (&after);
+        assert (after.size () == before.size ());
+
+        double values[4];
+        for (uint i = 0; i < 4; i++)
+            values[i] = f (batch[i]);
+        test.receive_batch (first, &batch, values);
+    }
+}
+
+void
+run_gp_tests ()
+{
+    test_gp_cholesky ();
+    test_gp_model ();
+    test_gp_sparse_model ();
+    test_gp_local_model ();
+    test_gp_functionality ();
+    test_gp_mapping ();
+    test_gp_global_search ();
+    test_gp_batch ();
+    std::cout << "All gp tests pass" << std::endl;
+}
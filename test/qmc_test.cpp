@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for the quasi-random sequences and search.
+ */
+
+#include <set>
+
+#include <optimisers/qmc.hpp>
+
+#include <tests/optimiser_test.hpp>
+#include <tests/testutils.hpp>
+#include <benchmarks/synthetic.hpp>
+
+/**
+ * Asserts that each of the first n = 2^k points of every 1D projection falls
+ * in a different interval of width 1/n.
+ */
+static void
+assert_stratified (const std::vector<double> &pts, u_int n, u_int d)
+{
+    for (u_int j = 0; j < d; j++) {
+        std::set<u_int> cells;
+        for (u_int i = 0; i < n; i++) {
+            double u = pts[i * d + j];
+            assert (0 <= u && u < 1);
+            cells.insert ((u_int) (u * n));
+        }
+        assert (cells.size () == n);
+    }
+}
+
+static void
+test_sobol ()
+{
+    // beyond the tabulated direction numbers
+    const u_int d = 40, n = 256;
+    optk::rng r (3);
+    __qmc::generator g (__qmc::sequence::sobol, d, r);
+    assert (g.dims () == d);
+
+    std::vector<double> pts (n * d);
+    g.next_block (n / 2, pts.data ());
+    g.next_block (n / 2, pts.data () + n / 2 * d);
+    assert_stratified (pts, n, d);
+    assert_stratified (pts, 16, d);
+
+    // every 2D projection of the first 2^k points of a (t, s)-sequence tiles
+    // the square; check that the leading pairs fill an 8 x 8 grid with t = 0
+    std::set<u_int> cells;
+    for (u_int i = 0; i < 64; i++)
+        cells.insert ((u_int) (pts[i * d] * 8) * 8 +
+                (u_int) (pts[i * d + 1] * 8));
+    assert (cells.size () == 64);
+
+    // the randomisation is seeded
+    optk::rng r1 (3), r2 (4);
+    __qmc::generator g1 (__qmc::sequence::sobol, d, r1);
+    __qmc::generator g2 (__qmc::sequence::sobol, d, r2);
+    std::vector<double> a (d), b (d);
+    g1.next_block (1, a.data ());
+    g2.next_block (1, b.data ());
+    assert (a[0] == pts[0] && a[d - 1] == pts[d - 1]);
+    assert (a != b);
+}
+
+static void
+test_halton ()
+{
+    const u_int d = 5, n = 243;
+    optk::rng r (1);
+    __qmc::generator g (__qmc::sequence::halton, d, r);
+    std::vector<double> pts (n * d);
+    g.next_block (n, pts.data ());
+
+    // the sequence starts at index 1, so the first b^k - 1 points lie on
+    // distinct multiples of b^-k (up to rounding).
+    const u_int bases[] = {2, 3, 5, 7, 11};
+    for (u_int j = 0; j < d; j++) {
+        u_int m = bases[j] * bases[j];
+        std::set<u_int> cells;
+        for (u_int i = 0; i < m - 1; i++) {
+            double u = pts[i * d + j];
+            assert (0 < u && u < 1);
+            cells.insert ((u_int) std::lround (u * m));
+        }
+        assert (cells.size () == m - 1);
+    }
+}
+
+static void
+test_lhs ()
+{
+    const u_int d = 7, n = 50;
+    optk::rng r (2);
+    __qmc::generator g (__qmc::sequence::lhs, d, r);
+    std::vector<double> pts (n * d);
+    for (int b = 0; b < 3; b++) {
+        g.next_block (n, pts.data ());
+        assert_stratified (pts, n, d);
+    }
+}
+
+static void
+test_qmc_search ()
+{
+    std::vector<int> int_opts = {1, 2, 3};
+    std::vector<std::string> str_opts = {"a", "b"};
+    sspace::randint ri ("ri", 0, 9);
+    sspace::quniform qu ("qu", 0, 10, 2);
+    sspace::qloguniform ql ("ql", 1, 100, 5);
+    sspace::normal nm ("nm", 0, 1);
+    sspace::qlognormal qln ("qln", 1, .5, 2);
+    sspace::categorical<int> ci ("ci", &int_opts);
+    sspace::categorical<std::string> cs ("cs", &str_opts);
+    sspace::uniform cu ("cu", -1, 1);
+    sspace::sspace_t copts ({&cu, &cs});
+    sspace::choice ch ("ch", &copts);
+    sspace::sspace_t space ({&ri, &qu, &ql, &nm, &qln, &ci, &ch});
+
+    const __qmc::sequence seqs[] = {
+        __qmc::sequence::sobol, __qmc::sequence::halton, __qmc::sequence::lhs
+    };
+    for (__qmc::sequence s: seqs) {
+        qmc_search qs (s, 16);
+        qs.seed (7);
+        qs.update_search_space (&space);
+
+        // 2^k points of a digital net hit every value of a small randint
+        std::set<int> seen;
+        for (int i = 0; i < 40; i++) {
+            inst::set ps = qs.generate_parameters (i);
+            sspace::validate_param_values (ps->get_values (), &space);
+            inst::node *sub = static_cast<inst::node *>(
+                    ps->get_item ("ch"));
+            assert (sub->getdbl ("cu") >= -1 && sub->getdbl ("cu") <= 1);
+            seen.insert (ps->getint ("ri"));
+            qs.receive_trial_results (i, ps, 0);
+        }
+        assert (seen.size () == 10);
+    }
+
+    // the search optimises a benchmark as well as random search does
+    syn::alpine1 a1 (10);
+    qmc_search qs;
+    qs.update_search_space (a1.get_search_space ());
+    for (int i = 0; i < 100; i++) {
+        inst::set ss = qs.generate_parameters (i);
+        a1.validate_param_set (ss);
+        qs.receive_trial_results (i, ss, a1.evaluate (ss));
+    }
+}
+
+void
+run_qmc_tests ()
+{
+    test_sobol ();
+    test_halton ();
+    test_lhs ();
+    test_qmc_search ();
+    std::cout << "All quasi-random search tests pass" << std::endl;
+}
@@ -44,10 +44,35 @@ test_random_search_functionality ()
     }
 }
 
+void
+test_random_search_choice ()
+{
+    // the options of a choice are sampled into a node of their own
+    sspace::randint ri ("ri", 0, 4);
+    std::vector<std::string> opts = {"a", "b"};
+    sspace::categorical<std::string> c ("c", &opts);
+    sspace::sspace_t inner ({&ri, &c});
+    sspace::choice ch ("ch", &inner);
+    sspace::uniform u ("u", 0, 1);
+    sspace::sspace_t space ({&u, &ch});
+
+    random_search test = random_search ();
+    test.seed (3);
+    test.update_search_space (&space);
+    for (int i = 0; i < 20; i++) {
+        inst::set ss = test.generate_parameters (i);
+        sspace::validate_param_values (ss->get_values (), &space);
+        GETNODE (sub, ss, "ch");
+        assert (sub != NULL && sub->get_values ()->size () == 2);
+        test.receive_trial_results (i, ss, 0.);
+    }
+}
+
 void
 run_random_search_tests()
 {
     test_random_search_functionality ();
+    test_random_search_choice ();
     std::cout << "All random search tests pass" << std::endl;
 }
 
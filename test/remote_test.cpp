@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2020 Maxime Robeyns <maximerobeyns@gmail.com>
+ *
+ * Written for the ACRC, University of Bristol
+ *
+ * Licensed under the Educational Community License, Version 2.0
+ * (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ * http://www.osedu.org/licenses/ECL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the LIcense For The Specific Language Governing permissions and
+ * limitations under the License.
+ *
+ * @file
+ * @brief Implements tests for the remote optimiser and its protocol.
+ */
+
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <optimisers/random.hpp>
+#include <optimisers/remote.hpp>
+#include <optk/core.hpp>
+
+#include <tests/optimiser_test.hpp>
+#include <tests/testutils.hpp>
+#include <benchmarks/synthetic.hpp>
+
+static const char *sock = "/tmp/optk_remote_test.sock";
+
+/** A random search which counts its calls, and runs out after a limit. */
+class counting_search: public random_search {
+    public:
+        counting_search (uint limit = ~0u): m_limit (limit) { }
+
+        inst::set
+        generate_parameters (int param_id) override
+        {
+            if (generated == m_limit)
+                return NULL;
+            generated++;
+            return random_search::generate_parameters (param_id);
+        }
+
+        void
+        receive_trial_results (int pid, inst::set p, double v) override
+        {
+            received++;
+            total += v;
+            random_search::receive_trial_results (pid, p, v);
+        }
+
+        uint generated = 0, received = 0;
+        double total = 0;
+
+    private:
+        uint m_limit;
+};
+
+/** Serves opt to a single client on a background thread. */
+static std::thread
+serve_one (int lfd, optk::optimiser *opt)
+{
+    return std::thread ([lfd, opt] () {
+            int fd = accept (lfd, NULL, NULL);
+            assert (fd >= 0);
+            __remote::serve (fd, opt);
+        });
+}
+
+/**
+ * Runs the same seeded random search locally and remotely, which must agree
+ * whatever the lookahead and batch size.
+ */
+static void
+test_remote_matches_local (int lfd, uint lookahead, uint batch)
+{
+    const uint iters = 37;
+    syn::alpine1 bench (3);
+
+    random_search local;
+    local.seed (5);
+    optk::trace expected (iters);
+    optk::core_loop (&bench, &local, expected);
+
+    counting_search served;
+    served.seed (5);
+    std::thread t = serve_one (lfd, &served);
+    double total = 0;
+    {
+        remote_optimiser remote (sock, lookahead);
+        optk::trace tr (iters);
+        if (batch > 1)
+            optk::core_loop_batch (&bench, &remote, tr, batch, NULL);
+        else
+            optk::core_loop (&bench, &remote, tr);
+        assert (tr.count () == iters);
+        for (uint i = 0; i < iters; i++) {
+            assert (tr.data ()[i] == expected.data ()[i]);
+            total += tr.data ()[i];
+        }
+    }
+    t.join ();
+
+    // every result was told back by the end of the run, whether or not
+    // trials were asked for ahead
+    assert (served.received == iters);
+    assert (served.generated >= iters);
+    assert (tutils::dbleq (served.total, total));
+}
+
+/** Runs twice over one connection, with a server that runs out. */
+static void
+test_remote_exhaustion (int lfd)
+{
+    syn::alpine1 bench (2);
+    counting_search served (8);
+    std::thread t = serve_one (lfd, &served);
+    {
+        remote_optimiser remote (sock, 3);
+        optk::trace tr (20);
+        optk::core_loop (&bench, &remote, tr);
+        assert (tr.count () == 8);
+
+        // a second run starts afresh on the server, but it is still out
+        optk::core_loop_batch (&bench, &remote, tr, 4, NULL);
+        assert (tr.count () == 0);
+    }
+    t.join ();
+    assert (served.generated == 8 && served.received == 8);
+}
+
+static void
+test_remote_space ()
+{
+    std::vector<int> opts = {1, 2, 3};
+    sspace::categorical<int> c ("c", &opts);
+    sspace::sspace_t space = {&c};
+    remote_optimiser remote ("/nonexistent/optk.sock");
+    try {
+        remote.update_search_space (&space);
+        assert (1 == 0);
+    } catch (const std::invalid_argument &) { }
+
+    sspace::uniform u ("u", 0, 1);
+    sspace::sspace_t flat = {&u};
+    try {
+        remote.update_search_space (&flat);
+        assert (1 == 0);
+    } catch (const std::runtime_error &) { }
+}
+
+void
+run_remote_tests ()
+{
+    int lfd = optk::net::listen_unix (sock);
+
+    test_remote_matches_local (lfd, 0, 1);
+    test_remote_matches_local (lfd, 1, 1);
+    test_remote_matches_local (lfd, 16, 1);
+    test_remote_matches_local (lfd, 2, 5);
+    test_remote_exhaustion (lfd);
+    test_remote_space ();
+
+    close (lfd);
+    unlink (sock);
+    std::cout << "All remote optimiser tests pass" << std::endl;
+}
@@ -22,6 +22,7 @@
 #include <tests/types_test.hpp>
 #include <tests/optimiser_test.hpp>
 #include <tests/benchmark_test.hpp>
+#include <tests/core_test.hpp>
 
 static void
 run_optimiser_tests ()
@@ -30,6 +31,10 @@ run_optimiser_tests ()
     run_static_gridsearch_tests ();
 
     run_random_search_tests ();
+    run_qmc_tests ();
+    run_remote_tests ();
+
+    run_gp_tests ();
 }
 
 void
@@ -41,6 +46,11 @@ OPTKtest::testmain ()
 
     run_benchmark_tests ();
 
+    run_core_tests ();
+    run_dist_tests ();
+    run_checkpoint_tests ();
+    run_cache_tests ();
+
     std::cout << "All tests pass." << std::endl;
 }
 
@@ -154,6 +154,226 @@ test_heap_concrete_types ()
     inst::free_node(nroot);
 }
 
+static void
+test_dense_values ()
+{
+    inst::node *root = new inst::node("root");
+    for (int i = 0; i < 5; i++)
+        root->add_item (new inst::dbl_val(std::to_string(i), (double)i*0.5));
+
+    const double *xs = root->dense (5);
+    for (int i = 0; i < 5; i++) {
+        assert (tutils::dbleq (xs[i], (double)i*0.5));
+        assert (tutils::dbleq (root->getdbl(i), (double)i*0.5));
+    }
+
+    // repeated calls return the cached array
+    assert (root->dense (5) == xs);
+
+    // modifying the node invalidates the cache
+    inst::param *p = root->get_item ("4");
+    root->remove_item ("4");
+    delete static_cast<inst::dbl_val *>(p);
+    root->add_item (new inst::dbl_val("4", 42.));
+    xs = root->dense (5);
+    assert (tutils::dbleq (xs[4], 42.));
+    assert (tutils::dbleq (root->getdbl(4), 42.));
+
+    // so does updating one of its values in place
+    static_cast<inst::dbl_val *>(root->get_item ("2"))->update_val (7.);
+    assert (tutils::dbleq (root->getdbl(2), 7.));
+    assert (tutils::dbleq (root->dense (5)[2], 7.));
+    *static_cast<inst::dbl_val *>(root->get_item ("3"))->get_addr () = 8.;
+    assert (tutils::dbleq (root->dense (5)[3], 8.));
+
+    // a value which has been removed no longer refers to the node
+    p = root->get_item ("1");
+    root->remove_item ("1");
+    static_cast<inst::dbl_val *>(p)->update_val (9.);
+    delete static_cast<inst::dbl_val *>(p);
+
+    // missing keys are reported
+    bool caught = false;
+    try {
+        root->dense (6);
+    } catch (const std::out_of_range &e) {
+        caught = true;
+    }
+    assert (caught);
+
+    inst::free_node(root);
+}
+
+/**
+ * Uses the pool from a thread-local destructor, which runs after the pool's
+ * own thread-local cache has gone if it was constructed first.
+ */
+struct late_user {
+    void *held = NULL;
+
+    ~late_user ()
+    {
+        // the blocks of the shared cache are reused, as those of any other
+        void *p = optk::pool::allocate (64);
+        assert (reinterpret_cast<std::uintptr_t>(p) % 16 == 0);
+        memset (p, 0xcd, 64);
+        optk::pool::deallocate (p, 64);
+        void *q = optk::pool::allocate (64);
+        assert (q == p);
+        optk::pool::deallocate (q, 64);
+        optk::pool::deallocate (held, 64);
+    }
+};
+
+static thread_local late_user t_late;
+
+static void
+test_pool ()
+{
+    // freed blocks are reused by allocations of the same size class
+    void *a = optk::pool::allocate (40);
+    optk::pool::deallocate (a, 40);
+    void *b = optk::pool::allocate (48);
+    assert (a == b);
+    void *c = optk::pool::allocate (48);
+    assert (c != b);
+    optk::pool::deallocate (b, 48);
+    optk::pool::deallocate (c, 48);
+
+    // blocks are aligned, and large blocks bypass the pool
+    for (std::size_t n = 1; n <= optk::pool::max_size + 64; n += 7) {
+        void *p = optk::pool::allocate (n);
+        assert (reinterpret_cast<std::uintptr_t>(p) % 16 == 0);
+        memset (p, 0xab, n);
+        optk::pool::deallocate (p, n);
+    }
+
+    // parameter values come from the pool, except in this build, where the
+    // sanitiser is to see them
+    assert (!optk::pool::enabled);
+
+    // trees can be built and freed on several threads at once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.push_back (std::thread ([] () {
+            for (int r = 0; r < 100; r++) {
+                inst::node *n = new inst::node ("root");
+                for (int i = 0; i < 50; i++)
+                    n->add_item (new inst::dbl_val (std::to_string (i), i));
+                assert (tutils::dbleq (n->dense (50)[49], 49.));
+                inst::free_node (n);
+            }
+        }));
+    for (uint t = 0; t < threads.size (); t++)
+        threads[t].join ();
+
+    // blocks freed on another thread than their own are reused by their
+    // own, so that memory stays flat when a worker allocates the dense
+    // arrays which the job thread frees
+    const uint per_round = 512, rounds = 400;
+    std::vector<void *> blocks (per_round);
+    std::mutex mtx;
+    std::condition_variable cv;
+    uint handed = 0, freed = 0;
+    std::thread worker ([&] () {
+        for (uint r = 0; r < rounds; r++) {
+            std::unique_lock<std::mutex> lock (mtx);
+            cv.wait (lock, [&] { return freed == r; });
+            for (uint i = 0; i < per_round; i++)
+                blocks[i] = optk::pool::allocate (80);
+            handed++;
+            cv.notify_all ();
+        }
+    });
+    std::size_t before = 0;
+    for (uint r = 0; r < rounds; r++) {
+        std::unique_lock<std::mutex> lock (mtx);
+        cv.wait (lock, [&] { return handed == r + 1; });
+        for (uint i = 0; i < per_round; i++)
+            optk::pool::deallocate (blocks[i], 80);
+        if (r == 0)
+            before = optk::pool::chunks ();
+        freed++;
+        cv.notify_all ();
+    }
+    worker.join ();
+    assert (optk::pool::chunks () <= before + 1);
+
+    // as are those of threads which have exited
+    for (uint r = 0; r < 50; r++) {
+        std::thread t ([&] () {
+            for (uint i = 0; i < per_round; i++)
+                blocks[i] = optk::pool::allocate (80);
+        });
+        t.join ();
+        for (uint i = 0; i < per_round; i++)
+            optk::pool::deallocate (blocks[i], 80);
+    }
+    assert (optk::pool::chunks () <= before + 2);
+
+    // the pool may be used once a thread's cache has gone
+    std::thread exiting ([] () {
+        t_late.held = NULL;
+        t_late.held = optk::pool::allocate (64);
+    });
+    exiting.join ();
+}
+
+static void
+test_rng ()
+{
+    // generators with the same seed produce the same stream
+    optk::rng a (42), b (42), c (43);
+    bool differs = false;
+    for (int i = 0; i < 100; i++) {
+        uint64_t x = a ();
+        assert (x == b ());
+        differs = differs || x != c ();
+    }
+    assert (differs);
+    assert (optk::rng::derive (1, 0) != optk::rng::derive (1, 1));
+    assert (optk::rng::derive (1, 0) == optk::rng::derive (1, 0));
+
+    // ranges
+    double sum = 0., sumsq = 0.;
+    const int n = 20000;
+    int counts[5] = {0};
+    for (int i = 0; i < n; i++) {
+        double u = a.uniform (-2., 3.);
+        assert (u >= -2. && u < 3.);
+        int64_t k = a.uniform_int (-1, 3);
+        assert (k >= -1 && k <= 3);
+        counts[k + 1]++;
+        double z = a.normal (1., 2.);
+        sum += z;
+        sumsq += z * z;
+    }
+    for (int k = 0; k < 5; k++)
+        assert (counts[k] > n / 5 - n / 20 && counts[k] < n / 5 + n / 20);
+    double mean = sum / n, var = sumsq / n - mean * mean;
+    assert (std::fabs (mean - 1.) < 0.1);
+    assert (std::fabs (var - 4.) < 0.3);
+
+    // the parameter types sample reproducibly from a given generator
+    sspace::uniform uni ("u", 0., 1.);
+    sspace::normal norm ("n", 0., 1.);
+    std::vector<int> opts = {1, 2, 3};
+    sspace::categorical<int> cat ("c", &opts);
+    optk::rng r1 (7), r2 (7);
+    for (int i = 0; i < 10; i++) {
+        assert (uni.sample (r1) == uni.sample (r2));
+        assert (norm.sample (r1) == norm.sample (r2));
+        assert (cat.sample (r1) == cat.sample (r2));
+    }
+
+    // reseeding the global seed reseeds the thread's generator
+    optk::set_seed (1234);
+    assert (optk::get_seed () == 1234u);
+    uint64_t first = optk::thread_rng () ();
+    optk::set_seed (1234);
+    assert (optk::thread_rng () () == first);
+}
+
 // test search space types ----------------------------------------------------
 
 static void
@@ -505,6 +725,43 @@ test_qlognormal ()
     }
 }
 
+static void
+test_quantiles ()
+{
+    sspace::normal n ("n", 10, 2);
+    assert (std::abs (n.quantile (.5) - 10) < 1e-12);
+    // Phi(1) and Phi(-2.5), to double precision
+    assert (std::abs (n.quantile (0.8413447460685429) - 12) < 1e-9);
+    assert (std::abs (n.quantile (0.0062096653257761) - 5) < 1e-9);
+    assert (std::isfinite (n.quantile (0)) && std::isfinite (n.quantile (1)));
+
+    sspace::qnormal qn ("qn", 10, 5, 2);
+    assert ((int) qn.quantile (.3) % 2 == 0);
+
+    sspace::lognormal ln ("ln", 1, .5);
+    assert (std::abs (ln.quantile (.5) - std::exp (1.)) < 1e-12);
+
+    sspace::uniform u ("u", -1, 3);
+    assert (u.quantile (0) == -1 && u.quantile (.25) == 0);
+
+    sspace::quniform qu ("qu", 0, 10, 3);
+    assert (qu.quantile (0) == 0 && qu.quantile (.99) == 9);
+
+    sspace::loguniform lu ("lu", 1, 100);
+    assert (std::abs (lu.quantile (.5) - 10) < 1e-12);
+    assert (lu.quantile (0) >= 1 && lu.quantile (1) <= 100);
+
+    sspace::randint ri ("ri", 0, 4);
+    for (int i = 0; i < 5; i++)
+        assert (ri.quantile ((i + .5) / 5) == i);
+    assert (ri.quantile (.999999) == 4);
+
+    std::vector<std::string> opts = {"a", "b", "c"};
+    sspace::categorical<std::string> c ("c", &opts);
+    assert (c.quantile (0) == "a" && c.quantile (.5) == "b" &&
+            c.quantile (.9999) == "c");
+}
+
 // validation tests -----------------------------------------------------------
 
 static void
@@ -516,6 +773,13 @@ validate_invalid (inst::param *p, sspace::sspace_t *root)
         sspace::validate_param_values(i.get_values(), root);
         assert (1 == 0);
     } catch (const std::invalid_argument &) { }
+
+    // the compiled space must agree
+    sspace::compiled cs (root);
+    try {
+        cs.validate (i.get_values());
+        assert (1 == 0);
+    } catch (const std::invalid_argument &) { }
 }
 
 static void
@@ -588,6 +852,30 @@ test_validation ()
 
     sspace::validate_param_values(instroot.get_values(), &testroot);
 
+    // and through the compiled space, which also checks the nested choice
+    sspace::compiled cs (&testroot);
+    cs.validate (instroot.get_values());
+
+    // unknown keys are reported either way
+    inst::dbl_val unknown_c("unknown", 1.);
+    inst::node unknown ("unknown root");
+    unknown.add_item (&unknown_c);
+    bool caught = false;
+    try {
+        sspace::validate_param_values(unknown.get_values(), &testroot);
+    } catch (const std::invalid_argument &e) {
+        caught = true;
+        assert (std::string (e.what ()).find ("unknown") != std::string::npos);
+    }
+    assert (caught);
+    caught = false;
+    try {
+        cs.validate (unknown.get_values());
+    } catch (const std::invalid_argument &e) {
+        caught = true;
+    }
+    assert (caught);
+
     inst::int_val iri_c("randint", 15);
     validate_invalid (&iri_c, &testroot);
 
@@ -625,12 +913,119 @@ test_validation ()
     validate_invalid (&iqlu_c2, &testroot);
 }
 
+// compiled search spaces -----------------------------------------------------
+
+static void
+test_compiled ()
+{
+    std::vector<int> iopts = {3, 5, 7};
+    std::vector<double> dopts = {.5, 1.5};
+    std::vector<std::string> sopts = {"a", "b", "c", "d"};
+    sspace::categorical<int> ci ("ci", &iopts);
+    sspace::categorical<double> cd ("cd", &dopts);
+    sspace::categorical<std::string> cstr ("cs", &sopts);
+    sspace::randint ri ("ri", -3, 8);
+    sspace::uniform u ("u", -1, 3);
+    // the quantised bounds are multiples of q, as sampled values are
+    // clamped to the bounds
+    sspace::quniform qu ("qu", 0, 9, 3);
+    sspace::loguniform lu ("lu", 1, 100);
+    sspace::qloguniform qlu ("qlu", 5, 100, 5);
+    sspace::normal n ("n", 10, 2);
+    sspace::qnormal qn ("qn", 10, 5, 2);
+    sspace::lognormal ln ("ln", 1, .5);
+    sspace::qlognormal qln ("qln", 1, .5, .25);
+
+    sspace::sspace_t inner ({&ri, &cstr});
+    sspace::choice ch ("ch", &inner);
+    sspace::sspace_t space ({&ci, &cd, &ch, &u, &qu, &lu, &qlu, &n, &qn,
+            &ln, &qln});
+
+    // the options of the choice follow it, and the pools hold the options
+    sspace::compiled cs (&space);
+    assert (cs.size () == 13 && cs.dims () == 12);
+    assert (cs.type (2) == pt::choice && cs.count (2) == 2 && cs.end (2) == 5);
+    assert (cs.name (3) == "ri" && cs.a (3) == -3 && cs.b (3) == 8);
+    assert (cs.type (4) == pt::categorical_str && cs.count (4) == 4);
+    assert (cs.end (0) == 1 && cs.end (12) == 13);
+    assert (cs.name (6) == "qu" && cs.q (6) == 3);
+    assert (cs.name (9) == "n" && cs.a (9) == 10 && cs.b (9) == 2);
+
+    // sampling draws exactly what the parameters' own sample methods do
+    optk::rng r1 (42), r2 (42);
+    for (int k = 0; k < 200; k++) {
+        inst::node *root = new inst::node ("root");
+        cs.sample (root, r1);
+        assert (root->getint ("ci") == ci.sample (r2));
+        assert (root->getdbl ("cd") == cd.sample (r2));
+        GETNODE (sub, root, "ch");
+        assert (sub->getint ("ri") == ri.sample (r2));
+        assert (sub->getstr ("cs") == cstr.sample (r2));
+        assert (root->getdbl ("u") == u.sample (r2));
+        assert (root->getdbl ("qu") == qu.sample (r2));
+        assert (root->getdbl ("lu") == lu.sample (r2));
+        assert (root->getdbl ("qlu") == qlu.sample (r2));
+        assert (root->getdbl ("n") == n.sample (r2));
+        assert (root->getdbl ("qn") == qn.sample (r2));
+        assert (root->getdbl ("ln") == ln.sample (r2));
+        assert (root->getdbl ("qln") == qln.sample (r2));
+        cs.validate (root->get_values ());
+        inst::free_node (root);
+    }
+
+    // and mapping a point uses their quantile methods, in entry order
+    for (int k = 0; k < 200; k++) {
+        double x[12];
+        for (int j = 0; j < 12; j++)
+            x[j] = r1.uniform ();
+        inst::node *root = new inst::node ("root");
+        cs.map (root, x);
+        assert (root->getint ("ci") == ci.quantile (x[0]));
+        assert (root->getdbl ("cd") == cd.quantile (x[1]));
+        GETNODE (sub, root, "ch");
+        assert (sub->getint ("ri") == ri.quantile (x[2]));
+        assert (sub->getstr ("cs") == cstr.quantile (x[3]));
+        assert (root->getdbl ("u") == u.quantile (x[4]));
+        assert (root->getdbl ("qu") == qu.quantile (x[5]));
+        assert (root->getdbl ("lu") == lu.quantile (x[6]));
+        assert (root->getdbl ("qlu") == qlu.quantile (x[7]));
+        assert (root->getdbl ("n") == n.quantile (x[8]));
+        assert (root->getdbl ("qn") == qn.quantile (x[9]));
+        assert (root->getdbl ("ln") == ln.quantile (x[10]));
+        assert (root->getdbl ("qln") == qln.quantile (x[11]));
+        cs.validate (root->get_values ());
+        inst::free_node (root);
+    }
+
+    // arrays of doubles are validated against a single entry
+    double ok[] = {-1, 0, 3}, bad[] = {0, 3.5};
+    cs.validate (5, ok, 3);
+    bool caught = false;
+    try {
+        cs.validate (5, bad, 2);
+    } catch (const std::invalid_argument &) {
+        caught = true;
+    }
+    assert (caught);
+
+    // a compiled space outlives its description, and may be recompiled
+    {
+        sspace::uniform tmp ("tmp", 0, 1);
+        sspace::sspace_t small ({&tmp});
+        cs.compile (&small);
+    }
+    assert (cs.size () == 1 && cs.dims () == 1 && cs.name (0) == "tmp");
+}
+
 void
 run_type_tests()
 {
 
     test_concrete_types ();
     test_heap_concrete_types ();
+    test_dense_values ();
+    test_pool ();
+    test_rng ();
 
     test_choice_type();
     test_categorical ();
@@ -644,8 +1039,10 @@ run_type_tests()
     test_lognormal ();
     test_qlognormal ();
     test_choice_type ();
+    test_quantiles ();
 
     test_validation ();
+    test_compiled ();
     std::cout << "All type tests pass" << std::endl;
 }
 